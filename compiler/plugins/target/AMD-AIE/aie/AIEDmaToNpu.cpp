@@ -15,6 +15,8 @@
 using namespace mlir;
 using namespace xilinx;
 using namespace xilinx::AIEX;
+using mlir::iree_compiler::AMDAIE::kRuntimePatchesAttrName;
+using mlir::iree_compiler::AMDAIE::kRuntimeSizesAttrName;
 
 #define GEN_PASS_DECL_AIEDMATONPU
 #include "aie/Dialect/AIEX/Transforms/AIEXPasses.h.inc"
@@ -67,6 +69,23 @@ struct ShimDMAllocationGetter {
     return std::nullopt;
   }
 };
+
+// Return the description of the instruction field `field`, to be patched with
+// `ceilDiv(c * multiplier + addend, divisor) * scale + bias` at dispatch time,
+// where the first part is the runtime size `runtimeSize`.
+DictionaryAttr getRuntimePatchAttr(Builder &builder, StringRef field,
+                                   DictionaryAttr runtimeSize, int64_t scale,
+                                   int64_t bias) {
+  SmallVector<NamedAttribute> patch;
+  patch.push_back(builder.getNamedAttr("field", builder.getStringAttr(field)));
+  for (StringRef name : {"ordinal", "multiplier", "addend", "divisor"})
+    patch.push_back(builder.getNamedAttr(name, runtimeSize.get(name)));
+  patch.push_back(
+      builder.getNamedAttr("scale", builder.getI64IntegerAttr(scale)));
+  patch.push_back(
+      builder.getNamedAttr("bias", builder.getI64IntegerAttr(bias)));
+  return builder.getDictionaryAttr(patch);
+}
 }  // namespace
 
 struct RtpToNpuPattern : OpConversionPattern<NpuWriteRTPOp> {
@@ -147,7 +166,11 @@ struct PushToNpuPattern : OpConversionPattern<NpuPushQueueOp> {
     auto i32ty = IntegerType::get(op->getContext(), 32);
     auto column = IntegerAttr::get(i32ty, op.getColumn());
     auto row = IntegerAttr::get(i32ty, 0);
-    rewriter.create<NpuWrite32Op>(op->getLoc(), queue_offset, cmd, column, row);
+    auto write32Op = rewriter.create<NpuWrite32Op>(op->getLoc(), queue_offset,
+                                                   cmd, column, row);
+    // Forward the runtime patch of the repeat count to the queue write.
+    if (Attribute patches = op->getAttr(kRuntimePatchesAttrName))
+      write32Op->setAttr(kRuntimePatchesAttrName, patches);
     rewriter.eraseOp(op);
     return success();
   }
@@ -260,9 +283,18 @@ struct DmaToNpuPattern : OpConversionPattern<NpuDmaMemcpyNdOp> {
     assert(el_bit_width % 8 == 0 &&
            "Expected Memref element bitwidth to be multiple of 8.");
     size_t S = el_bit_width / 8;
+    bool dynamicStride = false;
     for (size_t i = 0; i < R; i++) {
+      if (offsets[i] && dynamicStride) {
+        return op->emitOpError(
+            "can't compute the buffer offset within a dynamically shaped "
+            "memref");
+      }
       offset += offsets[i] * stride * S;
-      stride *= shape[R - i - 1];
+      if (ShapedType::isDynamic(shape[R - i - 1]))
+        dynamicStride = true;
+      else
+        stride *= shape[R - i - 1];
     }
     buffer_offset = IntegerAttr::get(i32ty, offset);
 
@@ -317,18 +349,67 @@ struct DmaToNpuPattern : OpConversionPattern<NpuDmaMemcpyNdOp> {
     // repeat_count
     repeat_count = IntegerAttr::get(i32ty, sizes[3] - 1);
 
+    // Sizes that are only known at dispatch time are patched into the BD
+    // fields and the repeat count derived from them. As the buffer length is
+    // the product of the three innermost sizes, only one of those can be
+    // dynamic.
+    SmallVector<Attribute> bdPatches;
+    SmallVector<Attribute> queuePatches;
+    if (auto runtimeSizes =
+            op->getAttrOfType<ArrayAttr>(kRuntimeSizesAttrName)) {
+      Builder builder(ctx);
+      bool hasDynamicLength = false;
+      for (auto runtimeSize : runtimeSizes.getAsRange<DictionaryAttr>()) {
+        // Dimensions are listed from outer to inner, while `sizes` is
+        // reversed.
+        auto dimAttr = cast<IntegerAttr>(runtimeSize.get("dim"));
+        int64_t dim = sizes.size() - 1 - dimAttr.getInt();
+        if (dim == 3) {
+          if (strides[2]) {
+            bdPatches.push_back(getRuntimePatchAttr(builder, "iteration_size",
+                                                    runtimeSize, 1, -1));
+          }
+          queuePatches.push_back(getRuntimePatchAttr(builder, "repeat_count",
+                                                     runtimeSize, 1, -1));
+          continue;
+        }
+        if (hasDynamicLength) {
+          return op->emitOpError(
+              "only a single dynamic size is supported within the buffer "
+              "length");
+        }
+        hasDynamicLength = true;
+        int64_t lengthScale = 1;
+        for (int64_t i = 0; i < 3; i++)
+          if (i != dim) lengthScale *= sizes[i];
+        bdPatches.push_back(getRuntimePatchAttr(builder, "buffer_length",
+                                                runtimeSize, lengthScale, 0));
+        if (dim == 0 && strides[0]) {
+          bdPatches.push_back(
+              getRuntimePatchAttr(builder, "d0_size", runtimeSize, 1, 0));
+        } else if (dim == 1 && strides[1]) {
+          bdPatches.push_back(
+              getRuntimePatchAttr(builder, "d1_size", runtimeSize, 1, 0));
+        }
+      }
+    }
+
     // Set the issue_token
     issue_token = BoolAttr::get(ctx, op.getIssueToken());
     // Earlier, all S2MM channels were implicitly assumed to issue a token.
     // This logic is kept for now for backward compatibility.
     if (!isMM2S) issue_token = BoolAttr::get(ctx, true);
 
-    rewriter.create<NpuWriteBdOp>(
+    auto writeBdOp = rewriter.create<NpuWriteBdOp>(
         op->getLoc(), column, ddr_id, bd_id, buffer_length, buffer_offset,
         enable_packet, out_of_order_id, packet_id, packet_type, d0_size,
         d0_stride, d1_size, d1_stride, d2_stride, iteration_current,
         iteration_size, iteration_stride, next_bd, row, use_next_bd, valid_bd,
         lock_rel_val, lock_rel_id, lock_acq_enable, lock_acq_val, lock_acq_id);
+    if (!bdPatches.empty()) {
+      writeBdOp->setAttr(kRuntimePatchesAttrName,
+                         rewriter.getArrayAttr(bdPatches));
+    }
 
     const AIE::AIETargetModel &tm =
         op->getParentOfType<AIE::DeviceOp>().getTargetModel();
@@ -337,9 +418,13 @@ struct DmaToNpuPattern : OpConversionPattern<NpuDmaMemcpyNdOp> {
         (col << tm.getColumnShift()) | (0x1D004 + op.getId() * 0x20);
     rewriter.create<NpuAddressPatchOp>(op->getLoc(), addr, arg_idx, offset);
 
-    rewriter.create<NpuPushQueueOp>(
+    auto pushQueueOp = rewriter.create<NpuPushQueueOp>(
         op->getLoc(), column, row, infoOp->getChannelDirAttr(),
         infoOp->getChannelIndexAttr(), issue_token, repeat_count, bd_id);
+    if (!queuePatches.empty()) {
+      pushQueueOp->setAttr(kRuntimePatchesAttrName,
+                           rewriter.getArrayAttr(queuePatches));
+    }
 
     rewriter.eraseOp(op);
     return success();
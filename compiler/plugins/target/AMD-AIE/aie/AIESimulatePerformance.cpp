@@ -0,0 +1,1013 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// This pass predicts the number of cycles the program of an aie.device takes
+// from the first instruction of the NPU control program until its last
+// dma_wait completes, together with the time every core and DMA channel of the
+// array is busy. It is a discrete-event simulation of the following agents:
+//
+//   * Cores, which interpret their body. Loops need constant bounds. Every op
+//     is charged a number of cycles from a simple cost table, with calls to
+//     microkernels charged the cycles annotated on the callee or call through
+//     `amdaie.estimated_cycles`. Lock acquires block until the lock is
+//     available.
+//   * Tile DMA channels, which walk their chain of buffer descriptors:
+//     acquire the locks of a BD, stream its bytes and release its locks.
+//   * Shim DMA channels driven by the control program, which serve the
+//     transfers of `aiex.npu.dma_memcpy_nd` in issue order, sharing the DDR
+//     bandwidth between all such channels.
+//   * The control program, which issues transfers and waits for them.
+//
+// Data sent by an MM2S channel arrives at all S2MM channels connected to it by
+// `aie.flow`, or, once routed, by the connections of the switchboxes and shim
+// multiplexers. Lock releases become visible to other agents after a fixed
+// latency.
+//
+// Known limitations: streams have unbounded buffering, i.e. a sender is never
+// stalled by a receiver which isn't ready yet, cascade transfers don't couple
+// neighbouring cores and packet-switched flows aren't modelled. The control
+// program needs to be in the form before `aie-dma-to-npu`.
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <queue>
+#include <set>
+
+#include "Passes.h"
+#include "aie/Dialect/AIE/IR/AIEDialect.h"
+#include "aie/Dialect/AIEX/IR/AIEXDialect.h"
+#include "llvm/ADT/DenseMap.h"
+#include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/Interfaces/ViewLikeInterface.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "aie-simulate-performance"
+
+using namespace mlir;
+using namespace xilinx;
+using namespace xilinx::AIE;
+
+namespace mlir::iree_compiler::AMDAIE {
+
+namespace {
+
+using Cycles = int64_t;
+
+/// The width in bits of the vector registers of the cores.
+constexpr int64_t kVectorBits = 512;
+
+/// A DMA channel of a tile.
+struct DmaChannel {
+  TileID tile;
+  DMAChannelDir dir;
+  int channel;
+
+  bool operator<(const DmaChannel &rhs) const {
+    return std::make_tuple(tile, dir, channel) <
+           std::make_tuple(rhs.tile, rhs.dir, rhs.channel);
+  }
+};
+
+std::string stringify(const DmaChannel &dmaChannel) {
+  std::string name;
+  llvm::raw_string_ostream os(name);
+  os << stringifyDMAChannelDir(dmaChannel.dir) << " channel "
+     << dmaChannel.channel << " of tile (" << dmaChannel.tile.col << ", "
+     << dmaChannel.tile.row << ")";
+  return os.str();
+}
+
+TileID getTileID(Value tile) {
+  auto tileOp = cast<TileOp>(tile.getDefiningOp());
+  return {tileOp.colIndex(), tileOp.rowIndex()};
+}
+
+/// Return the S2MM channels receiving the data sent by every MM2S channel. Use
+/// the flows if the device isn't routed yet and trace the connections of the
+/// switchboxes and shim multiplexers otherwise.
+std::map<DmaChannel, SmallVector<DmaChannel>> getStreamConnections(
+    DeviceOp deviceOp) {
+  std::map<DmaChannel, SmallVector<DmaChannel>> connections;
+  for (FlowOp flowOp : deviceOp.getOps<FlowOp>()) {
+    if (flowOp.getSourceBundle() != WireBundle::DMA ||
+        flowOp.getDestBundle() != WireBundle::DMA) {
+      continue;
+    }
+    DmaChannel source{getTileID(flowOp.getSource()), DMAChannelDir::MM2S,
+                      flowOp.getSourceChannel()};
+    DmaChannel dest{getTileID(flowOp.getDest()), DMAChannelDir::S2MM,
+                    flowOp.getDestChannel()};
+    connections[source].push_back(dest);
+  }
+  if (!connections.empty()) return connections;
+
+  DenseMap<TileID, SwitchboxOp> switchboxes;
+  for (SwitchboxOp switchboxOp : deviceOp.getOps<SwitchboxOp>())
+    switchboxes[{switchboxOp.colIndex(), switchboxOp.rowIndex()}] = switchboxOp;
+  DenseMap<int, ShimMuxOp> shimMuxes;
+  for (ShimMuxOp shimMuxOp : deviceOp.getOps<ShimMuxOp>())
+    shimMuxes[shimMuxOp.colIndex()] = shimMuxOp;
+
+  // Follow the stream entering the switchbox (or the shim multiplexer if
+  // `isShimMux`) of `tile` through `bundle` and `channel` to the DMA channels
+  // it ends in.
+  std::function<void(TileID, bool, WireBundle, int, SmallVector<DmaChannel> &)>
+      trace = [&](TileID tile, bool isShimMux, WireBundle bundle, int channel,
+                  SmallVector<DmaChannel> &dests) {
+        Operation *op = nullptr;
+        if (isShimMux) {
+          op = shimMuxes.lookup(tile.col);
+        } else {
+          op = switchboxes.lookup(tile);
+        }
+        if (!op) return;
+        for (ConnectOp connectOp : op->getRegion(0).getOps<ConnectOp>()) {
+          if (connectOp.getSourceBundle() != bundle ||
+              connectOp.getSourceChannel() != channel) {
+            continue;
+          }
+          int destChannel = connectOp.getDestChannel();
+          switch (connectOp.getDestBundle()) {
+            case WireBundle::DMA:
+              dests.push_back({tile, DMAChannelDir::S2MM, destChannel});
+              break;
+            case WireBundle::North:
+              if (isShimMux) {
+                trace(tile, false, WireBundle::South, destChannel, dests);
+              } else {
+                trace({tile.col, tile.row + 1}, false, WireBundle::South,
+                      destChannel, dests);
+              }
+              break;
+            case WireBundle::South:
+              if (tile.row == 0) {
+                trace(tile, true, WireBundle::North, destChannel, dests);
+              } else {
+                trace({tile.col, tile.row - 1}, false, WireBundle::North,
+                      destChannel, dests);
+              }
+              break;
+            case WireBundle::East:
+              trace({tile.col + 1, tile.row}, false, WireBundle::West,
+                    destChannel, dests);
+              break;
+            case WireBundle::West:
+              trace({tile.col - 1, tile.row}, false, WireBundle::East,
+                    destChannel, dests);
+              break;
+            default:
+              break;
+          }
+        }
+      };
+
+  auto addSources = [&](Operation *op, TileID tile, bool isShimMux) {
+    for (ConnectOp connectOp : op->getRegion(0).getOps<ConnectOp>()) {
+      if (connectOp.getSourceBundle() != WireBundle::DMA) continue;
+      DmaChannel source{tile, DMAChannelDir::MM2S,
+                        connectOp.getSourceChannel()};
+      if (connections.count(source)) continue;
+      trace(tile, isShimMux, WireBundle::DMA, source.channel,
+            connections[source]);
+    }
+  };
+  for (auto &[tile, switchboxOp] : switchboxes)
+    addSources(switchboxOp, tile, false);
+  for (auto &[col, shimMuxOp] : shimMuxes)
+    addSources(shimMuxOp, {col, 0}, true);
+  return connections;
+}
+
+/// Return the constant trip count of `forOp` if it has static bounds.
+std::optional<int64_t> getConstantTripCount(scf::ForOp forOp) {
+  std::optional<int64_t> lb = getConstantIntValue(forOp.getLowerBound());
+  std::optional<int64_t> ub = getConstantIntValue(forOp.getUpperBound());
+  std::optional<int64_t> step = getConstantIntValue(forOp.getStep());
+  if (!lb || !ub || !step || step.value() <= 0) return std::nullopt;
+  return std::max<int64_t>(
+      0, llvm::divideCeil(ub.value() - lb.value(), step.value()));
+}
+
+/// Return the number of cycles a core spends on `op`, which doesn't
+/// synchronize with other agents.
+Cycles getOpCycles(Operation *op, const AIEPerformanceModel &model) {
+  if (auto callOp = dyn_cast<func::CallOp>(op)) {
+    if (auto cycles =
+            callOp->getAttrOfType<IntegerAttr>(kEstimatedCyclesAttrName)) {
+      return cycles.getInt();
+    }
+    auto funcOp = SymbolTable::lookupNearestSymbolFrom<func::FuncOp>(
+        callOp, callOp.getCalleeAttr());
+    if (funcOp) {
+      if (auto cycles =
+              funcOp->getAttrOfType<IntegerAttr>(kEstimatedCyclesAttrName)) {
+        return cycles.getInt();
+      }
+    }
+    return model.defaultCallCycles;
+  }
+  // A contraction runs at the peak MAC rate of its operand type.
+  if (auto contractOp = dyn_cast<vector::ContractionOp>(op)) {
+    SmallVector<int64_t> bounds;
+    contractOp.getIterationBounds(bounds);
+    int64_t macs = 1;
+    for (int64_t bound : bounds) macs *= bound;
+    unsigned bitWidth =
+        contractOp.getLhsType().getElementType().getIntOrFloatBitWidth();
+    int64_t macsPerCycle = bitWidth <= 8 ? 256 : bitWidth <= 16 ? 128 : 32;
+    return llvm::divideCeil(macs, macsPerCycle);
+  }
+  // Constants, views and the index computations of addresses are free.
+  if (op->hasTrait<OpTrait::ConstantLike>() || isa<ViewLikeOpInterface>(op) ||
+      (op->getNumResults() > 0 &&
+       llvm::all_of(op->getResultTypes(),
+                    [](Type type) { return type.isIndex(); }))) {
+    return 0;
+  }
+  // Any other op processes one vector register per cycle.
+  int64_t bits = 0;
+  auto addVectorBits = [&](TypeRange types) {
+    for (Type type : types) {
+      auto vectorType = dyn_cast<VectorType>(type);
+      if (!vectorType || !vectorType.getElementType().isIntOrFloat()) continue;
+      bits = std::max<int64_t>(
+          bits, vectorType.getNumElements() *
+                    vectorType.getElementType().getIntOrFloatBitWidth());
+    }
+  };
+  addVectorBits(op->getOperandTypes());
+  addVectorBits(op->getResultTypes());
+  return std::max<int64_t>(1, llvm::divideCeil(bits, kVectorBits));
+}
+
+class ArraySimulator;
+
+/// An agent of the array, i.e. a core, a DMA channel or the control program,
+/// advancing through its program.
+class Actor {
+ public:
+  Actor(ArraySimulator &sim, Operation *op, std::string name)
+      : sim(sim), op(op), name(std::move(name)) {}
+  virtual ~Actor() = default;
+
+  /// Advance the actor from the current cycle of the simulation until it has
+  /// to wait for another agent or for time to pass.
+  virtual LogicalResult resume() = 0;
+
+  ArraySimulator &sim;
+  Operation *op;
+  std::string name;
+  Cycles busyCycles = 0;
+  std::optional<Cycles> finishedAt;
+};
+
+using WaitList = SmallVector<Actor *>;
+
+class ArraySimulator {
+ public:
+  ArraySimulator(DeviceOp deviceOp, const AIEPerformanceModel &model)
+      : deviceOp(deviceOp),
+        model(model),
+        isAIE1(deviceOp.getTargetModel().getTargetArch() == AIEArch::AIE1) {}
+
+  FailureOr<AIEPerformanceEstimate> run();
+
+  Cycles now() const { return currentCycle; }
+
+  /// Resume `actor` at cycle `cycle`.
+  void resumeAt(Cycles cycle, Actor *actor) {
+    schedule(cycle, [actor]() { return actor->resume(); });
+  }
+
+  /// Resume all actors of `waiters` at the current cycle.
+  void notify(WaitList &waiters) {
+    WaitList actors = std::move(waiters);
+    waiters.clear();
+    for (Actor *actor : actors) resumeAt(currentCycle, actor);
+  }
+
+  /// Try to acquire the lock of `useLockOp` for `actor`. If the lock isn't
+  /// available, return false and make `actor` wait for the next release.
+  bool tryAcquire(LockOp lockOp, UseLockOp useLockOp, Actor *actor);
+
+  /// Release the lock of `useLockOp`.
+  void release(LockOp lockOp, UseLockOp useLockOp);
+
+  /// The bytes received by an S2MM channel which it hasn't written yet.
+  struct Pipe {
+    int64_t bytes = 0;
+    WaitList waiters;
+  };
+  Pipe &getPipe(const DmaChannel &dmaChannel) { return pipes[dmaChannel]; }
+
+  /// Make the bytes sent by the MM2S channel `source` arrive at all S2MM
+  /// channels connected to it.
+  void send(const DmaChannel &source, int64_t bytes);
+
+  /// Count a step of the simulation and fail once there are too many.
+  LogicalResult step() {
+    if (++numSteps <= model.maxSteps) return success();
+    return deviceOp.emitOpError()
+           << "didn't complete within " << model.maxSteps
+           << " simulation steps";
+  }
+
+  DeviceOp deviceOp;
+  const AIEPerformanceModel &model;
+  bool isAIE1;
+
+ private:
+  struct Event {
+    Cycles cycle;
+    uint64_t order;
+    std::function<LogicalResult()> fn;
+  };
+  struct EventCompare {
+    bool operator()(const Event &a, const Event &b) const {
+      return std::tie(a.cycle, a.order) > std::tie(b.cycle, b.order);
+    }
+  };
+
+  /// Run `fn` at cycle `cycle`. Events of the same cycle run in the order in
+  /// which they're scheduled.
+  void schedule(Cycles cycle, std::function<LogicalResult()> fn) {
+    events.push({cycle, numEvents++, std::move(fn)});
+  }
+
+  LogicalResult createActors();
+
+  struct LockState {
+    int64_t value = 0;
+    WaitList waiters;
+  };
+  DenseMap<Operation *, LockState> locks;
+  std::map<DmaChannel, Pipe> pipes;
+  std::map<DmaChannel, SmallVector<DmaChannel>> connections;
+  SmallVector<std::unique_ptr<Actor>> actors;
+  Actor *controlActor = nullptr;
+  std::priority_queue<Event, std::vector<Event>, EventCompare> events;
+  Cycles currentCycle = 0;
+  uint64_t numEvents = 0;
+  int64_t numSteps = 0;
+};
+
+bool ArraySimulator::tryAcquire(LockOp lockOp, UseLockOp useLockOp,
+                                Actor *actor) {
+  LockState &lock = locks[lockOp];
+  int64_t value = useLockOp.getLockValue();
+  // AIE1 locks are binary and held by a single agent until released with the
+  // next value. AIE2 locks are semaphores.
+  bool isAvailable = useLockOp.acquireGE() ? lock.value >= value
+                                           : lock.value == value;
+  if (!isAvailable) {
+    lock.waiters.push_back(actor);
+    return false;
+  }
+  lock.value = isAIE1 ? -1 : lock.value - value;
+  return true;
+}
+
+void ArraySimulator::release(LockOp lockOp, UseLockOp useLockOp) {
+  int64_t value = useLockOp.getLockValue();
+  schedule(currentCycle + model.lockLatencyCycles, [this, lockOp, value]() {
+    LockState &lock = locks[lockOp];
+    lock.value = isAIE1 ? value : lock.value + value;
+    notify(lock.waiters);
+    return success();
+  });
+}
+
+void ArraySimulator::send(const DmaChannel &source, int64_t bytes) {
+  auto it = connections.find(source);
+  if (it == connections.end()) return;
+  for (const DmaChannel &dest : it->second) {
+    Pipe &pipe = pipes[dest];
+    pipe.bytes += bytes;
+    notify(pipe.waiters);
+  }
+}
+
+/// Return the lock operated on by `useLockOp`. Inside of a core, uses of the
+/// locks of neighbouring tiles may have been replaced by their local index
+/// already.
+FailureOr<LockOp> getLockOp(UseLockOp useLockOp) {
+  Value lock = useLockOp.getLock();
+  if (auto lockOp = lock.getDefiningOp<LockOp>()) return lockOp;
+  std::optional<int64_t> localIndex = getConstantIntValue(lock);
+  auto coreOp = useLockOp->getParentOfType<CoreOp>();
+  if (!localIndex || !coreOp) {
+    return useLockOp.emitOpError() << "uses a lock which can't be resolved";
+  }
+  TileID core = getTileID(coreOp.getTile());
+  const AIETargetModel &targetModel = getTargetModel(coreOp);
+  auto deviceOp = coreOp->getParentOfType<DeviceOp>();
+  for (LockOp lockOp : deviceOp.getOps<LockOp>()) {
+    TileID tile = getTileID(lockOp.getTile());
+    if (!lockOp.getLockID() ||
+        !targetModel.isLegalMemAffinity(core.col, core.row, tile.col,
+                                        tile.row)) {
+      continue;
+    }
+    // Mirror the numbering of `aie-localize-locks`.
+    int numLocks = targetModel.getNumLocks(tile.col, tile.row);
+    int offset = 0;
+    if (targetModel.isMemWest(core.col, core.row, tile.col, tile.row)) {
+      offset = numLocks;
+    } else if (targetModel.isMemNorth(core.col, core.row, tile.col,
+                                      tile.row)) {
+      offset = 2 * numLocks;
+    } else if (targetModel.isMemEast(core.col, core.row, tile.col,
+                                     tile.row)) {
+      offset = 3 * numLocks;
+    }
+    if (offset + lockOp.getLockIDValue() == localIndex.value()) return lockOp;
+  }
+  return useLockOp.emitOpError()
+         << "uses local lock " << localIndex.value()
+         << ", which doesn't belong to a neighbouring tile";
+}
+
+/// A core interpreting its body.
+class CoreActor : public Actor {
+ public:
+  CoreActor(ArraySimulator &sim, CoreOp coreOp, std::string name)
+      : Actor(sim, coreOp, std::move(name)) {
+    Block &entry = coreOp.getBody().front();
+    frames.push_back({&entry, entry.begin(), 0, 0, 1});
+  }
+
+  LogicalResult resume() override;
+
+ private:
+  /// The position in a block and, for the body of a loop, its iteration.
+  struct Frame {
+    Block *block;
+    Block::iterator it;
+    int64_t iv;
+    int64_t ub;
+    int64_t step;
+  };
+
+  /// Return the cycles spent on one execution of `block` if it doesn't
+  /// synchronize with other agents.
+  std::optional<Cycles> getBlockCycles(Block &block);
+
+  SmallVector<Frame> frames;
+  DenseMap<Block *, std::optional<Cycles>> blockCycles;
+};
+
+std::optional<Cycles> CoreActor::getBlockCycles(Block &block) {
+  auto it = blockCycles.find(&block);
+  if (it != blockCycles.end()) return it->second;
+  std::optional<Cycles> cycles = 0;
+  for (Operation &op : block) {
+    if (isa<UseLockOp, cf::BranchOp, AIE::EndOp>(op)) {
+      cycles = std::nullopt;
+      break;
+    }
+    if (auto forOp = dyn_cast<scf::ForOp>(op)) {
+      std::optional<int64_t> tripCount = getConstantTripCount(forOp);
+      std::optional<Cycles> bodyCycles = getBlockCycles(*forOp.getBody());
+      if (!tripCount || !bodyCycles) {
+        cycles = std::nullopt;
+        break;
+      }
+      *cycles += *tripCount * *bodyCycles;
+      continue;
+    }
+    if (op.getNumRegions() > 0) {
+      cycles = std::nullopt;
+      break;
+    }
+    *cycles += getOpCycles(&op, sim.model);
+  }
+  blockCycles[&block] = cycles;
+  return cycles;
+}
+
+LogicalResult CoreActor::resume() {
+  Cycles cycle = sim.now();
+  while (!frames.empty()) {
+    if (failed(sim.step())) return failure();
+    Frame &frame = frames.back();
+    Operation *op = &*frame.it;
+    if (auto useLockOp = dyn_cast<UseLockOp>(op)) {
+      // Locks are operated on in order of time across all agents.
+      if (cycle > sim.now()) {
+        sim.resumeAt(cycle, this);
+        return success();
+      }
+      FailureOr<LockOp> lockOp = getLockOp(useLockOp);
+      if (failed(lockOp)) return failure();
+      if (useLockOp.getAction() == LockAction::Release) {
+        sim.release(lockOp.value(), useLockOp);
+      } else if (!sim.tryAcquire(lockOp.value(), useLockOp, this)) {
+        return success();
+      }
+      ++frame.it;
+      continue;
+    }
+    if (auto forOp = dyn_cast<scf::ForOp>(op)) {
+      ++frame.it;
+      if (std::optional<Cycles> bodyCycles = getBlockCycles(*forOp.getBody())) {
+        Cycles cycles = *bodyCycles * getConstantTripCount(forOp).value();
+        cycle += cycles;
+        busyCycles += cycles;
+        continue;
+      }
+      if (!getConstantTripCount(forOp)) {
+        return forOp.emitOpError() << "needs constant bounds to be simulated";
+      }
+      int64_t lb = getConstantIntValue(forOp.getLowerBound()).value();
+      int64_t ub = getConstantIntValue(forOp.getUpperBound()).value();
+      int64_t step = getConstantIntValue(forOp.getStep()).value();
+      if (lb >= ub) continue;
+      Block *body = forOp.getBody();
+      frames.push_back({body, body->begin(), lb, ub, step});
+      continue;
+    }
+    if (isa<scf::YieldOp>(op)) {
+      frame.iv += frame.step;
+      if (frame.iv < frame.ub) {
+        frame.it = frame.block->begin();
+      } else {
+        frames.pop_back();
+      }
+      continue;
+    }
+    if (auto branchOp = dyn_cast<cf::BranchOp>(op)) {
+      frame.block = branchOp.getDest();
+      frame.it = frame.block->begin();
+      continue;
+    }
+    if (isa<AIE::EndOp>(op)) break;
+    if (op->getNumRegions() > 0 || op->hasTrait<OpTrait::IsTerminator>()) {
+      return op->emitOpError() << "can't be simulated";
+    }
+    Cycles cycles = getOpCycles(op, sim.model);
+    cycle += cycles;
+    busyCycles += cycles;
+    ++frame.it;
+  }
+  frames.clear();
+  finishedAt = cycle;
+  return success();
+}
+
+/// A tile DMA channel walking its chain of buffer descriptors.
+class DmaChannelActor : public Actor {
+ public:
+  DmaChannelActor(ArraySimulator &sim, DMAStartOp dmaStartOp,
+                  DmaChannel dmaChannel)
+      : Actor(sim, dmaStartOp, stringify(dmaChannel)),
+        dmaChannel(dmaChannel),
+        block(dmaStartOp.getDest()),
+        it(block->begin()) {}
+
+  LogicalResult resume() override;
+
+ private:
+  DmaChannel dmaChannel;
+  Block *block;
+  Block::iterator it;
+  /// The bytes of the current buffer descriptor which are still to transfer.
+  std::optional<int64_t> remainingBytes;
+  /// The size of the chunk of the current buffer descriptor in transfer.
+  int64_t chunkBytes = 0;
+  /// The cycle from which the channel is ready to transfer the next bytes.
+  Cycles readyAt = 0;
+};
+
+LogicalResult DmaChannelActor::resume() {
+  const AIEPerformanceModel &model = sim.model;
+  while (true) {
+    if (failed(sim.step())) return failure();
+    Operation *op = &*it;
+    if (auto useLockOp = dyn_cast<UseLockOp>(op)) {
+      FailureOr<LockOp> lockOp = getLockOp(useLockOp);
+      if (failed(lockOp)) return failure();
+      if (useLockOp.getAction() == LockAction::Release) {
+        sim.release(lockOp.value(), useLockOp);
+      } else if (!sim.tryAcquire(lockOp.value(), useLockOp, this)) {
+        return success();
+      }
+      ++it;
+      continue;
+    }
+    if (auto dmaBdOp = dyn_cast<DMABDOp>(op)) {
+      if (!remainingBytes) {
+        remainingBytes = dmaBdOp.getLenInBytes();
+        readyAt = sim.now();
+      }
+      if (dmaChannel.dir == DMAChannelDir::MM2S) {
+        // Send the chunk completed since the last resume and start the next.
+        if (chunkBytes > 0) {
+          sim.send(dmaChannel, chunkBytes);
+          *remainingBytes -= chunkBytes;
+          chunkBytes = 0;
+        }
+        if (*remainingBytes > 0) {
+          chunkBytes = std::min(*remainingBytes, model.streamChunkBytes);
+          Cycles cycles =
+              llvm::divideCeil(chunkBytes, model.streamBytesPerCycle);
+          busyCycles += cycles;
+          sim.resumeAt(sim.now() + cycles, this);
+          return success();
+        }
+      } else if (*remainingBytes > 0) {
+        ArraySimulator::Pipe &pipe = sim.getPipe(dmaChannel);
+        if (pipe.bytes == 0) {
+          pipe.waiters.push_back(this);
+          return success();
+        }
+        int64_t bytes = std::min(*remainingBytes, pipe.bytes);
+        pipe.bytes -= bytes;
+        *remainingBytes -= bytes;
+        Cycles cycles = llvm::divideCeil(bytes, model.streamBytesPerCycle);
+        busyCycles += cycles;
+        readyAt = std::max(readyAt + cycles, sim.now());
+        sim.resumeAt(readyAt, this);
+        return success();
+      }
+      remainingBytes = std::nullopt;
+      ++it;
+      continue;
+    }
+    if (auto nextBdOp = dyn_cast<NextBDOp>(op)) {
+      block = nextBdOp->getSuccessor(0);
+      it = block->begin();
+      continue;
+    }
+    if (isa<AIE::EndOp>(op)) {
+      finishedAt = sim.now();
+      return success();
+    }
+    ++it;
+  }
+}
+
+/// A shim DMA channel serving the transfers issued by the control program.
+class HostChannelActor : public Actor {
+ public:
+  HostChannelActor(ArraySimulator &sim, ShimDMAAllocationOp allocOp,
+                   DmaChannel dmaChannel, int64_t bytesPerCycle)
+      : Actor(sim, allocOp, stringify(dmaChannel)),
+        dmaChannel(dmaChannel),
+        bytesPerCycle(bytesPerCycle) {}
+
+  LogicalResult resume() override;
+
+  /// Append a transfer of `bytes` to the queue of the channel.
+  void enqueue(int64_t bytes) {
+    transfers.push_back(bytes);
+    if (isIdle) {
+      isIdle = false;
+      readyAt = sim.now();
+      sim.resumeAt(sim.now(), this);
+    }
+  }
+
+  /// Return whether all transfers issued so far are complete.
+  bool isDrained() const { return isIdle && transfers.empty(); }
+
+  WaitList drainWaiters;
+
+ private:
+  DmaChannel dmaChannel;
+  int64_t bytesPerCycle;
+  std::deque<int64_t> transfers;
+  bool isIdle = true;
+  int64_t chunkBytes = 0;
+  Cycles readyAt = 0;
+};
+
+LogicalResult HostChannelActor::resume() {
+  if (failed(sim.step())) return failure();
+  if (chunkBytes > 0) {
+    if (dmaChannel.dir == DMAChannelDir::MM2S) sim.send(dmaChannel, chunkBytes);
+    transfers.front() -= chunkBytes;
+    chunkBytes = 0;
+    if (transfers.front() == 0) transfers.pop_front();
+  }
+  if (transfers.empty()) {
+    isIdle = true;
+    sim.notify(drainWaiters);
+    return success();
+  }
+  if (dmaChannel.dir == DMAChannelDir::MM2S) {
+    chunkBytes = std::min(transfers.front(), sim.model.streamChunkBytes);
+    Cycles cycles = llvm::divideCeil(chunkBytes, bytesPerCycle);
+    busyCycles += cycles;
+    sim.resumeAt(sim.now() + cycles, this);
+    return success();
+  }
+  ArraySimulator::Pipe &pipe = sim.getPipe(dmaChannel);
+  if (pipe.bytes == 0) {
+    pipe.waiters.push_back(this);
+    return success();
+  }
+  chunkBytes = std::min(transfers.front(), pipe.bytes);
+  pipe.bytes -= chunkBytes;
+  Cycles cycles = llvm::divideCeil(chunkBytes, bytesPerCycle);
+  busyCycles += cycles;
+  readyAt = std::max(readyAt + cycles, sim.now());
+  sim.resumeAt(readyAt, this);
+  return success();
+}
+
+/// The NPU control program issuing shim DMA transfers and waiting for them.
+class ControlActor : public Actor {
+ public:
+  ControlActor(ArraySimulator &sim, func::FuncOp funcOp,
+               std::map<StringRef, HostChannelActor *> channels)
+      : Actor(sim, funcOp, "control program"),
+        it(funcOp.getBody().front().begin()),
+        channels(std::move(channels)) {}
+
+  LogicalResult resume() override;
+
+ private:
+  FailureOr<HostChannelActor *> getChannel(Operation *op, StringRef symbol) {
+    auto channelIt = channels.find(symbol);
+    if (channelIt == channels.end()) {
+      return op->emitOpError()
+             << "refers to @" << symbol
+             << ", which isn't a shim DMA channel driven by the control "
+                "program";
+    }
+    return channelIt->second;
+  }
+
+  Block::iterator it;
+  std::map<StringRef, HostChannelActor *> channels;
+  /// Whether the transfer of the current op has been issued already.
+  bool isIssued = false;
+};
+
+LogicalResult ControlActor::resume() {
+  while (true) {
+    if (failed(sim.step())) return failure();
+    Operation *op = &*it;
+    if (auto memcpyOp = dyn_cast<AIEX::NpuDmaMemcpyNdOp>(op)) {
+      // Issuing a transfer takes time before the channel can start on it.
+      if (!isIssued) {
+        isIssued = true;
+        busyCycles += sim.model.shimIssueCycles;
+        sim.resumeAt(sim.now() + sim.model.shimIssueCycles, this);
+        return success();
+      }
+      isIssued = false;
+      FailureOr<HostChannelActor *> channel =
+          getChannel(op, memcpyOp.getMetadata());
+      if (failed(channel)) return failure();
+      int64_t bytes =
+          memcpyOp.getMemref().getType().getElementTypeBitWidth() / 8;
+      for (OpFoldResult size : memcpyOp.getMixedSizes()) {
+        std::optional<int64_t> constantSize = getConstantIntValue(size);
+        if (!constantSize) {
+          return op->emitOpError()
+                 << "needs constant sizes to be simulated";
+        }
+        bytes *= constantSize.value();
+      }
+      channel.value()->enqueue(bytes);
+      ++it;
+      continue;
+    }
+    if (auto waitOp = dyn_cast<AIEX::NpuDmaWaitOp>(op)) {
+      FailureOr<HostChannelActor *> channel =
+          getChannel(op, waitOp.getSymbol());
+      if (failed(channel)) return failure();
+      if (!channel.value()->isDrained()) {
+        channel.value()->drainWaiters.push_back(this);
+        return success();
+      }
+      ++it;
+      continue;
+    }
+    if (isa<func::ReturnOp>(op)) {
+      finishedAt = sim.now();
+      return success();
+    }
+    if (op->getNumRegions() > 0) {
+      return op->emitOpError() << "can't be simulated in the control program";
+    }
+    ++it;
+  }
+}
+
+LogicalResult ArraySimulator::createActors() {
+  for (LockOp lockOp : deviceOp.getOps<LockOp>())
+    locks[lockOp] = {lockOp.getInit().value_or(0), {}};
+  connections = getStreamConnections(deviceOp);
+
+  for (CoreOp coreOp : deviceOp.getOps<CoreOp>()) {
+    TileID tile = getTileID(coreOp.getTile());
+    std::string name;
+    llvm::raw_string_ostream os(name);
+    os << "core (" << tile.col << ", " << tile.row << ")";
+    actors.push_back(std::make_unique<CoreActor>(*this, coreOp, os.str()));
+  }
+
+  // Channels driven by buffer descriptors in the array.
+  std::set<DmaChannel> bdChannels;
+  deviceOp.walk([&](DMAStartOp dmaStartOp) {
+    auto tileElement = cast<TileElement>(dmaStartOp->getParentOp());
+    DmaChannel dmaChannel{tileElement.getTileID(), dmaStartOp.getChannelDir(),
+                          dmaStartOp.getChannelIndex()};
+    bdChannels.insert(dmaChannel);
+    actors.push_back(
+        std::make_unique<DmaChannelActor>(*this, dmaStartOp, dmaChannel));
+  });
+
+  // Channels driven by the control program, which share the bandwidth to DDR.
+  SmallVector<std::pair<ShimDMAAllocationOp, DmaChannel>> hostChannels;
+  for (ShimDMAAllocationOp allocOp : deviceOp.getOps<ShimDMAAllocationOp>()) {
+    DmaChannel dmaChannel{{static_cast<int>(allocOp.getCol()), 0},
+                          allocOp.getChannelDir(),
+                          static_cast<int>(allocOp.getChannelIndex())};
+    if (!bdChannels.count(dmaChannel))
+      hostChannels.push_back({allocOp, dmaChannel});
+  }
+  std::map<StringRef, HostChannelActor *> channelsBySymbol;
+  if (!hostChannels.empty()) {
+    int64_t bytesPerCycle = std::max<int64_t>(
+        1, std::min(model.streamBytesPerCycle,
+                    model.ddrBytesPerCycle /
+                        static_cast<int64_t>(hostChannels.size())));
+    for (auto &[allocOp, dmaChannel] : hostChannels) {
+      auto actor = std::make_unique<HostChannelActor>(*this, allocOp,
+                                                      dmaChannel, bytesPerCycle);
+      channelsBySymbol[allocOp.getSymName()] = actor.get();
+      actors.push_back(std::move(actor));
+    }
+  }
+
+  for (func::FuncOp funcOp : deviceOp.getOps<func::FuncOp>()) {
+    bool isControlProgram = false;
+    funcOp.walk([&](Operation *op) {
+      if (isa<AIEX::NpuDmaMemcpyNdOp, AIEX::NpuDmaWaitOp>(op))
+        isControlProgram = true;
+    });
+    if (!isControlProgram) continue;
+    if (controlActor) {
+      return funcOp.emitOpError()
+             << "is a second control program, which isn't supported";
+    }
+    auto actor =
+        std::make_unique<ControlActor>(*this, funcOp, channelsBySymbol);
+    controlActor = actor.get();
+    actors.push_back(std::move(actor));
+  }
+
+  for (std::unique_ptr<Actor> &actor : actors) {
+    // Host channels only start once the control program issues a transfer.
+    if (isa<ShimDMAAllocationOp>(actor->op)) continue;
+    resumeAt(0, actor.get());
+  }
+  return success();
+}
+
+FailureOr<AIEPerformanceEstimate> ArraySimulator::run() {
+  if (failed(createActors())) return failure();
+  while (!events.empty()) {
+    // The program is complete once the control program is.
+    if (controlActor && controlActor->finishedAt) break;
+    Event event = events.top();
+    events.pop();
+    currentCycle = event.cycle;
+    if (failed(event.fn())) return failure();
+  }
+
+  AIEPerformanceEstimate estimate;
+  SmallVector<Actor *> blocked;
+  for (std::unique_ptr<Actor> &actor : actors) {
+    if (isa<CoreOp>(actor->op) && !actor->finishedAt) {
+      blocked.push_back(actor.get());
+    }
+  }
+  if (controlActor) {
+    if (!controlActor->finishedAt) {
+      blocked.insert(blocked.begin(), controlActor);
+    } else {
+      // Cores may loop forever once the control program is done.
+      blocked.clear();
+    }
+  }
+  if (!blocked.empty()) {
+    InFlightDiagnostic diag = deviceOp.emitOpError()
+                              << "deadlocks at cycle " << currentCycle;
+    for (Actor *actor : blocked)
+      diag.attachNote(actor->op->getLoc()) << actor->name << " is waiting";
+    return diag;
+  }
+  for (std::unique_ptr<Actor> &actor : actors) {
+    if (actor->finishedAt) {
+      estimate.totalCycles =
+          std::max(estimate.totalCycles, actor->finishedAt.value());
+    }
+  }
+  if (controlActor) estimate.totalCycles = controlActor->finishedAt.value();
+  for (std::unique_ptr<Actor> &actor : actors) {
+    if (actor.get() == controlActor) continue;
+    estimate.resources.push_back({actor->name, actor->op, actor->busyCycles});
+  }
+  return estimate;
+}
+
+struct AIESimulatePerformancePass
+    : public PassWrapper<AIESimulatePerformancePass,
+                         OperationPass<DeviceOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(AIESimulatePerformancePass)
+
+  AIESimulatePerformancePass() = default;
+  AIESimulatePerformancePass(const AIESimulatePerformancePass &pass)
+      : PassWrapper(pass) {}
+
+  StringRef getArgument() const override { return "aie-simulate-performance"; }
+
+  StringRef getDescription() const override {
+    return "Predict the cycles taken by the program of the device and the "
+           "utilization of its cores and DMA channels";
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<AIEDialect>();
+  }
+
+  void runOnOperation() override;
+
+  Option<int64_t> streamBytesPerCycle{
+      *this, "stream-bytes-per-cycle",
+      llvm::cl::desc("Bytes per cycle transferred by a DMA channel"),
+      llvm::cl::init(4)};
+  Option<int64_t> ddrBytesPerCycle{
+      *this, "ddr-bytes-per-cycle",
+      llvm::cl::desc(
+          "Bytes per cycle transferred from and to DDR by all shim DMA "
+          "channels together"),
+      llvm::cl::init(16)};
+  Option<int64_t> shimIssueCycles{
+      *this, "shim-issue-cycles",
+      llvm::cl::desc("Cycles for the control program to issue a transfer"),
+      llvm::cl::init(256)};
+  Option<int64_t> lockLatencyCycles{
+      *this, "lock-latency-cycles",
+      llvm::cl::desc("Cycles until a lock release is visible to other agents"),
+      llvm::cl::init(8)};
+  Option<int64_t> defaultCallCycles{
+      *this, "default-call-cycles",
+      llvm::cl::desc("Cycles charged for a call to a function without an "
+                     "`amdaie.estimated_cycles` annotation"),
+      llvm::cl::init(1000)};
+};
+
+void AIESimulatePerformancePass::runOnOperation() {
+  DeviceOp deviceOp = getOperation();
+  AIEPerformanceModel model;
+  model.streamBytesPerCycle = streamBytesPerCycle;
+  model.ddrBytesPerCycle = ddrBytesPerCycle;
+  model.shimIssueCycles = shimIssueCycles;
+  model.lockLatencyCycles = lockLatencyCycles;
+  model.defaultCallCycles = defaultCallCycles;
+  FailureOr<AIEPerformanceEstimate> estimate =
+      simulateAIEPerformance(deviceOp, model);
+  if (failed(estimate)) return signalPassFailure();
+
+  Cycles totalCycles = estimate->totalCycles;
+  deviceOp.emitRemark() << "predicted " << totalCycles << " cycles";
+  for (const AIEResourceUsage &usage : estimate->resources) {
+    int64_t percentage =
+        totalCycles > 0 ? usage.busyCycles * 100 / totalCycles : 0;
+    usage.op->emitRemark() << usage.name << " busy for " << usage.busyCycles
+                           << " cycles (" << percentage << "%)";
+  }
+}
+
+}  // namespace
+
+FailureOr<AIEPerformanceEstimate> simulateAIEPerformance(
+    DeviceOp deviceOp, const AIEPerformanceModel &model) {
+  ArraySimulator simulator(deviceOp, model);
+  return simulator.run();
+}
+
+std::unique_ptr<OperationPass<DeviceOp>> createAIESimulatePerformancePass() {
+  return std::make_unique<AIESimulatePerformancePass>();
+}
+
+void registerAIESimulatePerformance() {
+  mlir::registerPass([]() -> std::unique_ptr<mlir::Pass> {
+    return createAIESimulatePerformancePass();
+  });
+}
+
+}  // namespace mlir::iree_compiler::AMDAIE
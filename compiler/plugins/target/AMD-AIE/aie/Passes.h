@@ -64,6 +64,65 @@ struct TileID {
   int col, row;
 };
 
+/// Attribute on `aiex.npu.dma_memcpy_nd` operations, listing the sizes that are
+/// only known at dispatch time as functions of the push constants.
+inline constexpr llvm::StringLiteral kRuntimeSizesAttrName =
+    "amdaie.runtime_sizes";
+
+/// Attribute on NPU instruction operations, listing the instruction fields that
+/// are patched with values derived from the push constants at dispatch time.
+inline constexpr llvm::StringLiteral kRuntimePatchesAttrName =
+    "amdaie.runtime_patches";
+
+/// Attribute on `func.call` operations inside of cores, or on the functions
+/// they call, with the number of cycles a call is estimated to take.
+inline constexpr llvm::StringLiteral kEstimatedCyclesAttrName =
+    "amdaie.estimated_cycles";
+
+/// Attribute on `func.call` operations inside of cores, or on the functions
+/// they call, with the number of arithmetic operations a call performs.
+inline constexpr llvm::StringLiteral kEstimatedOpsAttrName =
+    "amdaie.estimated_ops";
+
+/// The parameters of the performance model of an AIE array.
+struct AIEPerformanceModel {
+  /// Bytes per cycle transferred by a DMA channel.
+  int64_t streamBytesPerCycle = 4;
+  /// Bytes per cycle transferred from and to DDR by all shim DMA channels
+  /// driven by the control program together.
+  int64_t ddrBytesPerCycle = 16;
+  /// Bytes after which data in transfer arrives at the receiving channels.
+  int64_t streamChunkBytes = 256;
+  /// Cycles for the control program to issue a shim DMA transfer.
+  int64_t shimIssueCycles = 256;
+  /// Cycles until a lock release is visible to other agents.
+  int64_t lockLatencyCycles = 8;
+  /// Cycles charged for a call without `kEstimatedCyclesAttrName`.
+  int64_t defaultCallCycles = 1000;
+  /// The number of simulation steps after which the simulation is aborted.
+  int64_t maxSteps = 1 << 24;
+};
+
+/// The time a core or DMA channel of the array is busy.
+struct AIEResourceUsage {
+  std::string name;
+  Operation *op;
+  int64_t busyCycles;
+};
+
+struct AIEPerformanceEstimate {
+  /// The cycles from the start of the control program until it completes, or
+  /// until all cores are done if there is no control program.
+  int64_t totalCycles = 0;
+  SmallVector<AIEResourceUsage> resources;
+};
+
+/// Predict the performance of the program of `deviceOp` with a discrete-event
+/// simulation of its cores, DMA channels and control program. Emits an error
+/// and returns failure if the program can't be simulated or deadlocks.
+FailureOr<AIEPerformanceEstimate> simulateAIEPerformance(
+    xilinx::AIE::DeviceOp deviceOp, const AIEPerformanceModel &model = {});
+
 std::unique_ptr<OperationPass<xilinx::AIE::DeviceOp>>
 createAIEAssignBufferAddressesBasicPass();
 std::unique_ptr<OperationPass<xilinx::AIE::DeviceOp>>
@@ -75,6 +134,8 @@ createAIELocalizeLocksPass();
 std::unique_ptr<OperationPass<xilinx::AIE::DeviceOp>>
 createAIEObjectFifoStatefulTransformPass();
 std::unique_ptr<OperationPass<xilinx::AIE::DeviceOp>> createAIEPathfinderPass();
+std::unique_ptr<OperationPass<xilinx::AIE::DeviceOp>>
+createAIESimulatePerformancePass();
 std::unique_ptr<OperationPass<ModuleOp>> createAIECoreToStandardPass();
 
 std::unique_ptr<OperationPass<xilinx::AIE::DeviceOp>> createAIEDmaToNpuPass();
@@ -87,6 +148,7 @@ void registerAIECoreToStandard();
 void registerAIELocalizeLocks();
 void registerAIEObjectFifoStatefulTransform();
 void registerAIERoutePathfinderFlows();
+void registerAIESimulatePerformance();
 
 void registerAIEDmaToNpu();
 void registerAIEXToStandardPass();
@@ -0,0 +1,76 @@
+// RUN: iree-opt --aie-report="npu-instruction-words=42" %s -o /dev/null | FileCheck %s
+
+// A core doubling a buffer in place, which is sent to DDR over a routed
+// connection from the DMA of its tile through the switchbox of the shim tile.
+
+// CHECK:      "cores": 1,
+// CHECK:      "tiles": [
+// CHECK:        "col": 0,
+// CHECK-NEXT:   "row": 0,
+// CHECK-NEXT:   "kind": "shim",
+// CHECK-NEXT:   "buffers": 0,
+// CHECK-NEXT:   "buffer_bytes": 0,
+// CHECK-NEXT:   "memory_bytes": 0,
+// CHECK-NEXT:   "locks": 0,
+// CHECK:        "bds": 0
+// CHECK:        "col": 0,
+// CHECK-NEXT:   "row": 2,
+// CHECK-NEXT:   "kind": "core",
+// CHECK-NEXT:   "buffers": 1,
+// CHECK-NEXT:   "buffer_bytes": 4352,
+// CHECK-NEXT:   "memory_bytes": 65536,
+// CHECK-NEXT:   "locks": 2,
+// CHECK:        "bds": 1
+// CHECK:      "l1_bytes": 4352,
+// CHECK-NEXT: "l2_bytes": 0,
+// CHECK-NEXT: "flows": 1,
+// CHECK-NEXT: "max_channel_utilization": {{[0-9.e+-]+}},
+// CHECK-NEXT: "busiest_channel": "South of switchbox (0, 2)",
+// CHECK-NEXT: "npu_instruction_words": 42,
+// CHECK-NEXT: "control_code_dmas": 1,
+// CHECK-NEXT: "ddr_bytes": 256,
+// CHECK-NEXT: "compute_ops": 4,
+// CHECK-NEXT: "arithmetic_intensity": 0.015625
+aie.device(npu1_4col) {
+  memref.global "public" @out : memref<64xi32>
+  %tile_0_0 = aie.tile(0, 0)
+  %tile_0_2 = aie.tile(0, 2)
+  %buff = aie.buffer(%tile_0_2) {address = 4096 : i32, sym_name = "buff"} : memref<64xi32>
+  %prod_lock = aie.lock(%tile_0_2, 0) {init = 1 : i32, sym_name = "prod_lock"}
+  %cons_lock = aie.lock(%tile_0_2, 1) {init = 0 : i32, sym_name = "cons_lock"}
+  %switchbox_0_2 = aie.switchbox(%tile_0_2) {
+    aie.connect<DMA : 0, South : 0>
+  }
+  %switchbox_0_0 = aie.switchbox(%tile_0_0) {
+    aie.connect<North : 0, South : 2>
+  }
+  %core_0_2 = aie.core(%tile_0_2) {
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %c4 = arith.constant 4 : index
+    aie.use_lock(%prod_lock, AcquireGreaterEqual, 1)
+    scf.for %arg0 = %c0 to %c4 step %c1 {
+      %0 = memref.load %buff[%arg0] : memref<64xi32>
+      %1 = arith.addi %0, %0 : i32
+      memref.store %1, %buff[%arg0] : memref<64xi32>
+    }
+    aie.use_lock(%cons_lock, Release, 1)
+    aie.end
+  }
+  %mem_0_2 = aie.mem(%tile_0_2) {
+    %0 = aie.dma_start(MM2S, 0, ^bb1, ^bb2)
+  ^bb1:
+    aie.use_lock(%cons_lock, AcquireGreaterEqual, 1)
+    aie.dma_bd(%buff : memref<64xi32>, 0, 64)
+    aie.use_lock(%prod_lock, Release, 1)
+    aie.next_bd ^bb1
+  ^bb2:
+    aie.end
+  }
+  aie.shim_dma_allocation @out(S2MM, 0, 0)
+  func.func @sequence(%arg0: memref<64xi32>) {
+    aiex.npu.dma_memcpy_nd(0, 0, %arg0[0, 0, 0, 0][1, 1, 1, 64][0, 0, 0]) {id = 0 : i64, metadata = @out} : memref<64xi32>
+    aiex.npu.dma_wait {symbol = @out}
+    return
+  }
+}
@@ -0,0 +1,142 @@
+// RUN: iree-opt --split-input-file --aie-simulate-performance="shim-issue-cycles=10 lock-latency-cycles=1 default-call-cycles=20" --verify-diagnostics %s
+
+// A core applying a kernel to two buffers streamed in from and back to DDR.
+// The input of the second iteration arrives while the core works on the first
+// one and the output of the first iteration is sent while the core works on the
+// second one.
+
+// expected-remark @+1 {{predicted 406 cycles}}
+aie.device(npu1_4col) {
+  memref.global "public" @in : memref<64xi32>
+  memref.global "public" @out : memref<64xi32>
+  %tile_0_0 = aie.tile(0, 0)
+  %tile_0_2 = aie.tile(0, 2)
+  %in_buff = aie.buffer(%tile_0_2) {sym_name = "in_buff"} : memref<64xi32>
+  %out_buff = aie.buffer(%tile_0_2) {sym_name = "out_buff"} : memref<64xi32>
+  %in_prod_lock = aie.lock(%tile_0_2, 0) {init = 1 : i32, sym_name = "in_prod_lock"}
+  %in_cons_lock = aie.lock(%tile_0_2, 1) {init = 0 : i32, sym_name = "in_cons_lock"}
+  %out_prod_lock = aie.lock(%tile_0_2, 2) {init = 1 : i32, sym_name = "out_prod_lock"}
+  %out_cons_lock = aie.lock(%tile_0_2, 3) {init = 0 : i32, sym_name = "out_cons_lock"}
+  aie.flow(%tile_0_0, DMA : 0, %tile_0_2, DMA : 0)
+  aie.flow(%tile_0_2, DMA : 0, %tile_0_0, DMA : 0)
+  func.func private @kernel(memref<64xi32>, memref<64xi32>) attributes {amdaie.estimated_cycles = 100 : i64}
+  // expected-remark @+1 {{core (0, 2) busy for 200 cycles (49%)}}
+  %core_0_2 = aie.core(%tile_0_2) {
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %c2 = arith.constant 2 : index
+    scf.for %arg0 = %c0 to %c2 step %c1 {
+      aie.use_lock(%in_cons_lock, AcquireGreaterEqual, 1)
+      aie.use_lock(%out_prod_lock, AcquireGreaterEqual, 1)
+      func.call @kernel(%in_buff, %out_buff) : (memref<64xi32>, memref<64xi32>) -> ()
+      aie.use_lock(%in_prod_lock, Release, 1)
+      aie.use_lock(%out_cons_lock, Release, 1)
+    }
+    aie.end
+  }
+  %mem_0_2 = aie.mem(%tile_0_2) {
+    // expected-remark @+1 {{S2MM channel 0 of tile (0, 2) busy for 128 cycles (31%)}}
+    %0 = aie.dma_start(S2MM, 0, ^bb1, ^bb2)
+  ^bb1:
+    aie.use_lock(%in_prod_lock, AcquireGreaterEqual, 1)
+    aie.dma_bd(%in_buff : memref<64xi32>, 0, 64)
+    aie.use_lock(%in_cons_lock, Release, 1)
+    aie.next_bd ^bb1
+  ^bb2:
+    // expected-remark @+1 {{MM2S channel 0 of tile (0, 2) busy for 128 cycles (31%)}}
+    %1 = aie.dma_start(MM2S, 0, ^bb3, ^bb4)
+  ^bb3:
+    aie.use_lock(%out_cons_lock, AcquireGreaterEqual, 1)
+    aie.dma_bd(%out_buff : memref<64xi32>, 0, 64)
+    aie.use_lock(%out_prod_lock, Release, 1)
+    aie.next_bd ^bb3
+  ^bb4:
+    aie.end
+  }
+  // expected-remark @+1 {{MM2S channel 0 of tile (0, 0) busy for 128 cycles (31%)}}
+  aie.shim_dma_allocation @in(MM2S, 0, 0)
+  // expected-remark @+1 {{S2MM channel 0 of tile (0, 0) busy for 128 cycles (31%)}}
+  aie.shim_dma_allocation @out(S2MM, 0, 0)
+  func.func @sequence(%arg0: memref<128xi32>, %arg1: memref<128xi32>) {
+    aiex.npu.dma_memcpy_nd(0, 0, %arg0[0, 0, 0, 0][1, 1, 1, 128][0, 0, 0]) {id = 0 : i64, metadata = @in} : memref<128xi32>
+    aiex.npu.dma_memcpy_nd(0, 0, %arg1[0, 0, 0, 0][1, 1, 1, 128][0, 0, 0]) {id = 1 : i64, metadata = @out} : memref<128xi32>
+    aiex.npu.dma_wait {symbol = @out}
+    return
+  }
+}
+
+// -----
+
+// Once routed, the stream connections are traced through the switchboxes.
+// Without a control program, the program is complete once all cores are.
+
+// expected-remark @+1 {{predicted 136 cycles}}
+aie.device(npu1_4col) {
+  %tile_0_2 = aie.tile(0, 2)
+  %tile_0_3 = aie.tile(0, 3)
+  %buff_0_2 = aie.buffer(%tile_0_2) {sym_name = "buff_0_2"} : memref<64xi32>
+  %buff_0_3 = aie.buffer(%tile_0_3) {sym_name = "buff_0_3"} : memref<64xi32>
+  %prod_lock_0_2 = aie.lock(%tile_0_2, 0) {init = 1 : i32, sym_name = "prod_lock_0_2"}
+  %cons_lock_0_2 = aie.lock(%tile_0_2, 1) {init = 0 : i32, sym_name = "cons_lock_0_2"}
+  %prod_lock_0_3 = aie.lock(%tile_0_3, 0) {init = 1 : i32, sym_name = "prod_lock_0_3"}
+  %cons_lock_0_3 = aie.lock(%tile_0_3, 1) {init = 0 : i32, sym_name = "cons_lock_0_3"}
+  %switchbox_0_2 = aie.switchbox(%tile_0_2) {
+    aie.connect<DMA : 0, North : 0>
+  }
+  %switchbox_0_3 = aie.switchbox(%tile_0_3) {
+    aie.connect<South : 0, DMA : 0>
+  }
+  func.func private @produce(memref<64xi32>)
+  func.func private @consume(memref<64xi32>)
+  // expected-remark @+1 {{core (0, 2) busy for 50 cycles (36%)}}
+  %core_0_2 = aie.core(%tile_0_2) {
+    aie.use_lock(%prod_lock_0_2, AcquireGreaterEqual, 1)
+    func.call @produce(%buff_0_2) {amdaie.estimated_cycles = 50 : i64} : (memref<64xi32>) -> ()
+    aie.use_lock(%cons_lock_0_2, Release, 1)
+    aie.end
+  }
+  // expected-remark @+1 {{core (0, 3) busy for 20 cycles (14%)}}
+  %core_0_3 = aie.core(%tile_0_3) {
+    aie.use_lock(%cons_lock_0_3, AcquireGreaterEqual, 1)
+    func.call @consume(%buff_0_3) : (memref<64xi32>) -> ()
+    aie.use_lock(%prod_lock_0_3, Release, 1)
+    aie.end
+  }
+  %mem_0_2 = aie.mem(%tile_0_2) {
+    // expected-remark @+1 {{MM2S channel 0 of tile (0, 2) busy for 64 cycles (47%)}}
+    %0 = aie.dma_start(MM2S, 0, ^bb1, ^bb2)
+  ^bb1:
+    aie.use_lock(%cons_lock_0_2, AcquireGreaterEqual, 1)
+    aie.dma_bd(%buff_0_2 : memref<64xi32>, 0, 64)
+    aie.use_lock(%prod_lock_0_2, Release, 1)
+    aie.next_bd ^bb1
+  ^bb2:
+    aie.end
+  }
+  %mem_0_3 = aie.mem(%tile_0_3) {
+    // expected-remark @+1 {{S2MM channel 0 of tile (0, 3) busy for 64 cycles (47%)}}
+    %0 = aie.dma_start(S2MM, 0, ^bb1, ^bb2)
+  ^bb1:
+    aie.use_lock(%prod_lock_0_3, AcquireGreaterEqual, 1)
+    aie.dma_bd(%buff_0_3 : memref<64xi32>, 0, 64)
+    aie.use_lock(%cons_lock_0_3, Release, 1)
+    aie.next_bd ^bb1
+  ^bb2:
+    aie.end
+  }
+}
+
+// -----
+
+// A core waiting for a lock which is never released.
+
+// expected-error @+1 {{deadlocks at cycle 0}}
+aie.device(npu1_4col) {
+  %tile_0_2 = aie.tile(0, 2)
+  %lock_0_2 = aie.lock(%tile_0_2, 0) {init = 0 : i32, sym_name = "lock_0_2"}
+  // expected-note @+1 {{core (0, 2) is waiting}}
+  %core_0_2 = aie.core(%tile_0_2) {
+    aie.use_lock(%lock_0_2, AcquireGreaterEqual, 1)
+    aie.end
+  }
+}
@@ -24,7 +24,9 @@ extern void registerAIEAssignLockIDs();
 extern void registerAIECoreToStandard();
 extern void registerAIELocalizeLocks();
 extern void registerAIEObjectFifoStatefulTransform();
+extern void registerAIEReport();
 extern void registerAIERoutePathfinderFlows();
+extern void registerAIESimulatePerformance();
 extern void registerAIEDmaToNpu();
 extern void registerAIEXToStandardPass();
 }  // namespace AMDAIE
@@ -42,7 +44,9 @@ struct AMDAIESession
     AMDAIE::registerAIECoreToStandard();
     AMDAIE::registerAIELocalizeLocks();
     AMDAIE::registerAIEObjectFifoStatefulTransform();
+    AMDAIE::registerAIEReport();
     AMDAIE::registerAIERoutePathfinderFlows();
+    AMDAIE::registerAIESimulatePerformance();
     AMDAIE::registerAIEDmaToNpu();
     AMDAIE::registerAIEXToStandardPass();
     AMDAIE::registerAIRConversionPasses();
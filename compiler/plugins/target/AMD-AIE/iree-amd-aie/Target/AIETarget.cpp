@@ -13,17 +13,22 @@
 #include "air/Dialect/AIR/AIRDialect.h"
 #include "air/Dialect/AIRRt/AIRRtDialect.h"
 #include "iree-amd-aie/IR/AMDAIEDialect.h"
+#include "iree-amd-aie/Target/AIETargets.h"
+#include "iree-amd-aie/Target/XCLBinGen.h"
 #include "iree-amd-aie/Transforms/Passes.h"
+#include "iree-amd-aie/UKernels/UKernelRegistry.h"
 #include "iree/compiler/Codegen/Dialect/Codegen/IR/IREECodegenDialect.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Dialect/LinalgExt/IR/LinalgExtDialect.h"
 #include "iree/compiler/Utils/FlatbufferUtils.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "mlir/Dialect/Transform/IR/TransformDialect.h"
+#include "mlir/Pass/PassManager.h"
 #include "mlir/Support/FileUtilities.h"
 #include "runtime/plugins/AMD-AIE/iree-amd-aie/schemas/xrt_executable_def_builder.h"
 
@@ -76,6 +81,27 @@ static xilinx::AIE::DeviceOp getDeviceOpFromEntryPoint(ModuleOp moduleOp,
   return deviceOp;
 }
 
+// Writes the resource and performance report of `deviceOp` to
+// `<reportDir>/<entryPointName>.report.json`. The `aie2xclbin` tool expects the
+// buffers, locks and BDs of `deviceOp` to be assigned and its flows routed by
+// the AIE device pass pipeline, so it is run on a copy of it to report on.
+static LogicalResult writeReport(xilinx::AIE::DeviceOp deviceOp,
+                                 StringRef reportDir, StringRef entryPointName,
+                                 int64_t numNPUInstructionWords) {
+  OwningOpRef<ModuleOp> reportModule = ModuleOp::create(deviceOp.getLoc());
+  reportModule->push_back(deviceOp.clone());
+  PassManager passManager(deviceOp.getContext(), ModuleOp::getOperationName());
+  xilinx::buildAIEDevicePassPipeline(
+      passManager.nest<xilinx::AIE::DeviceOp>());
+  if (failed(passManager.run(*reportModule))) {
+    return deviceOp.emitOpError()
+           << "failed to assign resources for the report of "
+           << entryPointName;
+  }
+  return writeAIEReport(*reportModule->getOps<xilinx::AIE::DeviceOp>().begin(),
+                        reportDir, entryPointName, numNPUInstructionWords);
+}
+
 class AIETargetDevice final : public IREE::HAL::TargetDevice {
  public:
   AIETargetDevice(const AMDAIEOptions &options) : options(options) {}
@@ -266,12 +292,19 @@ LogicalResult AIETargetBackend::serializeExecutable(
   SmallVector<std::string> entryPointNamesFb(ordinalCount);
   SmallVector<uint32_t> xclbinIndices(ordinalCount);
   SmallVector<uint32_t> asmInstrIndices(ordinalCount);
+  // Indices into `xclbinRefs` keyed by the digest of their array configuration.
+  llvm::StringMap<uint32_t> xclbinIndicesByDigest;
 
   for (size_t i = 0; i < entryPointNames.size(); i++) {
     uint64_t ordinal = entryPointOrdinals.at(entryPointNames[i]);
 
     entryPointNamesFb[ordinal] = entryPointNames[i];
 
+    // Resolve microkernel object files which aren't provided on disk to the
+    // microkernel library bundled with the compiler.
+    if (failed(materializeBundledUKernels(deviceOps[i], "AIE2", workDir)))
+      return failure();
+
     SmallString<128> inputMlirPath(workDir);
     llvm::sys::path::append(inputMlirPath,
                             entryPointNamesFb[ordinal] + ".aiecc.mlir");
@@ -370,8 +403,28 @@ LogicalResult AIETargetBackend::serializeExecutable(
     }
     auto npuInstrsVec = builder.createInt32Vec(npuInstrs);
     asmInstrIndices[ordinal] = asmInstrRefs.size();
-    asmInstrRefs.push_back(
-        iree_amd_aie_hal_xrt_AsmInstDef_create(builder, npuInstrsVec));
+    // Instructions generated by the external tool don't have runtime patches.
+    asmInstrRefs.push_back(iree_amd_aie_hal_xrt_AsmInstDef_create(
+        builder, npuInstrsVec, /*patches=*/0));
+
+    if (!options.reportDir.empty() &&
+        failed(writeReport(deviceOps[i], options.reportDir,
+                           entryPointNamesFb[ordinal], npuInstrs.size()))) {
+      return failure();
+    }
+
+    // Entry points with the same array configuration share an xclbin and only
+    // differ in their NPU instructions.
+    FailureOr<std::string> arrayConfigDigest =
+        computeArrayConfigDigest(entryPointWorkDir);
+    if (succeeded(arrayConfigDigest)) {
+      auto it = xclbinIndicesByDigest.find(*arrayConfigDigest);
+      if (it != xclbinIndicesByDigest.end()) {
+        xclbinIndices[ordinal] = it->second;
+        continue;
+      }
+      xclbinIndicesByDigest[*arrayConfigDigest] = xclbinRefs.size();
+    }
 
     xclbinIn = openInputFile(xclbinPath, &errorMessage);
     if (!xclbinIn) {
@@ -47,6 +47,10 @@ struct AMDAIEOptions {
   // Print MLIR timing summary for the MLIR passes in aie2xclbin.
   bool aie2xclbinTiming{false};
 
+  // Directory to write a JSON report of the resources and predicted
+  // performance of every dispatch to. No reports are written if empty.
+  std::string reportDir;
+
  public:
   void bindOptions(OptionsBinder &binder) {
     static llvm::cl::OptionCategory category("AMD AIE Options");
@@ -102,6 +106,12 @@ struct AMDAIEOptions {
     binder.opt<bool>("iree-amd-aie-enable-chess", useChess,
                      llvm::cl::cat(category),
                      llvm::cl::desc("Use the legacy chess compiler"));
+
+    binder.opt<std::string>(
+        "iree-amd-aie-report-dir", reportDir, llvm::cl::cat(category),
+        llvm::cl::desc("Directory to write a JSON report of the resources "
+                       "used by every dispatch and of its predicted "
+                       "performance to"));
   }
 };
 
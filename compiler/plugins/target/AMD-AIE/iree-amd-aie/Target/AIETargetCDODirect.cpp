@@ -12,6 +12,7 @@ extern "C" {
 }
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstddef>  // size_t
 #include <cstdint>  // uint
@@ -25,10 +26,16 @@ extern "C" {
 #include "aie/Dialect/AIE/IR/AIEDialect.h"
 #include "aie/Dialect/AIE/IR/AIEEnums.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA256.h"
 #include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/BuiltinTypeInterfaces.h"
@@ -782,4 +789,44 @@ LogicalResult AIETranslateToCDODirect(ModuleOp m, llvm::StringRef workDirPath,
   return AIETranslateToCDODirect(m, workDirPath, endianness, emitUnified,
                                  cdoDebug, aieSim, xaieDebug, enableCores);
 }
+
+FailureOr<std::string> computeArrayConfigDigest(llvm::StringRef workDirPath) {
+  SmallVector<std::string> paths;
+  for (StringRef cdoName :
+       {"aie_cdo_elfs.bin", "aie_cdo_init.bin", "aie_cdo_enable.bin"}) {
+    SmallString<128> cdoPath(workDirPath);
+    llvm::sys::path::append(cdoPath, cdoName);
+    if (!llvm::sys::fs::exists(cdoPath)) return failure();
+    paths.push_back(std::string(cdoPath));
+  }
+  // The core ELFs are also loaded by aie_cdo_elfs.bin, but hash them on their
+  // own in case the ELF loading ever moves out of the CDOs.
+  SmallVector<std::string> elfPaths;
+  std::error_code ec;
+  for (llvm::sys::fs::directory_iterator it(workDirPath, ec), end;
+       it != end && !ec; it.increment(ec)) {
+    StringRef fileName = llvm::sys::path::filename(it->path());
+    if (fileName.starts_with("core_") && fileName.ends_with(".elf"))
+      elfPaths.push_back(it->path());
+  }
+  if (ec) return failure();
+  llvm::sort(elfPaths);
+  paths.append(elfPaths.begin(), elfPaths.end());
+
+  llvm::SHA256 hasher;
+  for (const std::string &path : paths) {
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) return failure();
+    // Hash the file names rather than the paths, which differ between entry
+    // points, and the sizes so that the file boundaries are unambiguous.
+    StringRef fileName = llvm::sys::path::filename(path);
+    uint64_t size = (*buffer)->getBufferSize();
+    hasher.update(fileName);
+    hasher.update(ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(&size),
+                                    sizeof(size)));
+    hasher.update((*buffer)->getBuffer());
+  }
+  std::array<uint8_t, 32> digest = hasher.final();
+  return llvm::toHex(digest);
+}
 }  // namespace mlir::iree_compiler::AMDAIE
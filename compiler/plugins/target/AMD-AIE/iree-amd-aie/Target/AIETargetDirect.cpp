@@ -7,7 +7,9 @@
 #include "AIETargetDirect.h"
 
 #include <fstream>
+#include <limits>
 
+#include "AIETargets.h"
 #include "XCLBinGen.h"
 #include "aie/Dialect/AIE/IR/AIEDialect.h"
 #include "aie/Dialect/AIEVec/IR/AIEVecDialect.h"
@@ -17,11 +19,13 @@
 #include "aie/Target/LLVMIR/Dialect/XLLVM/XLLVMToLLVMIRTranslation.h"
 #include "iree-amd-aie/IR/AMDAIEDialect.h"
 #include "iree-amd-aie/Transforms/Passes.h"
+#include "iree-amd-aie/UKernels/UKernelRegistry.h"
 #include "iree-dialects/Dialect/LinalgTransform/Passes.h"
 #include "iree/compiler/Codegen/Dialect/Codegen/IR/IREECodegenDialect.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Dialect/LinalgExt/IR/LinalgExtDialect.h"
 #include "iree/compiler/Utils/FlatbufferUtils.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
@@ -179,13 +183,8 @@ class AIETargetDirectBackend final : public IREE::HAL::TargetBackend {
       IREE::HAL::ExecutableTargetAttr,
       OpPassManager &variantPassManager) override {
     OpPassManager &modulePassManager = variantPassManager.nest<ModuleOp>();
-    auto &devicePassMan = modulePassManager.nest<xilinx::AIE::DeviceOp>();
-    devicePassMan.addPass(createAIEObjectFifoStatefulTransformPass());
-    devicePassMan.addPass(createAIEAssignBufferAddressesBasicPass());
-    devicePassMan.addPass(createAIEAssignLockIDsPass());
-    devicePassMan.addPass(createAIEAssignBufferDescriptorIDsPass());
-    devicePassMan.addPass(createAIEPathfinderPass());
-    devicePassMan.addPass(createAIELocalizeLocksPass());
+    xilinx::buildAIEDevicePassPipeline(
+        modulePassManager.nest<xilinx::AIE::DeviceOp>());
   }
 
   void buildLinkingPassPipeline(OpPassManager &passManager) override {
@@ -300,12 +299,19 @@ LogicalResult AIETargetDirectBackend::serializeExecutable(
   SmallVector<std::string> entryPointNamesFb(ordinalCount);
   SmallVector<uint32_t> xclbinIndices(ordinalCount);
   SmallVector<uint32_t> asmInstrIndices(ordinalCount);
+  // Indices into `xclbinRefs` keyed by the digest of their array configuration.
+  llvm::StringMap<uint32_t> xclbinIndicesByDigest;
 
   for (size_t i = 0; i < entryPointNames.size(); i++) {
     uint64_t ordinal = entryPointOrdinals.at(entryPointNames[i]);
 
     entryPointNamesFb[ordinal] = entryPointNames[i];
 
+    // Resolve microkernel object files which aren't provided on disk to the
+    // microkernel library bundled with the compiler.
+    if (failed(materializeBundledUKernels(deviceOps[i], "AIE2", workDir)))
+      return failure();
+
     SmallString<128> inputMlirPath(workDir);
     llvm::sys::path::append(inputMlirPath,
                             entryPointNamesFb[ordinal] + ".aiecc.mlir");
@@ -372,9 +378,67 @@ LogicalResult AIETargetDirectBackend::serializeExecutable(
       npuInstrs.push_back(a);
     }
     auto npuInstrsVec = builder.createInt32Vec(npuInstrs);
+
+    // The translation pipeline already assigned the resources of the device,
+    // so the report is generated from it as is.
+    if (!options.reportDir.empty() &&
+        failed(writeAIEReport(deviceOps[i], options.reportDir,
+                              entryPointNamesFb[ordinal], npuInstrs.size()))) {
+      return failure();
+    }
+
+    // Sizes depending on push constants are patched into the instructions by
+    // the runtime before every dispatch.
+    std::vector<NPUInstructionPatch> npuPatches;
+    std::string npuPatchesPath =
+        (Twine(npuInstPath) + kNPUInstructionPatchesSuffix).str();
+    if (failed(readNPUInstructionPatches(npuPatchesPath, npuPatches))) {
+      return moduleOp.emitOpError("Unable to parse instruction patches file");
+    }
+    auto fitsInt32 = [](int64_t value) {
+      return value >= std::numeric_limits<int32_t>::min() &&
+             value <= std::numeric_limits<int32_t>::max();
+    };
+    std::vector<iree_amd_aie_hal_xrt_AsmInstPatchDef_t> patchDefs;
+    for (const NPUInstructionPatch &patch : npuPatches) {
+      if (!llvm::all_of(SmallVector<int64_t>{patch.multiplier, patch.addend,
+                                             patch.divisor, patch.scale,
+                                             patch.bias},
+                        fitsInt32)) {
+        return moduleOp.emitOpError("instruction patch coefficient overflow");
+      }
+      iree_amd_aie_hal_xrt_AsmInstPatchDef_t patchDef;
+      patchDef.word_index = patch.wordIndex;
+      patchDef.bit_offset = patch.bitOffset;
+      patchDef.bit_width = patch.bitWidth;
+      patchDef.constant_ordinal = patch.ordinal;
+      patchDef.multiplier = patch.multiplier;
+      patchDef.addend = patch.addend;
+      patchDef.divisor = patch.divisor;
+      patchDef.scale = patch.scale;
+      patchDef.bias = patch.bias;
+      patchDefs.push_back(patchDef);
+    }
+    iree_amd_aie_hal_xrt_AsmInstPatchDef_vec_ref_t npuPatchesVec =
+        patchDefs.empty() ? 0
+                          : iree_amd_aie_hal_xrt_AsmInstPatchDef_vec_create(
+                                builder, patchDefs.data(), patchDefs.size());
     asmInstrIndices[ordinal] = asmInstrRefs.size();
-    asmInstrRefs.push_back(
-        iree_amd_aie_hal_xrt_AsmInstDef_create(builder, npuInstrsVec));
+    asmInstrRefs.push_back(iree_amd_aie_hal_xrt_AsmInstDef_create(
+        builder, npuInstrsVec, npuPatchesVec));
+
+    // Entry points with the same array configuration share an xclbin and only
+    // differ in their NPU instructions.
+    FailureOr<std::string> arrayConfigDigest =
+        computeArrayConfigDigest(entryPointWorkDir);
+    if (succeeded(arrayConfigDigest)) {
+      auto it = xclbinIndicesByDigest.find(*arrayConfigDigest);
+      if (it != xclbinIndicesByDigest.end()) {
+        xclbinIndices[ordinal] = it->second;
+        continue;
+      }
+      xclbinIndicesByDigest[*arrayConfigDigest] = xclbinRefs.size();
+    }
 
     xclbinIn = openInputFile(xclbinPath, &errorMessage);
     if (!xclbinIn) {
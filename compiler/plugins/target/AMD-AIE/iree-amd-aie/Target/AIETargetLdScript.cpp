@@ -46,7 +46,7 @@ static void writeLDScriptMap(raw_ostream &output, BufferOp buf, int offset) {
 //      __init_array_end = .;
 //      __dtors_start__ = .;
 //      __dtors_end__ = .;
-//      *(.text)
+//      *(.text*)
 //   } > program
 //   .data : { *(.data) } > data
 //   . = 0x20000;
@@ -54,7 +54,7 @@ static void writeLDScriptMap(raw_ostream &output, BufferOp buf, int offset) {
 //   . = 0x24000;
 //   a = .;
 //   . += 1024;
-//   .bss : { *(.bss) } > data
+//   .bss : { *(.bss .bss.*) } > data
 // }
 LogicalResult mlir::iree_compiler::AMDAIE::AIETranslateToLdScript(
     ModuleOp module, raw_ostream &output, int tileCol, int tileRow) {
@@ -110,7 +110,7 @@ SECTIONS
      _init_array_end = .;
      _dtors_start = .;
      _dtors_end = .;
-     *(.text)
+     *(.text*)
   } > program
   .data : {
      *(.data*);
@@ -153,8 +153,10 @@ SECTIONS
       doBuffer(targetModel.getMemEast(srcCoord()),
                targetModel.getMemEastBaseAddress(), std::string("east"));
 
-      output << "  .bss : { *(.bss) } > data\n";
+      // The microkernels are compiled with -fdata-sections, so their
+      // zero-initialized data is in `.bss.<name>` sections.
       output << "  .bss.DMb.4 : { *(.bss.DMb.4) } > data\n";
+      output << "  .bss : { *(.bss .bss.*) } > data\n";
       output << "}\n";
       if (auto coreOp = tile.getCoreOp()) {
         if (auto fileAttr = coreOp.getLinkWith())
@@ -4,12 +4,16 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <fstream>
+#include <sstream>
 #include <vector>
 
 #include "AIETargets.h"
 #include "aie/Dialect/AIE/IR/AIEDialect.h"
 #include "aie/Dialect/AIEX/IR/AIEXDialect.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Format.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -19,6 +23,8 @@ using namespace mlir;
 using namespace xilinx;
 using namespace xilinx::AIE;
 using namespace xilinx::AIEX;
+using mlir::iree_compiler::AMDAIE::kRuntimePatchesAttrName;
+using mlir::iree_compiler::AMDAIE::NPUInstructionPatch;
 
 #define TXN_OPC_WRITE 0x0
 #define TXN_OPC_BLOCKWRITE 0x1
@@ -155,10 +161,60 @@ void appendWriteBdShimTile(std::vector<uint32_t> &instructions,
   words[11] |= op.getLockAcqId() & 0xf;
 }
 
+// Append the runtime patches of `op`, whose instruction words start at
+// `baseIndex`. `getField` returns the word index within the instruction, bit
+// offset and bit width of the named field.
+void appendPatches(
+    std::vector<NPUInstructionPatch> *patches, Operation *op,
+    uint32_t baseIndex,
+    llvm::function_ref<std::tuple<uint32_t, uint32_t, uint32_t>(StringRef)>
+        getField) {
+  auto patchAttrs = op->getAttrOfType<ArrayAttr>(kRuntimePatchesAttrName);
+  if (!patches || !patchAttrs) return;
+  for (auto patchAttr : patchAttrs.getAsRange<DictionaryAttr>()) {
+    auto getInt = [&](StringRef name) {
+      return cast<IntegerAttr>(patchAttr.get(name)).getInt();
+    };
+    auto [word, bitOffset, bitWidth] =
+        getField(cast<StringAttr>(patchAttr.get("field")).getValue());
+    assert(bitWidth != 0 && "unknown instruction field to be patched");
+    NPUInstructionPatch patch;
+    patch.wordIndex = baseIndex + word;
+    patch.bitOffset = bitOffset;
+    patch.bitWidth = bitWidth;
+    patch.ordinal = getInt("ordinal");
+    patch.multiplier = getInt("multiplier");
+    patch.addend = getInt("addend");
+    patch.divisor = getInt("divisor");
+    patch.scale = getInt("scale");
+    patch.bias = getInt("bias");
+    patches->push_back(patch);
+  }
+}
+
+// Return the location of the patchable fields of a shim tile BD write, see
+// `appendWriteBdShimTile`.
+std::tuple<uint32_t, uint32_t, uint32_t> getWriteBdField(StringRef field) {
+  return llvm::StringSwitch<std::tuple<uint32_t, uint32_t, uint32_t>>(field)
+      .Case("buffer_length", {4, 0, 32})
+      .Case("d0_size", {7, 20, 10})
+      .Case("d1_size", {8, 20, 10})
+      .Case("iteration_size", {10, 20, 6})
+      .Default({0, 0, 0});
+}
+
+// Return the location of the patchable fields of a task queue write, see
+// `appendWrite32` and the push queue command layout.
+std::tuple<uint32_t, uint32_t, uint32_t> getWrite32Field(StringRef field) {
+  return llvm::StringSwitch<std::tuple<uint32_t, uint32_t, uint32_t>>(field)
+      .Case("repeat_count", {4, 16, 8})
+      .Default({0, 0, 0});
+}
+
 }  // namespace
 
 std::vector<uint32_t> mlir::iree_compiler::AMDAIE::AIETranslateToNPU(
-    ModuleOp module) {
+    ModuleOp module, std::vector<NPUInstructionPatch> *patches) {
   std::vector<uint32_t> instructions;
 
   auto words = reserveAndGetTail(instructions, 4);
@@ -181,6 +237,7 @@ std::vector<uint32_t> mlir::iree_compiler::AMDAIE::AIETranslateToNPU(
           })
           .Case<NpuWrite32Op>([&](auto op) {
             count++;
+            appendPatches(patches, op, instructions.size(), getWrite32Field);
             appendWrite32(instructions, op);
           })
           .Case<NpuAddressPatchOp>([&](auto op) {
@@ -189,6 +246,7 @@ std::vector<uint32_t> mlir::iree_compiler::AMDAIE::AIETranslateToNPU(
           })
           .Case<NpuWriteBdOp>([&](auto op) {
             count++;
+            appendPatches(patches, op, instructions.size(), getWriteBdField);
             appendWriteBdShimTile(instructions, op);
           });
     }
@@ -206,3 +264,33 @@ LogicalResult mlir::iree_compiler::AMDAIE::AIETranslateToNPU(
   for (auto w : instructions) output << llvm::format("%08X\n", w);
   return success();
 }
+
+LogicalResult mlir::iree_compiler::AMDAIE::AIETranslateToNPUPatches(
+    ModuleOp module, raw_ostream &output) {
+  std::vector<NPUInstructionPatch> patches;
+  (void)AIETranslateToNPU(module, &patches);
+  for (const NPUInstructionPatch &p : patches) {
+    output << p.wordIndex << " " << p.bitOffset << " " << p.bitWidth << " "
+           << p.ordinal << " " << p.multiplier << " " << p.addend << " "
+           << p.divisor << " " << p.scale << " " << p.bias << "\n";
+  }
+  return success();
+}
+
+LogicalResult mlir::iree_compiler::AMDAIE::readNPUInstructionPatches(
+    StringRef path, std::vector<NPUInstructionPatch> &patches) {
+  // Instructions generated by an external tool don't come with patches.
+  std::ifstream patchesFile(path.str());
+  if (!patchesFile.is_open()) return success();
+  std::string line;
+  while (std::getline(patchesFile, line)) {
+    std::istringstream iss(line);
+    NPUInstructionPatch p;
+    if (!(iss >> p.wordIndex >> p.bitOffset >> p.bitWidth >> p.ordinal >>
+          p.multiplier >> p.addend >> p.divisor >> p.scale >> p.bias)) {
+      return failure();
+    }
+    patches.push_back(p);
+  }
+  return success();
+}
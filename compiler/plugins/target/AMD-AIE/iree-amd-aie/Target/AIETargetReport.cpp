@@ -0,0 +1,370 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// The report of a dispatch lists the resources its aie.device uses per tile,
+// its routing, the size of its control code and an estimate of its arithmetic
+// intensity, i.e. the arithmetic operations of all cores per byte transferred
+// from and to DDR. Loops in the cores need constant bounds to be counted more
+// than once and calls to microkernels only count if annotated with
+// `amdaie.estimated_ops`. The predicted cycles and utilization of cores and
+// DMA channels come from `simulateAIEPerformance` and are omitted if the
+// program can't be simulated.
+
+#include <map>
+#include <set>
+
+#include "AIETargets.h"
+#include "aie/Dialect/AIE/IR/AIEDialect.h"
+#include "aie/Dialect/AIEX/IR/AIEXDialect.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Support/FileUtilities.h"
+
+using namespace mlir;
+using namespace xilinx;
+using namespace xilinx::AIE;
+using mlir::iree_compiler::AMDAIE::AIEPerformanceEstimate;
+using mlir::iree_compiler::AMDAIE::AIEResourceUsage;
+using mlir::iree_compiler::AMDAIE::kEstimatedOpsAttrName;
+using mlir::iree_compiler::AMDAIE::simulateAIEPerformance;
+
+namespace {
+
+/// The resources used on a tile.
+struct TileUsage {
+  int64_t bufferBytes = 0;
+  int64_t numBuffers = 0;
+  int64_t numLocks = 0;
+  int64_t numBDs = 0;
+};
+
+/// Return the number of arithmetic operations of `op`, counting a
+/// multiply-accumulate as two operations.
+int64_t getArithmeticOps(Operation *op) {
+  if (auto callOp = dyn_cast<func::CallOp>(op)) {
+    if (auto ops = callOp->getAttrOfType<IntegerAttr>(kEstimatedOpsAttrName))
+      return ops.getInt();
+    auto funcOp = SymbolTable::lookupNearestSymbolFrom<func::FuncOp>(
+        callOp, callOp.getCalleeAttr());
+    if (!funcOp) return 0;
+    if (auto ops = funcOp->getAttrOfType<IntegerAttr>(kEstimatedOpsAttrName))
+      return ops.getInt();
+    return 0;
+  }
+  if (auto contractOp = dyn_cast<vector::ContractionOp>(op)) {
+    SmallVector<int64_t> bounds;
+    contractOp.getIterationBounds(bounds);
+    int64_t macs = 1;
+    for (int64_t bound : bounds) macs *= bound;
+    return 2 * macs;
+  }
+  // Elementwise arithmetic on scalars or vectors, but not the index
+  // computations of addresses, constants or casts.
+  bool isFMA = isa<vector::FMAOp>(op);
+  if (!isFMA &&
+      (!isa_and_nonnull<arith::ArithDialect>(op->getDialect()) ||
+       op->hasTrait<OpTrait::ConstantLike>() || isa<CastOpInterface>(op))) {
+    return 0;
+  }
+  if (op->getNumResults() != 1) return 0;
+  Type type = op->getResult(0).getType();
+  int64_t numElements = 1;
+  if (auto vectorType = dyn_cast<VectorType>(type)) {
+    numElements = vectorType.getNumElements();
+    type = vectorType.getElementType();
+  }
+  if (!type.isIntOrFloat()) return 0;
+  return isFMA ? 2 * numElements : numElements;
+}
+
+/// Return the number of arithmetic operations executed by the ops in `region`.
+/// Loops without constant bounds are counted as a single iteration.
+int64_t getArithmeticOps(Region &region) {
+  int64_t ops = 0;
+  for (Block &block : region) {
+    for (Operation &op : block) {
+      if (auto forOp = dyn_cast<scf::ForOp>(op)) {
+        std::optional<int64_t> lb = getConstantIntValue(forOp.getLowerBound());
+        std::optional<int64_t> ub = getConstantIntValue(forOp.getUpperBound());
+        std::optional<int64_t> step = getConstantIntValue(forOp.getStep());
+        int64_t tripCount = 1;
+        if (lb && ub && step && step.value() > 0) {
+          tripCount = std::max<int64_t>(
+              0, llvm::divideCeil(ub.value() - lb.value(), step.value()));
+        }
+        ops += tripCount * getArithmeticOps(forOp.getRegion());
+        continue;
+      }
+      ops += getArithmeticOps(&op);
+      for (Region &nested : op.getRegions()) ops += getArithmeticOps(nested);
+    }
+  }
+  return ops;
+}
+
+struct AIEReportPass
+    : public PassWrapper<AIEReportPass, OperationPass<DeviceOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(AIEReportPass)
+
+  AIEReportPass() = default;
+  AIEReportPass(const AIEReportPass &pass) : PassWrapper(pass) {}
+
+  StringRef getArgument() const override { return "aie-report"; }
+
+  StringRef getDescription() const override {
+    return "Print the JSON report of the resources used by the device and of "
+           "its predicted performance";
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<AIEDialect>();
+  }
+
+  void runOnOperation() override {
+    if (failed(mlir::iree_compiler::AMDAIE::AIETranslateToReport(
+            getOperation(), numNPUInstructionWords, llvm::outs()))) {
+      return signalPassFailure();
+    }
+  }
+
+  Option<int64_t> numNPUInstructionWords{
+      *this, "npu-instruction-words",
+      llvm::cl::desc("The size of the NPU instructions of the device"),
+      llvm::cl::init(0)};
+};
+
+}  // namespace
+
+namespace mlir::iree_compiler::AMDAIE {
+
+LogicalResult AIETranslateToReport(DeviceOp deviceOp,
+                                   int64_t numNPUInstructionWords,
+                                   raw_ostream &output) {
+  const AIETargetModel &targetModel = deviceOp.getTargetModel();
+
+  std::map<TileID, TileOp> tiles;
+  for (TileOp tileOp : deviceOp.getOps<TileOp>())
+    tiles[{tileOp.colIndex(), tileOp.rowIndex()}] = tileOp;
+
+  // The stack of a core is at the bottom of the memory of its tile.
+  std::map<TileID, TileUsage> usages;
+  for (auto &[tileID, tileOp] : tiles) {
+    if (CoreOp coreOp = tileOp.getCoreOp())
+      usages[tileID].bufferBytes = coreOp.getStackSize();
+  }
+  for (BufferOp bufferOp : deviceOp.getOps<BufferOp>()) {
+    TileOp tileOp = bufferOp.getTileOp();
+    TileUsage &usage = usages[{tileOp.colIndex(), tileOp.rowIndex()}];
+    int64_t size = bufferOp.getAllocationSize();
+    if (auto address = bufferOp.getAddress()) {
+      usage.bufferBytes =
+          std::max<int64_t>(usage.bufferBytes, address.value() + size);
+    } else {
+      usage.bufferBytes += size;
+    }
+    ++usage.numBuffers;
+  }
+  for (LockOp lockOp : deviceOp.getOps<LockOp>()) {
+    TileOp tileOp = lockOp.getTileOp();
+    ++usages[{tileOp.colIndex(), tileOp.rowIndex()}].numLocks;
+  }
+  auto memOps = llvm::to_vector_of<TileElement>(deviceOp.getOps<MemOp>());
+  llvm::append_range(memOps, deviceOp.getOps<MemTileDMAOp>());
+  llvm::append_range(memOps, deviceOp.getOps<ShimDMAOp>());
+  for (TileElement memOp : memOps) {
+    memOp->walk([&](DMABDOp) { ++usages[memOp.getTileID()].numBDs; });
+  }
+
+  // The flows are gone once routed, so count the routed connections starting
+  // at a DMA channel or core instead.
+  int64_t numFlows = llvm::range_size(deviceOp.getOps<FlowOp>());
+  for (SwitchboxOp switchboxOp : deviceOp.getOps<SwitchboxOp>()) {
+    for (ConnectOp connectOp :
+         switchboxOp.getRegion().getOps<ConnectOp>()) {
+      if (connectOp.getSourceBundle() == WireBundle::DMA ||
+          connectOp.getSourceBundle() == WireBundle::Core) {
+        ++numFlows;
+      }
+    }
+  }
+  for (ShimMuxOp shimMuxOp : deviceOp.getOps<ShimMuxOp>()) {
+    for (ConnectOp connectOp : shimMuxOp.getRegion().getOps<ConnectOp>())
+      if (connectOp.getSourceBundle() == WireBundle::DMA) ++numFlows;
+  }
+
+  // The utilization of the stream channels between neighbouring switchboxes,
+  // i.e. the capacities of the edges the pathfinder routes over.
+  double maxChannelUtilization = 0;
+  std::string busiestChannel;
+  for (SwitchboxOp switchboxOp : deviceOp.getOps<SwitchboxOp>()) {
+    int col = switchboxOp.colIndex();
+    int row = switchboxOp.rowIndex();
+    std::map<WireBundle, std::set<int>> usedChannels;
+    for (ConnectOp connectOp : switchboxOp.getRegion().getOps<ConnectOp>())
+      usedChannels[connectOp.getDestBundle()].insert(
+          connectOp.getDestChannel());
+    for (WireBundle bundle : {WireBundle::North, WireBundle::South,
+                              WireBundle::East, WireBundle::West}) {
+      uint32_t capacity =
+          targetModel.getNumDestSwitchboxConnections(col, row, bundle);
+      if (capacity == 0 || !usedChannels.count(bundle)) continue;
+      double utilization =
+          static_cast<double>(usedChannels[bundle].size()) / capacity;
+      if (utilization <= maxChannelUtilization) continue;
+      maxChannelUtilization = utilization;
+      busiestChannel = (Twine(stringifyWireBundle(bundle)) +
+                        " of switchbox (" + Twine(col) + ", " + Twine(row) +
+                        ")")
+                           .str();
+    }
+  }
+
+  // The transfers of the control program from and to DDR.
+  int64_t numControlCodeDMAs = 0;
+  int64_t ddrBytes = 0;
+  deviceOp.walk([&](AIEX::NpuDmaMemcpyNdOp memcpyOp) {
+    ++numControlCodeDMAs;
+    int64_t bytes = memcpyOp.getMemref().getType().getElementTypeBitWidth() / 8;
+    for (OpFoldResult size : memcpyOp.getMixedSizes()) {
+      std::optional<int64_t> constantSize = getConstantIntValue(size);
+      // Transfers with sizes only known at dispatch time aren't counted.
+      if (!constantSize) {
+        bytes = 0;
+        break;
+      }
+      bytes *= constantSize.value();
+    }
+    ddrBytes += bytes;
+  });
+
+  int64_t computeOps = 0;
+  int64_t numCores = 0;
+  for (CoreOp coreOp : deviceOp.getOps<CoreOp>()) {
+    computeOps += getArithmeticOps(coreOp.getBody());
+    ++numCores;
+  }
+
+  FailureOr<AIEPerformanceEstimate> estimate = failure();
+  {
+    // A program which can't be simulated still gets a resource report.
+    ScopedDiagnosticHandler handler(deviceOp.getContext(),
+                                    [](Diagnostic &) { return success(); });
+    estimate = simulateAIEPerformance(deviceOp);
+  }
+
+  llvm::json::OStream json(output, /*IndentSize=*/2);
+  json.object([&] {
+    json.attribute("cores", numCores);
+    int64_t l1Bytes = 0;
+    int64_t l2Bytes = 0;
+    json.attributeArray("tiles", [&] {
+      for (auto &[tileID, tileOp] : tiles) {
+        const TileUsage &usage = usages[tileID];
+        int col = tileID.col;
+        int row = tileID.row;
+        StringRef kind = "core";
+        int64_t memoryBytes = targetModel.getLocalMemorySize();
+        if (tileOp.isMemTile()) {
+          kind = "memtile";
+          memoryBytes = targetModel.getMemTileSize();
+          l2Bytes += usage.bufferBytes;
+        } else if (tileOp.isShimTile()) {
+          kind = "shim";
+          memoryBytes = 0;
+        } else {
+          l1Bytes += usage.bufferBytes;
+        }
+        json.object([&] {
+          json.attribute("col", col);
+          json.attribute("row", row);
+          json.attribute("kind", kind);
+          json.attribute("buffers", usage.numBuffers);
+          json.attribute("buffer_bytes", usage.bufferBytes);
+          json.attribute("memory_bytes", memoryBytes);
+          json.attribute("locks", usage.numLocks);
+          json.attribute("available_locks", targetModel.getNumLocks(col, row));
+          json.attribute("bds", usage.numBDs);
+        });
+      }
+    });
+    json.attribute("l1_bytes", l1Bytes);
+    json.attribute("l2_bytes", l2Bytes);
+    json.attribute("flows", numFlows);
+    json.attribute("max_channel_utilization", maxChannelUtilization);
+    if (!busiestChannel.empty())
+      json.attribute("busiest_channel", busiestChannel);
+    json.attribute("npu_instruction_words", numNPUInstructionWords);
+    json.attribute("control_code_dmas", numControlCodeDMAs);
+    json.attribute("ddr_bytes", ddrBytes);
+    json.attribute("compute_ops", computeOps);
+    if (ddrBytes > 0) {
+      json.attribute("arithmetic_intensity",
+                     static_cast<double>(computeOps) / ddrBytes);
+    }
+    if (failed(estimate)) return;
+    json.attribute("predicted_cycles", estimate->totalCycles);
+    json.attributeArray("resources", [&] {
+      for (const AIEResourceUsage &resource : estimate->resources) {
+        json.object([&] {
+          json.attribute("name", resource.name);
+          json.attribute("busy_cycles", resource.busyCycles);
+          if (estimate->totalCycles > 0) {
+            json.attribute("utilization",
+                           static_cast<double>(resource.busyCycles) /
+                               estimate->totalCycles);
+          }
+        });
+      }
+    });
+  });
+  output << "\n";
+  return success();
+}
+
+LogicalResult writeAIEReport(DeviceOp deviceOp, StringRef reportDir,
+                             StringRef entryPointName,
+                             int64_t numNPUInstructionWords) {
+  if (auto ecode = llvm::sys::fs::create_directories(reportDir)) {
+    return deviceOp.emitOpError()
+           << "failed to create report directory " << reportDir
+           << ". Error message : " << ecode.message();
+  }
+  SmallString<128> reportPath(reportDir);
+  llvm::sys::path::append(reportPath, entryPointName + ".report.json");
+  std::string errorMessage;
+  auto reportOut = openOutputFile(reportPath, &errorMessage);
+  if (!reportOut) {
+    return deviceOp.emitOpError()
+           << "Failed to write report: " << errorMessage;
+  }
+  if (failed(AIETranslateToReport(deviceOp, numNPUInstructionWords,
+                                  reportOut->os()))) {
+    return failure();
+  }
+  reportOut->keep();
+  return success();
+}
+
+std::unique_ptr<OperationPass<DeviceOp>> createAIEReportPass() {
+  return std::make_unique<AIEReportPass>();
+}
+
+void registerAIEReport() {
+  mlir::registerPass([]() -> std::unique_ptr<mlir::Pass> {
+    return createAIEReportPass();
+  });
+}
+
+}  // namespace mlir::iree_compiler::AMDAIE
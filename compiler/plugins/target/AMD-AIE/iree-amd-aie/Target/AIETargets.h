@@ -14,9 +14,34 @@
 #include "mlir/Support/LogicalResult.h"
 
 namespace mlir::iree_compiler::AMDAIE {
+
+/// A field of the NPU instructions, which is patched at dispatch time with
+/// `ceilDiv(c * multiplier + addend, divisor) * scale + bias`, where `c` is the
+/// push constant with ordinal `ordinal`. The field occupies `bitWidth` bits
+/// starting from bit `bitOffset` of the instruction word at `wordIndex`.
+struct NPUInstructionPatch {
+  uint32_t wordIndex;
+  uint32_t bitOffset;
+  uint32_t bitWidth;
+  uint32_t ordinal;
+  int64_t multiplier;
+  int64_t addend;
+  int64_t divisor;
+  int64_t scale;
+  int64_t bias;
+};
+
 mlir::LogicalResult AIETranslateToNPU(mlir::ModuleOp module,
                                       llvm::raw_ostream &output);
-std::vector<uint32_t> AIETranslateToNPU(mlir::ModuleOp);
+std::vector<uint32_t> AIETranslateToNPU(
+    mlir::ModuleOp, std::vector<NPUInstructionPatch> *patches = nullptr);
+mlir::LogicalResult AIETranslateToNPUPatches(mlir::ModuleOp module,
+                                             llvm::raw_ostream &output);
+/// Suffix appended to the path of the NPU instructions file to get the path of
+/// the file with their runtime patches.
+inline constexpr llvm::StringLiteral kNPUInstructionPatchesSuffix = ".patches";
+mlir::LogicalResult readNPUInstructionPatches(
+    llvm::StringRef path, std::vector<NPUInstructionPatch> &patches);
 mlir::LogicalResult AIETranslateToLdScript(mlir::ModuleOp module,
                                            llvm::raw_ostream &output,
                                            int tileCol, int tileRow);
@@ -27,6 +52,28 @@ mlir::LogicalResult AIETranslateToCDODirect(
     mlir::ModuleOp m, llvm::StringRef workDirPath, bool bigEndian = false,
     bool emitUnified = false, bool cdoDebug = false, bool aieSim = false,
     bool xaieDebug = false, bool enableCores = true);
+/// Returns a digest of the static array configuration, i.e. the CDO files and
+/// the core ELFs, generated for an xclbin in `workDirPath`. Entry points with
+/// the same digest only differ in their NPU instructions and can share an
+/// xclbin. Fails if `workDirPath` doesn't contain the separate CDO files.
+mlir::FailureOr<std::string> computeArrayConfigDigest(
+    llvm::StringRef workDirPath);
+/// Writes a JSON report of the resources used by `deviceOp` and of its
+/// predicted performance. The buffers, locks and BDs of `deviceOp` need to be
+/// assigned and its flows routed. `numNPUInstructionWords` is the size of the
+/// NPU instructions generated for it.
+mlir::LogicalResult AIETranslateToReport(xilinx::AIE::DeviceOp deviceOp,
+                                         int64_t numNPUInstructionWords,
+                                         llvm::raw_ostream &output);
+/// Writes the report of `deviceOp` with `AIETranslateToReport` to
+/// `<reportDir>/<entryPointName>.report.json`, creating `reportDir` if needed.
+mlir::LogicalResult writeAIEReport(xilinx::AIE::DeviceOp deviceOp,
+                                   llvm::StringRef reportDir,
+                                   llvm::StringRef entryPointName,
+                                   int64_t numNPUInstructionWords);
+/// Prints the report of every aie.device to stdout.
+std::unique_ptr<OperationPass<xilinx::AIE::DeviceOp>> createAIEReportPass();
+void registerAIEReport();
 
 inline void collectTiles(
     xilinx::AIE::DeviceOp &device,
@@ -15,6 +15,7 @@
 #include "aie/Dialect/AIEVec/Pipelines/Passes.h"
 #include "aie/Passes.h"
 #include "aie/Targets/AIETargets.h"
+#include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/JSON.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -201,6 +202,33 @@ static void aieTargetDefines(SmallVector<std::string, N> &Args,
     Args.push_back("-D__AIEARCH__=10");
 }
 
+// The size of the program memory of a core. The ld script doesn't restrict the
+// program to it, so it is checked once linked.
+static constexpr uint64_t kCoreProgramMemoryBytes = 16 * 1024;
+
+// Check that the executable sections of the linked core ELF `elfFile` fit into
+// the program memory of the core.
+static LogicalResult checkCoreProgramSize(AIE::CoreOp coreOp,
+                                          StringRef elfFile) {
+  auto objectFile = object::ObjectFile::createObjectFile(elfFile);
+  if (!objectFile) {
+    return coreOp.emitOpError("failed to read elf file ")
+           << elfFile << ": " << toString(objectFile.takeError());
+  }
+  uint64_t programBytes = 0;
+  for (const object::SectionRef &section :
+       objectFile->getBinary()->sections()) {
+    if (section.isText()) programBytes += section.getSize();
+  }
+  if (programBytes > kCoreProgramMemoryBytes) {
+    return coreOp.emitOpError("program of ")
+           << programBytes << " bytes in " << elfFile
+           << " exceeds the program memory of " << kCoreProgramMemoryBytes
+           << " bytes";
+  }
+  return success();
+}
+
 // Generate the elf files for the core
 static LogicalResult generateCoreElfFiles(ModuleOp moduleOp,
                                           const StringRef objFile,
@@ -321,6 +349,7 @@ static LogicalResult generateCoreElfFiles(ModuleOp moduleOp,
           return coreOp.emitOpError("failed to link elf file for core(")
                  << col << "," << row << ")";
       }
+      if (failed(checkCoreProgramSize(coreOp, elfFile))) return failure();
     }
   }
   return success();
@@ -824,6 +853,16 @@ static LogicalResult generateUnifiedObject(MLIRContext *context,
   return success();
 }
 
+void xilinx::buildAIEDevicePassPipeline(OpPassManager &devicePassManager) {
+  using namespace mlir::iree_compiler::AMDAIE;
+  devicePassManager.addPass(createAIEObjectFifoStatefulTransformPass());
+  devicePassManager.addPass(createAIEAssignBufferAddressesBasicPass());
+  devicePassManager.addPass(createAIEAssignLockIDsPass());
+  devicePassManager.addPass(createAIEAssignBufferDescriptorIDsPass());
+  devicePassManager.addPass(createAIEPathfinderPass());
+  devicePassManager.addPass(createAIELocalizeLocksPass());
+}
+
 LogicalResult xilinx::aie2xclbin(MLIRContext *ctx, ModuleOp moduleOp,
                                  XCLBinGenConfig &TK, StringRef OutputNPU,
                                  StringRef OutputXCLBin,
@@ -870,6 +909,22 @@ LogicalResult xilinx::aie2xclbin(MLIRContext *ctx, ModuleOp moduleOp,
       return moduleOp.emitOpError("NPU Instruction translation failed");
 
     output->keep();
+
+    // The fields of the NPU instructions that are patched at dispatch time,
+    // for sizes depending on push constants.
+    auto patchesOutput = openOutputFile(
+        (Twine(OutputNPU) +
+         mlir::iree_compiler::AMDAIE::kNPUInstructionPatchesSuffix)
+            .str(),
+        &errorMessage);
+    if (!patchesOutput) {
+      llvm::errs() << errorMessage << "\n";
+      return moduleOp.emitOpError("");
+    }
+    if (failed(mlir::iree_compiler::AMDAIE::AIETranslateToNPUPatches(
+            copy, patchesOutput->os())))
+      return moduleOp.emitOpError("NPU Instruction translation failed");
+    patchesOutput->keep();
     copy->erase();
   }
 
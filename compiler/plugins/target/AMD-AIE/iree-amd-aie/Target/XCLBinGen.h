@@ -10,6 +10,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/MLIRContext.h"
+#include "mlir/Pass/PassManager.h"
 #include "mlir/Support/LogicalResult.h"
 
 #pragma once
@@ -35,6 +36,12 @@ struct XCLBinGenConfig {
   bool Timing = false;
 };
 
+/// Adds the passes which lower the objectFifos of an aie.device, assign its
+/// buffers, locks and BDs and route its flows to `devicePassManager`, which
+/// runs on aie.device operations. aie2xclbin expects its input to have been
+/// through these passes.
+void buildAIEDevicePassPipeline(mlir::OpPassManager &devicePassManager);
+
 mlir::LogicalResult aie2xclbin(mlir::MLIRContext *ctx, mlir::ModuleOp moduleOp,
                                XCLBinGenConfig &TK, mlir::StringRef OutputNPU,
                                mlir::StringRef OutputXCLBin,
@@ -49,9 +49,17 @@ class AMDAIELoweringStrategyPass
 
 void AMDAIELoweringStrategyPass::runOnOperation() {
   ModuleOp moduleOp = getOperation();
+  // The cores of a K split all write their partial sums to the same output
+  // tile, which is only correct once the sums are chained over the cascade
+  // interface. The AIR lowering doesn't do that.
+  if (cascadeKSplit > 1 && !useObjectFifoLowering) {
+    moduleOp.emitOpError("cascade-k-split > 1 requires the objectFifo "
+                         "lowering (use-objectfifo-lowering)");
+    return signalPassFailure();
+  }
   // To simplify development, the number of cores can be passed as a flag during
   // compilation. In the future these parameters could be read from file.
-  struct AIEConfig cfg = {numCores};
+  struct AIEConfig cfg = {numCores, cascadeKSplit};
   for (auto funcOp : moduleOp.getOps<FunctionOpInterface>()) {
     // Set the strategy with default heuristics.
     if (failed(initAIELaunchConfig(funcOp, usePassPipeline, cfg))) {
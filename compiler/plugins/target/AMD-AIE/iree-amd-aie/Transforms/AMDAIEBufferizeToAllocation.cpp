@@ -9,8 +9,10 @@
 #include "iree-amd-aie/Transforms/Passes.h"
 #include "mlir/Dialect/Bufferization/IR/Bufferization.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "llvm/ADT/SetVector.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
 #include "mlir/Dialect/MemRef/Transforms/Transforms.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
 #include "mlir/IR/Iterators.h"
 #include "mlir/Pass/Pass.h"
 
@@ -95,6 +97,25 @@ static FailureOr<SmallVector<Value>> getOperandsFromDefOp(
   return operands;
 }
 
+/// Utility to fetch the operands of a tile of a chain of linalg ops, like the
+/// reductions and elementwise ops of a softmax or normalization: the inputs of
+/// all linalg ops in the block of `linalgOp` which are slices of a larger
+/// tensor, and the output of `linalgOp` if it is a slice. Intermediate results
+/// of the chain stay in the tile and aren't returned.
+static SmallVector<Value> getSliceInputOutputOperands(
+    linalg::LinalgOp &linalgOp) {
+  llvm::SetVector<Value> operands;
+  for (auto op : linalgOp->getBlock()->getOps<linalg::LinalgOp>()) {
+    for (Value input : op.getDpsInputs()) {
+      if (input.getDefiningOp<tensor::ExtractSliceOp>()) operands.insert(input);
+    }
+  }
+  for (Value init : linalgOp.getDpsInits()) {
+    if (init.getDefiningOp<tensor::ExtractSliceOp>()) operands.insert(init);
+  }
+  return operands.takeVector();
+}
+
 // This function helps to fetch operands of either a LinalgOp or its defining
 // ops, based on which operands the caller wants to bufferize via
 // `bufferizeOperand` parameter.
@@ -113,6 +134,10 @@ static FailureOr<SmallVector<Value>> getOperandsToBufferize(
     /// Create new allocations for operands from the def ops.
     case BufferizeOperand::DefOp:
       return getOperandsFromDefOp(linalgOp);
+    /// Create new allocations for the sliced inputs and output of a chain of
+    /// linalg ops.
+    case BufferizeOperand::SliceInputOutput:
+      return getSliceInputOutputOperands(linalgOp);
     default:
       return failure();
   }
@@ -159,6 +184,11 @@ void AMDAIEBufferizeToAllocationPass::runOnOperation() {
   mlir::FunctionOpInterface funcOp = getOperation();
   linalg::LinalgOp linalgOp;
   funcOp->walk<WalkOrder::PostOrder, ReverseIterator>([&](linalg::LinalgOp op) {
+    // For a chain of linalg ops, the last one is the target.
+    if (bufferizeOperand == BufferizeOperand::SliceInputOutput) {
+      linalgOp = op;
+      return WalkResult::interrupt();
+    }
     // Use flag `bufferizeElementwise` to indicate whether the target for
     // bufferization is an elementwise op.
     if (bufferizeElementwise && isElementwise(op)) {
@@ -8,6 +8,7 @@
 #include "iree-amd-aie/IR/AMDAIEOps.h"
 #include "iree-amd-aie/Transforms/AMDAIEDmaUtils.h"
 #include "iree-amd-aie/Transforms/Passes.h"
+#include "llvm/ADT/TypeSwitch.h"
 #include "mlir/Pass/Pass.h"
 
 #define DEBUG_TYPE "iree-amdaie-canonicalize-doubly-strided-dma"
@@ -16,6 +17,63 @@ namespace mlir::iree_compiler::AMDAIE {
 
 namespace {
 
+/// Return the BD limits of the DMAs accessing a logical objectFifo type, based
+/// on its memory space and element type, or `std::nullopt` if they can't be
+/// determined.
+std::optional<DmaDimConfig> getLogicalObjectFifoDmaDimConfig(Type type) {
+  auto logicalObjectFifoType = dyn_cast_if_present<LogicalObjectFifoType>(type);
+  if (!logicalObjectFifoType) return std::nullopt;
+  MemRefType memrefType = logicalObjectFifoType.getElementType();
+  int64_t elemBitWidth = memrefType.getElementTypeBitWidth();
+  Attribute memSpace = memrefType.getMemorySpace();
+  if (!memSpace) return getDmaDimConfig(AMDAIEMemSpace::Global, elemBitWidth);
+  auto intAttr = dyn_cast<IntegerAttr>(memSpace);
+  if (!intAttr) return std::nullopt;
+  std::optional<AMDAIEMemSpace> amdaieMemSpace =
+      symbolizeAMDAIEMemSpace(intAttr.getInt());
+  if (!amdaieMemSpace) return std::nullopt;
+  return getDmaDimConfig(amdaieMemSpace.value(), elemBitWidth);
+}
+
+/// Return the number of elements of the memref of a logical objectFifo type,
+/// or `std::nullopt` if it isn't statically known.
+std::optional<int64_t> getNbElements(Type type) {
+  auto logicalObjectFifoType = dyn_cast_if_present<LogicalObjectFifoType>(type);
+  if (!logicalObjectFifoType) return std::nullopt;
+  MemRefType memrefType = logicalObjectFifoType.getElementType();
+  if (!memrefType.hasStaticShape()) return std::nullopt;
+  return memrefType.getNumElements();
+}
+
+/// Return the logical objectFifo types of the source and target of a doubly
+/// strided operation, or null types if they can't be determined.
+std::pair<Type, Type> getSourceAndTargetTypes(
+    AMDAIE::DoublyStridedOpInterface op) {
+  return TypeSwitch<Operation *, std::pair<Type, Type>>(op.getOperation())
+      .Case<AMDAIE::DmaCpyNdOp, AMDAIE::CircularDmaCpyNdOp>(
+          [](auto dmaOp) -> std::pair<Type, Type> {
+            return {dmaOp.getSourceType(), dmaOp.getTargetType()};
+          })
+      .Case<AMDAIE::NpuDmaCpyNdOp>(
+          [](AMDAIE::NpuDmaCpyNdOp npuDmaOp) -> std::pair<Type, Type> {
+            AMDAIE::CircularDmaCpyNdOp dmaOp = npuDmaOp.getDmaCpyNdOp();
+            if (!dmaOp) return {};
+            return {dmaOp.getSourceType(), dmaOp.getTargetType()};
+          })
+      .Default([](Operation *) -> std::pair<Type, Type> { return {}; });
+}
+
+/// Return the BD limits of the DMAs executing the source and target access
+/// patterns of a doubly strided operation. The memory spaces determine on
+/// which tile types the access patterns are executed and the element types in
+/// which units they are expressed.
+std::pair<std::optional<DmaDimConfig>, std::optional<DmaDimConfig>>
+getSourceAndTargetDmaDimConfigs(AMDAIE::DoublyStridedOpInterface op) {
+  auto [sourceType, targetType] = getSourceAndTargetTypes(op);
+  return {getLogicalObjectFifoDmaDimConfig(sourceType),
+          getLogicalObjectFifoDmaDimConfig(targetType)};
+}
+
 /// Recognize linear accesses across multiple DMA access dimensions and fold
 /// them.
 LogicalResult foldDmaOpLinearDims(RewriterBase &rewriter,
@@ -57,10 +115,13 @@ LogicalResult foldDmaOpSingleDims(RewriterBase &rewriter,
   SmallVector<OpFoldResult> targetOffsets = op.getTargetOffsets();
   SmallVector<OpFoldResult> targetSizes = op.getTargetSizes();
   SmallVector<OpFoldResult> targetStrides = op.getTargetStrides();
-  LogicalResult sourceRes =
-      foldSingleDim(sourceOffsets, sourceSizes, sourceStrides);
-  LogicalResult targetRes =
-      foldSingleDim(targetOffsets, targetSizes, targetStrides);
+  auto [sourceType, targetType] = getSourceAndTargetTypes(op);
+  LogicalResult sourceRes = foldSingleDim(sourceOffsets, sourceSizes,
+                                          sourceStrides,
+                                          getNbElements(sourceType));
+  LogicalResult targetRes = foldSingleDim(targetOffsets, targetSizes,
+                                          targetStrides,
+                                          getNbElements(targetType));
   if (failed(sourceRes) && failed(targetRes)) {
     return failure();
   }
@@ -103,6 +164,85 @@ LogicalResult foldDmaOpUnitDims(RewriterBase &rewriter,
   return success();
 }
 
+/// Split dimensions with a size exceeding the maximum size supported by the
+/// buffer descriptors of the source and target DMAs, so the access patterns can
+/// be executed without unrolling those dimensions into chained BDs. Dimensions
+/// are only split as long as the number of dimensions stays within the number
+/// supported by a BD.
+LogicalResult splitDmaOpLargeDims(RewriterBase &rewriter,
+                                  AMDAIE::DoublyStridedOpInterface op) {
+  OpBuilder::InsertionGuard guard(rewriter);
+  auto [sourceConfig, targetConfig] = getSourceAndTargetDmaDimConfigs(op);
+  SmallVector<OpFoldResult> sourceOffsets = op.getSourceMixedOffsets();
+  SmallVector<OpFoldResult> sourceSizes = op.getSourceMixedSizes();
+  SmallVector<OpFoldResult> sourceStrides = op.getSourceMixedStrides();
+  SmallVector<OpFoldResult> targetOffsets = op.getTargetMixedOffsets();
+  SmallVector<OpFoldResult> targetSizes = op.getTargetMixedSizes();
+  SmallVector<OpFoldResult> targetStrides = op.getTargetMixedStrides();
+  SmallVector<OpFoldResult> newSourceOffsets, newSourceSizes, newSourceStrides,
+      newTargetOffsets, newTargetSizes, newTargetStrides;
+  // An access pattern is never split into more dimensions than a BD of the
+  // DMA supports, as those couldn't be lowered.
+  LogicalResult sourceRes = failure();
+  if (sourceConfig) {
+    sourceRes = splitLargeDims(op.getContext(), sourceOffsets, sourceSizes,
+                               sourceStrides, sourceConfig.value(),
+                               newSourceOffsets, newSourceSizes,
+                               newSourceStrides);
+  }
+  LogicalResult targetRes = failure();
+  if (targetConfig) {
+    targetRes = splitLargeDims(op.getContext(), targetOffsets, targetSizes,
+                               targetStrides, targetConfig.value(),
+                               newTargetOffsets, newTargetSizes,
+                               newTargetStrides);
+  }
+  if (failed(sourceRes) && failed(targetRes)) {
+    return failure();
+  }
+  if (failed(sourceRes)) {
+    newSourceOffsets = sourceOffsets;
+    newSourceSizes = sourceSizes;
+    newSourceStrides = sourceStrides;
+  }
+  if (failed(targetRes)) {
+    newTargetOffsets = targetOffsets;
+    newTargetSizes = targetSizes;
+    newTargetStrides = targetStrides;
+  }
+
+  rewriter.setInsertionPointAfter(op);
+  auto newDoublyStridedOp = op.createDoublyStridedOp(
+      rewriter, newTargetOffsets, newTargetSizes, newTargetStrides,
+      newSourceOffsets, newSourceSizes, newSourceStrides);
+  rewriter.replaceOp(op, newDoublyStridedOp.getOperation());
+  return success();
+}
+
+/// Emit a remark with the number of BDs needed on the source and target side
+/// to execute the access patterns of the provided op.
+void reportDmaOpBDCount(AMDAIE::DoublyStridedOpInterface op) {
+  auto [sourceConfig, targetConfig] = getSourceAndTargetDmaDimConfigs(op);
+  auto printBDCount = [](InFlightDiagnostic &diag,
+                         std::optional<DmaDimConfig> config,
+                         const SmallVector<OpFoldResult> &sizes,
+                         const SmallVector<OpFoldResult> &strides) {
+    FailureOr<int64_t> nbBDs = failure();
+    if (config) nbBDs = getNbBDs(sizes, strides, config.value());
+    if (succeeded(nbBDs)) {
+      diag << nbBDs.value();
+    } else {
+      diag << "unknown";
+    }
+  };
+  InFlightDiagnostic diag = op->emitRemark() << "source BDs: ";
+  printBDCount(diag, sourceConfig, op.getSourceMixedSizes(),
+               op.getSourceMixedStrides());
+  diag << ", target BDs: ";
+  printBDCount(diag, targetConfig, op.getTargetMixedSizes(),
+               op.getTargetMixedStrides());
+}
+
 class AMDAIECanonicalizeDoublyStridedOpPass
     : public impl::AMDAIECanonicalizeDoublyStridedOpBase<
           AMDAIECanonicalizeDoublyStridedOpPass> {
@@ -114,6 +254,9 @@ class AMDAIECanonicalizeDoublyStridedOpPass
   AMDAIECanonicalizeDoublyStridedOpPass() = default;
   AMDAIECanonicalizeDoublyStridedOpPass(
       const AMDAIECanonicalizeDoublyStridedOpPass &pass){};
+  AMDAIECanonicalizeDoublyStridedOpPass(
+      const AMDAIECanonicalizeDoublyStridedOpOptions &options)
+      : AMDAIECanonicalizeDoublyStridedOpBase(options) {}
   void runOnOperation() override;
 };
 
@@ -135,12 +278,25 @@ void AMDAIECanonicalizeDoublyStridedOpPass::runOnOperation() {
   parentOp->walk([&](AMDAIE::DoublyStridedOpInterface dmaOp) {
     (void)foldDmaOpSingleDims(rewriter, dmaOp);
   });
+
+  // Split dimensions exceeding the BD size limits of the source and target
+  // DMAs.
+  parentOp->walk([&](AMDAIE::DoublyStridedOpInterface dmaOp) {
+    (void)splitDmaOpLargeDims(rewriter, dmaOp);
+  });
+
+  if (reportBDCount) {
+    parentOp->walk([&](AMDAIE::DoublyStridedOpInterface dmaOp) {
+      reportDmaOpBDCount(dmaOp);
+    });
+  }
 }
 
 }  // namespace
 
-std::unique_ptr<Pass> createAMDAIECanonicalizeDoublyStridedOpPass() {
-  return std::make_unique<AMDAIECanonicalizeDoublyStridedOpPass>();
+std::unique_ptr<Pass> createAMDAIECanonicalizeDoublyStridedOpPass(
+    AMDAIECanonicalizeDoublyStridedOpOptions options) {
+  return std::make_unique<AMDAIECanonicalizeDoublyStridedOpPass>(options);
 }
 
 }  // namespace mlir::iree_compiler::AMDAIE
@@ -0,0 +1,249 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass combining the partial accumulators of cores
+// which split the reduction dimension of a matmul between them. The cores of
+// such a split all write back to the same region of shared memory. Instead,
+// their accumulators are chained over the cascade interface from west to east
+// and only the easternmost core writes back the complete result.
+//
+//===----------------------------------------------------------------------===//
+
+#include "aie/Dialect/AIE/IR/AIEDialect.h"
+#include "iree-amd-aie/IR/AMDAIEDialect.h"
+#include "iree-amd-aie/IR/AMDAIEOps.h"
+#include "iree-amd-aie/Transforms/AMDAIEUtils.h"
+#include "iree-amd-aie/Transforms/Passes.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+
+#define DEBUG_TYPE "iree-amdaie-chain-cascade-accumulators"
+
+namespace mlir::iree_compiler::AMDAIE {
+
+namespace {
+
+/// A core writing back its local accumulator through a DMA into shared
+/// memory.
+struct AccumulatorProducer {
+  AMDAIE::CoreOp coreOp;
+  AMDAIE::LogicalObjectFifoProduce produceOp;
+  AMDAIE::DmaCpyNdOp dmaOp;
+  int64_t col;
+  int64_t row;
+};
+
+/// Return whether `a` and `b` write to the same region of the same logical
+/// objectFifo.
+bool haveSameTarget(AMDAIE::DmaCpyNdOp a, AMDAIE::DmaCpyNdOp b) {
+  auto isEqual = [](ArrayRef<OpFoldResult> lhs, ArrayRef<OpFoldResult> rhs) {
+    return lhs.size() == rhs.size() &&
+           llvm::all_of(llvm::zip(lhs, rhs), [](auto pair) {
+             return isEqualConstantIntOrValue(std::get<0>(pair),
+                                              std::get<1>(pair));
+           });
+  };
+  return a.getTarget() == b.getTarget() &&
+         isEqual(a.getTargetMixedOffsets(), b.getTargetMixedOffsets()) &&
+         isEqual(a.getTargetMixedSizes(), b.getTargetMixedSizes()) &&
+         isEqual(a.getTargetMixedStrides(), b.getTargetMixedStrides());
+}
+
+/// Return the local accumulator written back by `producer`, i.e. the result of
+/// the core's access to the DMA's source logical objectFifo.
+FailureOr<Value> getAccumulator(const AccumulatorProducer &producer) {
+  Value localObjectFifo = producer.dmaOp.getSource();
+  AMDAIE::LogicalObjectFifoAccessOp accessOp;
+  producer.coreOp.walk([&](AMDAIE::LogicalObjectFifoAccessOp op) {
+    if (!accessOp && op.getInput() == localObjectFifo) accessOp = op;
+  });
+  if (!accessOp) {
+    return producer.coreOp.emitOpError()
+           << "has no access to the local accumulator it writes back";
+  }
+  return accessOp.getOutput();
+}
+
+/// Insert a loop before the write back of `producer` that streams the
+/// accumulator through the cascade interface in vectors of the cascade's
+/// width. Depending on the position of the core in the chain, it first adds
+/// the partial sum received from the west neighbour (`receive`) and either
+/// sends the result to the east neighbour (`send`) or stores it back in the
+/// local accumulator.
+LogicalResult insertCascadeLoop(IRRewriter &rewriter,
+                                const AccumulatorProducer &producer,
+                                bool receive, bool send) {
+  FailureOr<Value> maybeAccumulator = getAccumulator(producer);
+  if (failed(maybeAccumulator)) return failure();
+  Value accumulator = maybeAccumulator.value();
+  auto memrefType = cast<MemRefType>(accumulator.getType());
+  if (!memrefType.hasStaticShape() || !memrefType.getLayout().isIdentity()) {
+    return producer.coreOp.emitOpError()
+           << "has a local accumulator of type " << memrefType
+           << ", which isn't a contiguous, static buffer";
+  }
+  Type elementType = memrefType.getElementType();
+  FailureOr<unsigned> maybeLanes = getAIEVectorLanes(elementType);
+  if (failed(maybeLanes)) {
+    return producer.coreOp.emitOpError()
+           << "has a local accumulator element type " << elementType
+           << ", which can't be sent over the cascade interface";
+  }
+  int64_t lanes = maybeLanes.value();
+  int64_t numElements = memrefType.getNumElements();
+  if (numElements % lanes != 0) {
+    return producer.coreOp.emitOpError()
+           << "has a local accumulator of " << numElements
+           << " elements, which isn't a multiple of the cascade width of "
+           << lanes << " elements";
+  }
+
+  OpBuilder::InsertionGuard guard(rewriter);
+  rewriter.setInsertionPoint(producer.produceOp);
+  Location loc = producer.produceOp.getLoc();
+  SmallVector<ReassociationIndices> reassociation = {
+      llvm::to_vector(llvm::seq<int64_t>(0, memrefType.getRank()))};
+  Value flat = rewriter.create<memref::CollapseShapeOp>(loc, accumulator,
+                                                        reassociation);
+  // The cascade interface carries 512-bit vectors of i32.
+  auto vectorType = VectorType::get({lanes}, elementType);
+  auto cascadeType = VectorType::get({512 / 32}, rewriter.getI32Type());
+  Value lb = rewriter.create<arith::ConstantIndexOp>(loc, 0);
+  Value ub = rewriter.create<arith::ConstantIndexOp>(loc, numElements);
+  Value step = rewriter.create<arith::ConstantIndexOp>(loc, lanes);
+  auto forOp = rewriter.create<scf::ForOp>(loc, lb, ub, step);
+  rewriter.setInsertionPointToStart(forOp.getBody());
+  Value iv = forOp.getInductionVar();
+  Value partial =
+      rewriter.create<vector::LoadOp>(loc, vectorType, flat, ValueRange{iv});
+  if (receive) {
+    Value received =
+        rewriter.create<xilinx::AIE::GetCascadeOp>(loc, cascadeType);
+    if (vectorType != cascadeType) {
+      received = rewriter.create<vector::BitCastOp>(loc, vectorType, received);
+    }
+    if (isa<FloatType>(elementType)) {
+      partial = rewriter.create<arith::AddFOp>(loc, partial, received);
+    } else {
+      partial = rewriter.create<arith::AddIOp>(loc, partial, received);
+    }
+  }
+  if (send) {
+    Value toSend = partial;
+    if (vectorType != cascadeType) {
+      toSend = rewriter.create<vector::BitCastOp>(loc, cascadeType, toSend);
+    }
+    rewriter.create<xilinx::AIE::PutCascadeOp>(loc, toSend);
+  } else {
+    rewriter.create<vector::StoreOp>(loc, partial, flat, ValueRange{iv});
+  }
+  return success();
+}
+
+/// Find the groups of cores writing back to the same region of shared memory
+/// and chain their accumulators over the cascade interface. The cores of a
+/// group need to be direct neighbours within a single row.
+LogicalResult chainCascadeAccumulators(Operation *op) {
+  IRRewriter rewriter(op->getContext());
+  SmallVector<SmallVector<AccumulatorProducer>> groups;
+  WalkResult res = op->walk([&](AMDAIE::LogicalObjectFifoProduce produceOp) {
+    auto coreOp = produceOp->getParentOfType<AMDAIE::CoreOp>();
+    AMDAIE::DmaCpyNdOp dmaOp = produceOp.getDmaCpyNdOp();
+    if (!coreOp || !dmaOp) return WalkResult::advance();
+    auto tileOp = coreOp.getTileOp();
+    std::optional<int64_t> col = getConstantIntValue(tileOp.getCol());
+    std::optional<int64_t> row = getConstantIntValue(tileOp.getRow());
+    if (!col || !row) {
+      coreOp.emitOpError() << "needs to be placed on a constant tile to "
+                              "chain accumulators";
+      return WalkResult::interrupt();
+    }
+    AccumulatorProducer producer{coreOp, produceOp, dmaOp, col.value(),
+                                 row.value()};
+    auto it = llvm::find_if(groups, [&](ArrayRef<AccumulatorProducer> group) {
+      return haveSameTarget(group.front().dmaOp, dmaOp);
+    });
+    if (it == groups.end()) {
+      groups.push_back({producer});
+    } else {
+      it->push_back(producer);
+    }
+    return WalkResult::advance();
+  });
+  if (res.wasInterrupted()) return failure();
+
+  for (SmallVector<AccumulatorProducer> &group : groups) {
+    if (group.size() < 2) continue;
+    llvm::sort(group, [](const AccumulatorProducer &a,
+                         const AccumulatorProducer &b) {
+      return std::tie(a.col, a.row) < std::tie(b.col, b.row);
+    });
+    // A core writing back the same region repeatedly isn't a split reduction.
+    if (llvm::adjacent_find(group, [](const AccumulatorProducer &a,
+                                      const AccumulatorProducer &b) {
+          return a.coreOp == b.coreOp;
+        }) != group.end()) {
+      continue;
+    }
+    for (auto [i, producer] : llvm::enumerate(group)) {
+      if (producer.row != group.front().row ||
+          producer.col != group.front().col + static_cast<int64_t>(i)) {
+        return producer.coreOp.emitOpError()
+               << "writes back to the same region as the core on tile ("
+               << group.front().col << ", " << group.front().row
+               << "), but isn't its neighbour in the same row, so their "
+                  "accumulators can't be chained over the cascade interface";
+      }
+    }
+    for (auto [i, producer] : llvm::enumerate(group)) {
+      bool isFirst = i == 0;
+      bool isLast = i == group.size() - 1;
+      if (failed(insertCascadeLoop(rewriter, producer, !isFirst, !isLast))) {
+        return failure();
+      }
+      if (isLast) continue;
+      // Only the last core of the chain writes back the complete result.
+      rewriter.eraseOp(producer.produceOp);
+      if (producer.dmaOp->use_empty()) rewriter.eraseOp(producer.dmaOp);
+    }
+  }
+  return success();
+}
+
+class AMDAIEChainCascadeAccumulatorsPass
+    : public impl::AMDAIEChainCascadeAccumulatorsBase<
+          AMDAIEChainCascadeAccumulatorsPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<AMDAIEDialect, arith::ArithDialect, memref::MemRefDialect,
+                    scf::SCFDialect, vector::VectorDialect,
+                    xilinx::AIE::AIEDialect>();
+  }
+
+  AMDAIEChainCascadeAccumulatorsPass() = default;
+  AMDAIEChainCascadeAccumulatorsPass(
+      const AMDAIEChainCascadeAccumulatorsPass &pass){};
+  void runOnOperation() override;
+};
+
+void AMDAIEChainCascadeAccumulatorsPass::runOnOperation() {
+  if (failed(chainCascadeAccumulators(getOperation()))) {
+    return signalPassFailure();
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<Pass> createAMDAIEChainCascadeAccumulatorsPass() {
+  return std::make_unique<AMDAIEChainCascadeAccumulatorsPass>();
+}
+
+}  // namespace mlir::iree_compiler::AMDAIE
@@ -5,17 +5,269 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #include "iree-amd-aie/IR/AMDAIEOps.h"
+#include "iree-amd-aie/Transforms/AMDAIEDmaUtils.h"
 #include "iree-amd-aie/Transforms/Passes.h"
 #include "iree-amd-aie/Transforms/Transforms.h"
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/SCF/Transforms/Transforms.h"
 #include "mlir/Dialect/SCF/Utils/Utils.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "mlir/Support/MathExtras.h"
 
 #define DEBUG_TYPE "iree-amdaie-controlcode-loop-unroll"
 
 namespace mlir::iree_compiler::AMDAIE {
 
-/// Unroll all scf.forall and scf.for loops inside the control code region.
+namespace {
+
+/// Evaluate `value` for the iteration of `forOp` with induction variable value
+/// `iv` by constant folding its producers. Returns `std::nullopt` if `value`
+/// depends on anything else than constants and the induction variable.
+std::optional<int64_t> evaluateAtIteration(Value value, scf::ForOp forOp,
+                                           int64_t iv) {
+  if (value == forOp.getInductionVar()) return iv;
+  if (std::optional<int64_t> cst = getConstantIntValue(value)) return cst;
+  Operation *op = value.getDefiningOp();
+  if (!op || op->getNumResults() != 1 || !isMemoryEffectFree(op))
+    return std::nullopt;
+  SmallVector<Attribute> operandAttrs;
+  for (Value operand : op->getOperands()) {
+    std::optional<int64_t> operandValue =
+        evaluateAtIteration(operand, forOp, iv);
+    if (!operandValue) return std::nullopt;
+    operandAttrs.push_back(
+        IntegerAttr::get(operand.getType(), operandValue.value()));
+  }
+  SmallVector<OpFoldResult> results;
+  if (failed(op->fold(operandAttrs, results)) || results.size() != 1)
+    return std::nullopt;
+  return getConstantIntValue(results[0]);
+}
+
+/// Evaluate the offset `ofr` for the iteration of `forOp` with induction
+/// variable value `iv`.
+std::optional<int64_t> evaluateAtIteration(OpFoldResult ofr, scf::ForOp forOp,
+                                           int64_t iv) {
+  if (std::optional<int64_t> cst = getConstantIntValue(ofr)) return cst;
+  return evaluateAtIteration(ofr.get<Value>(), forOp, iv);
+}
+
+/// Return whether `value` is guaranteed to be a linear function of the
+/// induction variable of `forOp`, so that sampling two iterations is enough to
+/// know the value on all iterations.
+bool isLinearInInductionVar(Value value, scf::ForOp forOp) {
+  if (value == forOp.getInductionVar() || getConstantIntValue(value))
+    return true;
+  Operation *op = value.getDefiningOp();
+  if (!op) return false;
+  if (isa<arith::AddIOp, arith::SubIOp>(op)) {
+    return isLinearInInductionVar(op->getOperand(0), forOp) &&
+           isLinearInInductionVar(op->getOperand(1), forOp);
+  }
+  if (isa<arith::MulIOp>(op)) {
+    return (getConstantIntValue(op->getOperand(0)) &&
+            isLinearInInductionVar(op->getOperand(1), forOp)) ||
+           (getConstantIntValue(op->getOperand(1)) &&
+            isLinearInInductionVar(op->getOperand(0), forOp));
+  }
+  if (auto applyOp = dyn_cast<affine::AffineApplyOp>(op)) {
+    return applyOp.getAffineMap().getResult(0).isPureAffine() &&
+           llvm::all_of(applyOp.getMapOperands(), [&](Value operand) {
+             return isLinearInInductionVar(operand, forOp);
+           });
+  }
+  return false;
+}
+
+/// Compute the L3 access pattern of `npuDmaOp` with the iterations of `forOp`
+/// rolled into an additional outer dimension, which maps onto the iteration
+/// dimension (repeat count) of the shim tile BD. Fails if consecutive
+/// iterations don't differ by a constant address offset or if the rolled
+/// access pattern doesn't fit within a single BD. A dynamic `tripCount` is
+/// represented by a size of 1, to be replaced by the caller.
+LogicalResult getRolledAccessPattern(MLIRContext *ctx, scf::ForOp forOp,
+                                     AMDAIE::NpuDmaCpyNdOp npuDmaOp,
+                                     int64_t lb, int64_t step,
+                                     std::optional<int64_t> tripCount,
+                                     SmallVector<OpFoldResult> &newOffsets,
+                                     SmallVector<OpFoldResult> &sizes,
+                                     SmallVector<OpFoldResult> &strides) {
+  // Only the L3 side of the Npu DMA operation is addressed by the
+  // uController.
+  bool sourceAddressing = npuDmaOp.hasSourceAddressing();
+  if (sourceAddressing == npuDmaOp.hasTargetAddressing()) return failure();
+  SmallVector<OpFoldResult> offsets = sourceAddressing
+                                          ? npuDmaOp.getSourceMixedOffsets()
+                                          : npuDmaOp.getTargetMixedOffsets();
+  sizes = sourceAddressing ? npuDmaOp.getSourceMixedSizes()
+                           : npuDmaOp.getTargetMixedSizes();
+  strides = sourceAddressing ? npuDmaOp.getSourceMixedStrides()
+                             : npuDmaOp.getTargetMixedStrides();
+
+  // The sizes and strides need to be static and the address offset between
+  // consecutive iterations needs to be constant.
+  SmallVector<int64_t> staticStrides;
+  for (OpFoldResult ofr : llvm::concat<OpFoldResult>(sizes, strides)) {
+    if (!getConstantIntValue(ofr)) return failure();
+  }
+  for (OpFoldResult stride : strides)
+    staticStrides.push_back(getConstantIntValue(stride).value());
+  // With a dynamic trip count, the iterations can't all be evaluated, so the
+  // offsets need to be linear in the induction variable instead.
+  if (!tripCount && !llvm::all_of(offsets, [&](OpFoldResult offset) {
+        return getConstantIntValue(offset) ||
+               isLinearInInductionVar(offset.get<Value>(), forOp);
+      })) {
+    return failure();
+  }
+  int64_t nbEvaluatedIterations = tripCount ? tripCount.value() : 2;
+  int64_t firstAddress = 0;
+  int64_t addressStride = 0;
+  for (int64_t i = 0; i < nbEvaluatedIterations; i++) {
+    int64_t iv = lb + i * step;
+    int64_t address = 0;
+    for (auto &&[offset, stride] : llvm::zip(offsets, staticStrides)) {
+      std::optional<int64_t> offsetValue =
+          evaluateAtIteration(offset, forOp, iv);
+      if (!offsetValue) return failure();
+      if (i == 0)
+        newOffsets.push_back(getAsIndexOpFoldResult(ctx, *offsetValue));
+      address += offsetValue.value() * stride;
+    }
+    if (i == 0) {
+      firstAddress = address;
+    } else if (i == 1) {
+      addressStride = address - firstAddress;
+    } else if (address - firstAddress != i * addressStride) {
+      return failure();
+    }
+  }
+  if (addressStride < 0) return failure();
+
+  if (failed(padToShimIntraDims(ctx, newOffsets, sizes, strides)))
+    return failure();
+  newOffsets.insert(newOffsets.begin(), getAsIndexOpFoldResult(ctx, 0));
+  sizes.insert(sizes.begin(),
+               getAsIndexOpFoldResult(ctx, tripCount.value_or(1)));
+  strides.insert(strides.begin(), getAsIndexOpFoldResult(ctx, addressStride));
+  // A dynamic trip count is counted as a single repetition here. Whether the
+  // actual trip count fits within the iteration dimension is checked when it's
+  // patched into the instruction stream.
+  AMDAIE::CircularDmaCpyNdOp dmaOp = npuDmaOp.getDmaCpyNdOp();
+  if (!dmaOp) return failure();
+  AMDAIE::LogicalObjectFifoFromMemrefOp l3ObjectFifo =
+      sourceAddressing ? dmaOp.getSourceObjectFifo()
+                       : dmaOp.getTargetObjectFifo();
+  int64_t elemBitWidth = l3ObjectFifo.getMemrefType().getElementTypeBitWidth();
+  FailureOr<int64_t> nbBDs = getNbBDs(
+      sizes, strides, getDmaDimConfig(AMDAIEMemSpace::Global, elemBitWidth));
+  if (failed(nbBDs) || nbBDs.value() != 1) return failure();
+  return success();
+}
+
+/// Roll the iterations of the Npu DMA operations issued by `forOp` into single
+/// Npu DMA operations before the loop, each with an additional outer
+/// dimension for the iterations. This keeps the size of the control code
+/// independent of the trip count. Every Npu DMA operation is rolled on its
+/// own, as long as it's the only one in the loop using its DMA connection and
+/// consecutive iterations only differ by a constant address offset. The waits
+/// on the rolled DMAs are replaced by a single wait each after the loop, so
+/// the transfers remaining in the loop can make progress in the meantime.
+///
+/// Loops with a dynamic upper bound are rolled as well, with a dynamic size
+/// for the iteration dimension. This size is resolved at dispatch time by
+/// patching the instruction stream.
+///
+/// Returns success if all Npu DMA operations of the loop were rolled and the
+/// loop was erased. Otherwise, the loop is left with the Npu DMA operations
+/// that couldn't be rolled.
+LogicalResult rollLoopIntoNpuDmas(RewriterBase &rewriter, scf::ForOp forOp) {
+  if (forOp.getNumResults() != 0) return failure();
+  std::optional<int64_t> lb = getConstantIntValue(forOp.getLowerBound());
+  std::optional<int64_t> ub = getConstantIntValue(forOp.getUpperBound());
+  std::optional<int64_t> step = getConstantIntValue(forOp.getStep());
+  if (!lb || !step || step.value() <= 0) return failure();
+  std::optional<int64_t> tripCount;
+  if (ub) tripCount = mlir::ceilDiv(ub.value() - lb.value(), step.value());
+
+  SmallVector<AMDAIE::NpuDmaCpyNdOp> npuDmaOps;
+  SmallVector<AMDAIE::NpuDmaWaitOp> waitOps;
+  DenseMap<Value, int64_t> nbNpuDmaOpsPerConnection;
+  for (Operation &op : forOp.getBody()->without_terminator()) {
+    if (auto dmaOp = dyn_cast<AMDAIE::NpuDmaCpyNdOp>(op)) {
+      npuDmaOps.push_back(dmaOp);
+      nbNpuDmaOpsPerConnection[dmaOp.getDma()]++;
+    } else if (auto waitOp = dyn_cast<AMDAIE::NpuDmaWaitOp>(op)) {
+      waitOps.push_back(waitOp);
+    } else if (op.getNumRegions() != 0 || !isMemoryEffectFree(&op)) {
+      return failure();
+    }
+  }
+  if (npuDmaOps.empty()) return failure();
+
+  MLIRContext *ctx = rewriter.getContext();
+  Value dynamicTripCount;
+  Operation *lastWaitOp = forOp;
+  for (AMDAIE::NpuDmaCpyNdOp npuDmaOp : npuDmaOps) {
+    // Rolling reorders the transfers of different Npu DMA operations, which is
+    // only valid if they don't share a DMA connection.
+    if (nbNpuDmaOpsPerConnection[npuDmaOp.getDma()] != 1) continue;
+    SmallVector<AMDAIE::NpuDmaWaitOp> dmaWaitOps = llvm::to_vector(
+        llvm::make_filter_range(waitOps, [&](AMDAIE::NpuDmaWaitOp waitOp) {
+          return waitOp.getDma() == npuDmaOp.getResult();
+        }));
+    if (!llvm::all_of(dmaWaitOps, [&](AMDAIE::NpuDmaWaitOp waitOp) {
+          return waitOp.getDirection() == dmaWaitOps[0].getDirection();
+        })) {
+      continue;
+    }
+    SmallVector<OpFoldResult> offsets, sizes, strides;
+    if (failed(getRolledAccessPattern(ctx, forOp, npuDmaOp, lb.value(),
+                                      step.value(), tripCount, offsets, sizes,
+                                      strides))) {
+      continue;
+    }
+
+    rewriter.setInsertionPoint(forOp);
+    if (!tripCount && !dynamicTripCount) {
+      Location loc = forOp.getLoc();
+      Value range = rewriter.create<arith::SubIOp>(loc, forOp.getUpperBound(),
+                                                   forOp.getLowerBound());
+      dynamicTripCount =
+          rewriter.create<arith::CeilDivSIOp>(loc, range, forOp.getStep());
+    }
+    if (!tripCount) sizes[0] = dynamicTripCount;
+    SmallVector<OpFoldResult> empty;
+    auto newNpuDmaOp =
+        npuDmaOp.hasSourceAddressing()
+            ? rewriter.create<AMDAIE::NpuDmaCpyNdOp>(
+                  npuDmaOp.getLoc(), npuDmaOp.getDma(), empty, empty, empty,
+                  offsets, sizes, strides)
+            : rewriter.create<AMDAIE::NpuDmaCpyNdOp>(
+                  npuDmaOp.getLoc(), npuDmaOp.getDma(), offsets, sizes,
+                  strides, empty, empty, empty);
+    if (!dmaWaitOps.empty()) {
+      rewriter.setInsertionPointAfter(lastWaitOp);
+      lastWaitOp = rewriter.create<AMDAIE::NpuDmaWaitOp>(
+          dmaWaitOps[0].getLoc(), SmallVector<Type, 1>{},
+          newNpuDmaOp.getResult(), dmaWaitOps[0].getDirection());
+    }
+    for (AMDAIE::NpuDmaWaitOp waitOp : dmaWaitOps) rewriter.eraseOp(waitOp);
+    rewriter.eraseOp(npuDmaOp);
+  }
+  if (!llvm::all_of(forOp.getBody()->without_terminator(),
+                    [](Operation &op) { return isMemoryEffectFree(&op); })) {
+    return failure();
+  }
+  rewriter.eraseOp(forOp);
+  return success();
+}
+
+}  // namespace
+
+/// Unroll all scf.forall and scf.for loops inside the control code region,
+/// except for loops that can be rolled into a single Npu DMA operation.
 LogicalResult controlCodeLoopUnroll(RewriterBase &rewriter,
                                     AMDAIE::ControlCodeOp controlCodeOp) {
   // Convert all scf.forall in the control code region to scf.for.
@@ -33,36 +285,42 @@ LogicalResult controlCodeLoopUnroll(RewriterBase &rewriter,
   });
   if (forallRes.wasInterrupted()) return failure();
 
-  // Unroll all scf.for loops in the control code region.
-  WalkResult res =
-      controlCodeOp.walk([&](scf::ForOp forOp) {
-        // TODO(avarma): Remove this after upstream fix.
-        rewriter.setInsertionPoint(forOp);
-        if (succeeded(forOp.promoteIfSingleIteration(rewriter))) {
-          return WalkResult::advance();
-        }
-        std::optional<int64_t> lbCstOp =
-            getConstantIntValue(forOp.getLowerBound());
-        std::optional<int64_t> ubCstOp =
-            getConstantIntValue(forOp.getUpperBound());
-        std::optional<int64_t> stepCstOp = getConstantIntValue(forOp.getStep());
-        if (lbCstOp && ubCstOp && stepCstOp) {
-          int64_t lbInt = lbCstOp.value();
-          int64_t ubInt = ubCstOp.value();
-          int64_t stepInt = stepCstOp.value();
-          int64_t tripCount = mlir::ceilDiv(ubInt - lbInt, stepInt);
-          if (failed(loopUnrollByFactor(forOp, tripCount))) {
-            forOp.emitOpError() << "failed to unroll scf.for";
-            return WalkResult::interrupt();
-          }
-        } else {
-          forOp.emitOpError()
-              << "failed to unroll scf.for with dynamic bounds or step size";
-          return WalkResult::interrupt();
-        }
-        return WalkResult::advance();
-      });
-  if (res.wasInterrupted()) return failure();
+  // Roll or unroll all scf.for loops in the control code region, from the
+  // outermost to the innermost ones. Unrolling the outer loops first makes the
+  // offsets within the inner loops only depend on constants and their own
+  // induction variables, so the inner loops can still be rolled.
+  auto rollOrUnrollLoop = [&](scf::ForOp forOp) -> LogicalResult {
+    // TODO(avarma): Remove this after upstream fix.
+    rewriter.setInsertionPoint(forOp);
+    if (succeeded(forOp.promoteIfSingleIteration(rewriter))) return success();
+    if (succeeded(rollLoopIntoNpuDmas(rewriter, forOp))) return success();
+    std::optional<int64_t> lbCstOp = getConstantIntValue(forOp.getLowerBound());
+    std::optional<int64_t> ubCstOp = getConstantIntValue(forOp.getUpperBound());
+    std::optional<int64_t> stepCstOp = getConstantIntValue(forOp.getStep());
+    if (!lbCstOp || !ubCstOp || !stepCstOp) {
+      return forOp.emitOpError()
+             << "failed to unroll scf.for with dynamic bounds or step size";
+    }
+    int64_t lbInt = lbCstOp.value();
+    int64_t ubInt = ubCstOp.value();
+    int64_t stepInt = stepCstOp.value();
+    int64_t tripCount = mlir::ceilDiv(ubInt - lbInt, stepInt);
+    if (failed(loopUnrollByFactor(forOp, tripCount))) {
+      return forOp.emitOpError() << "failed to unroll scf.for";
+    }
+    return success();
+  };
+  SmallVector<scf::ForOp> forOps;
+  do {
+    forOps.clear();
+    controlCodeOp->walk<WalkOrder::PreOrder>([&](scf::ForOp forOp) {
+      forOps.push_back(forOp);
+      return WalkResult::skip();
+    });
+    for (scf::ForOp forOp : forOps) {
+      if (failed(rollOrUnrollLoop(forOp))) return failure();
+    }
+  } while (!forOps.empty());
   return success();
 }
 
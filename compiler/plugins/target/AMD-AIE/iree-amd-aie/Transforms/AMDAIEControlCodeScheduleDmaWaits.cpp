@@ -0,0 +1,117 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree-amd-aie/IR/AMDAIEDialect.h"
+#include "iree-amd-aie/IR/AMDAIEOps.h"
+#include "iree-amd-aie/Transforms/Passes.h"
+#include "llvm/ADT/SetVector.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+
+#define DEBUG_TYPE "iree-amdaie-controlcode-schedule-dma-waits"
+
+namespace mlir::iree_compiler::AMDAIE {
+
+namespace {
+
+/// Return the connection, i.e. the circular DMA operation, the provided wait
+/// operation is waiting on. All Npu DMA operations on the same connection are
+/// executed in order on the same DMA channel.
+Value getConnection(AMDAIE::NpuDmaWaitOp waitOp) {
+  AMDAIE::NpuDmaCpyNdOp npuDmaOp = waitOp.getDmaOp();
+  return npuDmaOp ? npuDmaOp.getDma() : Value();
+}
+
+/// Return whether a wait operation on `connection` can be moved past `op`.
+/// This is the case for operations without memory effects and for Npu DMA
+/// operations and waits on other connections. A wait needs to stay before the
+/// next DMA on the same connection as the DMA's buffer descriptor is reused.
+bool canSinkWaitPast(Operation *op, Value connection) {
+  if (op->hasTrait<OpTrait::IsTerminator>()) return false;
+  if (auto npuDmaOp = dyn_cast<AMDAIE::NpuDmaCpyNdOp>(op))
+    return npuDmaOp.getDma() != connection;
+  if (isa<AMDAIE::NpuDmaWaitOp>(op)) return true;
+  return op->getNumRegions() == 0 && isMemoryEffectFree(op);
+}
+
+/// Sink the wait operations within `block` as late as their dependencies
+/// allow. Waits are never moved out of their block, so they only overlap with
+/// the DMAs of later loop iterations once those loops have been unrolled. This
+/// lets DMAs on other connections, for example the inputs of the next
+/// iteration, be issued before waiting on the current output.
+void sinkDmaWaits(RewriterBase &rewriter, Block *block) {
+  SmallVector<AMDAIE::NpuDmaWaitOp> waitOps =
+      llvm::to_vector(block->getOps<AMDAIE::NpuDmaWaitOp>());
+  // Visit the waits from last to first, so every wait can be sunk past the
+  // waits following it.
+  for (AMDAIE::NpuDmaWaitOp waitOp : llvm::reverse(waitOps)) {
+    Value connection = getConnection(waitOp);
+    if (!connection) continue;
+    Operation *insertBefore = waitOp->getNextNode();
+    while (insertBefore && canSinkWaitPast(insertBefore, connection))
+      insertBefore = insertBefore->getNextNode();
+    if (insertBefore && insertBefore != waitOp->getNextNode())
+      rewriter.moveOpBefore(waitOp, insertBefore);
+  }
+}
+
+/// Merge waits on the same connection and in the same direction, without
+/// another DMA on that connection in between. As DMAs on the same connection
+/// complete in order, a wait on the later DMA implies the wait on the earlier
+/// one, so the wait on the earlier DMA can be removed.
+void mergeDmaWaits(RewriterBase &rewriter, Block *block) {
+  llvm::SmallSetVector<Operation *, 8> toBeErased;
+  for (AMDAIE::NpuDmaWaitOp waitOp : block->getOps<AMDAIE::NpuDmaWaitOp>()) {
+    Value connection = getConnection(waitOp);
+    if (!connection) continue;
+    for (Operation *op = waitOp->getNextNode(); op; op = op->getNextNode()) {
+      if (auto nextWaitOp = dyn_cast<AMDAIE::NpuDmaWaitOp>(op)) {
+        if (getConnection(nextWaitOp) != connection) continue;
+        if (nextWaitOp.getDirection() != waitOp.getDirection()) break;
+        Operation *dmaOp = waitOp.getDmaOp();
+        Operation *nextDmaOp = nextWaitOp.getDmaOp();
+        if (dmaOp->getBlock() != nextDmaOp->getBlock()) break;
+        toBeErased.insert(dmaOp->isBeforeInBlock(nextDmaOp) ? waitOp
+                                                            : nextWaitOp);
+        break;
+      }
+      if (!canSinkWaitPast(op, connection)) break;
+    }
+  }
+  for (Operation *waitOp : toBeErased) rewriter.eraseOp(waitOp);
+}
+
+class AMDAIEControlCodeScheduleDmaWaitsPass
+    : public impl::AMDAIEControlCodeScheduleDmaWaitsBase<
+          AMDAIEControlCodeScheduleDmaWaitsPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<AMDAIEDialect>();
+  }
+
+  AMDAIEControlCodeScheduleDmaWaitsPass() = default;
+  AMDAIEControlCodeScheduleDmaWaitsPass(
+      const AMDAIEControlCodeScheduleDmaWaitsPass &pass){};
+  void runOnOperation() override;
+};
+
+void AMDAIEControlCodeScheduleDmaWaitsPass::runOnOperation() {
+  Operation *parentOp = getOperation();
+  IRRewriter rewriter(parentOp->getContext());
+  parentOp->walk([&](AMDAIE::ControlCodeOp controlCodeOp) {
+    controlCodeOp->walk([&](Block *block) {
+      sinkDmaWaits(rewriter, block);
+      mergeDmaWaits(rewriter, block);
+    });
+  });
+}
+
+}  // namespace
+
+std::unique_ptr<Pass> createAMDAIEControlCodeScheduleDmaWaitsPass() {
+  return std::make_unique<AMDAIEControlCodeScheduleDmaWaitsPass>();
+}
+
+}  // namespace mlir::iree_compiler::AMDAIE
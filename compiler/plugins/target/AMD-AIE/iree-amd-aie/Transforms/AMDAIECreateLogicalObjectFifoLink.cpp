@@ -7,12 +7,61 @@
 #include "iree-amd-aie/IR/AMDAIEOps.h"
 #include "iree-amd-aie/Transforms/Passes.h"
 #include "iree-amd-aie/Transforms/Transforms.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
 #include "mlir/Support/LogicalResult.h"
 
 #define DEBUG_TYPE "iree-amdaie-create-logical-objectfifo-link"
 
 namespace mlir::iree_compiler::AMDAIE {
 
+namespace {
+
+/// Return the static base offset, in elements, of the access pattern of
+/// `copyOp` on its source or target, or `std::nullopt` if it isn't static. An
+/// empty access pattern starts at the beginning of the buffer.
+std::optional<int64_t> getStaticBaseOffset(CopyOpInterface copyOp,
+                                           CopyOpOperateOn operateOn) {
+  auto stridedOp =
+      dyn_cast<AMDAIE::DoublyStridedOpInterface>(copyOp.getOperation());
+  if (!stridedOp) return std::nullopt;
+  bool onSource = operateOn == CopyOpOperateOn::Source;
+  SmallVector<OpFoldResult> offsets = onSource
+                                          ? stridedOp.getSourceMixedOffsets()
+                                          : stridedOp.getTargetMixedOffsets();
+  SmallVector<OpFoldResult> strides = onSource
+                                          ? stridedOp.getSourceMixedStrides()
+                                          : stridedOp.getTargetMixedStrides();
+  int64_t baseOffset = 0;
+  for (auto &&[offset, stride] : llvm::zip(offsets, strides)) {
+    std::optional<int64_t> constantOffset = getConstantIntValue(offset);
+    std::optional<int64_t> constantStride = getConstantIntValue(stride);
+    if (!constantOffset || !constantStride) return std::nullopt;
+    baseOffset += constantOffset.value() * constantStride.value();
+  }
+  return baseOffset;
+}
+
+/// Sort the copy operations on the base offset at which they access the
+/// linked buffer, as an `aie.objectfifo.link` places its inputs (join) or
+/// outputs (distribute) in order within the buffer. The order is left
+/// untouched if not all base offsets are static.
+void sortOnBaseOffset(SmallVector<CopyOpInterface> &copyOps,
+                      CopyOpOperateOn operateOn) {
+  SmallVector<std::pair<int64_t, CopyOpInterface>> offsetsAndOps;
+  for (CopyOpInterface copyOp : copyOps) {
+    std::optional<int64_t> baseOffset = getStaticBaseOffset(copyOp, operateOn);
+    if (!baseOffset) return;
+    offsetsAndOps.push_back({baseOffset.value(), copyOp});
+  }
+  llvm::stable_sort(offsetsAndOps, [](const auto &a, const auto &b) {
+    return a.first < b.first;
+  });
+  copyOps = llvm::map_to_vector(offsetsAndOps,
+                                [](const auto &elem) { return elem.second; });
+}
+
+}  // namespace
+
 /// Utility to add explicit link operations to avoid having to do this during
 /// conversion to AIEDialect operations. This function only consider L2/MT for
 /// links as L1/L3 don't need this linking through AIE objectFifos. Furthermore,
@@ -30,8 +79,8 @@ LogicalResult createLogicalObjectFifoLink(
   // either the input or output side of this logical objectFifo. While
   // doing this, keep track of the last user operation for insertion
   // purposes.
-  SmallVector<OpFoldResult> ins;
-  SmallVector<OpFoldResult> outs;
+  SmallVector<CopyOpInterface> ins;
+  SmallVector<CopyOpInterface> outs;
   CopyOpInterface lastUserOp;
   for (Operation *userOp : logicalObjectFifo->getUsers()) {
     if (auto copyOp = dyn_cast<CopyOpInterface>(userOp)) {
@@ -52,22 +101,25 @@ LogicalResult createLogicalObjectFifoLink(
         lastUserOp = copyOp;
       }
       if (logicalObjectFifo == sourceLogicalObjectFifo) {
-        outs.push_back(copyOp->getResult(0));
+        outs.push_back(copyOp);
       } else {
-        ins.push_back(copyOp->getResult(0));
+        ins.push_back(copyOp);
       }
     }
   }
+  sortOnBaseOffset(ins, CopyOpOperateOn::Target);
+  sortOnBaseOffset(outs, CopyOpOperateOn::Source);
 
   // Insert the `LogicalObjectFifoLink` after the last user operation.
   if (lastUserOp) {
     rewriter.setInsertionPointAfter(lastUserOp);
+    auto getResults = [](ArrayRef<CopyOpInterface> copyOps) {
+      return llvm::map_to_vector(copyOps, [](CopyOpInterface copyOp) {
+        return copyOp->getResult(0);
+      });
+    };
     rewriter.create<AMDAIE::LogicalObjectFifoLink>(
-        rewriter.getUnknownLoc(),
-        getValueOrCreateConstantIndexOp(rewriter, rewriter.getUnknownLoc(),
-                                        ins),
-        getValueOrCreateConstantIndexOp(rewriter, rewriter.getUnknownLoc(),
-                                        outs));
+        rewriter.getUnknownLoc(), getResults(ins), getResults(outs));
   }
   return success();
 }
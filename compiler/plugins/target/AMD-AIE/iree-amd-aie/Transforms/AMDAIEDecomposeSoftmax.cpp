@@ -0,0 +1,55 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree-amd-aie/Transforms/Passes.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-amdaie-decompose-softmax"
+
+namespace mlir::iree_compiler::AMDAIE {
+
+namespace {
+
+class AMDAIEDecomposeSoftmaxPass
+    : public impl::AMDAIEDecomposeSoftmaxBase<AMDAIEDecomposeSoftmaxPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithDialect, linalg::LinalgDialect,
+                    math::MathDialect, tensor::TensorDialect>();
+  }
+
+  AMDAIEDecomposeSoftmaxPass() = default;
+  AMDAIEDecomposeSoftmaxPass(const AMDAIEDecomposeSoftmaxPass &pass){};
+  void runOnOperation() override;
+};
+
+void AMDAIEDecomposeSoftmaxPass::runOnOperation() {
+  IRRewriter rewriter(&getContext());
+  WalkResult res = getOperation()->walk([&](linalg::SoftmaxOp softmaxOp) {
+    rewriter.setInsertionPoint(softmaxOp);
+    FailureOr<SmallVector<Value>> results =
+        softmaxOp.decomposeOperation(rewriter);
+    if (failed(results)) {
+      softmaxOp.emitOpError("failed to decompose");
+      return WalkResult::interrupt();
+    }
+    rewriter.replaceOp(softmaxOp, *results);
+    return WalkResult::advance();
+  });
+  if (res.wasInterrupted()) return signalPassFailure();
+}
+
+}  // namespace
+
+std::unique_ptr<Pass> createAMDAIEDecomposeSoftmaxPass() {
+  return std::make_unique<AMDAIEDecomposeSoftmaxPass>();
+}
+
+}  // namespace mlir::iree_compiler::AMDAIE
@@ -0,0 +1,290 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree-amd-aie/IR/AMDAIEDialect.h"
+#include "iree-amd-aie/IR/AMDAIEOps.h"
+#include "iree-amd-aie/Transforms/AMDAIEDmaUtils.h"
+#include "iree-amd-aie/Transforms/Passes.h"
+#include "llvm/ADT/DenseMap.h"
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+
+#include <numeric>
+
+#define DEBUG_TYPE "iree-amdaie-distribute-l3-dma"
+
+namespace mlir::iree_compiler::AMDAIE {
+
+namespace {
+
+/// The number of DMA channels per direction on a shim tile respectively a
+/// memory tile.
+constexpr int64_t kShimTileNbChannels = 2;
+constexpr int64_t kMemTileNbChannels = 6;
+
+/// The number of bytes a single DMA channel streams per cycle (32-bit stream).
+constexpr int64_t kChannelBytesPerCycle = 4;
+
+/// Simple bandwidth model for transfers between L3 and L2. A transfer split
+/// over `n` shim DMA channels is bound by the aggregated stream bandwidth of
+/// those channels and by the DDR bandwidth available to the AIE array. Every
+/// part is configured and issued separately by the uController, which adds a
+/// fixed overhead per channel.
+struct ShimDmaBandwidthModel {
+  int64_t ddrBytesPerCycle;
+  int64_t setupCycles;
+
+  /// Return the estimated number of cycles to transfer `nbBytes` evenly split
+  /// over `nbChannels` shim DMA channels.
+  int64_t getCycles(int64_t nbBytes, int64_t nbChannels) const {
+    int64_t bytesPerCycle = std::max<int64_t>(
+        std::min(nbChannels * kChannelBytesPerCycle, ddrBytesPerCycle), 1);
+    return nbChannels * setupCycles + llvm::divideCeil(nbBytes, bytesPerCycle);
+  }
+};
+
+/// A DMA channel resource: the column and row of the tile and whether it's a
+/// MM2S (true) or S2MM (false) channel.
+using ChannelKey = std::tuple<int64_t, int64_t, bool>;
+
+/// Return the static location of the single tile a logical objectFifo is
+/// assigned to, or `std::nullopt` if there is no such tile.
+std::optional<std::pair<int64_t, int64_t>> getTileLocation(
+    AMDAIE::LogicalObjectFifoFromMemrefOp logicalObjectFifo) {
+  if (logicalObjectFifo.getTiles().size() != 1) return std::nullopt;
+  auto tileOp =
+      logicalObjectFifo.getTiles()[0].getDefiningOp<AMDAIE::TileOp>();
+  if (!tileOp) return std::nullopt;
+  std::optional<int64_t> col = getConstantIntValue(tileOp.getCol());
+  std::optional<int64_t> row = getConstantIntValue(tileOp.getRow());
+  if (!col || !row) return std::nullopt;
+  return std::make_pair(col.value(), row.value());
+}
+
+/// Count the DMA channels in use per shim and memory tile. Every copy
+/// operation from or to L3 and L2 occupies a channel on the tile its logical
+/// objectFifo is assigned to.
+DenseMap<ChannelKey, int64_t> getChannelUsage(Operation *parentOp) {
+  DenseMap<ChannelKey, int64_t> channelUsage;
+  auto addUsage = [&](Value value, bool isMM2S) {
+    auto logicalObjectFifo =
+        value.getDefiningOp<AMDAIE::LogicalObjectFifoFromMemrefOp>();
+    if (!logicalObjectFifo || logicalObjectFifo.getMemorySpaceAsUInt() > 1)
+      return;
+    for (Value tile : logicalObjectFifo.getTiles()) {
+      auto tileOp = tile.getDefiningOp<AMDAIE::TileOp>();
+      if (!tileOp) continue;
+      std::optional<int64_t> col = getConstantIntValue(tileOp.getCol());
+      std::optional<int64_t> row = getConstantIntValue(tileOp.getRow());
+      if (col && row) channelUsage[{col.value(), row.value(), isMM2S}]++;
+    }
+  };
+  parentOp->walk([&](CopyOpInterface copyOp) {
+    addUsage(copyOp.getSource(), /*isMM2S=*/true);
+    addUsage(copyOp.getTarget(), /*isMM2S=*/false);
+  });
+  return channelUsage;
+}
+
+/// Return the number of copy operations from (`onSource`) or to the provided
+/// logical objectFifo.
+int64_t getNbCopyUsers(AMDAIE::LogicalObjectFifoFromMemrefOp logicalObjectFifo,
+                       bool onSource) {
+  return llvm::count_if(logicalObjectFifo->getUsers(), [&](Operation *user) {
+    auto copyOp = dyn_cast<CopyOpInterface>(user);
+    if (!copyOp) return false;
+    Value side = onSource ? copyOp.getSource() : copyOp.getTarget();
+    return side == logicalObjectFifo.getOutput();
+  });
+}
+
+/// Distribute a DMA operation between L3 and L2 over multiple shim DMA
+/// channels in different columns if the bandwidth model predicts a speedup.
+/// The L3 access pattern is split along its outermost non-unit dimension and
+/// every part transfers a contiguous slice of the L2 buffer. The parts end up
+/// being joined (L3 -> L2) or distributed (L2 -> L3) by the logical objectFifo
+/// link on the memory tile.
+LogicalResult distributeL3Dma(RewriterBase &rewriter, AMDAIE::DmaCpyNdOp dmaOp,
+                              int64_t numColumns,
+                              const ShimDmaBandwidthModel &model,
+                              DenseMap<ChannelKey, int64_t> &channelUsage) {
+  AMDAIE::LogicalObjectFifoFromMemrefOp source = dmaOp.getSourceObjectFifo();
+  AMDAIE::LogicalObjectFifoFromMemrefOp target = dmaOp.getTargetObjectFifo();
+  bool l3IsSource =
+      source.getMemorySpaceAsUInt() == 0 && target.getMemorySpaceAsUInt() == 1;
+  bool l3IsTarget =
+      source.getMemorySpaceAsUInt() == 1 && target.getMemorySpaceAsUInt() == 0;
+  if ((!l3IsSource && !l3IsTarget) || !dmaOp->use_empty()) return failure();
+  AMDAIE::LogicalObjectFifoFromMemrefOp l3ObjectFifo =
+      l3IsSource ? source : target;
+  AMDAIE::LogicalObjectFifoFromMemrefOp l2ObjectFifo =
+      l3IsSource ? target : source;
+
+  // The parts fill contiguous slices of the L2 buffer, so the L2 side needs to
+  // access the whole buffer contiguously. Furthermore, a link can't both join
+  // and distribute, so the L2 buffer should only be accessed by this DMA on
+  // the L3 side and by at most one DMA on the other side.
+  MemRefType l2Type = l2ObjectFifo.getMemrefType();
+  if (!l2Type.hasStaticShape() || !l2Type.getLayout().isIdentity())
+    return failure();
+  if (l3IsSource ? dmaOp.getTargetMixedOffsets().size()
+                 : dmaOp.getSourceMixedOffsets().size()) {
+    return failure();
+  }
+  if (getNbCopyUsers(l2ObjectFifo, /*onSource=*/l3IsTarget) != 1 ||
+      getNbCopyUsers(l2ObjectFifo, /*onSource=*/l3IsSource) > 1) {
+    return failure();
+  }
+
+  MLIRContext *ctx = rewriter.getContext();
+  SmallVector<OpFoldResult> offsets = l3IsSource
+                                          ? dmaOp.getSourceMixedOffsets()
+                                          : dmaOp.getTargetMixedOffsets();
+  SmallVector<OpFoldResult> sizes = l3IsSource ? dmaOp.getSourceMixedSizes()
+                                               : dmaOp.getTargetMixedSizes();
+  SmallVector<OpFoldResult> strides = l3IsSource
+                                          ? dmaOp.getSourceMixedStrides()
+                                          : dmaOp.getTargetMixedStrides();
+  if (failed(makeAccessPatternExplicit(ctx, l3ObjectFifo.getMemrefType(),
+                                       offsets, sizes, strides))) {
+    return failure();
+  }
+  std::optional<SmallVector<int64_t>> staticSizes =
+      getConstantIntValues(sizes);
+  if (!staticSizes) return failure();
+  int64_t nbElements =
+      std::accumulate(staticSizes->begin(), staticSizes->end(), int64_t{1},
+                      std::multiplies<>());
+  if (nbElements != l2Type.getNumElements()) return failure();
+  auto splitDimIt =
+      llvm::find_if(staticSizes.value(), [](int64_t size) { return size > 1; });
+  if (splitDimIt == staticSizes->end()) return failure();
+  size_t splitDim = std::distance(staticSizes->begin(), splitDimIt);
+  int64_t splitDimSize = *splitDimIt;
+
+  std::optional<std::pair<int64_t, int64_t>> l3Location =
+      getTileLocation(l3ObjectFifo);
+  std::optional<std::pair<int64_t, int64_t>> l2Location =
+      getTileLocation(l2ObjectFifo);
+  if (!l3Location || !l2Location) return failure();
+  auto [l3Col, l3Row] = l3Location.value();
+  auto [l2Col, l2Row] = l2Location.value();
+
+  // Collect the columns with a free shim DMA channel in the direction of the
+  // transfer, closest to the original column first to keep the routes short.
+  SmallVector<int64_t> freeColumns;
+  for (int64_t col = 0; col < numColumns; ++col) {
+    if (col != l3Col &&
+        channelUsage.lookup({col, l3Row, l3IsSource}) < kShimTileNbChannels) {
+      freeColumns.push_back(col);
+    }
+  }
+  llvm::stable_sort(freeColumns, [&](int64_t a, int64_t b) {
+    return std::abs(a - l3Col) < std::abs(b - l3Col);
+  });
+  int64_t freeMemTileChannels =
+      kMemTileNbChannels - channelUsage.lookup({l2Col, l2Row, l3IsTarget});
+  int64_t maxNbParts =
+      1 + std::min<int64_t>(freeColumns.size(), freeMemTileChannels);
+
+  // Pick the number of parts with the lowest estimated number of cycles. The
+  // parts should divide the split dimension evenly.
+  int64_t nbBytes = nbElements * l2Type.getElementTypeBitWidth() / 8;
+  int64_t nbParts = 1;
+  for (int64_t n = 2; n <= std::min(maxNbParts, splitDimSize); ++n) {
+    if (splitDimSize % n != 0) continue;
+    if (model.getCycles(nbBytes, n) < model.getCycles(nbBytes, nbParts))
+      nbParts = n;
+  }
+  if (nbParts == 1) return failure();
+  LLVM_DEBUG(llvm::dbgs() << "Distribute " << dmaOp << " over " << nbParts
+                          << " shim DMA channels\n");
+
+  // Create the logical objectFifos on the additional shim tiles.
+  SmallVector<Value> l3Parts = {l3ObjectFifo.getOutput()};
+  rewriter.setInsertionPointAfter(l3ObjectFifo);
+  Location loc = l3ObjectFifo.getLoc();
+  Value row = rewriter.create<arith::ConstantIndexOp>(loc, l3Row);
+  for (int64_t col : ArrayRef<int64_t>(freeColumns).take_front(nbParts - 1)) {
+    Value colValue = rewriter.create<arith::ConstantIndexOp>(loc, col);
+    auto tileOp = rewriter.create<AMDAIE::TileOp>(loc, colValue, row);
+    auto newObjectFifo = rewriter.create<AMDAIE::LogicalObjectFifoFromMemrefOp>(
+        loc, l3ObjectFifo.getOutput().getType(), l3ObjectFifo.getMemref(),
+        ValueRange{tileOp.getResult()});
+    l3Parts.push_back(newObjectFifo.getOutput());
+    channelUsage[{col, l3Row, l3IsSource}]++;
+  }
+  channelUsage[{l2Col, l2Row, l3IsTarget}] += nbParts - 1;
+
+  // Create one DMA per part, each transferring a slice of the split dimension
+  // on L3 into the corresponding contiguous slice of the L2 buffer.
+  rewriter.setInsertionPoint(dmaOp);
+  int64_t partSize = splitDimSize / nbParts;
+  int64_t partElements = nbElements / nbParts;
+  AffineExpr d0 = rewriter.getAffineDimExpr(0);
+  for (auto &&[i, l3Part] : llvm::enumerate(l3Parts)) {
+    SmallVector<OpFoldResult> partOffsets = offsets;
+    SmallVector<OpFoldResult> partSizes = sizes;
+    int64_t partIndex = i;
+    partOffsets[splitDim] = affine::makeComposedFoldedAffineApply(
+        rewriter, dmaOp.getLoc(), d0 + partIndex * partSize,
+        {offsets[splitDim]});
+    partSizes[splitDim] = getAsIndexOpFoldResult(ctx, partSize);
+    SmallVector<OpFoldResult> l2Offsets = {
+        getAsIndexOpFoldResult(ctx, partIndex * partElements)};
+    SmallVector<OpFoldResult> l2Sizes = {
+        getAsIndexOpFoldResult(ctx, partElements)};
+    SmallVector<OpFoldResult> l2Strides = {getAsIndexOpFoldResult(ctx, 1)};
+    if (l3IsSource) {
+      rewriter.create<AMDAIE::DmaCpyNdOp>(
+          dmaOp.getLoc(), dmaOp.getTarget(), l2Offsets, l2Sizes, l2Strides,
+          l3Part, partOffsets, partSizes, strides);
+    } else {
+      rewriter.create<AMDAIE::DmaCpyNdOp>(
+          dmaOp.getLoc(), l3Part, partOffsets, partSizes, strides,
+          dmaOp.getSource(), l2Offsets, l2Sizes, l2Strides);
+    }
+  }
+  rewriter.eraseOp(dmaOp);
+  return success();
+}
+
+class AMDAIEDistributeL3DmaPass
+    : public impl::AMDAIEDistributeL3DmaBase<AMDAIEDistributeL3DmaPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<AMDAIEDialect, affine::AffineDialect,
+                    arith::ArithDialect>();
+  }
+
+  AMDAIEDistributeL3DmaPass() = default;
+  AMDAIEDistributeL3DmaPass(const AMDAIEDistributeL3DmaPass &pass){};
+  AMDAIEDistributeL3DmaPass(const AMDAIEDistributeL3DmaOptions &options)
+      : AMDAIEDistributeL3DmaBase(options) {}
+  void runOnOperation() override;
+};
+
+void AMDAIEDistributeL3DmaPass::runOnOperation() {
+  Operation *parentOp = getOperation();
+  IRRewriter rewriter(parentOp->getContext());
+  ShimDmaBandwidthModel model{ddrBytesPerCycle, setupCycles};
+  DenseMap<ChannelKey, int64_t> channelUsage = getChannelUsage(parentOp);
+  SmallVector<AMDAIE::DmaCpyNdOp> dmaOps;
+  parentOp->walk([&](AMDAIE::DmaCpyNdOp dmaOp) { dmaOps.push_back(dmaOp); });
+  for (AMDAIE::DmaCpyNdOp dmaOp : dmaOps) {
+    (void)distributeL3Dma(rewriter, dmaOp, numColumns, model, channelUsage);
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<Pass> createAMDAIEDistributeL3DmaPass(
+    AMDAIEDistributeL3DmaOptions options) {
+  return std::make_unique<AMDAIEDistributeL3DmaPass>(options);
+}
+
+}  // namespace mlir::iree_compiler::AMDAIE
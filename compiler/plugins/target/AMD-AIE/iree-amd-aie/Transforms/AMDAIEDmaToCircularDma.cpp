@@ -6,7 +6,12 @@
 
 #include "iree-amd-aie/IR/AMDAIEDialect.h"
 #include "iree-amd-aie/IR/AMDAIEOps.h"
+#include "iree-amd-aie/Transforms/AMDAIEDmaUtils.h"
 #include "iree-amd-aie/Transforms/Passes.h"
+#include "mlir/Analysis/AliasAnalysis.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/Interfaces/LoopLikeInterface.h"
 
 #define DEBUG_TYPE "iree-amdaie-insert-circular-dma"
 
@@ -14,24 +19,200 @@ namespace mlir::iree_compiler::AMDAIE {
 
 namespace {
 
-/// Convert dma copy operations to circular dma copy operations from L2 to L1
-/// and L1 to L2. This is hardcoded for now because of how MLIR-AIE is set up,
-/// but can be generalized in the future.
+/// Return whether the access patterns and logical objectFifos of `dmaOp` are
+/// all defined outside of `loopOp`, i.e. whether `dmaOp` describes the same
+/// transfer on every iteration of the loop.
+bool isLoopInvariant(AMDAIE::DmaCpyNdOp dmaOp, LoopLikeOpInterface loopOp) {
+  return llvm::all_of(dmaOp->getOperands(), [&](Value operand) {
+    return loopOp.isDefinedOutsideOfLoop(operand);
+  });
+}
+
+/// Return whether the access patterns of `dmaOp` are invariant with respect
+/// to all loops it's nested in.
+bool hasLoopInvariantAccessPatterns(AMDAIE::DmaCpyNdOp dmaOp) {
+  SmallVector<Value> accessPatternOperands;
+  llvm::append_range(accessPatternOperands, dmaOp.getTargetOffsets());
+  llvm::append_range(accessPatternOperands, dmaOp.getTargetSizes());
+  llvm::append_range(accessPatternOperands, dmaOp.getTargetStrides());
+  llvm::append_range(accessPatternOperands, dmaOp.getSourceOffsets());
+  llvm::append_range(accessPatternOperands, dmaOp.getSourceSizes());
+  llvm::append_range(accessPatternOperands, dmaOp.getSourceStrides());
+  for (auto loopOp = dmaOp->getParentOfType<LoopLikeOpInterface>(); loopOp;
+       loopOp = loopOp->getParentOfType<LoopLikeOpInterface>()) {
+    if (!llvm::all_of(accessPatternOperands, [&](Value operand) {
+          return loopOp.isDefinedOutsideOfLoop(operand);
+        })) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Return the constant trip count of `forOp` if it has static bounds.
+std::optional<int64_t> getConstantTripCount(scf::ForOp forOp) {
+  std::optional<int64_t> lb = getConstantIntValue(forOp.getLowerBound());
+  std::optional<int64_t> ub = getConstantIntValue(forOp.getUpperBound());
+  std::optional<int64_t> step = getConstantIntValue(forOp.getStep());
+  if (!lb || !ub || !step || step.value() <= 0) return std::nullopt;
+  return llvm::divideCeil(ub.value() - lb.value(), step.value());
+}
+
+/// Return the access pattern on L3, made explicit and padded to the number of
+/// addressing dimensions of a shim tile BD. Returns `failure` if the access
+/// pattern can't be made explicit or doesn't leave room for an iteration
+/// dimension.
+LogicalResult getPaddedL3AccessPattern(
+    MLIRContext *ctx, AMDAIE::LogicalObjectFifoFromMemrefOp logicalObjectFifo,
+    SmallVector<OpFoldResult> &offsets, SmallVector<OpFoldResult> &sizes,
+    SmallVector<OpFoldResult> &strides) {
+  if (failed(makeAccessPatternExplicit(ctx, logicalObjectFifo.getMemrefType(),
+                                       offsets, sizes, strides))) {
+    return failure();
+  }
+  return padToShimIntraDims(ctx, offsets, sizes, strides);
+}
+
+/// Prepend a dimension with size `repeatCount` and stride zero to the given
+/// access pattern, so it's repeated `repeatCount` times.
+void prependRepeatDim(MLIRContext *ctx, int64_t repeatCount,
+                      SmallVector<OpFoldResult> &offsets,
+                      SmallVector<OpFoldResult> &sizes,
+                      SmallVector<OpFoldResult> &strides) {
+  offsets.insert(offsets.begin(), getAsIndexOpFoldResult(ctx, 0));
+  sizes.insert(sizes.begin(), getAsIndexOpFoldResult(ctx, repeatCount));
+  strides.insert(strides.begin(), getAsIndexOpFoldResult(ctx, 0));
+}
+
+/// Return whether `dmaOp`, reading from L3 into L2, can be issued before
+/// `forOp` without changing the data it reads or the order in which its target
+/// is filled:
+///   - No other DMA within the loop writes to L3 memory which may alias the L3
+///     memory read by `dmaOp`, as that data could then change between
+///     iterations.
+///   - No other DMA within the loop writes into the same L2 buffer, as the
+///     transfers into that buffer would then no longer interleave in program
+///     order.
+bool canHoistOutOf(AMDAIE::DmaCpyNdOp dmaOp, scf::ForOp forOp,
+                   AliasAnalysis &aliasAnalysis) {
+  Value l3Memref = dmaOp.getSourceObjectFifo().getMemref();
+  Value l2Memref = dmaOp.getTargetObjectFifo().getMemref();
+  WalkResult res = forOp->walk([&](Operation *op) {
+    if (op == dmaOp.getOperation()) return WalkResult::advance();
+    AMDAIE::LogicalObjectFifoFromMemrefOp target;
+    if (auto otherDmaOp = dyn_cast<AMDAIE::DmaCpyNdOp>(op)) {
+      target = otherDmaOp.getTargetObjectFifo();
+    } else if (auto circularDmaOp = dyn_cast<AMDAIE::CircularDmaCpyNdOp>(op)) {
+      target = circularDmaOp.getTargetObjectFifo();
+    } else {
+      return WalkResult::advance();
+    }
+    if (!target) return WalkResult::interrupt();
+    if (target.getMemorySpaceAsUInt() == 0 &&
+        !aliasAnalysis.alias(target.getMemref(), l3Memref).isNo()) {
+      return WalkResult::interrupt();
+    }
+    if (target.getMemref() == l2Memref) return WalkResult::interrupt();
+    return WalkResult::advance();
+  });
+  return !res.wasInterrupted();
+}
+
+/// Hoist a DMA operation reading from L3 into L2 out of the surrounding
+/// `scf.for` loops as long as it's invariant with respect to them and no
+/// other DMA in the loop conflicts with it. The repetition is encoded as an
+/// additional outer dimension with stride zero on the L3 side only, which maps
+/// onto the iteration dimension of the shim tile BD. The L2 access pattern
+/// is kept as is, so the memory tile still receives one transfer per handoff
+/// to its consumers and synchronizes on every one of them. This way, the
+/// transfer is issued once by the uController for all iterations instead of
+/// once per iteration, while the shim tile still reads the data from DDR on
+/// every iteration.
+///
+/// Writes from L2 back to L3 are never hoisted, as the data written on every
+/// iteration depends on the computation in that iteration.
+void hoistLoopInvariantL3Dma(RewriterBase &rewriter, AMDAIE::DmaCpyNdOp dmaOp,
+                             AliasAnalysis &aliasAnalysis) {
+  if (dmaOp.getSourceObjectFifo().getMemorySpaceAsUInt() != 0 ||
+      dmaOp.getTargetObjectFifo().getMemorySpaceAsUInt() != 1) {
+    return;
+  }
+  while (auto forOp = dyn_cast<scf::ForOp>(dmaOp->getParentOp())) {
+    if (!isLoopInvariant(dmaOp, forOp)) return;
+    if (!canHoistOutOf(dmaOp, forOp, aliasAnalysis)) return;
+    std::optional<int64_t> tripCount = getConstantTripCount(forOp);
+    if (!tripCount) return;
+
+    MLIRContext *ctx = rewriter.getContext();
+    SmallVector<OpFoldResult> sourceOffsets = dmaOp.getSourceMixedOffsets();
+    SmallVector<OpFoldResult> sourceSizes = dmaOp.getSourceMixedSizes();
+    SmallVector<OpFoldResult> sourceStrides = dmaOp.getSourceMixedStrides();
+    if (failed(getPaddedL3AccessPattern(ctx, dmaOp.getSourceObjectFifo(),
+                                        sourceOffsets, sourceSizes,
+                                        sourceStrides))) {
+      return;
+    }
+    prependRepeatDim(ctx, tripCount.value(), sourceOffsets, sourceSizes,
+                     sourceStrides);
+
+    // Only hoist if the repeated transfer still fits within a single BD on
+    // the L3 side and a single transfer fits within a single BD on the L2
+    // side.
+    int64_t elemBitWidth = dmaOp.getSourceObjectFifo()
+                               .getMemrefType()
+                               .getElementTypeBitWidth();
+    FailureOr<int64_t> sourceNbBDs =
+        getNbBDs(sourceSizes, sourceStrides,
+                 getDmaDimConfig(AMDAIEMemSpace::Global, elemBitWidth));
+    if (failed(sourceNbBDs) || sourceNbBDs.value() != 1) return;
+    FailureOr<int64_t> targetNbBDs =
+        getNbBDs(dmaOp.getTargetMixedSizes(), dmaOp.getTargetMixedStrides(),
+                 getDmaDimConfig(AMDAIEMemSpace::Shared, elemBitWidth));
+    if (failed(targetNbBDs) || targetNbBDs.value() != 1) return;
+
+    rewriter.setInsertionPoint(forOp);
+    dmaOp = rewriter.replaceOpWithNewOp<AMDAIE::DmaCpyNdOp>(
+        dmaOp, dmaOp.getTarget(), dmaOp.getTargetMixedOffsets(),
+        dmaOp.getTargetMixedSizes(), dmaOp.getTargetMixedStrides(),
+        dmaOp.getSource(), sourceOffsets, sourceSizes, sourceStrides);
+  }
+}
+
+/// Decide for every DMA copy operation whether it can be statically configured
+/// as a circular DMA or needs to be issued by the uController:
+///   - DMAs between L2 and L1 are converted into circular DMAs if their access
+///     patterns are invariant with respect to all surrounding loops.
+///   - DMAs from or to L3 are kept as host-issued transfers, so their L3
+///     access patterns can be reconfigured on every iteration. If reads from
+///     L3 into L2 are invariant across the surrounding loops, they're hoisted
+///     out of those loops and issued once with a repetition count instead.
 LogicalResult convertDmaToCircularDma(Operation *op) {
   IRRewriter rewriter(op->getContext());
-  op->walk([&](AMDAIE::DmaCpyNdOp dmaOp) {
+  AliasAnalysis aliasAnalysis(op);
+  SmallVector<AMDAIE::DmaCpyNdOp> dmaOps;
+  op->walk([&](AMDAIE::DmaCpyNdOp dmaOp) { dmaOps.push_back(dmaOp); });
+  for (AMDAIE::DmaCpyNdOp dmaOp : dmaOps) {
     Attribute sourceMemSpace = dmaOp.getSourceObjectFifo().getMemorySpace();
     Attribute targetMemSpace = dmaOp.getTargetObjectFifo().getMemorySpace();
-    if (sourceMemSpace && targetMemSpace) {
-      // L2 -> L1 or L1 -> L2 goes to uController instructions in MLIR-AIE.
-      rewriter.setInsertionPointAfter(dmaOp);
-      rewriter.replaceOpWithNewOp<AMDAIE::CircularDmaCpyNdOp>(
-          dmaOp, dmaOp.getTarget(), dmaOp.getTargetMixedOffsets(),
-          dmaOp.getTargetMixedSizes(), dmaOp.getTargetMixedStrides(),
-          dmaOp.getSource(), dmaOp.getSourceMixedOffsets(),
-          dmaOp.getSourceMixedSizes(), dmaOp.getSourceMixedStrides());
+    if (!sourceMemSpace && !targetMemSpace) continue;
+    if (!sourceMemSpace || !targetMemSpace) {
+      hoistLoopInvariantL3Dma(rewriter, dmaOp, aliasAnalysis);
+      continue;
     }
-  });
+    // L2 -> L1 or L1 -> L2 can't be issued by the uController in MLIR-AIE and
+    // thus needs to be configured statically.
+    if (!hasLoopInvariantAccessPatterns(dmaOp)) {
+      return dmaOp.emitOpError()
+             << "has a loop-variant access pattern between L2 and L1, which "
+                "can't be configured statically";
+    }
+    rewriter.setInsertionPointAfter(dmaOp);
+    rewriter.replaceOpWithNewOp<AMDAIE::CircularDmaCpyNdOp>(
+        dmaOp, dmaOp.getTarget(), dmaOp.getTargetMixedOffsets(),
+        dmaOp.getTargetMixedSizes(), dmaOp.getTargetMixedStrides(),
+        dmaOp.getSource(), dmaOp.getSourceMixedOffsets(),
+        dmaOp.getSourceMixedSizes(), dmaOp.getSourceMixedStrides());
+  }
   return success();
 }
 
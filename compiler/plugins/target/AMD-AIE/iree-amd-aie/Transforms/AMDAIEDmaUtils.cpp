@@ -89,12 +89,15 @@ LogicalResult foldLinearDims(MLIRContext *ctx,
 ///   offsets: [], sizes: [], strides: []
 LogicalResult foldSingleDim(SmallVector<OpFoldResult> &offsets,
                             SmallVector<OpFoldResult> &sizes,
-                            SmallVector<OpFoldResult> &strides) {
-  if (offsets.size() == 0) {
+                            SmallVector<OpFoldResult> &strides,
+                            std::optional<int64_t> nbElements) {
+  if (offsets.size() == 0 || !nbElements) {
     return failure();
   }
   if (offsets.size() == 1 && getConstantIntValue(offsets[0]) &&
       getConstantIntValue(offsets[0]).value() == 0 &&
+      getConstantIntValue(sizes[0]) &&
+      getConstantIntValue(sizes[0]).value() == nbElements.value() &&
       getConstantIntValue(strides[0]) &&
       getConstantIntValue(strides[0]).value() == 1) {
     offsets.clear();
@@ -127,4 +130,185 @@ LogicalResult foldUnitDims(const SmallVector<OpFoldResult> &offsets,
   return success(foldableUnitDimsFound);
 }
 
+DmaDimConfig getDmaDimConfig(AMDAIEMemSpace memSpace, int64_t elemBitWidth) {
+  switch (memSpace) {
+    case AMDAIEMemSpace::Global:
+      // Shim tile: 3 addressing dimensions (of which the outer one has no wrap
+      // field and is bounded by the buffer length) and 1 iteration dimension.
+      // Wraps are 10 bits, strides 20 bits and the iteration wrap 6 bits.
+      return {/*nbIntraDims=*/3, /*nbInterDims=*/1,
+              /*maxIntraSize=*/(1 << 10) - 1, /*maxIntraStride=*/1 << 20,
+              /*maxInterSize=*/1 << 6, /*maxInterStride=*/1 << 20,
+              elemBitWidth};
+    case AMDAIEMemSpace::Shared:
+      // Memory tile: 4 addressing dimensions with 10 bits wraps and 17 bits
+      // strides.
+      return {/*nbIntraDims=*/4, /*nbInterDims=*/0,
+              /*maxIntraSize=*/(1 << 10) - 1, /*maxIntraStride=*/1 << 17,
+              /*maxInterSize=*/0, /*maxInterStride=*/0, elemBitWidth};
+    case AMDAIEMemSpace::Local:
+      // Core tile: 3 addressing dimensions with 8 bits wraps and 13 bits
+      // strides.
+      return {/*nbIntraDims=*/3, /*nbInterDims=*/0,
+              /*maxIntraSize=*/(1 << 8) - 1, /*maxIntraStride=*/1 << 13,
+              /*maxInterSize=*/0, /*maxInterStride=*/0, elemBitWidth};
+  }
+  llvm_unreachable("unknown memory space");
+}
+
+/// Return whether dimension `dim` of an access pattern with `nbDims`
+/// dimensions is a contiguous innermost dimension. The BD wrap of such a
+/// dimension counts 32-bit words instead of elements.
+static bool isContiguousInnerDim(int64_t dim, int64_t nbDims, int64_t stride) {
+  return dim == nbDims - 1 && stride == 1;
+}
+
+/// Split dimensions with a size larger than the maximum BD size into an outer
+/// and an inner dimension. The inner size is the largest divisor of the
+/// original size that fits. For a contiguous innermost dimension, the limit
+/// applies to the number of 32-bit words and the inner size needs to span a
+/// whole number of words, so the outer stride stays word aligned. The offset
+/// is kept on the inner dimension as it has the same stride as the original
+/// dimension. Every split adds a dimension, so only as many dimensions are
+/// split, starting from the innermost one, as fit within a BD.
+///
+/// Example (32-bit elements, maxIntraSize = 1023):
+///
+/// `offsets: [0], sizes: [2048], strides: [1]`
+///
+/// becomes:
+///
+/// `offsets: [0, 0], sizes: [4, 512], strides: [512, 1]`
+LogicalResult splitLargeDims(MLIRContext *ctx,
+                             const SmallVector<OpFoldResult> &offsets,
+                             const SmallVector<OpFoldResult> &sizes,
+                             const SmallVector<OpFoldResult> &strides,
+                             const DmaDimConfig &config,
+                             SmallVector<OpFoldResult> &newOffsets,
+                             SmallVector<OpFoldResult> &newSizes,
+                             SmallVector<OpFoldResult> &newStrides) {
+  // The inner size of every dimension to be split, 0 for the others.
+  SmallVector<int64_t> innerSizes(offsets.size(), 0);
+  int64_t maxSize = config.maxIntraSize;
+  int64_t nbDims = offsets.size();
+  int64_t nbSplitsLeft = config.nbIntraDims + config.nbInterDims - nbDims;
+  for (int i = nbDims - 1; i >= 0 && nbSplitsLeft > 0; i--) {
+    std::optional<int64_t> size = getConstantIntValue(sizes[i]);
+    std::optional<int64_t> stride = getConstantIntValue(strides[i]);
+    if (!size || !stride) continue;
+    bool inWords = isContiguousInnerDim(i, nbDims, stride.value());
+    auto fits = [&](int64_t elems) {
+      return (inWords ? config.toWords(elems) : elems) <= maxSize;
+    };
+    auto isWordAligned = [&](int64_t elems) {
+      return !inWords || (elems * config.elemBitWidth) % 32 == 0;
+    };
+    if (fits(size.value())) continue;
+    int64_t innerSize =
+        inWords ? maxSize * 32 / config.elemBitWidth : maxSize;
+    while (innerSize > 1 &&
+           (size.value() % innerSize != 0 || !isWordAligned(innerSize))) {
+      innerSize--;
+    }
+    int64_t outerSize = size.value() / innerSize;
+    if (innerSize <= 1 || outerSize > maxSize) continue;
+    innerSizes[i] = innerSize;
+    nbSplitsLeft--;
+  }
+  if (llvm::all_of(innerSizes, [](int64_t size) { return size == 0; }))
+    return failure();
+
+  for (int i = 0; i < offsets.size(); i++) {
+    if (innerSizes[i] == 0) {
+      newOffsets.push_back(offsets[i]);
+      newSizes.push_back(sizes[i]);
+      newStrides.push_back(strides[i]);
+      continue;
+    }
+    int64_t size = getConstantIntValue(sizes[i]).value();
+    int64_t stride = getConstantIntValue(strides[i]).value();
+    newOffsets.push_back(getAsIndexOpFoldResult(ctx, 0));
+    newSizes.push_back(getAsIndexOpFoldResult(ctx, size / innerSizes[i]));
+    newStrides.push_back(getAsIndexOpFoldResult(ctx, innerSizes[i] * stride));
+    newOffsets.push_back(offsets[i]);
+    newSizes.push_back(getAsIndexOpFoldResult(ctx, innerSizes[i]));
+    newStrides.push_back(strides[i]);
+  }
+  return success();
+}
+
+FailureOr<int64_t> getNbBDs(const SmallVector<OpFoldResult> &sizes,
+                            const SmallVector<OpFoldResult> &strides,
+                            const DmaDimConfig &config) {
+  int64_t nbIntraDims = 0;
+  int64_t nbInterDims = 0;
+  int64_t nbBDs = 1;
+  bool unrolling = false;
+  int64_t nbDims = sizes.size();
+  for (int i = nbDims - 1; i >= 0; i--) {
+    std::optional<int64_t> size = getConstantIntValue(sizes[i]);
+    std::optional<int64_t> stride = getConstantIntValue(strides[i]);
+    if (!size) return failure();
+    if (!unrolling && stride) {
+      // The BD limits are expressed in 32-bit words: the strides always and the
+      // size only for a contiguous innermost dimension.
+      int64_t sizeInWords = size.value();
+      int64_t strideInWords = config.toWords(stride.value());
+      if (isContiguousInnerDim(i, nbDims, stride.value())) {
+        sizeInWords = config.toWords(size.value());
+        strideInWords = 1;
+      }
+      if (nbIntraDims < config.nbIntraDims &&
+          sizeInWords <= config.maxIntraSize &&
+          strideInWords <= config.maxIntraStride) {
+        nbIntraDims++;
+        continue;
+      }
+      if (nbInterDims < config.nbInterDims &&
+          sizeInWords <= config.maxInterSize &&
+          strideInWords <= config.maxInterStride) {
+        nbInterDims++;
+        continue;
+      }
+    }
+    // This dimension and all outer ones don't fit within a single BD and need
+    // to be unrolled into chained BDs.
+    unrolling = true;
+    nbBDs *= size.value();
+  }
+  return nbBDs;
+}
+
+LogicalResult makeAccessPatternExplicit(MLIRContext *ctx,
+                                        MemRefType memrefType,
+                                        SmallVector<OpFoldResult> &offsets,
+                                        SmallVector<OpFoldResult> &sizes,
+                                        SmallVector<OpFoldResult> &strides) {
+  if (!offsets.empty()) return success();
+  if (!memrefType.hasStaticShape()) return failure();
+  int64_t stride = 1;
+  for (int64_t size : llvm::reverse(memrefType.getShape())) {
+    offsets.insert(offsets.begin(), getAsIndexOpFoldResult(ctx, 0));
+    sizes.insert(sizes.begin(), getAsIndexOpFoldResult(ctx, size));
+    strides.insert(strides.begin(), getAsIndexOpFoldResult(ctx, stride));
+    stride *= size;
+  }
+  return success();
+}
+
+LogicalResult padToShimIntraDims(MLIRContext *ctx,
+                                 SmallVector<OpFoldResult> &offsets,
+                                 SmallVector<OpFoldResult> &sizes,
+                                 SmallVector<OpFoldResult> &strides) {
+  size_t nbIntraDims =
+      getDmaDimConfig(AMDAIEMemSpace::Global, /*elemBitWidth=*/32).nbIntraDims;
+  if (offsets.size() > nbIntraDims) return failure();
+  while (offsets.size() < nbIntraDims) {
+    offsets.insert(offsets.begin(), getAsIndexOpFoldResult(ctx, 0));
+    sizes.insert(sizes.begin(), getAsIndexOpFoldResult(ctx, 1));
+    strides.insert(strides.begin(), getAsIndexOpFoldResult(ctx, 1));
+  }
+  return success();
+}
+
 }  // namespace mlir::iree_compiler::AMDAIE
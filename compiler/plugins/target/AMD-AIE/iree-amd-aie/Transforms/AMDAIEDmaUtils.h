@@ -10,6 +10,8 @@
 #include "iree-amd-aie/IR/AMDAIEAttrs.h"
 #include "iree-amd-aie/IR/AMDAIEDmaOpInterface.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
+#include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/OpDefinition.h"
 #include "mlir/IR/PatternMatch.h"
@@ -26,11 +28,15 @@ LogicalResult foldLinearDims(MLIRContext *ctx,
                              SmallVector<OpFoldResult> &newSizes,
                              SmallVector<OpFoldResult> &newStrides);
 
-/// Fold single dimension linear accesses and make them implicit. `This
-/// operation happens in place. Returns `success` if folding took place.
+/// Fold single dimension linear accesses covering all `nbElements` elements
+/// of the accessed memref and make them implicit. A single dimension covering
+/// only part of the memref, or a memref with an unknown number of elements,
+/// can't be made implicit. This operation happens in place. Returns `success`
+/// if folding took place.
 LogicalResult foldSingleDim(SmallVector<OpFoldResult> &offsets,
                             SmallVector<OpFoldResult> &sizes,
-                            SmallVector<OpFoldResult> &strides);
+                            SmallVector<OpFoldResult> &strides,
+                            std::optional<int64_t> nbElements);
 
 /// Fold unit dimensions within a strided access pattern. Returns `success` if
 /// folding took place.
@@ -41,6 +47,82 @@ LogicalResult foldUnitDims(const SmallVector<OpFoldResult> &offsets,
                            SmallVector<OpFoldResult> &newStrides,
                            SmallVector<OpFoldResult> &newSizes);
 
+/// Hardware limits of a single buffer descriptor (BD) of the DMAs on a
+/// certain tile type. The sizes (wraps) and strides are limited by the bit
+/// widths of the corresponding BD register fields. The BDs address memory in
+/// 32-bit words, so the strides and the size of a contiguous innermost
+/// dimension are limited in words, while the access patterns are expressed in
+/// elements of `elemBitWidth` bits.
+struct DmaDimConfig {
+  /// The number of addressing dimensions within a single BD.
+  int64_t nbIntraDims;
+  /// The number of iteration dimensions a BD supports on top of the addressing
+  /// dimensions, i.e. the number of times the BD is repeated with a stride.
+  int64_t nbInterDims;
+  int64_t maxIntraSize;
+  int64_t maxIntraStride;
+  int64_t maxInterSize;
+  int64_t maxInterStride;
+  /// The bit width of the elements the access patterns are expressed in.
+  int64_t elemBitWidth;
+
+  /// Return the number of 32-bit words spanned by `nbElements` elements.
+  int64_t toWords(int64_t nbElements) const {
+    return llvm::divideCeil(nbElements * elemBitWidth, 32);
+  }
+};
+
+/// Return the BD limits of the DMAs on the tile type corresponding to the
+/// provided memory space: shim tile (global), memory tile (shared) or core
+/// tile (local), for access patterns on elements of `elemBitWidth` bits.
+DmaDimConfig getDmaDimConfig(AMDAIEMemSpace memSpace, int64_t elemBitWidth);
+
+/// Split the dimensions of a strided access pattern with a size larger than
+/// the maximum BD size of `config` into two dimensions which both fit, if
+/// possible. The access pattern is never split into more dimensions than a BD
+/// supports; if not all dimensions can be split, the innermost ones are.
+/// Returns `success` if splitting took place.
+LogicalResult splitLargeDims(MLIRContext *ctx,
+                             const SmallVector<OpFoldResult> &offsets,
+                             const SmallVector<OpFoldResult> &sizes,
+                             const SmallVector<OpFoldResult> &strides,
+                             const DmaDimConfig &config,
+                             SmallVector<OpFoldResult> &newOffsets,
+                             SmallVector<OpFoldResult> &newSizes,
+                             SmallVector<OpFoldResult> &newStrides);
+
+/// Return the number of chained BDs needed to execute the strided access
+/// pattern described by `sizes` and `strides` on a DMA with the provided
+/// limits. Dimensions are assigned from innermost to outermost to the BD
+/// addressing dimensions and then to the iteration dimensions. All dimensions
+/// that don't fit need to be unrolled into separate BDs. An empty access
+/// pattern describes a contiguous access and needs a single BD. Returns
+/// `failure` if the count can't be determined statically.
+FailureOr<int64_t> getNbBDs(const SmallVector<OpFoldResult> &sizes,
+                            const SmallVector<OpFoldResult> &strides,
+                            const DmaDimConfig &config);
+
+/// Make an empty strided access pattern on a memref of type `memrefType`
+/// explicit, i.e. describe the contiguous access of the whole memref through
+/// offsets, sizes and strides. Non-empty access patterns are left untouched.
+/// Returns `failure` if an empty access pattern is provided for a memref
+/// without a static shape.
+LogicalResult makeAccessPatternExplicit(MLIRContext *ctx,
+                                        MemRefType memrefType,
+                                        SmallVector<OpFoldResult> &offsets,
+                                        SmallVector<OpFoldResult> &sizes,
+                                        SmallVector<OpFoldResult> &strides);
+
+/// Pad a strided access pattern executed by a shim tile DMA with leading unit
+/// dimensions up to the number of addressing dimensions of a shim tile BD. This
+/// ensures that an additional outer dimension ends up in the BD's iteration
+/// dimension. Returns `failure` if the access pattern has more dimensions than
+/// the BD's addressing dimensions.
+LogicalResult padToShimIntraDims(MLIRContext *ctx,
+                                 SmallVector<OpFoldResult> &offsets,
+                                 SmallVector<OpFoldResult> &sizes,
+                                 SmallVector<OpFoldResult> &strides);
+
 /// Utility to discard all non-zero offsets that have dimension equal to 1 on
 /// the same index of the provided shape. This helps with updating DMA
 /// operations for a shape change. If an empty shape is passed, all non-zero
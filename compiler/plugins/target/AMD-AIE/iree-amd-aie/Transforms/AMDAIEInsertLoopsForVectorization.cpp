@@ -4,6 +4,7 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include "iree-amd-aie/Transforms/AMDAIEUtils.h"
 #include "iree-amd-aie/Transforms/Passes.h"
 #include "llvm/ADT/STLExtras.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
@@ -55,11 +56,20 @@ class AMDAIEInsertLoopsForVectorizationPass
     tileSizes[numIterators - 3] = 0;
     tileSizes[numIterators - 2] = 0;
     tileSizes[numIterators - 1] = 0;
+    rewrite(rewriter, genericOp, tileSizes);
+  }
+
+  static void rewrite(IRRewriter &rewriter, linalg::LinalgOp linalgOp,
+                      ArrayRef<int64_t> tileSizes) {
     auto opts = linalg::LinalgTilingOptions().setTileSizes(tileSizes);
-    auto tiled = linalg::tileLinalgOp(rewriter, genericOp, opts);
+    auto tiled = linalg::tileLinalgOp(rewriter, linalgOp, opts);
     const auto &loops = tiled.value().loops;
     assert(!loops.empty() && "expected at least one loop here");
-    rewriter.replaceOp(genericOp, loops[0]->getResult(0));
+    if (linalgOp.hasPureBufferSemantics()) {
+      rewriter.eraseOp(linalgOp);
+    } else {
+      rewriter.replaceOp(linalgOp, loops[0]->getResults());
+    }
   }
 
   // Return success if the generic op is rewritten, failure otherwise.
@@ -119,14 +129,84 @@ class AMDAIEInsertLoopsForVectorizationPass
     return success();
   }
 
+  // Return success if the elementwise op (this includes linalg.fill and
+  // linalg.copy) is rewritten, failure otherwise. The minimal number of
+  // inner-most dimensions that together span a whole number of native AIE
+  // vectors are kept, all outer dimensions are replaced with scf.for loops.
+  // The op remaining in the loop body vectorizes to vector-width aligned
+  // transfers and arithmetic.
+  //
+  // Example: a fill of tensor<1x1x8x16x4x8xf32> (16 f32 lanes per vector)
+  // keeps the inner 4x8 = 32 elements, so the tile sizes are [1,1,1,1,0,0].
+  LogicalResult maybeRewriteElementwise(linalg::LinalgOp linalgOp,
+                                        IRRewriter &rewriter) {
+    if (!linalg::isElementwise(linalgOp)) return failure();
+    // Copies and fills between L3 and L2 become DMAs, only ops on the core
+    // are vectorized.
+    if (!hasOnlyLocalMemoryOperands(linalgOp)) return failure();
+
+    // Only consider ops where all shaped operands are accessed with an
+    // identity map, so that the inner-most dimensions are contiguous for all
+    // operands. Transposes and broadcasts are left alone.
+    unsigned maxLanes = 0;
+    for (OpOperand &opOperand : linalgOp->getOpOperands()) {
+      auto type = dyn_cast<ShapedType>(opOperand.get().getType());
+      if (!type) continue;
+      if (!linalgOp.getMatchingIndexingMap(&opOperand).isIdentity())
+        return failure();
+      FailureOr<unsigned> lanes = getAIEVectorLanes(type.getElementType());
+      if (failed(lanes)) return failure();
+      maxLanes = std::max(maxLanes, lanes.value());
+    }
+    if (maxLanes == 0) return failure();
+
+    SmallVector<int64_t> loopRanges = linalgOp.getStaticLoopRanges();
+    if (ShapedType::isDynamicShape(loopRanges)) return failure();
+
+    // Find the minimal number of inner-most dimensions whose product is a
+    // multiple of the vector width.
+    auto numIterators = loopRanges.size();
+    uint32_t numInnerDims = 0;
+    int64_t innerSize = 1;
+    while (numInnerDims < numIterators && innerSize % maxLanes != 0) {
+      innerSize *= loopRanges[numIterators - 1 - numInnerDims];
+      ++numInnerDims;
+    }
+    if (innerSize == 0 || innerSize % maxLanes != 0) return failure();
+
+    // Don't transform to scf.for loops unless there is at least one
+    // non-singleton loop to construct.
+    if (llvm::all_of(ArrayRef(loopRanges).drop_back(numInnerDims),
+                     [](int64_t size) { return size == 1; })) {
+      return failure();
+    }
+
+    SmallVector<int64_t> tileSizes(numIterators, 1);
+    for (uint32_t i = numIterators - numInnerDims; i < numIterators; ++i) {
+      tileSizes[i] = 0;
+    }
+    rewrite(rewriter, linalgOp, tileSizes);
+    return success();
+  }
+
   void runOnOperation() final {
     MLIRContext *context = &getContext();
     mlir::FunctionOpInterface operation = getOperation();
 
-    IRRewriter rewriter(context);
-    operation->walk([&](linalg::GenericOp genericOp) {
-      (void)maybeRewrite(genericOp, rewriter);
+    SmallVector<linalg::LinalgOp> linalgOps;
+    operation->walk([&](linalg::LinalgOp linalgOp) {
+      linalgOps.push_back(linalgOp);
     });
+
+    IRRewriter rewriter(context);
+    for (linalg::LinalgOp linalgOp : linalgOps) {
+      rewriter.setInsertionPoint(linalgOp);
+      if (auto genericOp = dyn_cast<linalg::GenericOp>(linalgOp.getOperation());
+          genericOp && succeeded(maybeRewrite(genericOp, rewriter))) {
+        continue;
+      }
+      (void)maybeRewriteElementwise(linalgOp, rewriter);
+    }
   }
 };
 
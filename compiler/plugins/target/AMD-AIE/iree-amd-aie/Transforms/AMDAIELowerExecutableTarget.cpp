@@ -4,6 +4,7 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include "iree-amd-aie/Transforms/AMDAIEUtils.h"
 #include "iree-amd-aie/Transforms/KernelDispatch.h"
 #include "iree-amd-aie/Transforms/Passes.h"
 #include "iree/compiler/Codegen/Common/Passes.h"
@@ -88,6 +89,16 @@ static TilingConfig getTilingConfigForPipeline(FunctionOpInterface funcOp) {
   return TilingConfig(*maybeLoweringConfig);
 }
 
+/// Returns whether the root op of `funcOp` is a row reduction, like the
+/// reductions of softmax and normalizations, which use their own pipeline
+/// independent of the pipeline selected for matmuls.
+static bool hasRowReductionRoot(FunctionOpInterface funcOp) {
+  FailureOr<Operation *> rootOp = getRootOperation(getComputeOps(funcOp));
+  if (failed(rootOp) || !*rootOp) return false;
+  auto linalgOp = dyn_cast<linalg::LinalgOp>(*rootOp);
+  return linalgOp && isRowReduction(linalgOp);
+}
+
 void AMDAIELowerExecutableTargetPass::runOnOperation() {
   auto funcOp = getOperation();
   auto target = IREE::HAL::ExecutableTargetAttr::lookup(funcOp);
@@ -107,7 +118,10 @@ void AMDAIELowerExecutableTargetPass::runOnOperation() {
       return;
     case IREE::Codegen::DispatchLoweringPassPipeline::Custom: {
       TilingConfig tilingConfig = getTilingConfigForPipeline(funcOp);
-      if (usePassPipeline == AIEPassPipeline::PackPeelPipeline) {
+      if (hasRowReductionRoot(funcOp)) {
+        addReductionBasedPassPipeline(executableLoweringPipeline,
+                                      tilingConfig);
+      } else if (usePassPipeline == AIEPassPipeline::PackPeelPipeline) {
         addPackPeelBasedPassPipeline(executableLoweringPipeline, tilingConfig);
       } else if (usePassPipeline == AIEPassPipeline::PadPackPipeline) {
         addPadPackBasedPassPipeline(executableLoweringPipeline, tilingConfig);
@@ -15,13 +15,19 @@
 
 #include "aie/Dialect/AIE/IR/AIEDialect.h"
 #include "aie/Dialect/AIEX/IR/AIEXDialect.h"
+#include "aie/Passes.h"
 #include "iree-amd-aie/IR/AMDAIEDialect.h"
 #include "iree-amd-aie/IR/AMDAIEOps.h"
 #include "iree-amd-aie/Transforms/Passes.h"
 #include "iree-amd-aie/Transforms/Transforms.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/IR/IRMapping.h"
 #include "mlir/IR/Iterators.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
 #define DEBUG_TYPE "iree-amdaie-lower-to-aie"
@@ -64,20 +70,86 @@ AIE::BDDimLayoutArrayAttr convertSizeStrideToBDDimLayoutArrayAttr(
                                         ArrayRef(bdDimLayoutAttr));
 }
 
+/// Return whether `dmaOp` is one of the parts of a transfer between L3 and L2
+/// distributed over multiple shim DMA channels, i.e. one of multiple DMAs from
+/// L3 joined by a link, or one of multiple DMAs to L3 distributed by a link.
+bool isDistributedL3Dma(AMDAIE::CircularDmaCpyNdOp dmaOp) {
+  uint64_t sourceMemSpace = dmaOp.getSourceObjectFifo().getMemorySpaceAsUInt();
+  uint64_t targetMemSpace = dmaOp.getTargetObjectFifo().getMemorySpaceAsUInt();
+  bool l3IsSource = sourceMemSpace == 0 && targetMemSpace == 1;
+  bool l3IsTarget = sourceMemSpace == 1 && targetMemSpace == 0;
+  if (!l3IsSource && !l3IsTarget) return false;
+  return llvm::any_of(dmaOp->getUsers(), [&](Operation *user) {
+    auto linkOp = dyn_cast<AMDAIE::LogicalObjectFifoLink>(user);
+    if (!linkOp) return false;
+    OperandRange parts = l3IsSource ? linkOp.getIns() : linkOp.getOuts();
+    return parts.size() > 1 && llvm::is_contained(parts, dmaOp.getResult());
+  });
+}
+
+/// Return the number of elements of a contiguous slice of an L2 memref,
+/// accessed through a single dimension with unit stride. Such an access
+/// pattern results from distributing a transfer over multiple DMA channels,
+/// which each fill a slice of the buffer through an `aie.objectfifo.link`.
+std::optional<int64_t> getContiguousSliceSize(
+    MemRefType memrefType, const SmallVector<OpFoldResult> &sizes,
+    const SmallVector<OpFoldResult> &strides) {
+  auto memSpace = dyn_cast_if_present<IntegerAttr>(memrefType.getMemorySpace());
+  if (!memSpace || memSpace.getInt() != 1 || !memrefType.hasStaticShape() ||
+      sizes.size() != 1) {
+    return std::nullopt;
+  }
+  std::optional<int64_t> stride = getConstantIntValue(strides[0]);
+  std::optional<int64_t> size = getConstantIntValue(sizes[0]);
+  if (!stride || stride.value() != 1 || !size ||
+      size.value() >= memrefType.getNumElements()) {
+    return std::nullopt;
+  }
+  return size;
+}
+
 /// Utility to create an `aie.objectfifo` operation from
 /// `amdaie.circular_dma_cpy_nd`.
 AIE::ObjectFifoCreateOp createObjectFifo(IRRewriter &rewriter,
                                          AMDAIE::CircularDmaCpyNdOp dmaOp,
                                          Value srcTile, ValueRange dstTiles,
                                          StringAttr &symName) {
+  MemRefType srcType =
+      cast<LogicalObjectFifoType>(dmaOp.getSourceType()).getElementType();
+  MemRefType dstType =
+      cast<LogicalObjectFifoType>(dmaOp.getTargetType()).getElementType();
+  SmallVector<OpFoldResult> sourceSizes = dmaOp.getSourceMixedSizes();
+  SmallVector<OpFoldResult> sourceStrides = dmaOp.getSourceMixedStrides();
+  SmallVector<OpFoldResult> targetSizes = dmaOp.getTargetMixedSizes();
+  SmallVector<OpFoldResult> targetStrides = dmaOp.getTargetMixedStrides();
+  // The objectFifo of a distributed transfer only carries a contiguous slice
+  // of the buffer, which is placed within the buffer by the link, so no
+  // dimensions are needed.
+  std::optional<int64_t> sourceSliceSize;
+  std::optional<int64_t> targetSliceSize;
+  if (isDistributedL3Dma(dmaOp)) {
+    sourceSliceSize =
+        getContiguousSliceSize(srcType, sourceSizes, sourceStrides);
+    targetSliceSize =
+        getContiguousSliceSize(dstType, targetSizes, targetStrides);
+  }
+  if (sourceSliceSize) {
+    sourceSizes.clear();
+    sourceStrides.clear();
+  }
+  if (targetSliceSize) {
+    targetSizes.clear();
+    targetStrides.clear();
+  }
+
   // Convert source and target sizes and strides to `BDDimLayoutArrayAttr`s,
   // which the `aie.objectfifo` works with.
   AIE::BDDimLayoutArrayAttr sourceDims =
-      convertSizeStrideToBDDimLayoutArrayAttr(
-          rewriter, dmaOp.getSourceMixedSizes(), dmaOp.getSourceMixedStrides());
+      convertSizeStrideToBDDimLayoutArrayAttr(rewriter, sourceSizes,
+                                              sourceStrides);
   SmallVector<AIE::BDDimLayoutArrayAttr> targetDimsVec;
   targetDimsVec.push_back(convertSizeStrideToBDDimLayoutArrayAttr(
-      rewriter, dmaOp.getTargetMixedSizes(), dmaOp.getTargetMixedStrides()));
+      rewriter, targetSizes, targetStrides));
   AIE::BDDimLayoutArrayArrayAttr targetDims =
       AIE::BDDimLayoutArrayArrayAttr::get(rewriter.getContext(),
                                           ArrayRef(targetDimsVec));
@@ -89,20 +161,21 @@ AIE::ObjectFifoCreateOp createObjectFifo(IRRewriter &rewriter,
   // objectfifos are set up and it is probably better to adjust AIE objectfifos
   // directly to make this more clean.
   // TODO(jornt): I think objectfifos should support source type != dest type.
-  MemRefType srcType =
-      cast<LogicalObjectFifoType>(dmaOp.getSourceType()).getElementType();
-  MemRefType dstType =
-      cast<LogicalObjectFifoType>(dmaOp.getTargetType()).getElementType();
   ArrayRef<int64_t> sourceShape = srcType.getShape();
   ArrayRef<int64_t> targetShape = dstType.getShape();
-  int64_t sourceSize = std::accumulate(sourceShape.begin(), sourceShape.end(),
-                                       1, std::multiplies<>());
-  int64_t targetSize = std::accumulate(targetShape.begin(), targetShape.end(),
-                                       1, std::multiplies<>());
+  int64_t sourceSize = sourceSliceSize.value_or(std::accumulate(
+      sourceShape.begin(), sourceShape.end(), 1, std::multiplies<>()));
+  int64_t targetSize = targetSliceSize.value_or(std::accumulate(
+      targetShape.begin(), targetShape.end(), 1, std::multiplies<>()));
+  // A dynamically shaped L3 memref doesn't determine the objectfifo type, as
+  // only the L2/L1 side of the transfer needs to be allocated.
+  bool useSourceType = srcType.hasStaticShape() && dstType.hasStaticShape()
+                           ? sourceSize < targetSize
+                           : srcType.hasStaticShape();
   // TODO(jornt) for now, memory space 1 is used for objectfifos. Maybe refactor
   // `aie.objectfifo` in the future to support different memory spaces.
   MemRefType memrefType =
-      sourceSize < targetSize
+      useSourceType
           ? MemRefType::get({sourceSize}, srcType.getElementType(),
                             MemRefLayoutAttrInterface{},
                             rewriter.getI64IntegerAttr(1))
@@ -239,6 +312,48 @@ LogicalResult coreReleaseOpToAIE(IRRewriter &rewriter,
   return success();
 }
 
+/// Insert an `aie.configure_cascade` for `tileOp` if `aieCoreOp` uses the
+/// cascade stream, which the accumulator chains of split reductions flow over
+/// from west to east (see `iree-amdaie-chain-cascade-accumulators`). A core
+/// getting values takes its cascade input from the west and a core putting
+/// values sends its cascade output to the east. The unused side keeps the
+/// default direction.
+LogicalResult configureCascadeToAIE(IRRewriter &rewriter,
+                                    AMDAIE::CoreOp coreOp,
+                                    AIE::CoreOp aieCoreOp, AIE::TileOp tileOp,
+                                    AIE::DeviceOp deviceOp) {
+  bool getsCascade = false;
+  bool putsCascade = false;
+  aieCoreOp.walk([&](Operation *op) {
+    getsCascade |= isa<AIE::GetCascadeOp>(op);
+    putsCascade |= isa<AIE::PutCascadeOp>(op);
+  });
+  if (!getsCascade && !putsCascade) return success();
+  Block *deviceBlock = &deviceOp.getRegion().front();
+  auto hasTileAt = [&](int col) {
+    return llvm::any_of(deviceBlock->getOps<AIE::TileOp>(), [&](AIE::TileOp t) {
+      return t.getCol() == col && t.getRow() == tileOp.getRow();
+    });
+  };
+  if (getsCascade && !hasTileAt(tileOp.getCol() - 1)) {
+    return coreOp.emitOpError()
+           << "gets values from its cascade input, but there is no tile west "
+              "of it to send them";
+  }
+  if (putsCascade && !hasTileAt(tileOp.getCol() + 1)) {
+    return coreOp.emitOpError()
+           << "puts values on its cascade output, but there is no tile east "
+              "of it to receive them";
+  }
+  OpBuilder::InsertionGuard guard(rewriter);
+  rewriter.setInsertionPointToEnd(deviceBlock);
+  rewriter.create<AIE::ConfigureCascadeOp>(
+      rewriter.getUnknownLoc(), tileOp,
+      getsCascade ? AIE::CascadeDir::West : AIE::CascadeDir::North,
+      putsCascade ? AIE::CascadeDir::East : AIE::CascadeDir::South);
+  return success();
+}
+
 /// Convert `amdaie.core` into `aie.core`.
 LogicalResult coreToAIE(IRRewriter &rewriter, AMDAIE::CoreOp coreOp,
                         IRMapping &mapper, AIE::DeviceOp deviceOp,
@@ -312,6 +427,10 @@ LogicalResult coreToAIE(IRRewriter &rewriter, AMDAIE::CoreOp coreOp,
     op->dropAllUses();
     rewriter.eraseOp(op);
   }
+  if (failed(configureCascadeToAIE(rewriter, coreOp, aieCoreOp, tileOp,
+                                   deviceOp))) {
+    return failure();
+  }
 
   mapper.map(coreOp.getResult(), aieCoreOp.getResult());
   mapper.map(coreOp.getOperation(), aieCoreOp.getOperation());
@@ -359,15 +478,88 @@ LogicalResult circularDmaToAIE(IRRewriter &rewriter,
 
 namespace {
 
+/// A size that's only known at dispatch time, expressed as
+/// `ceilDiv(c * multiplier + addend, divisor)` with `c` the push constant with
+/// ordinal `ordinal`.
+struct RuntimeSizeExpr {
+  int64_t ordinal;
+  int64_t multiplier = 1;
+  int64_t addend = 0;
+  int64_t divisor = 1;
+};
+
+/// Utility to express the dynamic `value` in terms of the push constant it's
+/// derived from. Only casts and integer arithmetic with constant operands are
+/// supported, as the expression needs to be evaluated by the runtime.
+FailureOr<RuntimeSizeExpr> getRuntimeSizeExpr(Value value) {
+  Operation *op = value.getDefiningOp();
+  if (!op) return failure();
+  if (auto loadOp = dyn_cast<IREE::HAL::InterfaceConstantLoadOp>(op)) {
+    RuntimeSizeExpr expr;
+    expr.ordinal = loadOp.getIndex().getZExtValue();
+    return expr;
+  }
+  if (isa<arith::IndexCastOp, arith::IndexCastUIOp, arith::ExtSIOp,
+          arith::ExtUIOp>(op)) {
+    return getRuntimeSizeExpr(op->getOperand(0));
+  }
+  if (op->getNumOperands() != 2) return failure();
+  Value lhs = op->getOperand(0);
+  std::optional<int64_t> cst = getConstantIntValue(op->getOperand(1));
+  if (!cst && isa<arith::AddIOp, arith::MulIOp>(op)) {
+    lhs = op->getOperand(1);
+    cst = getConstantIntValue(op->getOperand(0));
+  }
+  if (!cst) return failure();
+  FailureOr<RuntimeSizeExpr> expr = getRuntimeSizeExpr(lhs);
+  // Other operations can't be applied after the division.
+  if (failed(expr) || expr->divisor != 1) return failure();
+  return TypeSwitch<Operation *, FailureOr<RuntimeSizeExpr>>(op)
+      .Case<arith::AddIOp>([&](auto) {
+        expr->addend += cst.value();
+        return expr;
+      })
+      .Case<arith::SubIOp>([&](auto) {
+        expr->addend -= cst.value();
+        return expr;
+      })
+      .Case<arith::MulIOp>([&](auto) {
+        expr->multiplier *= cst.value();
+        expr->addend *= cst.value();
+        return expr;
+      })
+      .Case<arith::CeilDivSIOp, arith::CeilDivUIOp>(
+          [&](auto) -> FailureOr<RuntimeSizeExpr> {
+            if (cst.value() <= 0) return failure();
+            expr->divisor = cst.value();
+            return expr;
+          })
+      .Case<arith::DivSIOp, arith::DivUIOp>(
+          [&](auto) -> FailureOr<RuntimeSizeExpr> {
+            // floorDiv(x, d) == ceilDiv(x - d + 1, d) for non-negative sizes.
+            if (cst.value() <= 0) return failure();
+            expr->addend -= cst.value() - 1;
+            expr->divisor = cst.value();
+            return expr;
+          })
+      .Default([&](Operation *) -> FailureOr<RuntimeSizeExpr> {
+        return failure();
+      });
+}
+
 /// Utility to get the static offsets, sizes and strides for
-/// `AIEX::NpuDmaMemcpyNdOp`.
+/// `AIEX::NpuDmaMemcpyNdOp`. Dynamic sizes are allowed if they can be derived
+/// from the push constants at dispatch time. Their static size is set to 1 and
+/// they are described in `runtimeSizes`, to be patched into the NPU
+/// instructions by the runtime.
 LogicalResult getStaticDims(Operation *op,
                             const SmallVector<OpFoldResult> &offsets,
                             const SmallVector<OpFoldResult> &sizes,
                             const SmallVector<OpFoldResult> &strides,
                             SmallVectorImpl<int64_t> &staticOffsets,
                             SmallVectorImpl<int64_t> &staticSizes,
-                            SmallVectorImpl<int64_t> &staticStrides) {
+                            SmallVectorImpl<int64_t> &staticStrides,
+                            SmallVectorImpl<Attribute> &runtimeSizes) {
   if (offsets.size() > staticOffsets.size()) {
     return op->emitError() << "size of `offsets` should be smaller or equal to "
                               "size of `staticOffsets`";
@@ -383,15 +575,43 @@ LogicalResult getStaticDims(Operation *op,
     return op->emitError() << "size of `strides` should be smaller or equal to "
                               "size of `staticStrides`";
   }
+  if (!llvm::all_of(llvm::concat<const OpFoldResult>(offsets, strides),
+                    [](OpFoldResult ofr) {
+                      return getConstantIntValue(ofr).has_value();
+                    })) {
+    return op->emitError() << "expected static offsets and strides";
+  }
   if (getConstantIntValue(strides[strides.size() - 1]).value() != 1) {
     return op->emitError() << "invalid last stride, should be 1";
   }
   for (int i = 0; i < offsets.size(); ++i)
     staticOffsets[staticOffsets.size() - offsets.size() + i] =
         getConstantIntValue(offsets[i]).value();
-  for (int i = 0; i < sizes.size(); ++i)
-    staticSizes[staticSizes.size() - sizes.size() + i] =
-        getConstantIntValue(sizes[i]).value();
+  Builder builder(op->getContext());
+  for (int i = 0; i < sizes.size(); ++i) {
+    int64_t dim = staticSizes.size() - sizes.size() + i;
+    if (std::optional<int64_t> size = getConstantIntValue(sizes[i])) {
+      staticSizes[dim] = size.value();
+      continue;
+    }
+    FailureOr<RuntimeSizeExpr> expr =
+        getRuntimeSizeExpr(sizes[i].get<Value>());
+    if (failed(expr)) {
+      return op->emitError() << "dynamic size can't be derived from the push "
+                                "constants at dispatch time";
+    }
+    staticSizes[dim] = 1;
+    runtimeSizes.push_back(builder.getDictionaryAttr({
+        builder.getNamedAttr("dim", builder.getI64IntegerAttr(dim)),
+        builder.getNamedAttr("ordinal",
+                             builder.getI64IntegerAttr(expr->ordinal)),
+        builder.getNamedAttr("multiplier",
+                             builder.getI64IntegerAttr(expr->multiplier)),
+        builder.getNamedAttr("addend", builder.getI64IntegerAttr(expr->addend)),
+        builder.getNamedAttr("divisor",
+                             builder.getI64IntegerAttr(expr->divisor)),
+    }));
+  }
   for (int i = 0; i < strides.size() - 1; ++i)
     staticStrides[staticStrides.size() - (strides.size() - 1) + i] =
         getConstantIntValue(strides[i]).value();
@@ -410,10 +630,11 @@ LogicalResult npuDmaCpyNdOpToAIE(IRRewriter &rewriter,
     SmallVector<int64_t, 4> staticOffsets(4, 1);
     SmallVector<int64_t, 4> staticSizes(4, 1);
     SmallVector<int64_t, 3> staticStrides(3, 1);
+    SmallVector<Attribute> runtimeSizes;
     if (failed(getStaticDims(dmaOp, dmaOp.getSourceMixedOffsets(),
                              dmaOp.getSourceMixedSizes(),
                              dmaOp.getSourceMixedStrides(), staticOffsets,
-                             staticSizes, staticStrides))) {
+                             staticSizes, staticStrides, runtimeSizes))) {
       return failure();
     }
 
@@ -428,20 +649,25 @@ LogicalResult npuDmaCpyNdOpToAIE(IRRewriter &rewriter,
     }
     // TODO(jornt): use bd_id != 0
     bool issueToken = dmaOp.hasDmaWaitOpUser();
-    rewriter.create<AIEX::NpuDmaMemcpyNdOp>(
+    auto npuDmaOp = rewriter.create<AIEX::NpuDmaMemcpyNdOp>(
         rewriter.getUnknownLoc(), SmallVector<Type, 1>{}, 0, 0, memref, empty,
         empty, empty, staticOffsets, staticSizes, staticStrides,
         objFifo.getName(), 0, issueToken);
+    if (!runtimeSizes.empty()) {
+      npuDmaOp->setAttr(kRuntimeSizesAttrName,
+                        rewriter.getArrayAttr(runtimeSizes));
+    }
   }
   if (dmaOp.hasTargetAddressing()) {
     SmallVector<Value> empty;
     SmallVector<int64_t, 4> staticOffsets(4, 1);
     SmallVector<int64_t, 4> staticSizes(4, 1);
     SmallVector<int64_t, 3> staticStrides(3, 1);
+    SmallVector<Attribute> runtimeSizes;
     if (failed(getStaticDims(dmaOp, dmaOp.getTargetMixedOffsets(),
                              dmaOp.getTargetMixedSizes(),
                              dmaOp.getTargetMixedStrides(), staticOffsets,
-                             staticSizes, staticStrides))) {
+                             staticSizes, staticStrides, runtimeSizes))) {
       return failure();
     }
     AMDAIE::CircularDmaCpyNdOp dmaCpyNd = dmaOp.getDmaCpyNdOp();
@@ -455,10 +681,14 @@ LogicalResult npuDmaCpyNdOpToAIE(IRRewriter &rewriter,
     }
     bool issueToken = dmaOp.hasDmaWaitOpUser();
     // TODO(jornt): use bd_id != 0
-    rewriter.create<AIEX::NpuDmaMemcpyNdOp>(
+    auto npuDmaOp = rewriter.create<AIEX::NpuDmaMemcpyNdOp>(
         rewriter.getUnknownLoc(), SmallVector<Type, 1>{}, 0, 0, memref, empty,
         empty, empty, staticOffsets, staticSizes, staticStrides,
         objFifo.getName(), 0, issueToken);
+    if (!runtimeSizes.empty()) {
+      npuDmaOp->setAttr(kRuntimeSizesAttrName,
+                        rewriter.getArrayAttr(runtimeSizes));
+    }
   }
   toBeErased.push_back(dmaOp);
   return success();
@@ -534,6 +764,10 @@ LogicalResult controlCodeToAie(IRRewriter &rewriter,
     op->dropAllUses();
     rewriter.eraseOp(op);
   }
+  // The computations of the sizes resolved at dispatch time are dead now.
+  for (Operation &op : llvm::make_early_inc_range(llvm::reverse(*funcBlock))) {
+    if (isOpTriviallyDead(&op)) rewriter.eraseOp(&op);
+  }
   return success();
 }
 
@@ -741,23 +975,69 @@ LogicalResult lowerToAIE(ModuleOp moduleOp) {
   return success();
 }
 
-/// Utility to erase all HAL bindings and dependent operations.
+/// Utility to erase all HAL bindings and push constant loads. By now, their
+/// uses have been converted: the bindings into arguments of the NPU
+/// instruction function and the push constants into sizes patched at dispatch
+/// time. The operations left using them are either computations without any
+/// remaining users or alignment assumptions on the bindings, which are erased
+/// as well. Any other remaining use can't be lowered and results in an error.
 LogicalResult eraseHALBindings(ModuleOp moduleOp) {
   IRRewriter rewriter(moduleOp.getContext());
-  SmallVector<Operation *> opsToBeErased;
-  moduleOp.walk([&](IREE::HAL::InterfaceBindingSubspanOp subspanOp) {
-    opsToBeErased.push_back(subspanOp.getOperation());
-    SmallVector<Operation *> userQueue(subspanOp->getUsers().begin(),
-                                       subspanOp->getUsers().end());
+  SmallVector<Operation *> halOps;
+  llvm::SetVector<Operation *> users;
+  moduleOp.walk([&](Operation *op) {
+    if (!isa<IREE::HAL::InterfaceBindingSubspanOp,
+             IREE::HAL::InterfaceConstantLoadOp>(op)) {
+      return;
+    }
+    halOps.push_back(op);
+    SmallVector<Operation *> userQueue(op->getUsers().begin(),
+                                       op->getUsers().end());
     while (!userQueue.empty()) {
       Operation *current = userQueue.pop_back_val();
-      opsToBeErased.push_back(current);
+      if (isa<IREE::HAL::InterfaceBindingSubspanOp>(current)) continue;
+      if (!users.insert(current)) continue;
       userQueue.insert(userQueue.end(), current->getUsers().begin(),
                        current->getUsers().end());
     }
   });
 
-  for (Operation *op : llvm::reverse(opsToBeErased)) rewriter.eraseOp(op);
+  // Erase the converted users until no more can be erased, as erasing a user
+  // can make the operations it depends on dead.
+  llvm::SmallPtrSet<Operation *, 8> erased;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (Operation *op : users) {
+      if (erased.contains(op)) continue;
+      if (!isOpTriviallyDead(op) && !isa<memref::AssumeAlignmentOp>(op))
+        continue;
+      op->walk([&](Operation *nestedOp) { erased.insert(nestedOp); });
+      rewriter.eraseOp(op);
+      changed = true;
+    }
+  }
+
+  // Report the remaining users at the end of their chains of uses, as those
+  // are the operations which couldn't be converted.
+  for (Operation *op : users) {
+    if (erased.contains(op)) continue;
+    if (llvm::any_of(op->getUsers(), [&](Operation *user) {
+          return users.contains(user) && !erased.contains(user);
+        })) {
+      continue;
+    }
+    return op->emitOpError() << "depends on a HAL binding or push constant in "
+                                "a way that can't be lowered to AIE";
+  }
+
+  // A push constant can be used by a binding for its dynamic dimensions, so
+  // the bindings are erased first.
+  llvm::stable_sort(halOps, [](Operation *a, Operation *b) {
+    return isa<IREE::HAL::InterfaceBindingSubspanOp>(a) &&
+           !isa<IREE::HAL::InterfaceBindingSubspanOp>(b);
+  });
+  for (Operation *op : halOps) rewriter.eraseOp(op);
   return success();
 }
 
@@ -6,10 +6,12 @@
 
 #include "iree-amd-aie/Transforms/AMDAIEUtils.h"
 #include "iree-amd-aie/Transforms/Passes.h"
+#include "iree-amd-aie/UKernels/UKernelRegistry.h"
 #include "iree/compiler/Codegen/Dialect/Codegen/IR/IREECodegenDialect.h"
 #include "iree/compiler/Codegen/Dialect/Codegen/IR/UKernelOps.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
 #include "llvm/Support/Path.h"
+#include "mlir/Dialect/Linalg/IR/LinalgInterfaces.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
@@ -47,32 +49,26 @@ struct FnNameAndDefAttrs {
 
 static std::string getPathToUKernelObjectFile(std::string pathToUkernels,
                                               std::string ukernelObjectFile) {
-  // TODO(avarma): The idea is that we build the microkernel object files while
-  // building IREE with iree-amd-aie plugin. This way we know where the object
-  // files is going to reside w.r.t IREE build and by extension the onus of
-  // spilling out the path to the same is going to be on IREE(iree-amd-aie).
-  // For now, I'm using `path-to-ukernels` pass flag to specify the directory
-  // where microkernel resides.
+  // If no `path-to-ukernels` is specified, this is just the name of the
+  // object file, which the target backend resolves against the microkernel
+  // library bundled with the compiler (see UKernels/UKernelRegistry.h).
   SmallVector<char> parentDirectoryPath{pathToUkernels.begin(),
                                         pathToUkernels.end()};
   llvm::sys::path::append(parentDirectoryPath, ukernelObjectFile);
   return Twine(parentDirectoryPath).str();
 }
 
-/// Returns the function name and attributes to use for a ukernel with given
-/// `ukernelName` on the target described by `targetAttr`.
+/// Returns the function name and attributes to use for the given library
+/// microkernel `ukernel`.
 static FnNameAndDefAttrs getFnNameAndDefAttrs(RewriterBase &rewriter,
-                                              std::string ukernelName,
-                                              std::string inputOutputElemType,
-                                              std::string pathToUkernels,
-                                              std::string ukernelObjectFile) {
+                                              const UKernelDescriptor &ukernel,
+                                              std::string pathToUkernels) {
   FnNameAndDefAttrs result;
-  std::string ukernelSuffix = "";
-  result.name = ukernelName + ukernelSuffix + "_" + inputOutputElemType;
+  result.name = ukernel.getFnName();
   result.defAttrs.emplace_back(
       rewriter.getStringAttr("link_with"),
-      rewriter.getStringAttr(
-          getPathToUKernelObjectFile(pathToUkernels, ukernelObjectFile)));
+      rewriter.getStringAttr(getPathToUKernelObjectFile(
+          pathToUkernels, ukernel.objectFile.str())));
   return result;
 }
 
@@ -80,6 +76,89 @@ static FnNameAndDefAttrs getFnNameAndDefAttrs(RewriterBase &rewriter,
 /// ================== SAME UTILITIES AS IREE LLVMCPU ====================
 /// ======================================================================
 
+/// Returns the (M, N, K) shape of the tile computed by the matmul `op`, i.e.
+/// the product of the static loop ranges of the M-, N- and K-dimensions
+/// respectively. Returns an empty shape if any of these is dynamic or if there
+/// is a non-unit batch dimension.
+static SmallVector<int64_t> getMatmulTileShape(
+    linalg::LinalgOp op, const linalg::ContractionDimensions &dims) {
+  SmallVector<int64_t> ranges = op.getStaticLoopRanges();
+  auto getSize = [&](ArrayRef<unsigned> loopDims) -> std::optional<int64_t> {
+    int64_t size = 1;
+    for (unsigned dim : loopDims) {
+      if (ShapedType::isDynamic(ranges[dim])) return std::nullopt;
+      size *= ranges[dim];
+    }
+    return size;
+  };
+  std::optional<int64_t> batch = getSize(dims.batch);
+  std::optional<int64_t> m = getSize(dims.m);
+  std::optional<int64_t> n = getSize(dims.n);
+  std::optional<int64_t> k = getSize(dims.k);
+  if (!batch || *batch != 1 || !m || !n || !k) return {};
+  return {*m, *n, *k};
+}
+
+/// Returns whether the rhs of the matmul `op` is transposed, i.e. whether its
+/// innermost dimension is a K-dimension. The `_bT` microkernels expect a
+/// transposed rhs of N x K blocks of t x s elements in row-major order, i.e.
+/// block (i, j) at index `j * colA + i`, so the rhs needs to be indexed with
+/// (N, K, N, K) after any unit dimensions. Returns failure for a transposed rhs
+/// in any other layout.
+static FailureOr<bool> isRhsTransposed(
+    linalg::LinalgOp op, const linalg::ContractionDimensions &dims) {
+  AffineMap rhsMap = op.getMatchingIndexingMap(op.getDpsInputOperand(1));
+  ArrayRef<AffineExpr> results = rhsMap.getResults();
+  auto isDimIn = [](AffineExpr expr, ArrayRef<unsigned> loopDims) {
+    auto dimExpr = dyn_cast<AffineDimExpr>(expr);
+    return dimExpr && llvm::is_contained(loopDims, dimExpr.getPosition());
+  };
+  if (results.empty() || !isDimIn(results.back(), dims.k)) return false;
+  if (results.size() < 4) return failure();
+
+  SmallVector<int64_t> ranges = op.getStaticLoopRanges();
+  for (AffineExpr expr : results.drop_back(4)) {
+    auto dimExpr = dyn_cast<AffineDimExpr>(expr);
+    if (!dimExpr || ranges[dimExpr.getPosition()] != 1) return failure();
+  }
+  ArrayRef<AffineExpr> blocked = results.take_back(4);
+  if (isDimIn(blocked[0], dims.n) && isDimIn(blocked[1], dims.k) &&
+      isDimIn(blocked[2], dims.n)) {
+    return true;
+  }
+  return failure();
+}
+
+/// Returns the element types of the matmul `op` as they appear in the names of
+/// the microkernels, e.g. `bf16_f32`, or failure if there is no microkernel
+/// for them.
+static FailureOr<std::string> getMatmulElemTypes(linalg::LinalgOp op) {
+  auto getElemType = [](Value v) {
+    return llvm::cast<ShapedType>(v.getType()).getElementType();
+  };
+  Type lhsElemType = getElemType(op.getDpsInputOperand(0)->get());
+  Type rhsElemType = getElemType(op.getDpsInputOperand(1)->get());
+  Type outElemType = getElemType(op.getDpsInitOperand(0)->get());
+  if (lhsElemType.isSignlessInteger(32) && rhsElemType.isSignlessInteger(32) &&
+      outElemType.isSignlessInteger(32)) {
+    return std::string("i32_i32");
+  } else if (lhsElemType.isBF16() && rhsElemType.isBF16() &&
+             outElemType.isBF16()) {
+    return std::string("bf16_bf16");
+  } else if (lhsElemType.isBF16() && rhsElemType.isBF16() &&
+             outElemType.isF32()) {
+    return std::string("bf16_f32");
+  } else if (lhsElemType.isF32() && rhsElemType.isF32() &&
+             outElemType.isF32()) {
+    return std::string("f32_f32");
+  } else if (lhsElemType.isSignlessInteger(8) &&
+             rhsElemType.isSignlessInteger(8) &&
+             outElemType.isSignlessInteger(32)) {
+    return std::string("i8_i32");
+  }
+  return failure();
+}
+
 /// Matches a linalg.generic operation which is basically a tiled matmul and
 /// converts it into a iree_codegen.ukernel."iree_amdaie_uk_matmul" operation,
 /// that is later lowered into a call to the microkernel.
@@ -94,32 +173,40 @@ static FailureOr<IREE::Codegen::UKernelOpInterface> matchDAGForUKernel(
   Value rhs = op.getDpsInputOperand(1)->get();
   Value out = op.getDpsInitOperand(0)->get();
   auto outType = llvm::cast<ShapedType>(out.getType());
-  Type lhsElemType = llvm::cast<ShapedType>(lhs.getType()).getElementType();
-  Type rhsElemType = llvm::cast<ShapedType>(rhs.getType()).getElementType();
-  Type outElemType = outType.getElementType();
-
-  std::string inputOutputElemType = "";
-  if (lhsElemType.isSignlessInteger(32) && rhsElemType.isSignlessInteger(32) &&
-      outElemType.isSignlessInteger(32)) {
-    inputOutputElemType = "i32_i32";
-  } else if (lhsElemType.isBF16() && rhsElemType.isBF16() &&
-             outElemType.isBF16()) {
-    inputOutputElemType = "bf16_bf16";
-  } else if (lhsElemType.isBF16() && rhsElemType.isBF16() &&
-             outElemType.isF32()) {
-    inputOutputElemType = "bf16_f32";
-  } else if (lhsElemType.isF32() && rhsElemType.isF32() &&
-             outElemType.isF32()) {
-    inputOutputElemType = "f32_f32";
-  } else {
+  FailureOr<std::string> inputOutputElemType = getMatmulElemTypes(op);
+  if (failed(inputOutputElemType)) {
     return rewriter.notifyMatchFailure(
         op, "unsupported combination of element types for microkernel");
   }
 
+  // Prefer a microkernel specialized for the tile shape. The generic one of
+  // the bundled library is only compiled for a single tile shape, while an
+  // object file from `path-to-ukernels` is compiled for the shape in use.
+  SmallVector<int64_t> tileShape;
+  bool transposeB = false;
+  FailureOr<linalg::ContractionDimensions> contractionDims =
+      linalg::inferContractionDims(op);
+  if (succeeded(contractionDims)) {
+    tileShape = getMatmulTileShape(op, *contractionDims);
+    FailureOr<bool> rhsTransposed = isRhsTransposed(op, *contractionDims);
+    if (failed(rhsTransposed)) {
+      return rewriter.notifyMatchFailure(
+          op, "transposed rhs isn't in the blocked layout of the microkernels");
+    }
+    transposeB = *rhsTransposed;
+  }
+  FailureOr<UKernelDescriptor> ukernel =
+      lookupUKernel(ukernelName, *inputOutputElemType, tileShape, transposeB,
+                    /*anyGenericTileShape=*/!pathToUkernels.empty());
+  if (failed(ukernel)) {
+    return rewriter.notifyMatchFailure(
+        op, "no microkernel in the library for this combination of types, "
+            "tile shape and rhs layout");
+  }
+
   Location loc = op.getLoc();
 
-  auto fn = getFnNameAndDefAttrs(rewriter, ukernelName, inputOutputElemType,
-                                 pathToUkernels, "mm.o");
+  auto fn = getFnNameAndDefAttrs(rewriter, *ukernel, pathToUkernels);
 
   // Create UKernel for AMD-AIE.
   auto genericMicroKernelOp = rewriter.create<IREE::Codegen::UKernelGenericOp>(
@@ -153,15 +240,26 @@ static FailureOr<IREE::Codegen::UKernelOpInterface> matchDAGForUKernel(
     elemType = "bf16";
   } else if (outElemType.isF32()) {
     elemType = "f32";
+  } else if (outElemType.isSignlessInteger(32)) {
+    elemType = "i32";
   } else {
     return rewriter.notifyMatchFailure(
         op, "unsupported combination of element types for microkernel");
   }
 
+  SmallVector<int64_t> tileShape;
+  if (outType.hasStaticShape()) tileShape.push_back(outType.getNumElements());
+  FailureOr<UKernelDescriptor> ukernel =
+      lookupUKernel(ukernelName, elemType, tileShape, /*transposeB=*/false,
+                    /*anyGenericTileShape=*/!pathToUkernels.empty());
+  if (failed(ukernel)) {
+    return rewriter.notifyMatchFailure(
+        op, "no microkernel in the library for this element type and size");
+  }
+
   Location loc = op.getLoc();
 
-  auto fn = getFnNameAndDefAttrs(rewriter, ukernelName, elemType,
-                                 pathToUkernels, "mm.o");
+  auto fn = getFnNameAndDefAttrs(rewriter, *ukernel, pathToUkernels);
 
   // Create UKernel for AMD-AIE.
   auto genericMicroKernelOp = rewriter.create<IREE::Codegen::UKernelGenericOp>(
@@ -238,6 +336,23 @@ void AMDAIELowerToUKernelsPass::runOnOperation() {
           applyPatternsAndFoldGreedily(getOperation(), std::move(patterns)))) {
     return signalPassFailure();
   }
+
+  // The bundled matmul microkernels are compiled for the tile shapes chosen by
+  // the tiling heuristics. A matmul left over here has another tile shape or
+  // rhs layout and is left to code generation, which is pointed out as the
+  // heuristics and the library are likely out of sync.
+  if (!pathToUkernels.empty()) return;
+  getOperation()->walk([](linalg::LinalgOp op) {
+    if (!isa<linalg::GenericOp, linalg::MatmulOp>(op) || !isMatmul(op) ||
+        failed(getMatmulElemTypes(op)) ||
+        !hasUkernel(IREE::HAL::ExecutableTargetAttr::lookup(op), "matmul")) {
+      return;
+    }
+    op.emitRemark(
+        "has no matmul microkernel for its element types, tile shape and rhs "
+        "layout in the bundled microkernel library, falling back to code "
+        "generation");
+  });
 }
 
 }  // namespace
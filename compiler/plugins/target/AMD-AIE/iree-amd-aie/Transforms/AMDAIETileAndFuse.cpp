@@ -164,15 +164,28 @@ void AMDAIETileAndFusePass::runOnOperation() {
     // Here we assume there are always two levels of parallel (scf.forall)
     // loops, and the first level of tiling is always using scf.forall and
     // mapped to blocks.
+    SmallVector<Attribute> mapping;
     if (tilingLevel == 0) {
-      options.setMapping(
-          {gpu::GPUBlockMappingAttr::get(context, gpu::MappingId::DimY),
-           gpu::GPUBlockMappingAttr::get(context, gpu::MappingId::DimX)});
+      mapping = {gpu::GPUBlockMappingAttr::get(context, gpu::MappingId::DimY),
+                 gpu::GPUBlockMappingAttr::get(context, gpu::MappingId::DimX)};
     } else {
-      options.setMapping(
-          {gpu::GPUThreadMappingAttr::get(context, gpu::MappingId::DimY),
-           gpu::GPUThreadMappingAttr::get(context, gpu::MappingId::DimX)});
+      mapping = {gpu::GPUThreadMappingAttr::get(context, gpu::MappingId::DimY),
+                 gpu::GPUThreadMappingAttr::get(context, gpu::MappingId::DimX)};
     }
+    // With a single tiled dimension, e.g. the rows of a row reduction, the
+    // loop is mapped to the x dimension only.
+    size_t numTiledDims =
+        llvm::count_if(tileSizesVal, [](int64_t size) { return size != 0; });
+    if (numTiledDims < mapping.size())
+      mapping.erase(mapping.begin(), mapping.end() - numTiledDims);
+    if (numTiledDims > mapping.size()) {
+      consumerOp->emitOpError("has ")
+          << numTiledDims << " tiled dimensions at tiling level "
+          << tilingLevel << ", but at most " << mapping.size()
+          << " can be mapped to the AIE array";
+      return signalPassFailure();
+    }
+    options.setMapping(mapping);
   }
 
   IRRewriter rewriter(context);
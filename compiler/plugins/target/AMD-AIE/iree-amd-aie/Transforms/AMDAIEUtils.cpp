@@ -6,7 +6,11 @@
 
 #include "AMDAIEUtils.h"
 
+#include "iree-amd-aie/IR/AMDAIEAttrs.h"
 #include "llvm/ADT/DenseMap.h"
+#include "mlir/Dialect/Bufferization/IR/Bufferization.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Iterators.h"
 
@@ -108,6 +112,14 @@ FailureOr<unsigned> getTilingScaleFactor(Type elemType) {
   return 64 / bitWidth;
 }
 
+FailureOr<unsigned> getAIEVectorLanes(Type elemType) {
+  if (!elemType.isIntOrFloat()) return failure();
+  unsigned bitWidth = elemType.getIntOrFloatBitWidth();
+  if (bitWidth % 8 != 0) return failure();
+  if (bitWidth > 32) return failure();
+  return 512 / bitWidth;
+}
+
 /// Utility to match iterator type and indexing map for a linalg.generic that
 /// is basically implementing a matmul with 2D input/output operands.
 static bool match2DLinalgGenericMatmul(linalg::LinalgOp linalgOp) {
@@ -317,6 +329,74 @@ bool isMatmulProducerOfElementwise(linalg::LinalgOp linalgOp) {
   return false;
 }
 
+bool isRowReduction(linalg::LinalgOp linalgOp) {
+  if (linalg::isaContractionOpInterface(linalgOp)) return false;
+  SmallVector<utils::IteratorType> iteratorTypes =
+      linalgOp.getIteratorTypesArray();
+  // At least one row and one reduced dimension, with all reduced dimensions
+  // after all row dimensions.
+  if (iteratorTypes.empty() ||
+      iteratorTypes.front() != utils::IteratorType::parallel ||
+      iteratorTypes.back() != utils::IteratorType::reduction) {
+    return false;
+  }
+  return llvm::is_sorted(iteratorTypes, [](utils::IteratorType lhs,
+                                           utils::IteratorType rhs) {
+    return lhs == utils::IteratorType::parallel &&
+           rhs == utils::IteratorType::reduction;
+  });
+}
+
+std::optional<uint64_t> getMemorySpace(Value value) {
+  while (value) {
+    if (auto memRefType = dyn_cast<MemRefType>(value.getType())) {
+      Attribute memSpace = memRefType.getMemorySpace();
+      if (!memSpace) return 0;
+      if (auto intAttr = dyn_cast<IntegerAttr>(memSpace))
+        return intAttr.getInt();
+      return std::nullopt;
+    }
+    if (auto blockArg = dyn_cast<BlockArgument>(value)) {
+      Operation *parentOp = blockArg.getOwner()->getParentOp();
+      if (auto forallOp = dyn_cast<scf::ForallOp>(parentOp)) {
+        OpOperand *tiedOperand = forallOp.getTiedOpOperand(blockArg);
+        if (!tiedOperand) return std::nullopt;
+        value = tiedOperand->get();
+      } else if (auto forOp = dyn_cast<scf::ForOp>(parentOp)) {
+        OpOperand *tiedOperand = forOp.getTiedLoopInit(blockArg);
+        if (!tiedOperand) return std::nullopt;
+        value = tiedOperand->get();
+      } else {
+        return std::nullopt;
+      }
+      continue;
+    }
+    Operation *defOp = value.getDefiningOp();
+    if (auto toTensorOp = dyn_cast<bufferization::ToTensorOp>(defOp)) {
+      value = toTensorOp.getMemref();
+    } else if (auto sliceOp = dyn_cast<tensor::ExtractSliceOp>(defOp)) {
+      value = sliceOp.getSource();
+    } else if (auto dpsOp = dyn_cast<DestinationStyleOpInterface>(defOp)) {
+      value = dpsOp.getTiedOpOperand(cast<OpResult>(value))->get();
+    } else {
+      return std::nullopt;
+    }
+  }
+  return std::nullopt;
+}
+
+bool hasOnlyLocalMemoryOperands(Operation *op) {
+  for (auto operand : op->getOperands()) {
+    if (!isa<ShapedType>(operand.getType())) continue;
+    std::optional<uint64_t> memSpace = getMemorySpace(operand);
+    if (!memSpace ||
+        memSpace.value() != static_cast<uint64_t>(AMDAIEMemSpace::Local)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /// Find the largest factor of 'num' which is not larger than 'max'.
 int detail::findLargestFactor(int num, int max) {
   assert(max > 0 && "No factors less than or equal to 0 exist");
@@ -66,6 +66,16 @@ FailureOr<std::array<uint32_t, 3>> getAIEIntegerMatmulInstructionSize(
 /// width.
 FailureOr<unsigned> getTilingScaleFactor(Type elemType);
 
+/// Utility that returns the number of elements of type `elemType` that fit in
+/// a single 512-bit AIE vector register, i.e. the native vector width for
+/// elementwise operations, fills and copies on the core:
+///     a. 32 bit width -> 16 lanes.
+///     b. 16 bit width -> 32 lanes.
+///     c.  8 bit width -> 64 lanes.
+/// Element types wider than 32 bits have no native vector support and return
+/// failure.
+FailureOr<unsigned> getAIEVectorLanes(Type elemType);
+
 /// Utility to indentify whether a linalg op is a matmul op.
 bool isMatmul(linalg::LinalgOp linalgOp);
 
@@ -77,6 +87,22 @@ bool isMatmulInDefChain(Value operand);
 /// matmul-like op upstream in its computation tree.
 bool isMatmulProducerOfElementwise(linalg::LinalgOp linalgOp);
 
+/// Utility to identify whether `linalgOp` reduces along the innermost
+/// dimensions of its iteration space only, as the row reductions of softmax
+/// and normalizations (layernorm, RMSNorm) do. Contractions are excluded.
+bool isRowReduction(linalg::LinalgOp linalgOp);
+
+/// Utility to return the memory space of `value` if it can be determined.
+/// Memrefs carry their memory space in their type. Tensors are traced back
+/// through slices, destination passing style ops and loop carried values to
+/// the memref they were created from with `bufferization.to_tensor`. A memref
+/// without memory space attribute is in global memory.
+std::optional<uint64_t> getMemorySpace(Value value);
+
+/// Utility to identify whether all shaped operands of `op` are known to live
+/// in the local (L1) memory of a core.
+bool hasOnlyLocalMemoryOperands(Operation *op);
+
 namespace detail {
 
 // Returns the largest number that perfectly divides `num` that
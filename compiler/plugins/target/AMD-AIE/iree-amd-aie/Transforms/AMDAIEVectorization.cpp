@@ -4,6 +4,7 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include "iree-amd-aie/Transforms/AMDAIEUtils.h"
 #include "iree-amd-aie/Transforms/Passes.h"
 #include "mlir/Dialect/Affine/LoopUtils.h"
 #include "mlir/Dialect/Linalg/IR/LinalgInterfaces.h"
@@ -27,7 +28,8 @@ namespace {
 // AIE-specific pass is a minimal version of GenericVectorization tailored to
 // the needs of amd-aie. iree-amd-aie uses linalg.copy ops to move data between
 // memory spaces (DDR, memory tile, core). These copy ops should not be
-// vectorized to vector transfer_read/transfer_write ops. This 'fork' of
+// vectorized to vector transfer_read/transfer_write ops, but copies and fills
+// which stay within a core's local memory are vectorized. This 'fork' of
 // GenericVectorization will be extended in the future to support more
 // AIE-specific vectorization patterns.
 
@@ -53,6 +55,17 @@ class AMDAIEVectorizationPass
     }
     return false;
   }
+
+  /// Return true if all shaped operands of `op` have an element type for
+  /// which the AIE core has native vector instructions (i.e. at most 32 bits).
+  static bool hasOnlyVectorizableElementTypes(Operation *op) {
+    for (auto operand : op->getOperands()) {
+      if (auto type = dyn_cast<ShapedType>(operand.getType())) {
+        if (failed(getAIEVectorLanes(type.getElementType()))) return false;
+      }
+    }
+    return true;
+  }
 };
 
 void AMDAIEVectorizationPass::runOnOperation() {
@@ -69,16 +82,28 @@ void AMDAIEVectorizationPass::runOnOperation() {
 
     // iree-amd-aie's current tiling pipelines use linalg.copy ops to move data
     // between memory spaces. These copy ops should not be vectorized to
-    // vector.transfer_read/transfer_write ops.
-    if (isa<linalg::CopyOp>(op)) return;
-
-    // Temporarily disabling linalg::FillOp vectorization. Current compilation
-    // pipeline crashes in DMAToChannelPass: 'error: operand #0 does not
-    // dominate this use'. TODO(newling) follow-up on this.
-    if (isa<linalg::FillOp>(op)) return;
+    // vector.transfer_read/transfer_write ops, as they are converted to DMAs.
+    // The same holds for fills of buffers outside of the cores (vectorizing
+    // these makes DMAToChannelPass crash with 'error: operand #0 does not
+    // dominate this use'). Copies and fills which only touch the local
+    // memory of a core, like the zero initialization of the accumulator,
+    // are executed by the core and are vectorized.
+    if (isa<linalg::CopyOp, linalg::FillOp>(op)) {
+      if (!hasOnlyLocalMemoryOperands(op)) return;
+      if (!hasOnlyVectorizableElementTypes(op)) return;
+      candidates.push_back(op);
+      return;
+    }
 
-    // AIE architecture has no vector instructions for 32/64-bit types.
-    if (!hasOperandWithSmallElementType(op)) return;
+    // AIE architecture has no vector matmul instructions for 32/64-bit types,
+    // but elementwise operations and row reductions (e.g. the row maxima and
+    // sums of a softmax) on 32-bit types can use the vector unit.
+    if (!hasOperandWithSmallElementType(op)) {
+      auto linalgOp = cast<linalg::LinalgOp>(op);
+      if (!linalg::isElementwise(linalgOp) && !isRowReduction(linalgOp))
+        return;
+      if (!hasOnlyVectorizableElementTypes(op)) return;
+    }
 
     candidates.push_back(op);
   });
@@ -89,7 +89,8 @@ class ParameterSetting {
   }
 
   static FailureOr<ParameterSetting> create(linalg::LinalgOp linalgOp,
-                                            bool isPackPeel);
+                                            bool isPackPeel,
+                                            uint32_t cascadeKSplit = 1);
 
   uint32_t getM0() const { return M0; }
   uint32_t getN0() const { return N0; }
@@ -103,12 +104,16 @@ class ParameterSetting {
   uint32_t getM1Pack() const { return m1Pack; }
   uint32_t getN1Pack() const { return n1Pack; }
   uint32_t getK1Pack() const { return k1Pack; }
+  // Number of cores in a row that each accumulate a slice of the K dimension
+  // and chain their partial sums over the cascade interface. 1 if K is not
+  // split across cores.
+  uint32_t getKSplit() const { return kSplit; }
 
  private:
   ParameterSetting(uint32_t M0, uint32_t N0, uint32_t K0, uint32_t M1,
                    uint32_t N1, uint32_t K1, uint32_t m0Pack, uint32_t n0Pack,
                    uint32_t k0Pack, uint32_t m1Pack, uint32_t n1Pack,
-                   uint32_t k1Pack)
+                   uint32_t k1Pack, uint32_t kSplit = 1)
       : M0(M0),
         N0(N0),
         K0(K0),
@@ -120,7 +125,8 @@ class ParameterSetting {
         k0Pack(k0Pack),
         m1Pack(m1Pack),
         n1Pack(n1Pack),
-        k1Pack(k1Pack) {}
+        k1Pack(k1Pack),
+        kSplit(kSplit) {}
 
   uint32_t M0;
   uint32_t N0;
@@ -134,10 +140,12 @@ class ParameterSetting {
   uint32_t m1Pack;
   uint32_t n1Pack;
   uint32_t k1Pack;
+  uint32_t kSplit;
 };
 
 FailureOr<ParameterSetting> ParameterSetting::create(linalg::LinalgOp linalgOp,
-                                                     bool isPackPeel) {
+                                                     bool isPackPeel,
+                                                     uint32_t cascadeKSplit) {
   auto initType =
       llvm::cast<ShapedType>(linalgOp.getDpsInitOperand(0)->get().getType());
   auto initShape = initType.getShape();
@@ -193,6 +201,8 @@ FailureOr<ParameterSetting> ParameterSetting::create(linalg::LinalgOp linalgOp,
     // be (tileM0/2, tileN0/2). Since packing happens before tiling, and an
     // extra step is performed to fuse pack ops into the loops, the adjusted
     // level 1 tile sizes should be (tileM0/2/packedM1, tileN0/2/packedN1).
+    // The bundled microkernels are compiled for the resulting L1 tile shapes,
+    // keep `getMatmulTileShapes` in UKernels/UKernelRegistry.cpp in sync.
     auto maxL1Size = 16 * scaleFactor;
     uint32_t M1 = findLargestFactor(M / m1Pack, maxL1Size / m1Pack, m1Pack);
     uint32_t N1 = findLargestFactor(N / n1Pack, maxL1Size / n1Pack, n1Pack);
@@ -214,6 +224,24 @@ FailureOr<ParameterSetting> ParameterSetting::create(linalg::LinalgOp linalgOp,
     uint32_t n0Pack = (N0 / 2) % n1Pack == 0 ? (N0 / 2) : N0;
     uint32_t k0Pack = findLargestFactor(K, maxL1Size);
 
+    // Optionally split K across a row of `cascadeKSplit` cores. This is only
+    // worthwhile for large-K/small-N shapes, where the whole of N fits in one
+    // shared memory tile and the N dimension would otherwise leave cores idle.
+    // N is then not split across cores at all, and the K block moved into
+    // shared memory per iteration grows by the split factor so that each core
+    // still receives a `maxL1Size` slice of it.
+    if (cascadeKSplit > 1 && N0 == N) {
+      uint32_t splitK0Pack =
+          findLargestFactor(K, maxL1Size * cascadeKSplit,
+                            k1Pack * cascadeKSplit);
+      if (splitK0Pack % (k1Pack * cascadeKSplit) == 0) {
+        return ParameterSetting{M0,          N0,     K0,     M1,
+                                N1,          K1,     m0Pack, N0,
+                                splitK0Pack, m1Pack, n1Pack, k1Pack,
+                                cascadeKSplit};
+      }
+    }
+
     return ParameterSetting{M0,     N0,     K0,     M1,     N1,     K1,
                             m0Pack, n0Pack, k0Pack, m1Pack, n1Pack, k1Pack};
   } else {
@@ -300,7 +328,8 @@ static SmallVector<int64_t> setInnerPermB(bool isMatmulTransposeB) {
 static LogicalResult setRootConfigForPackPeelPipeline(
     mlir::FunctionOpInterface entryPointFn, linalg::LinalgOp linalgOp,
     AIEConfig cfg, bool isMatmulTransposeB) {
-  auto maybePackPeelTiling = ParameterSetting::create(linalgOp, true);
+  auto maybePackPeelTiling = ParameterSetting::create(
+      linalgOp, true, std::max<int32_t>(cfg.cascade_k_split, 1));
   if (failed(maybePackPeelTiling)) return failure();
   auto packPeelTiling = maybePackPeelTiling.value();
 
@@ -360,6 +389,14 @@ static LogicalResult setRootConfigForPackPeelPipeline(
                                          packPeelTiling.getN0()};
   SmallVector<int64_t> TileSizeLevel1 = {0, 0, packPeelTiling.getK0()};
   SmallVector<int64_t> TileSizeLevel2 = {1, 1, 0, 0, 0, 0};
+  // With a K split, the cores in a row (thread x) each take a contiguous
+  // slice of the packed K blocks instead of a slice of N. Their partial sums
+  // are combined on-array by `iree-amdaie-chain-cascade-accumulators`.
+  uint32_t kSplit = packPeelTiling.getKSplit();
+  if (kSplit > 1) {
+    int64_t kBlocks = packPeelTiling.getK0Pack() / packPeelTiling.getK1Pack();
+    TileSizeLevel2 = {1, 0, 0, 0, 0, kBlocks / kSplit};
+  }
   TileSizesListType tileSizes = {TileSizeLevel0, TileSizeLevel1,
                                  TileSizeLevel2};
   if (failed(setOpConfigAndEntryPointFnTranslation(
@@ -422,6 +459,90 @@ static LogicalResult setRootConfigForPadPackPipeline(
   return success();
 }
 
+/// Sets the lowering configuration for a row reduction, i.e. the reductions of
+/// softmax, layernorm and RMSNorm. Complete rows are reduced on a core, so the
+/// reduced dimensions are not tiled, and neither are the row dimensions outside
+/// of the innermost two. The rows are distributed in two levels:
+///   - level 0: a block of rows per workgroup, staged in shared memory.
+///   - level 1: a block of rows per core, staged in local memory.
+static LogicalResult setRootConfigForReductionPipeline(
+    mlir::FunctionOpInterface entryPointFn, linalg::LinalgOp linalgOp,
+    AIEConfig cfg) {
+  // Bytes of local memory available for the rows of a core. This leaves room
+  // for the stack and the second buffer of double buffered transfers.
+  const int64_t kLocalMemoryBudget = 32 * 1024;
+  // Number of row buffers live at the same time on a core: the input and
+  // output rows and the intermediate results of the reduction chain (e.g. the
+  // exponentials of a softmax).
+  const int64_t kNumRowBuffers = 4;
+
+  SmallVector<int64_t> loopRanges = linalgOp.getStaticLoopRanges();
+  if (llvm::any_of(loopRanges, ShapedType::isDynamic)) {
+    return linalgOp.emitOpError(
+        "has dynamic dimensions, which are not supported for reductions");
+  }
+  SmallVector<unsigned> parallelDims;
+  linalgOp.getParallelDims(parallelDims);
+  SmallVector<unsigned> reductionDims;
+  linalgOp.getReductionDims(reductionDims);
+
+  int64_t rowSize = 1;
+  for (unsigned dim : reductionDims) rowSize *= loopRanges[dim];
+  unsigned bitWidth = 0;
+  for (Value operand : linalgOp->getOperands()) {
+    Type elemType = getElementTypeOrSelf(operand.getType());
+    if (elemType.isIntOrFloat())
+      bitWidth = std::max(bitWidth, elemType.getIntOrFloatBitWidth());
+  }
+  int64_t rowBytes = rowSize * bitWidth / 8;
+  int64_t maxRowsPerCore = kLocalMemoryBudget / (kNumRowBuffers * rowBytes);
+  if (maxRowsPerCore == 0) {
+    return linalgOp.emitOpError("reduces rows of ")
+           << rowSize << " elements, which do not fit in the local memory of "
+           << "an AIE core.";
+  }
+
+  // The tiled loops are mapped to the y and x dimensions of the workgroups and
+  // cores, so at most two row dimensions are tiled: the rows of the innermost
+  // one are distributed over the cores and the next one is processed one at a
+  // time. Any further outer row dimensions are not tiled, so all of their rows
+  // are part of every block.
+  int64_t numUntiledRows = 1;
+  for (unsigned dim : ArrayRef(parallelDims).drop_back(2))
+    numUntiledRows *= loopRanges[dim];
+  maxRowsPerCore /= numUntiledRows;
+  if (maxRowsPerCore == 0) {
+    return linalgOp.emitOpError("has ")
+           << numUntiledRows << " rows of " << rowSize
+           << " elements in its outer row dimensions, which do not fit in the "
+           << "local memory of an AIE core. Collapse the row dimensions first.";
+  }
+
+  unsigned rowDim = parallelDims.back();
+  int64_t numRows = loopRanges[rowDim];
+  int64_t numCores = std::max<int64_t>(cfg.num_cores, 1);
+  int64_t rowsPerCore = findLargestFactor(
+      numRows,
+      std::max<int64_t>(1, std::min(maxRowsPerCore, numRows / numCores)));
+  int64_t numCoresUsed = findLargestFactor(numRows / rowsPerCore, numCores);
+
+  SmallVector<int64_t> level0(linalgOp.getNumLoops(), 0);
+  SmallVector<int64_t> level1(linalgOp.getNumLoops(), 0);
+  for (unsigned dim : ArrayRef(parallelDims).take_back(2)) {
+    level0[dim] = 1;
+    level1[dim] = 1;
+  }
+  level0[rowDim] = rowsPerCore * numCoresUsed;
+  level1[rowDim] = rowsPerCore;
+  TileSizesListType tileSizes = {level0, level1};
+  if (failed(setOpConfigAndEntryPointFnTranslation(
+          entryPointFn, linalgOp, tileSizes,
+          IREE::Codegen::DispatchLoweringPassPipeline::Custom))) {
+    return failure();
+  }
+  return success();
+}
+
 /// TODO(avarma): This currently is skipping checking for ext* ops.
 static bool bodyMatcherForMatmulTranspose(Value yieldVal, Block *body) {
   Operation *addOp = yieldVal.getDefiningOp();
@@ -516,6 +637,9 @@ static LogicalResult setRootConfig(mlir::FunctionOpInterface entryPointFn,
     return success();
   }
 
+  if (isRowReduction(genericOp))
+    return setRootConfigForReductionPipeline(entryPointFn, genericOp, cfg);
+
   return failure();
 }
 
@@ -572,6 +696,10 @@ static LogicalResult setRootConfigImpl(mlir::FunctionOpInterface entryPointFn,
         .Case<linalg::ContractionOpInterface>([&](auto op) {
           return setRootConfig(entryPointFn, op, passPipeline, cfg);
         })
+        .Case<linalg::ReduceOp>([&](auto op) {
+          if (!isRowReduction(op)) return failure();
+          return setRootConfigForReductionPipeline(entryPointFn, op, cfg);
+        })
         .Default([&](Operation *op) { return success(); });
   };
   return setRootConfigFn(op);
@@ -21,6 +21,10 @@ enum class AIEPassPipeline : int32_t {
   None = 2
 };
 
+/// Enum for the pass pipelines lowering the tiled and bufferized IR to the AIE
+/// dialect.
+enum class LowerToAIEPassPipeline : int32_t { AIR = 0, ObjectFifo = 1 };
+
 /// Enum for types of loop peeling.
 enum class PeelingType : int32_t { First = 0, Last = 1, FirstLast = 2 };
 
@@ -29,13 +33,18 @@ enum class BufferizeOperand : int32_t {
   InputOutput = 0,
   Input = 1,
   Output = 2,
-  DefOp = 3
+  DefOp = 3,
+  SliceInputOutput = 4
 };
 
 /// Struct specifying the number of cores to use. This will be replaced
 /// by a more versatile handling in the future.
 struct AIEConfig {
   int32_t num_cores;
+  /// Number of cores in a row to split the matmul K dimension across, chaining
+  /// their accumulators over the cascade interface (pack-peel with the
+  /// objectFifo lowering only).
+  int32_t cascade_k_split = 1;
 };
 
 LogicalResult initAIELaunchConfig(FunctionOpInterface funcOp,
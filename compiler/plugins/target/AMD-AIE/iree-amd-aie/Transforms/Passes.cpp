@@ -39,13 +39,33 @@ static llvm::cl::opt<AIEPassPipeline> clUsePipeline(
                    "pad and pack operations")),
     llvm::cl::init(AIEPassPipeline::PadPackPipeline));
 
+static llvm::cl::opt<LowerToAIEPassPipeline> clUseLowerToAIEPipeline(
+    "iree-amdaie-lower-to-aie-pipeline",
+    llvm::cl::desc("Pick the lowering pipeline to use from the tiled and "
+                   "bufferized IR to the AIE dialect"),
+    llvm::cl::values(
+        clEnumValN(LowerToAIEPassPipeline::AIR, "air",
+                   "Lower to AIE through the MLIR-AIR dialect"),
+        clEnumValN(LowerToAIEPassPipeline::ObjectFifo, "objectFifo",
+                   "Lower to AIE through logical objectFifos in the AMDAIE "
+                   "dialect")),
+    llvm::cl::init(LowerToAIEPassPipeline::AIR));
+
 static llvm::cl::opt<int32_t> clNumCores(
     "iree-amdaie-num-cores",
     llvm::cl::desc("Choose the number of cores to use"), llvm::cl::init(1));
 
+static llvm::cl::opt<int32_t> clCascadeKSplit(
+    "iree-amdaie-cascade-k-split",
+    llvm::cl::desc("Choose the number of cores in a row to split the matmul K "
+                   "dimension across, chaining their partial sums over the "
+                   "cascade interface (requires the objectFifo lowering)"),
+    llvm::cl::init(1));
+
 static llvm::cl::opt<std::string> clPathToUkernels(
     "iree-amdaie-path-to-ukernels",
-    llvm::cl::desc("Path to microkernels' directory"));
+    llvm::cl::desc("Path to microkernels' directory. If not specified, the "
+                   "microkernels bundled with the compiler are used"));
 
 static llvm::cl::opt<bool> clEnableVectorizationPasses(
     "iree-amdaie-enable-vectorization-passes",
@@ -400,17 +420,79 @@ void addPadPackBasedPassPipeline(OpPassManager &funcPassManager,
   addAMDAIEBufferizePasses(funcPassManager);
 }
 
+void addReductionBasedPassPipeline(OpPassManager &funcPassManager,
+                                   TilingConfig &tilingConfig) {
+  // First level tiling using scf.forall: a block of rows per workgroup. The
+  // reductions and elementwise ops over the same rows are fused into the loop.
+  {
+    AMDAIETileAndFuseOptions tileFuseOptions;
+    tileFuseOptions.tilingLevel = 0;
+    tileFuseOptions.useSCFFor = false;
+    funcPassManager.addPass(createAMDAIETileAndFusePass(tileFuseOptions));
+  }
+  funcPassManager.addPass(createAMDAIECleanupPass());
+  funcPassManager.addPass(createCanonicalizerPass());
+  funcPassManager.addPass(createCSEPass());
+
+  // Promote the rows to shared memory
+  {
+    AMDAIEBufferizeToAllocationOptions bufferizeOptions;
+    bufferizeOptions.memorySpace = 1;
+    bufferizeOptions.bufferizeOperand = BufferizeOperand::SliceInputOutput;
+    funcPassManager.addPass(
+        createAMDAIEBufferizeToAllocationPass(bufferizeOptions));
+  }
+
+  // Second level tiling using scf.forall: a block of rows per core
+  {
+    AMDAIETileAndFuseOptions tileFuseOptions;
+    tileFuseOptions.tilingLevel = 1;
+    tileFuseOptions.useSCFFor = false;
+    funcPassManager.addPass(createAMDAIETileAndFusePass(tileFuseOptions));
+  }
+  funcPassManager.addPass(createAMDAIECleanupPass());
+  funcPassManager.addPass(createCanonicalizerPass());
+  funcPassManager.addPass(createCSEPass());
+
+  // Promote the rows to local memory. The intermediate results of the chain,
+  // e.g. the row maxima and sums, are allocated in local memory by the
+  // comprehensive bufferization.
+  {
+    AMDAIEBufferizeToAllocationOptions bufferizeOptions;
+    bufferizeOptions.memorySpace = 2;
+    bufferizeOptions.bufferizeOperand = BufferizeOperand::SliceInputOutput;
+    funcPassManager.addPass(
+        createAMDAIEBufferizeToAllocationPass(bufferizeOptions));
+  }
+
+  // AIE cores have no instructions for transcendental functions, replace
+  // them (e.g. the exponentials of a softmax) by polynomial approximations,
+  // which are vectorized together with the surrounding elementwise ops.
+  funcPassManager.addPass(createPolynomialApproximationPass());
+
+  // Vectorization passes
+  appendVectorizationToPipeline(funcPassManager);
+  funcPassManager.addPass(createCanonicalizerPass());
+
+  // Comprehensive bufferization
+  addAMDAIEBufferizePasses(funcPassManager);
+}
+
 void buildAMDAIETransformPassPipeline(OpPassManager &variantPassManager) {
   OpPassManager &modulePassManager = variantPassManager.nest<ModuleOp>();
   {
     FunctionLikeNest funcPassManager(modulePassManager);
     addCommonTargetExecutablePreprocessingPasses(funcPassManager);
+    funcPassManager.addPass(createAMDAIEDecomposeSoftmaxPass);
   }
   modulePassManager.addPass(createMaterializeUserConfigsPass());
   {
     AMDAIELoweringStrategyOptions options;
     options.usePassPipeline = clUsePipeline;
     options.numCores = clNumCores;
+    options.cascadeKSplit = clCascadeKSplit;
+    options.useObjectFifoLowering =
+        clUseLowerToAIEPipeline == LowerToAIEPassPipeline::ObjectFifo;
     modulePassManager.addPass(createAMDAIELoweringStrategyPass(options));
   }
   modulePassManager.addPass(createLowerExecutableUsingTransformDialectPass());
@@ -422,7 +504,9 @@ void buildAMDAIETransformPassPipeline(OpPassManager &variantPassManager) {
         [&]() { return createAMDAIELowerExecutableTargetPass(options); });
   }
   modulePassManager.addPass(createLowerUKernelOpsToCallsPass());
-  if (clUsePipeline == AIEPassPipeline::PadPackPipeline) {
+  if (clUseLowerToAIEPipeline == LowerToAIEPassPipeline::ObjectFifo) {
+    addAMDAIEObjectFifoLoweringPasses(modulePassManager);
+  } else if (clUsePipeline == AIEPassPipeline::PadPackPipeline) {
     addMLIRAIRAIELoweringPasses(modulePassManager, false);
   } else if (clUsePipeline == AIEPassPipeline::PackPeelPipeline) {
     addMLIRAIRAIELoweringPasses(modulePassManager, true);
@@ -437,6 +521,38 @@ void buildAMDAIETransformPassPipeline(OpPassManager &variantPassManager) {
   });
 }
 
+void addAMDAIEObjectFifoLoweringPasses(OpPassManager &passManager) {
+  passManager.addPass(createEraseHALDescriptorTypeFromMemRefPass());
+  passManager.addPass(memref::createFoldMemRefAliasOpsPass());
+  passManager.addPass(createAMDAIEPackToDmaPass());
+  passManager.addPass(xilinx::air::createCopyToDmaPass());
+  passManager.addPass(createAMDAIEAIRDmaAMDAIEDmaPass());
+  passManager.addPass(createAMDAIENormalizeLoopBoundsPass());
+  passManager.addPass(createAMDAIEInsertCoresPass());
+  passManager.addPass(createAMDAIELocalizeLogicalObjectFifoPass());
+  passManager.addPass(createCSEPass());
+  passManager.addPass(createAMDAIEDistributeCoresAndObjectFifosPass());
+  passManager.addPass(createCSEPass());
+  passManager.addPass(createCanonicalizerPass());
+  passManager.addPass(createAMDAIEChainCascadeAccumulatorsPass());
+  // The L3 DMAs are distributed once all logical objectFifos have been
+  // assigned tiles and before they are converted to circular DMAs.
+  passManager.addPass(createAMDAIEDistributeL3DmaPass());
+  passManager.addPass(createAMDAIEDmaToCircularDmaPass());
+  passManager.addNestedPass<func::FuncOp>(createAMDAIECreateAIEWorkgroupPass());
+  passManager.addPass(createCSEPass());
+  passManager.addPass(createAMDAIEHoistForLoopAffineApplyPass());
+  passManager.addPass(createAMDAIECanonicalizeDoublyStridedOpPass());
+  passManager.addPass(createAMDAIEAccessToAcquireReleasePass());
+  // The control code loops are unrolled first, so the waits can be sunk past
+  // the DMAs of the following iterations.
+  passManager.addPass(createAMDAIEControlCodeLoopUnrollPass());
+  passManager.addPass(createAMDAIEControlCodeScheduleDmaWaitsPass());
+  passManager.addPass(createAMDAIECreateLogicalObjectFifoLinkPass());
+  passManager.addPass(createAMDAIELowerToAIEPass());
+  passManager.addPass(createCanonicalizerPass());
+}
+
 // TODO (Erwei): The "packPeel" temporary argument should be removed once
 // pack-peel and pack-pad share the same pass pipeline. See TODOs inlined below
 // for details.
@@ -17,6 +17,10 @@ namespace mlir::iree_compiler::AMDAIE {
 /// currently the default passes used for lowering after IREEs tiling.
 void addMLIRAIRAIELoweringPasses(OpPassManager &passManager, bool packPeel);
 
+/// Add passes to lower to AIE through logical objectFifos and DMA operations
+/// in the AMDAIE dialect, instead of through MLIR-AIR.
+void addAMDAIEObjectFifoLoweringPasses(OpPassManager &passManager);
+
 /// Populates passes needed to lower linalg/arith/math ops to LLVM dialect via
 /// the structured ops path. The pass manager `pm` here operate on the module
 /// within the IREE::HAL::ExecutableOp.
@@ -32,6 +36,11 @@ void addPackPeelBasedPassPipeline(OpPassManager &passManager,
 void addPadPackBasedPassPipeline(OpPassManager &passManager,
                                  TilingConfig &tilingConfig);
 
+/// Populates passes needed to lower the IR of row reductions (softmax,
+/// layernorm, RMSNorm) by distributing the rows over the cores.
+void addReductionBasedPassPipeline(OpPassManager &passManager,
+                                   TilingConfig &tilingConfig);
+
 /// Populates passes needed to link HAL executables across AIE targets.
 void buildAMDAIELinkingPassPipeline(OpPassManager &passManager);
 
@@ -56,11 +65,19 @@ std::unique_ptr<Pass> createAMDAIEBufferizeToAllocationPass(
 std::unique_ptr<Pass> createAMDAIECanonicalizeDmaPass();
 
 /// Create pass to canonicalize doubly strided operations.
-std::unique_ptr<Pass> createAMDAIECanonicalizeDoublyStridedOpPass();
+std::unique_ptr<Pass> createAMDAIECanonicalizeDoublyStridedOpPass(
+    AMDAIECanonicalizeDoublyStridedOpOptions options = {});
+
+/// Create a pass to chain the accumulators of cores splitting a reduction
+/// over the cascade interface.
+std::unique_ptr<Pass> createAMDAIEChainCascadeAccumulatorsPass();
 
 /// Pass to unroll the loops within the control code regions.
 std::unique_ptr<Pass> createAMDAIEControlCodeLoopUnrollPass();
 
+/// Pass to sink and merge the DMA waits within the control code regions.
+std::unique_ptr<Pass> createAMDAIEControlCodeScheduleDmaWaitsPass();
+
 /// Pass to create a single AIE workgroup.
 std::unique_ptr<Pass> createAMDAIECreateAIEWorkgroupPass();
 
@@ -74,6 +91,10 @@ std::unique_ptr<Pass> createAMDAIEVectorizationPass();
 /// Create pass to invoke several cleanup and canonicalization patterns.
 std::unique_ptr<Pass> createAMDAIECleanupPass();
 
+/// Create a pass decomposing softmax ops into row reductions and elementwise
+/// ops.
+std::unique_ptr<Pass> createAMDAIEDecomposeSoftmaxPass();
+
 /// Create a pass decomposing iree_linalg_ext.pack and unpack ops to AIR
 /// dialect.
 std::unique_ptr<Pass> createAMDAIEDecomposeLinalgExtPackUnPackToAIRPass();
@@ -82,6 +103,11 @@ std::unique_ptr<Pass> createAMDAIEDecomposeLinalgExtPackUnPackToAIRPass();
 /// operations and distribute the logical objectFifos.
 std::unique_ptr<Pass> createAMDAIEDistributeCoresAndObjectFifosPass();
 
+/// Create a pass to distribute large L3 <-> L2 DMA transfers over multiple
+/// shim DMA channels.
+std::unique_ptr<Pass> createAMDAIEDistributeL3DmaPass(
+    AMDAIEDistributeL3DmaOptions options = {});
+
 /// Create a pass to convert dma operations to circular dma operations.
 std::unique_ptr<Pass> createAMDAIEDmaToCircularDmaPass();
 
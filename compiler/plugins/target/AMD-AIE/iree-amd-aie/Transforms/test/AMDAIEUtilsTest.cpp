@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 
 #include "iree-amd-aie/Transforms/AMDAIEUtils.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/MLIRContext.h"
 
 namespace {
 
@@ -12,6 +14,19 @@ TEST(IntegerMatmulInstructionSizeTest, FailsWithStrangeShape) {
             failValue);
 }
 
+TEST(AIEVectorLanesTest, Test0) {
+  mlir::MLIRContext context;
+  mlir::Builder b(&context);
+  EXPECT_EQ(getAIEVectorLanes(b.getI8Type()).value_or(0), 64u);
+  EXPECT_EQ(getAIEVectorLanes(b.getBF16Type()).value_or(0), 32u);
+  EXPECT_EQ(getAIEVectorLanes(b.getI16Type()).value_or(0), 32u);
+  EXPECT_EQ(getAIEVectorLanes(b.getF32Type()).value_or(0), 16u);
+  EXPECT_EQ(getAIEVectorLanes(b.getI32Type()).value_or(0), 16u);
+  EXPECT_TRUE(failed(getAIEVectorLanes(b.getF64Type())));
+  EXPECT_TRUE(failed(getAIEVectorLanes(b.getI64Type())));
+  EXPECT_TRUE(failed(getAIEVectorLanes(b.getIndexType())));
+}
+
 TEST(FindLargestFactorTest, Test0) {
   EXPECT_EQ(detail::findLargestFactor(/* num = */ 6, /* max = */ 1), 1);
   EXPECT_EQ(detail::findLargestFactor(/* num = */ 6, /* max = */ 2), 2);
@@ -4,6 +4,7 @@
 // RUN: iree-opt --pass-pipeline='builtin.module(func.func(iree-amdaie-bufferize-to-allocation{memory-space=1 bufferize-operand=def-op}))' --split-input-file %s | FileCheck %s --check-prefix=DEF-OP
 // RUN: iree-opt --pass-pipeline='builtin.module(func.func(iree-amdaie-bufferize-to-allocation{memory-space=2 bufferize-elementwise=true bufferize-operand=input}))' --split-input-file %s | FileCheck %s --check-prefix=ELEMENTWISE-INPUT
 // RUN: iree-opt --pass-pipeline='builtin.module(func.func(iree-amdaie-bufferize-to-allocation{memory-space=2 bufferize-elementwise=true bufferize-operand=input-output}))' --split-input-file %s | FileCheck %s --check-prefix=ELEMENTWISE-INPUT-OUTPUT
+// RUN: iree-opt --pass-pipeline='builtin.module(func.func(iree-amdaie-bufferize-to-allocation{memory-space=2 bufferize-operand=slice-input-output}))' --split-input-file %s | FileCheck %s --check-prefix=SLICE-INPUT-OUTPUT
 
 #map = affine_map<(d0, d1, d2, d3, d4, d5, d6, d7, d8) -> (d0, d2, d3, d5, d6, d8)>
 #map1 = affine_map<(d0, d1, d2, d3, d4, d5, d6, d7, d8) -> (d2, d1, d5, d4, d7, d8)>
@@ -171,3 +172,44 @@ func.func @matmul_elementwise(%arg0: tensor<1024x512xi8>, %arg1: tensor<512x1024
 //         ELEMENTWISE-INPUT-OUTPUT:  bufferization.to_tensor
 //         ELEMENTWISE-INPUT-OUTPUT:  tensor.pack
 //         ELEMENTWISE-INPUT-OUTPUT:  linalg.generic
+
+// -----
+
+// A chain of a row reduction and an elementwise op over the same rows, as in a
+// normalization. The sliced input is promoted once and the intermediate row
+// sums stay in the tile.
+#map = affine_map<(d0, d1) -> (d0, d1)>
+#map1 = affine_map<(d0, d1) -> (d0)>
+func.func @row_reduction_chain(%arg0: tensor<64x256xf32>) -> tensor<64x256xf32> {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = tensor.empty() : tensor<64x256xf32>
+  %1 = scf.forall (%arg1) = (0) to (64) step (4) shared_outs(%arg2 = %0) -> (tensor<64x256xf32>) {
+    %extracted_slice = tensor.extract_slice %arg0[%arg1, 0] [4, 256] [1, 1] : tensor<64x256xf32> to tensor<4x256xf32>
+    %extracted_slice_0 = tensor.extract_slice %arg2[%arg1, 0] [4, 256] [1, 1] : tensor<64x256xf32> to tensor<4x256xf32>
+    %2 = tensor.empty() : tensor<4xf32>
+    %3 = linalg.fill ins(%cst : f32) outs(%2 : tensor<4xf32>) -> tensor<4xf32>
+    %4 = linalg.generic {indexing_maps = [#map, #map1], iterator_types = ["parallel", "reduction"]} ins(%extracted_slice : tensor<4x256xf32>) outs(%3 : tensor<4xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %6 = arith.mulf %in, %in : f32
+      %7 = arith.addf %out, %6 : f32
+      linalg.yield %7 : f32
+    } -> tensor<4xf32>
+    %5 = linalg.generic {indexing_maps = [#map, #map1, #map], iterator_types = ["parallel", "parallel"]} ins(%extracted_slice, %4 : tensor<4x256xf32>, tensor<4xf32>) outs(%extracted_slice_0 : tensor<4x256xf32>) {
+    ^bb0(%in: f32, %in_1: f32, %out: f32):
+      %6 = arith.divf %in, %in_1 : f32
+      linalg.yield %6 : f32
+    } -> tensor<4x256xf32>
+    scf.forall.in_parallel {
+      tensor.parallel_insert_slice %5 into %arg2[%arg1, 0] [4, 256] [1, 1] : tensor<4x256xf32> into tensor<64x256xf32>
+    }
+  }
+  return %1 : tensor<64x256xf32>
+}
+
+//       SLICE-INPUT-OUTPUT-LABEL: @row_reduction_chain
+//             SLICE-INPUT-OUTPUT:   scf.forall
+// SLICE-INPUT-OUTPUT-COUNT-2:       memref.alloc() : memref<4x256xf32, 2 : i32>
+//         SLICE-INPUT-OUTPUT-NOT:   memref.alloc
+//             SLICE-INPUT-OUTPUT:   linalg.fill
+//             SLICE-INPUT-OUTPUT:   linalg.generic
+//             SLICE-INPUT-OUTPUT:   linalg.generic
@@ -206,6 +206,24 @@ func.func @dma_cpy_nd_partial_non_zero_offset(%arg0: !amdaie.logicalobjectfifo<m
 
 // -----
 
+// Verify that a single dimension only covering part of the memref isn't made
+// implicit.
+//
+// CHECK-LABEL: func.func @dma_cpy_nd_partial_single_dim
+// CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG:   %[[C1:.+]] = arith.constant 1 : index
+// CHECK-DAG:   %[[C64:.+]] = arith.constant 64 : index
+// CHECK:       amdaie.dma_cpy_nd
+// CHECK-SAME:  [%[[C0]]] [%[[C64]]] [%[[C1]]]
+// CHECK-SAME:  [%[[C0]]] [%[[C64]]] [%[[C1]]]
+func.func @dma_cpy_nd_partial_single_dim(%arg0: !amdaie.logicalobjectfifo<memref<1x1x8x16xi32, 1>>, %arg1: !amdaie.logicalobjectfifo<memref<8x16xi32, 1>>) {
+  %0 = amdaie.dma_cpy_nd(%arg0[0, 0, 0, 0] [1, 1, 4, 16] [128, 128, 16, 1], %arg1[0, 0] [4, 16] [16, 1]) : (!amdaie.logicalobjectfifo<memref<1x1x8x16xi32, 1>>, !amdaie.logicalobjectfifo<memref<8x16xi32, 1>>)
+  amdaie.logicalobjectfifo.consume(%0)
+  return
+}
+
+// -----
+
 // Verify that the input DMA of `amdaie.npu.dma_cpy_nd` is still correct after canonicalization.
 //
 // CHECK-LABEL: func.func @npu_dma_cpy_nd_source
@@ -306,3 +324,112 @@ func.func @npu_dma_cpy_nd_partial_non_zero_offset(%arg0: !amdaie.logicalobjectfi
   %1 = amdaie.npu.dma_cpy_nd %0([0, 0, 0, 1] [1, 1, 8, 16] [128, 128, 16, 1], [0, 0, 0, 1] [1, 4, 2, 8] [64, 16, 8, 1])
   return
 }
+
+// -----
+
+// Verify that dimensions exceeding the memory tile's maximum size of 1023 are
+// split.
+//
+// CHECK-LABEL: func.func @dma_cpy_nd_split_large_dims
+// CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG:   %[[C1:.+]] = arith.constant 1 : index
+// CHECK-DAG:   %[[C4:.+]] = arith.constant 4 : index
+// CHECK-DAG:   %[[C512:.+]] = arith.constant 512 : index
+// CHECK-DAG:   %[[C4096:.+]] = arith.constant 4096 : index
+// CHECK:       amdaie.dma_cpy_nd
+// CHECK-SAME:  [] [] []
+// CHECK-SAME:  [%[[C0]], %[[C0]], %[[C0]]] [%[[C4]], %[[C4]], %[[C512]]] [%[[C4096]], %[[C512]], %[[C1]]]
+func.func @dma_cpy_nd_split_large_dims(%arg0: !amdaie.logicalobjectfifo<memref<4x4096xi32, 1>>, %arg1: !amdaie.logicalobjectfifo<memref<8192xi32, 1>>) {
+  %0 = amdaie.dma_cpy_nd(%arg0[] [] [], %arg1[0, 0] [4, 2048] [4096, 1]) : (!amdaie.logicalobjectfifo<memref<4x4096xi32, 1>>, !amdaie.logicalobjectfifo<memref<8192xi32, 1>>)
+  amdaie.logicalobjectfifo.consume(%0)
+  return
+}
+
+// -----
+
+// Verify that dimensions of core tile access patterns are split with the core
+// tile's maximum size of 255.
+//
+// CHECK-LABEL: func.func @dma_cpy_nd_split_large_dims_local
+// CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG:   %[[C1:.+]] = arith.constant 1 : index
+// CHECK-DAG:   %[[C2:.+]] = arith.constant 2 : index
+// CHECK-DAG:   %[[C4:.+]] = arith.constant 4 : index
+// CHECK-DAG:   %[[C128:.+]] = arith.constant 128 : index
+// CHECK-DAG:   %[[C512:.+]] = arith.constant 512 : index
+// CHECK-DAG:   %[[C1024:.+]] = arith.constant 1024 : index
+// CHECK:       amdaie.dma_cpy_nd
+// CHECK-SAME:  [%[[C0]], %[[C0]], %[[C0]]] [%[[C2]], %[[C4]], %[[C128]]] [%[[C1024]], %[[C128]], %[[C1]]]
+// CHECK-SAME:  [%[[C0]], %[[C0]]] [%[[C2]], %[[C512]]] [%[[C1024]], %[[C1]]]
+func.func @dma_cpy_nd_split_large_dims_local(%arg0: !amdaie.logicalobjectfifo<memref<2x1024xi32, 2>>, %arg1: !amdaie.logicalobjectfifo<memref<2048xi32, 1>>) {
+  %0 = amdaie.dma_cpy_nd(%arg0[0, 0] [2, 512] [1024, 1], %arg1[0, 0] [2, 512] [1024, 1]) : (!amdaie.logicalobjectfifo<memref<2x1024xi32, 2>>, !amdaie.logicalobjectfifo<memref<2048xi32, 1>>)
+  amdaie.logicalobjectfifo.consume(%0)
+  return
+}
+
+// -----
+
+// Verify that the size of a contiguous innermost dimension is checked in 32-bit
+// words: 512 bf16 elements are 256 words, which exceeds the core tile's maximum
+// size of 255 and is split into word aligned parts, while 400 bf16 elements
+// are 200 words and fit.
+//
+// CHECK-LABEL: func.func @dma_cpy_nd_split_large_dims_bf16
+// CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG:   %[[C1:.+]] = arith.constant 1 : index
+// CHECK-DAG:   %[[C2:.+]] = arith.constant 2 : index
+// CHECK-DAG:   %[[C256:.+]] = arith.constant 256 : index
+// CHECK-DAG:   %[[C400:.+]] = arith.constant 400 : index
+// CHECK-DAG:   %[[C512:.+]] = arith.constant 512 : index
+// CHECK-DAG:   %[[C1024:.+]] = arith.constant 1024 : index
+// CHECK:       amdaie.dma_cpy_nd
+// CHECK-SAME:  [%[[C0]], %[[C0]], %[[C0]]] [%[[C2]], %[[C2]], %[[C256]]] [%[[C1024]], %[[C256]], %[[C1]]]
+// CHECK-SAME:  [%[[C0]], %[[C0]]] [%[[C2]], %[[C512]]] [%[[C1024]], %[[C1]]]
+// CHECK:       amdaie.dma_cpy_nd
+// CHECK-SAME:  [%[[C0]], %[[C0]]] [%[[C2]], %[[C400]]] [%[[C1024]], %[[C1]]]
+// CHECK-SAME:  [%[[C0]], %[[C0]]] [%[[C2]], %[[C400]]] [%[[C1024]], %[[C1]]]
+func.func @dma_cpy_nd_split_large_dims_bf16(%arg0: !amdaie.logicalobjectfifo<memref<2x1024xbf16, 2>>, %arg1: !amdaie.logicalobjectfifo<memref<2048xbf16, 1>>) {
+  %0 = amdaie.dma_cpy_nd(%arg0[0, 0] [2, 512] [1024, 1], %arg1[0, 0] [2, 512] [1024, 1]) : (!amdaie.logicalobjectfifo<memref<2x1024xbf16, 2>>, !amdaie.logicalobjectfifo<memref<2048xbf16, 1>>)
+  amdaie.logicalobjectfifo.consume(%0)
+  %1 = amdaie.dma_cpy_nd(%arg0[0, 0] [2, 400] [1024, 1], %arg1[0, 0] [2, 400] [1024, 1]) : (!amdaie.logicalobjectfifo<memref<2x1024xbf16, 2>>, !amdaie.logicalobjectfifo<memref<2048xbf16, 1>>)
+  amdaie.logicalobjectfifo.consume(%1)
+  return
+}
+
+// -----
+
+// Verify that access patterns already using all dimensions of a memory tile BD
+// are not split, as the resulting access pattern couldn't be lowered.
+//
+// CHECK-LABEL: func.func @dma_cpy_nd_split_large_dims_rank_limit
+// CHECK:       amdaie.dma_cpy_nd
+// CHECK-SAME:  [] [] []
+// CHECK-SAME:  [0, 0, 0, 0] [2, 2, 4, 2048] [131072, 32768, 4096, 1]
+func.func @dma_cpy_nd_split_large_dims_rank_limit(%arg0: !amdaie.logicalobjectfifo<memref<2x2x4x2048xi32, 1>>, %arg1: !amdaie.logicalobjectfifo<memref<4x4x8x4096xi32, 1>>) {
+  %0 = amdaie.dma_cpy_nd(%arg0[] [] [], %arg1[0, 0, 0, 0] [2, 2, 4, 2048] [131072, 32768, 4096, 1]) : (!amdaie.logicalobjectfifo<memref<2x2x4x2048xi32, 1>>, !amdaie.logicalobjectfifo<memref<4x4x8x4096xi32, 1>>)
+  amdaie.logicalobjectfifo.consume(%0)
+  return
+}
+
+// -----
+
+// Verify that only the innermost large dimension is split if splitting all of
+// them would exceed the number of dimensions of a memory tile BD.
+//
+// CHECK-LABEL: func.func @dma_cpy_nd_split_large_dims_innermost
+// CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG:   %[[C1:.+]] = arith.constant 1 : index
+// CHECK-DAG:   %[[C2:.+]] = arith.constant 2 : index
+// CHECK-DAG:   %[[C4:.+]] = arith.constant 4 : index
+// CHECK-DAG:   %[[C512:.+]] = arith.constant 512 : index
+// CHECK-DAG:   %[[C2048:.+]] = arith.constant 2048 : index
+// CHECK-DAG:   %[[C4096:.+]] = arith.constant 4096 : index
+// CHECK-DAG:   %[[C16777216:.+]] = arith.constant 16777216 : index
+// CHECK:       amdaie.dma_cpy_nd
+// CHECK-SAME:  [] [] []
+// CHECK-SAME:  [%[[C0]], %[[C0]], %[[C0]], %[[C0]]] [%[[C2]], %[[C2048]], %[[C4]], %[[C512]]] [%[[C16777216]], %[[C4096]], %[[C512]], %[[C1]]]
+func.func @dma_cpy_nd_split_large_dims_innermost(%arg0: !amdaie.logicalobjectfifo<memref<2x2048x2048xi32, 1>>, %arg1: !amdaie.logicalobjectfifo<memref<4x2048x4096xi32, 1>>) {
+  %0 = amdaie.dma_cpy_nd(%arg0[] [] [], %arg1[0, 0, 0] [2, 2048, 2048] [16777216, 4096, 1]) : (!amdaie.logicalobjectfifo<memref<2x2048x2048xi32, 1>>, !amdaie.logicalobjectfifo<memref<4x2048x4096xi32, 1>>)
+  amdaie.logicalobjectfifo.consume(%0)
+  return
+}
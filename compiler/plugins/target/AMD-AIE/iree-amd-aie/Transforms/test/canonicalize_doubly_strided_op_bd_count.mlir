@@ -0,0 +1,68 @@
+// RUN: iree-opt --split-input-file --pass-pipeline="builtin.module(func.func(iree-amdaie-canonicalize-doubly-strided-op{report-bd-count}))" --verify-diagnostics %s
+
+// A contiguous access pattern needs a single BD on both sides.
+func.func @contiguous(%arg0: !amdaie.logicalobjectfifo<memref<8x16xi32, 2>>, %arg1: !amdaie.logicalobjectfifo<memref<8x16xi32, 1>>) {
+  // expected-remark @+1 {{source BDs: 1, target BDs: 1}}
+  %0 = amdaie.dma_cpy_nd(%arg0[] [] [], %arg1[0, 0] [8, 16] [16, 1]) : (!amdaie.logicalobjectfifo<memref<8x16xi32, 2>>, !amdaie.logicalobjectfifo<memref<8x16xi32, 1>>)
+  return
+}
+
+// -----
+
+// A 4D access pattern fits within a single memory tile BD, but needs to be
+// unrolled across 2 BDs on a core tile, which only supports 3 dimensions.
+func.func @core_4d(%arg0: !amdaie.logicalobjectfifo<memref<2x2x8x8xi32, 2>>, %arg1: !amdaie.logicalobjectfifo<memref<2x2x8x16xi32, 1>>) {
+  // expected-remark @+1 {{source BDs: 1, target BDs: 2}}
+  %0 = amdaie.dma_cpy_nd(%arg0[0, 0, 0, 0] [2, 2, 8, 8] [256, 64, 16, 1], %arg1[0, 0, 0, 0] [2, 2, 8, 16] [512, 16, 32, 1]) : (!amdaie.logicalobjectfifo<memref<2x2x8x8xi32, 2>>, !amdaie.logicalobjectfifo<memref<2x2x8x16xi32, 1>>)
+  return
+}
+
+// -----
+
+// A shim tile BD supports 3 addressing dimensions and 1 iteration dimension, so
+// a 5D access pattern needs to be unrolled along the outermost dimension.
+func.func @shim_5d(%arg0: !amdaie.logicalobjectfifo<memref<8192xi32, 1>>, %arg1: !amdaie.logicalobjectfifo<memref<65536xi32>>) {
+  // expected-remark @+1 {{source BDs: 2, target BDs: 1}}
+  %0 = amdaie.dma_cpy_nd(%arg0[] [] [], %arg1[0, 0, 0, 0, 0] [2, 3, 4, 8, 16] [20000, 5000, 1000, 100, 1]) : (!amdaie.logicalobjectfifo<memref<8192xi32, 1>>, !amdaie.logicalobjectfifo<memref<65536xi32>>)
+  return
+}
+
+// -----
+
+// A shim tile iteration dimension supports at most 64 repetitions.
+func.func @shim_iteration_limit(%arg0: !amdaie.logicalobjectfifo<memref<8192xi32, 1>>, %arg1: !amdaie.logicalobjectfifo<memref<65536xi32>>) {
+  // expected-remark @+1 {{source BDs: 100, target BDs: 1}}
+  %0 = amdaie.dma_cpy_nd(%arg0[] [] [], %arg1[0, 0, 0, 0] [100, 4, 8, 16] [1000, 200, 20, 1]) : (!amdaie.logicalobjectfifo<memref<8192xi32, 1>>, !amdaie.logicalobjectfifo<memref<65536xi32>>)
+  return
+}
+
+// -----
+
+// The BD limits are expressed in 32-bit words. A contiguous row of 400 bf16
+// elements spans 200 words and fits within the core tile's maximum size of 255,
+// while a row of 400 i32 elements needs to be unrolled.
+func.func @core_bf16_words(%arg0: !amdaie.logicalobjectfifo<memref<2x400xbf16, 2>>, %arg1: !amdaie.logicalobjectfifo<memref<2x400xi32, 2>>) {
+  // expected-remark @+1 {{source BDs: 1, target BDs: 1}}
+  %0 = amdaie.dma_cpy_nd(%arg0[0, 0] [2, 400] [400, 1], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<2x400xbf16, 2>>, !amdaie.logicalobjectfifo<memref<2x400xbf16, 2>>)
+  // expected-remark @+1 {{source BDs: 1, target BDs: 800}}
+  %1 = amdaie.dma_cpy_nd(%arg1[0, 0] [2, 400] [400, 1], %arg1[] [] []) : (!amdaie.logicalobjectfifo<memref<2x400xi32, 2>>, !amdaie.logicalobjectfifo<memref<2x400xi32, 2>>)
+  return
+}
+
+// -----
+
+func.func @npu_dma_cpy_nd(%arg0: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %arg1: !amdaie.logicalobjectfifo<memref<32x1024xi32>>) {
+  %0 = amdaie.circular_dma_cpy_nd(%arg0[] [] [], %arg1[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+  // expected-remark @-1 {{source BDs: 1, target BDs: 1}}
+  // expected-remark @+1 {{source BDs: 1, target BDs: 1}}
+  %1 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, 0] [32, 64] [1024, 1])
+  return
+}
+
+// -----
+
+func.func @dynamic_size(%arg0: !amdaie.logicalobjectfifo<memref<8x16xi32, 1>>, %arg1: !amdaie.logicalobjectfifo<memref<8x16xi32, 1>>, %arg2: index) {
+  // expected-remark @+1 {{source BDs: unknown, target BDs: 1}}
+  %0 = amdaie.dma_cpy_nd(%arg0[] [] [], %arg1[0, 0] [%arg2, 8] [16, 1]) : (!amdaie.logicalobjectfifo<memref<8x16xi32, 1>>, !amdaie.logicalobjectfifo<memref<8x16xi32, 1>>)
+  return
+}
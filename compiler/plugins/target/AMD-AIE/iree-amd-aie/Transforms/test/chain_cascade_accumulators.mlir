@@ -0,0 +1,165 @@
+// RUN: iree-opt --pass-pipeline="builtin.module(iree-amdaie-chain-cascade-accumulators)" --split-input-file --verify-diagnostics %s | FileCheck %s
+
+// Three cores in a row splitting K all write back to the same region of L2.
+// CHECK-LABEL: @chain_k_split
+// CHECK-DAG:   %[[FROM_MEMREF_L2:.+]] = amdaie.logicalobjectfifo.from_memref %{{.+}}, {%{{.+}}} : memref<1x1x32x32xf32, 1>
+// CHECK:       amdaie.core
+// CHECK:         linalg.fill
+// CHECK:         %[[FLAT_0:.+]] = memref.collapse_shape %{{.+}} {{\[}}[0, 1, 2, 3]] : memref<1x1x32x32xf32, 2> into memref<1024xf32, 2>
+// CHECK-DAG:     %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG:     %[[C1024:.+]] = arith.constant 1024 : index
+// CHECK-DAG:     %[[C16:.+]] = arith.constant 16 : index
+// CHECK:         scf.for %[[IV_0:.+]] = %[[C0]] to %[[C1024]] step %[[C16]]
+// CHECK:           %[[PARTIAL_0:.+]] = vector.load %[[FLAT_0]][%[[IV_0]]] : memref<1024xf32, 2>, vector<16xf32>
+// CHECK-NOT:       aie.get_cascade
+// CHECK:           %[[OUT_0:.+]] = vector.bitcast %[[PARTIAL_0]] : vector<16xf32> to vector<16xi32>
+// CHECK:           aie.put_cascade(%[[OUT_0]] : vector<16xi32>)
+// CHECK-NOT:     amdaie.logicalobjectfifo.produce
+// CHECK:         amdaie.end
+// CHECK:       amdaie.core
+// CHECK:         %[[FLAT_1:.+]] = memref.collapse_shape
+// CHECK:         scf.for %[[IV_1:.+]] = %{{.+}} to %{{.+}} step %{{.+}}
+// CHECK:           %[[PARTIAL_1:.+]] = vector.load %[[FLAT_1]][%[[IV_1]]]
+// CHECK:           %[[IN_1:.+]] = aie.get_cascade() : vector<16xi32>
+// CHECK:           %[[IN_CAST_1:.+]] = vector.bitcast %[[IN_1]] : vector<16xi32> to vector<16xf32>
+// CHECK:           %[[SUM_1:.+]] = arith.addf %[[PARTIAL_1]], %[[IN_CAST_1]] : vector<16xf32>
+// CHECK:           %[[OUT_1:.+]] = vector.bitcast %[[SUM_1]] : vector<16xf32> to vector<16xi32>
+// CHECK:           aie.put_cascade(%[[OUT_1]] : vector<16xi32>)
+// CHECK-NOT:     amdaie.logicalobjectfifo.produce
+// CHECK:         amdaie.end
+// CHECK:       %[[DMA_2:.+]] = amdaie.dma_cpy_nd(%[[FROM_MEMREF_L2]]
+// CHECK:       amdaie.core
+// CHECK:         %[[FLAT_2:.+]] = memref.collapse_shape
+// CHECK:         scf.for %[[IV_2:.+]] = %{{.+}} to %{{.+}} step %{{.+}}
+// CHECK:           %[[PARTIAL_2:.+]] = vector.load %[[FLAT_2]][%[[IV_2]]]
+// CHECK:           %[[IN_2:.+]] = aie.get_cascade() : vector<16xi32>
+// CHECK:           %[[IN_CAST_2:.+]] = vector.bitcast %[[IN_2]] : vector<16xi32> to vector<16xf32>
+// CHECK:           %[[SUM_2:.+]] = arith.addf %[[PARTIAL_2]], %[[IN_CAST_2]] : vector<16xf32>
+// CHECK-NOT:       aie.put_cascade
+// CHECK:           vector.store %[[SUM_2]], %[[FLAT_2]][%[[IV_2]]] : memref<1024xf32, 2>, vector<16xf32>
+// CHECK:         amdaie.logicalobjectfifo.produce(%[[DMA_2]])
+// CHECK:         amdaie.end
+module {
+  func.func @chain_k_split() {
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %c2 = arith.constant 2 : index
+    %cst = arith.constant 0.000000e+00 : f32
+    %alloc = memref.alloc() : memref<1x1x32x32xf32, 2>
+    %alloc_0 = memref.alloc() : memref<1x1x32x32xf32, 1>
+    %tile_0_1 = amdaie.tile(%c0, %c1)
+    %tile_0_2 = amdaie.tile(%c0, %c2)
+    %tile_1_2 = amdaie.tile(%c1, %c2)
+    %tile_2_2 = amdaie.tile(%c2, %c2)
+    %0 = amdaie.logicalobjectfifo.from_memref %alloc_0, {%tile_0_1} : memref<1x1x32x32xf32, 1> -> !amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 1>>
+    %1 = amdaie.logicalobjectfifo.from_memref %alloc, {%tile_0_2} : memref<1x1x32x32xf32, 2> -> !amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 2>>
+    %2 = amdaie.logicalobjectfifo.from_memref %alloc, {%tile_1_2} : memref<1x1x32x32xf32, 2> -> !amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 2>>
+    %3 = amdaie.logicalobjectfifo.from_memref %alloc, {%tile_2_2} : memref<1x1x32x32xf32, 2> -> !amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 2>>
+    %4 = amdaie.dma_cpy_nd(%0[] [] [], %1[] [] []) : (!amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 1>>, !amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 2>>)
+    %core_0_2 = amdaie.core(%tile_0_2) {
+      %7 = amdaie.logicalobjectfifo.access(%1, Write) : !amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 2>> -> memref<1x1x32x32xf32, 2>
+      linalg.fill ins(%cst : f32) outs(%7 : memref<1x1x32x32xf32, 2>)
+      amdaie.logicalobjectfifo.produce(%4)
+      amdaie.end
+    }
+    %5 = amdaie.dma_cpy_nd(%0[] [] [], %2[] [] []) : (!amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 1>>, !amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 2>>)
+    %core_1_2 = amdaie.core(%tile_1_2) {
+      %7 = amdaie.logicalobjectfifo.access(%2, Write) : !amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 2>> -> memref<1x1x32x32xf32, 2>
+      linalg.fill ins(%cst : f32) outs(%7 : memref<1x1x32x32xf32, 2>)
+      amdaie.logicalobjectfifo.produce(%5)
+      amdaie.end
+    }
+    %6 = amdaie.dma_cpy_nd(%0[] [] [], %3[] [] []) : (!amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 1>>, !amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 2>>)
+    %core_2_2 = amdaie.core(%tile_2_2) {
+      %7 = amdaie.logicalobjectfifo.access(%3, Write) : !amdaie.logicalobjectfifo<memref<1x1x32x32xf32, 2>> -> memref<1x1x32x32xf32, 2>
+      linalg.fill ins(%cst : f32) outs(%7 : memref<1x1x32x32xf32, 2>)
+      amdaie.logicalobjectfifo.produce(%6)
+      amdaie.end
+    }
+    memref.dealloc %alloc_0 : memref<1x1x32x32xf32, 1>
+    memref.dealloc %alloc : memref<1x1x32x32xf32, 2>
+    return
+  }
+}
+
+// -----
+
+// Cores writing back to different regions are left untouched.
+// CHECK-LABEL: @no_shared_target
+// CHECK-NOT:   aie.put_cascade
+// CHECK-NOT:   aie.get_cascade
+// CHECK:       amdaie.logicalobjectfifo.produce
+// CHECK:       amdaie.logicalobjectfifo.produce
+module {
+  func.func @no_shared_target() {
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %c2 = arith.constant 2 : index
+    %c32 = arith.constant 32 : index
+    %c64 = arith.constant 64 : index
+    %cst = arith.constant 0 : i32
+    %alloc = memref.alloc() : memref<32x32xi32, 2>
+    %alloc_0 = memref.alloc() : memref<32x64xi32, 1>
+    %tile_0_1 = amdaie.tile(%c0, %c1)
+    %tile_0_2 = amdaie.tile(%c0, %c2)
+    %tile_1_2 = amdaie.tile(%c1, %c2)
+    %0 = amdaie.logicalobjectfifo.from_memref %alloc_0, {%tile_0_1} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+    %1 = amdaie.logicalobjectfifo.from_memref %alloc, {%tile_0_2} : memref<32x32xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x32xi32, 2>>
+    %2 = amdaie.logicalobjectfifo.from_memref %alloc, {%tile_1_2} : memref<32x32xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x32xi32, 2>>
+    %3 = amdaie.dma_cpy_nd(%0[%c0, %c0] [%c32, %c32] [%c64, %c1], %1[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x32xi32, 2>>)
+    %core_0_2 = amdaie.core(%tile_0_2) {
+      %5 = amdaie.logicalobjectfifo.access(%1, Write) : !amdaie.logicalobjectfifo<memref<32x32xi32, 2>> -> memref<32x32xi32, 2>
+      linalg.fill ins(%cst : i32) outs(%5 : memref<32x32xi32, 2>)
+      amdaie.logicalobjectfifo.produce(%3)
+      amdaie.end
+    }
+    %4 = amdaie.dma_cpy_nd(%0[%c0, %c32] [%c32, %c32] [%c64, %c1], %2[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x32xi32, 2>>)
+    %core_1_2 = amdaie.core(%tile_1_2) {
+      %5 = amdaie.logicalobjectfifo.access(%2, Write) : !amdaie.logicalobjectfifo<memref<32x32xi32, 2>> -> memref<32x32xi32, 2>
+      linalg.fill ins(%cst : i32) outs(%5 : memref<32x32xi32, 2>)
+      amdaie.logicalobjectfifo.produce(%4)
+      amdaie.end
+    }
+    memref.dealloc %alloc_0 : memref<32x64xi32, 1>
+    memref.dealloc %alloc : memref<32x32xi32, 2>
+    return
+  }
+}
+
+// -----
+
+module {
+  func.func @not_neighbours() {
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %c2 = arith.constant 2 : index
+    %c3 = arith.constant 3 : index
+    %cst = arith.constant 0 : i32
+    %alloc = memref.alloc() : memref<32x32xi32, 2>
+    %alloc_0 = memref.alloc() : memref<32x32xi32, 1>
+    %tile_0_1 = amdaie.tile(%c0, %c1)
+    %tile_0_2 = amdaie.tile(%c0, %c2)
+    %tile_1_3 = amdaie.tile(%c1, %c3)
+    %0 = amdaie.logicalobjectfifo.from_memref %alloc_0, {%tile_0_1} : memref<32x32xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x32xi32, 1>>
+    %1 = amdaie.logicalobjectfifo.from_memref %alloc, {%tile_0_2} : memref<32x32xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x32xi32, 2>>
+    %2 = amdaie.logicalobjectfifo.from_memref %alloc, {%tile_1_3} : memref<32x32xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x32xi32, 2>>
+    %3 = amdaie.dma_cpy_nd(%0[] [] [], %1[] [] []) : (!amdaie.logicalobjectfifo<memref<32x32xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x32xi32, 2>>)
+    %core_0_2 = amdaie.core(%tile_0_2) {
+      %5 = amdaie.logicalobjectfifo.access(%1, Write) : !amdaie.logicalobjectfifo<memref<32x32xi32, 2>> -> memref<32x32xi32, 2>
+      linalg.fill ins(%cst : i32) outs(%5 : memref<32x32xi32, 2>)
+      amdaie.logicalobjectfifo.produce(%3)
+      amdaie.end
+    }
+    %4 = amdaie.dma_cpy_nd(%0[] [] [], %2[] [] []) : (!amdaie.logicalobjectfifo<memref<32x32xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x32xi32, 2>>)
+    // expected-error @+1 {{isn't its neighbour in the same row}}
+    %core_1_3 = amdaie.core(%tile_1_3) {
+      %5 = amdaie.logicalobjectfifo.access(%2, Write) : !amdaie.logicalobjectfifo<memref<32x32xi32, 2>> -> memref<32x32xi32, 2>
+      linalg.fill ins(%cst : i32) outs(%5 : memref<32x32xi32, 2>)
+      amdaie.logicalobjectfifo.produce(%4)
+      amdaie.end
+    }
+    memref.dealloc %alloc_0 : memref<32x32xi32, 1>
+    memref.dealloc %alloc : memref<32x32xi32, 2>
+    return
+  }
+}
@@ -151,3 +151,234 @@ func.func @no_forall_unroll_outside_controlcode() {
   }
   return
 }
+
+// -----
+
+// Verify that a loop issuing a single Npu DMA with an affine offset is rolled
+// into a single Npu DMA with an outer repeat dimension.
+//
+// CHECK-LABEL: @roll_npu_dma_affine_offset
+// CHECK:       %[[DMA0:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       amdaie.controlcode
+// CHECK-NOT:     scf.for
+// CHECK:         %[[NPU_DMA:.+]] = amdaie.npu.dma_cpy_nd %[[DMA0]]([] [] [], [0, 0, 0, 64] [4, 1, 32, 64] [128, 1, 1024, 1])
+// CHECK-NEXT:    amdaie.npu.dma_wait(%[[NPU_DMA]], MM2S)
+// CHECK-NOT:     amdaie.npu.dma_cpy_nd
+// CHECK:         amdaie.end
+func.func @roll_npu_dma_affine_offset(%arg0: !amdaie.logicalobjectfifo<memref<32x1024xi32>>, %arg1: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>) {
+  %c1 = arith.constant 1 : index
+  %c5 = arith.constant 5 : index
+  amdaie.workgroup {
+    %0 = amdaie.circular_dma_cpy_nd(%arg1[] [] [], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+    amdaie.controlcode {
+      scf.for %arg2 = %c1 to %c5 step %c1 {
+        %1 = affine.apply affine_map<(d0) -> (d0 * 128 - 64)>(%arg2)
+        %2 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, %1] [32, 64] [1024, 1])
+        amdaie.npu.dma_wait(%2, MM2S)
+      }
+      amdaie.end
+    }
+  }
+  return
+}
+
+// -----
+
+// Verify that a loop with a non-affine offset is still unrolled.
+//
+// CHECK-LABEL: @unroll_npu_dma_non_affine_offset
+// CHECK:       amdaie.controlcode
+// CHECK-NOT:     scf.for
+// CHECK-COUNT-4: amdaie.npu.dma_cpy_nd
+// CHECK:         amdaie.end
+func.func @unroll_npu_dma_non_affine_offset(%arg0: !amdaie.logicalobjectfifo<memref<32x1024xi32>>, %arg1: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  amdaie.workgroup {
+    %0 = amdaie.circular_dma_cpy_nd(%arg1[] [] [], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+    amdaie.controlcode {
+      scf.for %arg2 = %c0 to %c4 step %c1 {
+        %1 = affine.apply affine_map<(d0) -> ((d0 mod 2) * 64)>(%arg2)
+        %2 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, %1] [32, 64] [1024, 1])
+        amdaie.npu.dma_wait(%2, MM2S)
+      }
+      amdaie.end
+    }
+  }
+  return
+}
+
+// -----
+
+// Verify that only the inner loop is rolled as the shim tile BD only has a
+// single iteration dimension.
+//
+// CHECK-LABEL: @roll_inner_unroll_outer
+// CHECK:       %[[DMA0:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       amdaie.controlcode
+// CHECK-NOT:     scf.for
+// CHECK:         amdaie.npu.dma_cpy_nd %[[DMA0]]([] [] [], [0, 0, 0, 0] [8, 1, 32, 64] [64, 1, 1024, 1])
+// CHECK:         amdaie.npu.dma_cpy_nd %[[DMA0]]([] [] [], [0, 0, 32, 0] [8, 1, 32, 64] [64, 1, 1024, 1])
+// CHECK-NOT:     amdaie.npu.dma_cpy_nd
+// CHECK:         amdaie.end
+func.func @roll_inner_unroll_outer(%arg0: !amdaie.logicalobjectfifo<memref<64x1024xi32>>, %arg1: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c2 = arith.constant 2 : index
+  %c8 = arith.constant 8 : index
+  amdaie.workgroup {
+    %0 = amdaie.circular_dma_cpy_nd(%arg1[] [] [], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<64x1024xi32>>)
+    amdaie.controlcode {
+      scf.for %arg2 = %c0 to %c2 step %c1 {
+        scf.for %arg3 = %c0 to %c8 step %c1 {
+          %1 = affine.apply affine_map<(d0) -> (d0 * 32)>(%arg2)
+          %2 = affine.apply affine_map<(d0) -> (d0 * 64)>(%arg3)
+          %3 = amdaie.npu.dma_cpy_nd %0([] [] [], [%1, %2] [32, 64] [1024, 1])
+        }
+      }
+      amdaie.end
+    }
+  }
+  return
+}
+
+// -----
+
+// Verify that a loop with a dynamic trip count is rolled into a Npu DMA
+// operation with a dynamic iteration dimension.
+//
+// CHECK-LABEL: @roll_npu_dma_dynamic_trip_count
+// CHECK-SAME:  %{{.+}}: !amdaie.logicalobjectfifo<memref<32x1024xi32>>, %{{.+}}: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %[[UB:.+]]: index
+// CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG:   %[[C1:.+]] = arith.constant 1 : index
+// CHECK:       %[[DMA0:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       amdaie.controlcode
+// CHECK-NOT:     scf.for
+// CHECK:         %[[RANGE:.+]] = arith.subi %[[UB]], %[[C0]]
+// CHECK:         %[[TRIP_COUNT:.+]] = arith.ceildivsi %[[RANGE]], %[[C1]]
+// CHECK:         %[[NPU_DMA:.+]] = amdaie.npu.dma_cpy_nd %[[DMA0]]([] [] [], [0, 0, 0, 0] [%[[TRIP_COUNT]], 1, 32, 64] [64, 1, 1024, 1])
+// CHECK-NEXT:    amdaie.npu.dma_wait(%[[NPU_DMA]], MM2S)
+// CHECK-NOT:     amdaie.npu.dma_cpy_nd
+// CHECK:         amdaie.end
+func.func @roll_npu_dma_dynamic_trip_count(%arg0: !amdaie.logicalobjectfifo<memref<32x1024xi32>>, %arg1: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %arg2: index) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  amdaie.workgroup {
+    %0 = amdaie.circular_dma_cpy_nd(%arg1[] [] [], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+    amdaie.controlcode {
+      scf.for %arg3 = %c0 to %arg2 step %c1 {
+        %1 = affine.apply affine_map<(d0) -> (d0 * 64)>(%arg3)
+        %2 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, %1] [32, 64] [1024, 1])
+        amdaie.npu.dma_wait(%2, MM2S)
+      }
+      amdaie.end
+    }
+  }
+  return
+}
+
+// -----
+
+// Verify that every Npu DMA of a loop issuing multiple Npu DMAs on different
+// connections is rolled on its own, with the waits moved after the rolled
+// Npu DMAs.
+//
+// CHECK-LABEL: @roll_multiple_npu_dmas
+// CHECK:       %[[DMA0:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       %[[DMA1:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       amdaie.controlcode
+// CHECK-NOT:     scf.for
+// CHECK:         %[[NPU_DMA_0:.+]] = amdaie.npu.dma_cpy_nd %[[DMA0]]([] [] [], [0, 0, 0, 0] [4, 1, 32, 64] [64, 1, 1024, 1])
+// CHECK-NEXT:    %[[NPU_DMA_1:.+]] = amdaie.npu.dma_cpy_nd %[[DMA1]]([0, 0, 0, 0] [4, 1, 32, 64] [64, 1, 1024, 1], [] [] [])
+// CHECK-NEXT:    amdaie.npu.dma_wait(%[[NPU_DMA_0]], MM2S)
+// CHECK-NEXT:    amdaie.npu.dma_wait(%[[NPU_DMA_1]], S2MM)
+// CHECK-NOT:     amdaie.npu.dma_cpy_nd
+// CHECK:         amdaie.end
+func.func @roll_multiple_npu_dmas(%arg0: !amdaie.logicalobjectfifo<memref<32x1024xi32>>, %arg1: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %arg2: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %arg3: !amdaie.logicalobjectfifo<memref<32x1024xi32>>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  amdaie.workgroup {
+    %0 = amdaie.circular_dma_cpy_nd(%arg1[] [] [], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+    %1 = amdaie.circular_dma_cpy_nd(%arg3[] [] [], %arg2[] [] []) : (!amdaie.logicalobjectfifo<memref<32x1024xi32>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+    amdaie.controlcode {
+      scf.for %arg4 = %c0 to %c4 step %c1 {
+        %2 = affine.apply affine_map<(d0) -> (d0 * 64)>(%arg4)
+        %3 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, %2] [32, 64] [1024, 1])
+        %4 = amdaie.npu.dma_cpy_nd %1([0, %2] [32, 64] [1024, 1], [] [] [])
+        amdaie.npu.dma_wait(%3, MM2S)
+        amdaie.npu.dma_wait(%4, S2MM)
+      }
+      amdaie.end
+    }
+  }
+  return
+}
+
+// -----
+
+// Verify that the Npu DMAs of a loop that can be rolled are, while the loop is
+// still unrolled for the other ones. The wait on the rolled Npu DMA is issued
+// after the unrolled iterations.
+//
+// CHECK-LABEL: @roll_npu_dma_unroll_other
+// CHECK:       %[[DMA0:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       %[[DMA1:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       amdaie.controlcode
+// CHECK-NOT:     scf.for
+// CHECK:         %[[NPU_DMA_0:.+]] = amdaie.npu.dma_cpy_nd %[[DMA0]]([] [] [], [0, 0, 0, 0] [4, 1, 32, 64] [64, 1, 1024, 1])
+// CHECK-COUNT-4: amdaie.npu.dma_cpy_nd %[[DMA1]]
+// CHECK:         amdaie.npu.dma_wait(%[[NPU_DMA_0]], MM2S)
+// CHECK-NOT:     amdaie.npu.dma_cpy_nd
+// CHECK:         amdaie.end
+func.func @roll_npu_dma_unroll_other(%arg0: !amdaie.logicalobjectfifo<memref<32x1024xi32>>, %arg1: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %arg2: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %arg3: !amdaie.logicalobjectfifo<memref<32x1024xi32>>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  amdaie.workgroup {
+    %0 = amdaie.circular_dma_cpy_nd(%arg1[] [] [], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+    %1 = amdaie.circular_dma_cpy_nd(%arg3[] [] [], %arg2[] [] []) : (!amdaie.logicalobjectfifo<memref<32x1024xi32>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+    amdaie.controlcode {
+      scf.for %arg4 = %c0 to %c4 step %c1 {
+        %2 = affine.apply affine_map<(d0) -> (d0 * 64)>(%arg4)
+        %3 = affine.apply affine_map<(d0) -> ((d0 mod 2) * 64)>(%arg4)
+        %4 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, %2] [32, 64] [1024, 1])
+        %5 = amdaie.npu.dma_cpy_nd %1([0, %3] [32, 64] [1024, 1], [] [] [])
+        amdaie.npu.dma_wait(%4, MM2S)
+        amdaie.npu.dma_wait(%5, S2MM)
+      }
+      amdaie.end
+    }
+  }
+  return
+}
+
+// -----
+
+// Verify that Npu DMAs sharing a connection aren't rolled, as that would
+// reorder their transfers.
+//
+// CHECK-LABEL: @unroll_npu_dmas_same_connection
+// CHECK:       amdaie.controlcode
+// CHECK-NOT:     scf.for
+// CHECK-COUNT-8: amdaie.npu.dma_cpy_nd
+// CHECK:         amdaie.end
+func.func @unroll_npu_dmas_same_connection(%arg0: !amdaie.logicalobjectfifo<memref<32x1024xi32>>, %arg1: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  amdaie.workgroup {
+    %0 = amdaie.circular_dma_cpy_nd(%arg1[] [] [], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+    amdaie.controlcode {
+      scf.for %arg2 = %c0 to %c4 step %c1 {
+        %1 = affine.apply affine_map<(d0) -> (d0 * 128)>(%arg2)
+        %2 = affine.apply affine_map<(d0) -> (d0 * 128 + 64)>(%arg2)
+        %3 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, %1] [32, 64] [1024, 1])
+        %4 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, %2] [32, 64] [1024, 1])
+      }
+      amdaie.end
+    }
+  }
+  return
+}
@@ -0,0 +1,118 @@
+// RUN: iree-opt --pass-pipeline="builtin.module(func.func(iree-amdaie-controlcode-schedule-dma-waits))" --split-input-file %s | FileCheck %s
+
+// Verify that the waits are sunk up to the next DMA on the same connection, so
+// the input DMA of the second iteration is issued before waiting on the output
+// of the first iteration.
+//
+// CHECK-LABEL: @sink_wait_past_other_connection
+// CHECK:       %[[DMA0:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       %[[DMA1:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       amdaie.controlcode
+// CHECK-NEXT:    %[[IN_0:.+]] = amdaie.npu.dma_cpy_nd %[[DMA0]]
+// CHECK-NEXT:    %[[OUT_0:.+]] = amdaie.npu.dma_cpy_nd %[[DMA1]]
+// CHECK-NEXT:    amdaie.npu.dma_wait(%[[IN_0]], MM2S)
+// CHECK-NEXT:    %[[IN_1:.+]] = amdaie.npu.dma_cpy_nd %[[DMA0]]
+// CHECK-NEXT:    amdaie.npu.dma_wait(%[[OUT_0]], S2MM)
+// CHECK-NEXT:    %[[OUT_1:.+]] = amdaie.npu.dma_cpy_nd %[[DMA1]]
+// CHECK-NEXT:    amdaie.npu.dma_wait(%[[OUT_1]], S2MM)
+// CHECK-NEXT:    amdaie.npu.dma_wait(%[[IN_1]], MM2S)
+// CHECK-NEXT:    amdaie.end
+func.func @sink_wait_past_other_connection(%arg0: !amdaie.logicalobjectfifo<memref<32x64xi32>>, %arg1: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %arg2: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %arg3: !amdaie.logicalobjectfifo<memref<32x64xi32>>) {
+  amdaie.workgroup {
+    %0 = amdaie.circular_dma_cpy_nd(%arg1[] [] [], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x64xi32>>)
+    %1 = amdaie.circular_dma_cpy_nd(%arg3[] [] [], %arg2[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+    amdaie.controlcode {
+      %2 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, 0] [32, 64] [128, 1])
+      amdaie.npu.dma_wait(%2, MM2S)
+      %3 = amdaie.npu.dma_cpy_nd %1([0, 0] [32, 64] [128, 1], [] [] [])
+      amdaie.npu.dma_wait(%3, S2MM)
+      %4 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, 64] [32, 64] [128, 1])
+      amdaie.npu.dma_wait(%4, MM2S)
+      %5 = amdaie.npu.dma_cpy_nd %1([0, 64] [32, 64] [128, 1], [] [] [])
+      amdaie.npu.dma_wait(%5, S2MM)
+      amdaie.end
+    }
+  }
+  return
+}
+
+// -----
+
+// Verify that a wait isn't sunk past an operation with side effects.
+//
+// CHECK-LABEL: @no_sink_past_side_effect
+// CHECK:       amdaie.controlcode
+// CHECK:         %[[IN_0:.+]] = amdaie.npu.dma_cpy_nd
+// CHECK-NEXT:    amdaie.npu.dma_wait(%[[IN_0]], MM2S)
+// CHECK-NEXT:    func.call @callee
+func.func private @callee()
+func.func @no_sink_past_side_effect(%arg0: !amdaie.logicalobjectfifo<memref<32x64xi32>>, %arg1: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>) {
+  amdaie.workgroup {
+    %0 = amdaie.circular_dma_cpy_nd(%arg1[] [] [], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x64xi32>>)
+    amdaie.controlcode {
+      %1 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, 0] [32, 64] [128, 1])
+      amdaie.npu.dma_wait(%1, MM2S)
+      func.call @callee() : () -> ()
+      amdaie.end
+    }
+  }
+  return
+}
+
+// -----
+
+// Verify that a wait which is implied by a later wait on the same connection
+// is removed.
+//
+// CHECK-LABEL: @merge_waits_same_connection
+// CHECK:       amdaie.controlcode
+// CHECK-NEXT:    amdaie.npu.dma_cpy_nd
+// CHECK-NEXT:    %[[OUT_1:.+]] = amdaie.npu.dma_cpy_nd
+// CHECK-NEXT:    amdaie.npu.dma_wait(%[[OUT_1]], S2MM)
+// CHECK-NEXT:    amdaie.end
+func.func @merge_waits_same_connection(%arg0: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %arg1: !amdaie.logicalobjectfifo<memref<32x64xi32>>) {
+  amdaie.workgroup {
+    %0 = amdaie.circular_dma_cpy_nd(%arg1[] [] [], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+    amdaie.controlcode {
+      %1 = amdaie.npu.dma_cpy_nd %0([0, 0] [32, 32] [64, 1], [] [] [])
+      %2 = amdaie.npu.dma_cpy_nd %0([0, 32] [32, 32] [64, 1], [] [] [])
+      amdaie.npu.dma_wait(%1, S2MM)
+      amdaie.npu.dma_wait(%2, S2MM)
+      amdaie.end
+    }
+  }
+  return
+}
+
+// -----
+
+// Verify that waits within a loop that remains in the control code are only
+// sunk to the end of the loop body and aren't moved across iterations.
+//
+// CHECK-LABEL: @sink_wait_within_loop_body
+// CHECK:       amdaie.controlcode
+// CHECK:         scf.for
+// CHECK-NEXT:      %[[IN:.+]] = amdaie.npu.dma_cpy_nd
+// CHECK-NEXT:      %[[OUT:.+]] = amdaie.npu.dma_cpy_nd
+// CHECK-NEXT:      amdaie.npu.dma_wait(%[[OUT]], S2MM)
+// CHECK-NEXT:      amdaie.npu.dma_wait(%[[IN]], MM2S)
+// CHECK-NEXT:    }
+// CHECK-NEXT:    amdaie.end
+func.func @sink_wait_within_loop_body(%arg0: !amdaie.logicalobjectfifo<memref<32x64xi32>>, %arg1: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %arg2: !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, %arg3: !amdaie.logicalobjectfifo<memref<32x64xi32>>, %arg4: index) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  amdaie.workgroup {
+    %0 = amdaie.circular_dma_cpy_nd(%arg1[] [] [], %arg0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x64xi32>>)
+    %1 = amdaie.circular_dma_cpy_nd(%arg3[] [] [], %arg2[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+    amdaie.controlcode {
+      scf.for %arg5 = %c0 to %arg4 step %c1 {
+        %2 = amdaie.npu.dma_cpy_nd %0([] [] [], [0, %arg5] [32, 64] [128, 1])
+        amdaie.npu.dma_wait(%2, MM2S)
+        %3 = amdaie.npu.dma_cpy_nd %1([0, %arg5] [32, 64] [128, 1], [] [] [])
+        amdaie.npu.dma_wait(%3, S2MM)
+      }
+      amdaie.end
+    }
+  }
+  return
+}
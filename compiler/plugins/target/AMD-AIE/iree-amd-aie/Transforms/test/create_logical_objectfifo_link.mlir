@@ -80,6 +80,26 @@ func.func @link_multiple_inputs_and_outputs(%arg0: memref<32x1024xi32>, %arg1: m
 
 // -----
 
+// Verify that the inputs are ordered on the offset at which they fill the
+// linked buffer.
+//
+// CHECK-LABEL: func.func @link_inputs_ordered_on_offset
+// CHECK:       %[[DMA0:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       %[[DMA1:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       %[[DMA2:.+]] = amdaie.circular_dma_cpy_nd
+// CHECK:       amdaie.logicalobjectfifo.link{{.*}}[%[[DMA1]], %[[DMA0]]] -> [%[[DMA2]]]
+func.func @link_inputs_ordered_on_offset(%arg0: memref<32x1024xi32>, %arg1: memref<32x64xi32, 1>, %arg2: memref<32x64xi32, 2>) {
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {} :memref<32x1024xi32> -> !amdaie.logicalobjectfifo<memref<32x1024xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  %2 = amdaie.logicalobjectfifo.from_memref %arg2, {} : memref<32x64xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 2>>
+  %3 = amdaie.circular_dma_cpy_nd(%1[1024] [1024] [1], %0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+  %4 = amdaie.circular_dma_cpy_nd(%1[0] [1024] [1], %0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+  %5 = amdaie.circular_dma_cpy_nd(%2[] [] [], %1[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 2>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+  return
+}
+
+// -----
+
 func.func @link_different_blocks(%arg0: memref<32x1024xi32>, %arg1: memref<32x64xi32, 1>, %arg2: memref<8x8x4x8xi32, 2>) {
   %0 = amdaie.logicalobjectfifo.from_memref %arg0, {} :memref<32x1024xi32> -> !amdaie.logicalobjectfifo<memref<32x1024xi32>>
   // expected-error @+2 {{does have copy-like users not residing in the same block}}
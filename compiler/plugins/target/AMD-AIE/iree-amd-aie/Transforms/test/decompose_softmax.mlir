@@ -0,0 +1,24 @@
+// RUN: iree-opt --split-input-file --pass-pipeline="builtin.module(func.func(iree-amdaie-decompose-softmax))" %s | FileCheck %s
+
+// A softmax is decomposed into a max reduction, an exponentiation, a sum
+// reduction and a division by the sum.
+// CHECK-LABEL: func.func @softmax
+//   CHECK-NOT:   linalg.softmax
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       iterator_types = ["parallel", "reduction"]
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       iterator_types = ["parallel", "parallel"]
+//       CHECK:     arith.subf
+//       CHECK:     math.exp
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       iterator_types = ["parallel", "reduction"]
+//       CHECK:     arith.addf
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       iterator_types = ["parallel", "parallel"]
+//       CHECK:     arith.divf
+//   CHECK-NOT:   linalg.softmax
+func.func @softmax(%arg0: tensor<16x64xf32>) -> tensor<16x64xf32> {
+  %0 = tensor.empty() : tensor<16x64xf32>
+  %1 = linalg.softmax dimension(1) ins(%arg0 : tensor<16x64xf32>) outs(%0 : tensor<16x64xf32>) -> tensor<16x64xf32>
+  return %1 : tensor<16x64xf32>
+}
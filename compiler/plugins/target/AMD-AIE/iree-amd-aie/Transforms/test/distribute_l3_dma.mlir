@@ -0,0 +1,168 @@
+// RUN: iree-opt --pass-pipeline="builtin.module(func.func(iree-amdaie-distribute-l3-dma))" --split-input-file %s | FileCheck %s
+
+// CHECK-LABEL: @distribute_l3_to_l2
+// CHECK:       %[[TILE_0_0:.+]] = amdaie.tile(%[[C0:.+]], %[[C0]])
+// CHECK:       %[[TILE_0_1:.+]] = amdaie.tile
+// CHECK:       %[[FROM_MEMREF_0:.+]] = amdaie.logicalobjectfifo.from_memref %{{.+}}, {%[[TILE_0_0]]}
+// CHECK:       %[[ROW:.+]] = arith.constant 0 : index
+// CHECK:       %[[C1:.+]] = arith.constant 1 : index
+// CHECK:       %[[TILE_1_0:.+]] = amdaie.tile(%[[C1]], %[[ROW]])
+// CHECK:       %[[FROM_MEMREF_1:.+]] = amdaie.logicalobjectfifo.from_memref %{{.+}}, {%[[TILE_1_0]]}
+// CHECK:       %[[C2:.+]] = arith.constant 2 : index
+// CHECK:       %[[TILE_2_0:.+]] = amdaie.tile(%[[C2]], %[[ROW]])
+// CHECK:       %[[FROM_MEMREF_2:.+]] = amdaie.logicalobjectfifo.from_memref %{{.+}}, {%[[TILE_2_0]]}
+// CHECK:       %[[C3:.+]] = arith.constant 3 : index
+// CHECK:       %[[TILE_3_0:.+]] = amdaie.tile(%[[C3]], %[[ROW]])
+// CHECK:       %[[FROM_MEMREF_3:.+]] = amdaie.logicalobjectfifo.from_memref %{{.+}}, {%[[TILE_3_0]]}
+// CHECK:       %[[L2:.+]] = amdaie.logicalobjectfifo.from_memref %{{.+}}, {%[[TILE_0_1]]}
+// CHECK:       amdaie.dma_cpy_nd(%[[L2]][0] [1024] [1], %[[FROM_MEMREF_0]][0, 0] [16, 64] [64, 1])
+// CHECK:       amdaie.dma_cpy_nd(%[[L2]][1024] [1024] [1], %[[FROM_MEMREF_1]][16, 0] [16, 64] [64, 1])
+// CHECK:       amdaie.dma_cpy_nd(%[[L2]][2048] [1024] [1], %[[FROM_MEMREF_2]][32, 0] [16, 64] [64, 1])
+// CHECK:       amdaie.dma_cpy_nd(%[[L2]][3072] [1024] [1], %[[FROM_MEMREF_3]][48, 0] [16, 64] [64, 1])
+// CHECK-NOT:   amdaie.dma_cpy_nd
+func.func @distribute_l3_to_l2(%arg0: memref<64x64xi32>, %arg1: memref<64x64xi32, 1>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %tile_0_0 = amdaie.tile(%c0, %c0)
+  %tile_0_1 = amdaie.tile(%c0, %c1)
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {%tile_0_0} : memref<64x64xi32> -> !amdaie.logicalobjectfifo<memref<64x64xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {%tile_0_1} : memref<64x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<64x64xi32, 1>>
+  %2 = amdaie.dma_cpy_nd(%1[] [] [], %0[] [] []) : (!amdaie.logicalobjectfifo<memref<64x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<64x64xi32>>)
+  return
+}
+
+// -----
+
+// Verify that the bandwidth model balances the setup overhead per channel
+// against the aggregated bandwidth: an 8 KB transfer is split in two.
+//
+// CHECK-LABEL: @distribute_l2_to_l3
+// CHECK:       %[[TILE_0_0:.+]] = amdaie.tile
+// CHECK:       %[[TILE_0_1:.+]] = amdaie.tile
+// CHECK:       %[[FROM_MEMREF_0:.+]] = amdaie.logicalobjectfifo.from_memref %{{.+}}, {%[[TILE_0_0]]}
+// CHECK:       %[[TILE_1_0:.+]] = amdaie.tile
+// CHECK:       %[[FROM_MEMREF_1:.+]] = amdaie.logicalobjectfifo.from_memref %{{.+}}, {%[[TILE_1_0]]}
+// CHECK-NOT:   amdaie.tile
+// CHECK:       %[[L2:.+]] = amdaie.logicalobjectfifo.from_memref %{{.+}}, {%[[TILE_0_1]]}
+// CHECK:       amdaie.dma_cpy_nd(%[[FROM_MEMREF_0]][0, 32] [16, 64] [128, 1], %[[L2]][0] [1024] [1])
+// CHECK:       amdaie.dma_cpy_nd(%[[FROM_MEMREF_1]][16, 32] [16, 64] [128, 1], %[[L2]][1024] [1024] [1])
+// CHECK-NOT:   amdaie.dma_cpy_nd
+func.func @distribute_l2_to_l3(%arg0: memref<64x128xi32>, %arg1: memref<32x64xi32, 1>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %tile_0_0 = amdaie.tile(%c0, %c0)
+  %tile_0_1 = amdaie.tile(%c0, %c1)
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {%tile_0_0} : memref<64x128xi32> -> !amdaie.logicalobjectfifo<memref<64x128xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {%tile_0_1} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  %2 = amdaie.dma_cpy_nd(%0[0, 32] [32, 64] [128, 1], %1[] [] []) : (!amdaie.logicalobjectfifo<memref<64x128xi32>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+  return
+}
+
+// -----
+
+// CHECK-DAG:   #[[MAP:.+]] = affine_map<{{.+}} -> ({{.+}} + 16)>
+// CHECK-LABEL: @distribute_dynamic_offset
+// CHECK:       %[[FROM_MEMREF_0:.+]] = amdaie.logicalobjectfifo.from_memref
+// CHECK:       %[[FROM_MEMREF_1:.+]] = amdaie.logicalobjectfifo.from_memref
+// CHECK:       %[[L2:.+]] = amdaie.logicalobjectfifo.from_memref
+// CHECK:       scf.for %[[ARG2:.+]] = %{{.+}} to %{{.+}} step %{{.+}}
+// CHECK:         %[[OFFSET:.+]] = affine.apply #[[MAP]]{{.*}}%[[ARG2]]
+// CHECK:         amdaie.dma_cpy_nd(%[[L2]][0] [1024] [1], %[[FROM_MEMREF_0]][%[[ARG2]], 0] [16, 64] [64, 1])
+// CHECK:         amdaie.dma_cpy_nd(%[[L2]][1024] [1024] [1], %[[FROM_MEMREF_1]][%[[OFFSET]], 0] [16, 64] [64, 1])
+func.func @distribute_dynamic_offset(%arg0: memref<128x64xi32>, %arg1: memref<32x64xi32, 1>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c32 = arith.constant 32 : index
+  %c128 = arith.constant 128 : index
+  %tile_0_0 = amdaie.tile(%c0, %c0)
+  %tile_0_1 = amdaie.tile(%c0, %c1)
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {%tile_0_0} : memref<128x64xi32> -> !amdaie.logicalobjectfifo<memref<128x64xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {%tile_0_1} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  scf.for %arg2 = %c0 to %c128 step %c32 {
+    %2 = amdaie.dma_cpy_nd(%1[] [] [], %0[%arg2, 0] [32, 64] [64, 1]) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<128x64xi32>>)
+  }
+  return
+}
+
+// -----
+
+// Small transfers don't benefit from multiple channels as the setup overhead
+// dominates.
+//
+// CHECK-LABEL: @no_distribute_small
+// CHECK-COUNT-1: amdaie.dma_cpy_nd
+// CHECK-NOT:     amdaie.dma_cpy_nd
+func.func @no_distribute_small(%arg0: memref<8x16xi32>, %arg1: memref<8x16xi32, 1>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %tile_0_0 = amdaie.tile(%c0, %c0)
+  %tile_0_1 = amdaie.tile(%c0, %c1)
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {%tile_0_0} : memref<8x16xi32> -> !amdaie.logicalobjectfifo<memref<8x16xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {%tile_0_1} : memref<8x16xi32, 1> -> !amdaie.logicalobjectfifo<memref<8x16xi32, 1>>
+  %2 = amdaie.dma_cpy_nd(%1[] [] [], %0[] [] []) : (!amdaie.logicalobjectfifo<memref<8x16xi32, 1>>, !amdaie.logicalobjectfifo<memref<8x16xi32>>)
+  return
+}
+
+// -----
+
+// An L2 buffer distributed to multiple consumers can't be joined from multiple
+// producers at the same time.
+//
+// CHECK-LABEL: @no_distribute_multiple_consumers
+// CHECK-COUNT-3: amdaie.dma_cpy_nd
+// CHECK-NOT:     amdaie.dma_cpy_nd
+func.func @no_distribute_multiple_consumers(%arg0: memref<64x64xi32>, %arg1: memref<64x64xi32, 1>, %arg2: memref<32x64xi32, 2>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c2 = arith.constant 2 : index
+  %tile_0_0 = amdaie.tile(%c0, %c0)
+  %tile_0_1 = amdaie.tile(%c0, %c1)
+  %tile_0_2 = amdaie.tile(%c0, %c2)
+  %tile_1_2 = amdaie.tile(%c1, %c2)
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {%tile_0_0} : memref<64x64xi32> -> !amdaie.logicalobjectfifo<memref<64x64xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {%tile_0_1} : memref<64x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<64x64xi32, 1>>
+  %2 = amdaie.logicalobjectfifo.from_memref %arg2, {%tile_0_2} : memref<32x64xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 2>>
+  %3 = amdaie.logicalobjectfifo.from_memref %arg2, {%tile_1_2} : memref<32x64xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 2>>
+  %4 = amdaie.dma_cpy_nd(%1[] [] [], %0[] [] []) : (!amdaie.logicalobjectfifo<memref<64x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<64x64xi32>>)
+  %5 = amdaie.dma_cpy_nd(%2[] [] [], %1[0, 0] [32, 64] [64, 1]) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 2>>, !amdaie.logicalobjectfifo<memref<64x64xi32, 1>>)
+  %6 = amdaie.dma_cpy_nd(%3[] [] [], %1[32, 0] [32, 64] [64, 1]) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 2>>, !amdaie.logicalobjectfifo<memref<64x64xi32, 1>>)
+  return
+}
+
+// -----
+
+// The shim tiles in columns 1 and 2 don't have a free MM2S channel left, so
+// the transfer can only be distributed over columns 0 and 3.
+//
+// CHECK-LABEL: @distribute_free_channels
+// CHECK:       %[[TILE_0_0:.+]] = amdaie.tile(%[[C0:.+]], %[[C0]])
+// CHECK:       %[[FROM_MEMREF_0:.+]] = amdaie.logicalobjectfifo.from_memref %{{.+}}, {%[[TILE_0_0]]}
+// CHECK:       %[[C3:.+]] = arith.constant 3 : index
+// CHECK:       %[[TILE_3_0:.+]] = amdaie.tile(%[[C3]], %{{.+}})
+// CHECK:       %[[FROM_MEMREF_3:.+]] = amdaie.logicalobjectfifo.from_memref %{{.+}}, {%[[TILE_3_0]]}
+// CHECK-NOT:   amdaie.tile
+// CHECK:       amdaie.dma_cpy_nd(%{{.+}}[0] [2048] [1], %[[FROM_MEMREF_0]][0, 0] [32, 64] [64, 1])
+// CHECK:       amdaie.dma_cpy_nd(%{{.+}}[2048] [2048] [1], %[[FROM_MEMREF_3]][32, 0] [32, 64] [64, 1])
+func.func @distribute_free_channels(%arg0: memref<64x64xi32>, %arg1: memref<64x64xi32, 1>, %arg2: memref<8x8xi32>, %arg3: memref<8x8xi32, 1>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c2 = arith.constant 2 : index
+  %tile_0_0 = amdaie.tile(%c0, %c0)
+  %tile_0_1 = amdaie.tile(%c0, %c1)
+  %tile_1_0 = amdaie.tile(%c1, %c0)
+  %tile_1_1 = amdaie.tile(%c1, %c1)
+  %tile_2_0 = amdaie.tile(%c2, %c0)
+  %tile_2_1 = amdaie.tile(%c2, %c1)
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {%tile_0_0} : memref<64x64xi32> -> !amdaie.logicalobjectfifo<memref<64x64xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {%tile_0_1} : memref<64x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<64x64xi32, 1>>
+  %2 = amdaie.logicalobjectfifo.from_memref %arg2, {%tile_1_0} : memref<8x8xi32> -> !amdaie.logicalobjectfifo<memref<8x8xi32>>
+  %3 = amdaie.logicalobjectfifo.from_memref %arg3, {%tile_1_1} : memref<8x8xi32, 1> -> !amdaie.logicalobjectfifo<memref<8x8xi32, 1>>
+  %4 = amdaie.logicalobjectfifo.from_memref %arg2, {%tile_2_0} : memref<8x8xi32> -> !amdaie.logicalobjectfifo<memref<8x8xi32>>
+  %5 = amdaie.logicalobjectfifo.from_memref %arg3, {%tile_2_1} : memref<8x8xi32, 1> -> !amdaie.logicalobjectfifo<memref<8x8xi32, 1>>
+  %6 = amdaie.dma_cpy_nd(%1[] [] [], %0[] [] []) : (!amdaie.logicalobjectfifo<memref<64x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<64x64xi32>>)
+  %7 = amdaie.dma_cpy_nd(%3[] [] [], %2[] [] []) : (!amdaie.logicalobjectfifo<memref<8x8xi32, 1>>, !amdaie.logicalobjectfifo<memref<8x8xi32>>)
+  %8 = amdaie.dma_cpy_nd(%3[] [] [], %2[] [] []) : (!amdaie.logicalobjectfifo<memref<8x8xi32, 1>>, !amdaie.logicalobjectfifo<memref<8x8xi32>>)
+  %9 = amdaie.dma_cpy_nd(%5[] [] [], %4[] [] []) : (!amdaie.logicalobjectfifo<memref<8x8xi32, 1>>, !amdaie.logicalobjectfifo<memref<8x8xi32>>)
+  %10 = amdaie.dma_cpy_nd(%5[] [] [], %4[] [] []) : (!amdaie.logicalobjectfifo<memref<8x8xi32, 1>>, !amdaie.logicalobjectfifo<memref<8x8xi32>>)
+  return
+}
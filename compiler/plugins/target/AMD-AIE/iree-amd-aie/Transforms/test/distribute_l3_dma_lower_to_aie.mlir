@@ -0,0 +1,59 @@
+// RUN: iree-opt --pass-pipeline="builtin.module(func.func(iree-amdaie-distribute-l3-dma,iree-amdaie-dma-to-circular-dma,iree-amdaie-create-aie-workgroup),iree-amdaie-lower-to-aie)" --verify-diagnostics %s | FileCheck %s
+
+// Verify that an L3 -> L2 transfer distributed over the shim tiles of two
+// columns is lowered to one objectFifo per column, each carrying a contiguous
+// slice of the L2 buffer, which are joined by a link, and to one NPU DMA per
+// column in the control code.
+//
+// CHECK:       aie.device
+// CHECK-DAG:   %[[TILE_0_0:.+]] = aie.tile(0, 0)
+// CHECK-DAG:   %[[TILE_1_0:.+]] = aie.tile(1, 0)
+// CHECK-DAG:   %[[TILE_0_1:.+]] = aie.tile(0, 1)
+// CHECK-DAG:   %[[TILE_0_2:.+]] = aie.tile(0, 2)
+// CHECK:       aie.objectfifo @[[OBJ0:.+]](%[[TILE_0_0]], {%[[TILE_0_1]]}
+// CHECK-SAME:  !aie.objectfifo<memref<1024xi32, 1>>
+// CHECK-NEXT:  aie.objectfifo @[[OBJ1:.+]](%[[TILE_1_0]], {%[[TILE_0_1]]}
+// CHECK-SAME:  !aie.objectfifo<memref<1024xi32, 1>>
+// CHECK-NEXT:  aie.objectfifo @[[OBJ2:.+]](%[[TILE_0_1]], {%[[TILE_0_2]]}
+// CHECK-SAME:  !aie.objectfifo<memref<2048xi32, 1>>
+// CHECK-NEXT:  aie.objectfifo.link [@[[OBJ0]], @[[OBJ1]]] -> [@[[OBJ2]]]
+// CHECK:       func.func @distribute_l3_to_l2
+// CHECK-SAME:  %[[ARG0:.+]]: memref<32x64xi32>
+// CHECK:         aiex.npu.dma_memcpy_nd
+// CHECK-SAME:    %[[ARG0]]
+// CHECK-SAME:    [1, 1, 0, 0]
+// CHECK-SAME:    [1, 1, 16, 64]
+// CHECK-SAME:    [1, 1, 64]
+// CHECK-SAME:    @[[OBJ0]]
+// CHECK-NEXT:    aiex.npu.dma_wait
+// CHECK-SAME:    @[[OBJ0]]
+// CHECK:         aiex.npu.dma_memcpy_nd
+// CHECK-SAME:    %[[ARG0]]
+// CHECK-SAME:    [1, 1, 16, 0]
+// CHECK-SAME:    [1, 1, 16, 64]
+// CHECK-SAME:    [1, 1, 64]
+// CHECK-SAME:    @[[OBJ1]]
+// CHECK-NEXT:    aiex.npu.dma_wait
+// CHECK-SAME:    @[[OBJ1]]
+module {
+  func.func @distribute_l3_to_l2() {
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %c2 = arith.constant 2 : index
+    %tile_0_0 = amdaie.tile(%c0, %c0)
+    %tile_0_1 = amdaie.tile(%c0, %c1)
+    %tile_0_2 = amdaie.tile(%c0, %c2)
+    %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) alignment(64) offset(%c0) : memref<32x64xi32>
+    memref.assume_alignment %0, 64 : memref<32x64xi32>
+    %alloc_1 = memref.alloc() : memref<32x64xi32, 1>
+    %alloc_2 = memref.alloc() : memref<32x64xi32, 2>
+    %obj0 = amdaie.logicalobjectfifo.from_memref %0, {%tile_0_0} : memref<32x64xi32> -> !amdaie.logicalobjectfifo<memref<32x64xi32>>
+    %obj1 = amdaie.logicalobjectfifo.from_memref %alloc_1, {%tile_0_1} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+    %obj2 = amdaie.logicalobjectfifo.from_memref %alloc_2, {%tile_0_2} : memref<32x64xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 2>>
+    %dma0 = amdaie.dma_cpy_nd(%obj1[] [] [], %obj0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x64xi32>>)
+    %dma1 = amdaie.dma_cpy_nd(%obj2[] [] [], %obj1[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 2>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+    memref.dealloc %alloc_2 : memref<32x64xi32, 2>
+    memref.dealloc %alloc_1 : memref<32x64xi32, 1>
+    return
+  }
+}
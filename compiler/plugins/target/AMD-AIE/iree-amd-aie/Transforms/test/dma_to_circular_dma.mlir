@@ -1,4 +1,4 @@
-// RUN: iree-opt --pass-pipeline="builtin.module(func.func(iree-amdaie-dma-to-circular-dma))" --split-input-file %s | FileCheck %s
+// RUN: iree-opt --pass-pipeline="builtin.module(func.func(iree-amdaie-dma-to-circular-dma))" --split-input-file --verify-diagnostics %s | FileCheck %s
 
 // CHECK-LABEL: @circular_dma_cpy_nd_l2_l1
 // CHECK:       %[[FROM_MEMREF_0:.*]] = amdaie.logicalobjectfifo.from_memref
@@ -61,3 +61,174 @@ func.func @no_circular_dma_cpy_nd_l3_l2(%arg0: memref<32x1024xi32>, %arg1: memre
   %2 = amdaie.dma_cpy_nd(%1[0, 0] [1, 1] [1, 1], %0[0, 0] [2, 2] [1, 1]) : (!amdaie.logicalobjectfifo<memref<32x1024xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
   return
 }
+
+// -----
+
+// CHECK-LABEL: @circular_dma_cpy_nd_l2_l1_in_loop
+// CHECK:       scf.for
+// CHECK:         amdaie.circular_dma_cpy_nd
+func.func @circular_dma_cpy_nd_l2_l1_in_loop(%arg0: memref<32x64xi32, 1>, %arg1: memref<32x64xi32, 2>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {} : memref<32x64xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 2>>
+  scf.for %arg2 = %c0 to %c8 step %c1 {
+    %2 = amdaie.dma_cpy_nd(%1[] [] [], %0[0, 0] [32, 32] [64, 1]) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 2>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+  }
+  return
+}
+
+// -----
+
+func.func @l2_l1_loop_variant(%arg0: memref<32x64xi32, 1>, %arg1: memref<32x64xi32, 2>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {} : memref<32x64xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 2>>
+  scf.for %arg2 = %c0 to %c8 step %c1 {
+    // expected-error @+1 {{has a loop-variant access pattern between L2 and L1, which can't be configured statically}}
+    %2 = amdaie.dma_cpy_nd(%1[] [] [], %0[0, %arg2] [32, 8] [64, 1]) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 2>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+  }
+  return
+}
+
+// -----
+
+// Verify that loop invariant L3 -> L2 DMAs are hoisted out of the loop and
+// repeated with an outer stride zero dimension on the L3 side only, so the L2
+// side still receives one transfer per iteration.
+//
+// CHECK-LABEL: @hoist_l3_l2_loop_invariant
+// CHECK:       %[[FROM_MEMREF_0:.*]] = amdaie.logicalobjectfifo.from_memref
+// CHECK:       %[[FROM_MEMREF_1:.*]] = amdaie.logicalobjectfifo.from_memref
+// CHECK:       amdaie.dma_cpy_nd
+// CHECK-SAME:  %[[FROM_MEMREF_1]][] [] []
+// CHECK-SAME:  %[[FROM_MEMREF_0]][0, 0, 0, 0] [8, 1, 32, 64] [0, 1, 1024, 1]
+// CHECK:       scf.for
+// CHECK-NOT:     amdaie.dma_cpy_nd
+func.func @hoist_l3_l2_loop_invariant(%arg0: memref<32x1024xi32>, %arg1: memref<32x64xi32, 1>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {} : memref<32x1024xi32> -> !amdaie.logicalobjectfifo<memref<32x1024xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  scf.for %arg2 = %c0 to %c8 step %c1 {
+    %2 = amdaie.dma_cpy_nd(%1[] [] [], %0[0, 0] [32, 64] [1024, 1]) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+  }
+  return
+}
+
+// -----
+
+// Verify that loop invariant L2 -> L3 write-backs aren't hoisted, as the data
+// written back differs on every iteration.
+//
+// CHECK-LABEL: @no_hoist_l2_l3_loop_invariant
+// CHECK:       scf.for
+// CHECK:         amdaie.dma_cpy_nd
+// CHECK-SAME:    [] [] []
+// CHECK-SAME:    [] [] []
+func.func @no_hoist_l2_l3_loop_invariant(%arg0: memref<32x64xi32, 1>, %arg1: memref<32x64xi32>) {
+  %c0 = arith.constant 0 : index
+  %c2 = arith.constant 2 : index
+  %c8 = arith.constant 8 : index
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {} : memref<32x64xi32> -> !amdaie.logicalobjectfifo<memref<32x64xi32>>
+  scf.for %arg2 = %c0 to %c8 step %c2 {
+    %2 = amdaie.dma_cpy_nd(%1[] [] [], %0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+  }
+  return
+}
+
+// -----
+
+// Verify that L3 -> L2 DMAs depending on the loop induction variable stay
+// within the loop, so they can be reconfigured on every iteration.
+//
+// CHECK-LABEL: @no_hoist_l3_l2_loop_variant
+// CHECK:       scf.for
+// CHECK:         amdaie.dma_cpy_nd
+func.func @no_hoist_l3_l2_loop_variant(%arg0: memref<32x1024xi32>, %arg1: memref<32x64xi32, 1>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {} : memref<32x1024xi32> -> !amdaie.logicalobjectfifo<memref<32x1024xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  scf.for %arg2 = %c0 to %c8 step %c1 {
+    %2 = affine.apply affine_map<(d0) -> (d0 * 64)>(%arg2)
+    %3 = amdaie.dma_cpy_nd(%1[] [] [], %0[0, %2] [32, 64] [1024, 1]) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+  }
+  return
+}
+
+// -----
+
+// Verify that L3 -> L2 DMAs aren't hoisted if the trip count exceeds the
+// maximum repetition count of a shim tile BD.
+//
+// CHECK-LABEL: @no_hoist_l3_l2_large_trip_count
+// CHECK:       scf.for
+// CHECK:         amdaie.dma_cpy_nd
+func.func @no_hoist_l3_l2_large_trip_count(%arg0: memref<32x1024xi32>, %arg1: memref<32x64xi32, 1>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c128 = arith.constant 128 : index
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {} : memref<32x1024xi32> -> !amdaie.logicalobjectfifo<memref<32x1024xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  scf.for %arg2 = %c0 to %c128 step %c1 {
+    %2 = amdaie.dma_cpy_nd(%1[] [] [], %0[0, 0] [32, 64] [1024, 1]) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+  }
+  return
+}
+
+// -----
+
+// Verify that L3 -> L2 DMAs aren't hoisted if the loop writes back to L3
+// memory which may alias the memory being read, as the data read could then
+// differ between iterations.
+//
+// CHECK-LABEL: @no_hoist_l3_l2_aliasing_write
+// CHECK:       scf.for
+// CHECK:         amdaie.dma_cpy_nd
+// CHECK-SAME:    [0, 0] [32, 64] [1024, 1]
+// CHECK:         amdaie.dma_cpy_nd
+func.func @no_hoist_l3_l2_aliasing_write(%arg0: memref<32x1024xi32>, %arg1: memref<32x64xi32, 1>, %arg2: memref<32x1024xi32>, %arg3: memref<32x64xi32, 1>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {} : memref<32x1024xi32> -> !amdaie.logicalobjectfifo<memref<32x1024xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  %2 = amdaie.logicalobjectfifo.from_memref %arg2, {} : memref<32x1024xi32> -> !amdaie.logicalobjectfifo<memref<32x1024xi32>>
+  %3 = amdaie.logicalobjectfifo.from_memref %arg3, {} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  scf.for %arg4 = %c0 to %c8 step %c1 {
+    %4 = amdaie.dma_cpy_nd(%1[] [] [], %0[0, 0] [32, 64] [1024, 1]) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+    %5 = amdaie.dma_cpy_nd(%2[0, 0] [32, 64] [1024, 1], %3[] [] []) : (!amdaie.logicalobjectfifo<memref<32x1024xi32>>, !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>)
+  }
+  return
+}
+
+// -----
+
+// Verify that L3 -> L2 DMAs aren't hoisted if another DMA in the loop writes
+// into the same L2 buffer, as the order of the transfers into that buffer
+// would change.
+//
+// CHECK-LABEL: @no_hoist_l3_l2_shared_target
+// CHECK:       scf.for
+// CHECK:         amdaie.dma_cpy_nd
+// CHECK:         amdaie.dma_cpy_nd
+func.func @no_hoist_l3_l2_shared_target(%arg0: memref<32x1024xi32>, %arg1: memref<32x64xi32, 1>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %0 = amdaie.logicalobjectfifo.from_memref %arg0, {} : memref<32x1024xi32> -> !amdaie.logicalobjectfifo<memref<32x1024xi32>>
+  %1 = amdaie.logicalobjectfifo.from_memref %arg1, {} : memref<32x64xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x64xi32, 1>>
+  scf.for %arg2 = %c0 to %c8 step %c1 {
+    %2 = amdaie.dma_cpy_nd(%1[] [] [], %0[0, 0] [32, 64] [1024, 1]) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+    %3 = affine.apply affine_map<(d0) -> (d0 * 64)>(%arg2)
+    %4 = amdaie.dma_cpy_nd(%1[] [] [], %0[0, %3] [32, 64] [1024, 1]) : (!amdaie.logicalobjectfifo<memref<32x64xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x1024xi32>>)
+  }
+  return
+}
@@ -103,8 +103,9 @@ module {
   }
 
 
-  // A check that a linalg.generic where the number of operands is not 3, does
-  // not get transformed to have an scf.for
+  // A check that a linalg.generic where the number of operands is not 3, and
+  // which is a transpose rather than a plain elementwise op, does not get
+  // transformed to have an scf.for
   // CHECK-LABEL: funcWithTwoOperands
   // CHECK-NOT: scf.for
   func.func @funcWithTwoOperands(%arg0: !t4, %arg1: !t4) -> !t4 {
@@ -205,6 +206,72 @@ module {
     } -> tensor<1x1x8x8x4x4xf32>
     return %0 : tensor<1x1x8x8x4x4xf32>
   }
-}
 
+  // An elementwise op keeps the inner-most dimension (64 f32 elements is a
+  // multiple of the 16 lane vector width) and the outer dimension is
+  // converted to an scf.for.
+  // CHECK-LABEL: elementwise_add
+  // CHECK: scf.for
+  // CHECK-NOT: scf.for
+  // CHECK: linalg.generic
+  // CHECK-SAME: iterator_types = ["parallel", "parallel"]
+  // CHECK-SAME: tensor<1x64xf32>, tensor<1x64xf32>
+  // CHECK-SAME: outs
+  // CHECK-SAME: tensor<1x64xf32>
+  func.func @elementwise_add(%arg0: memref<64x64xf32, 2 : i32>, %arg1: memref<64x64xf32, 2 : i32>, %arg2: memref<64x64xf32, 2 : i32>) -> !t2 {
+    %in0 = bufferization.to_tensor %arg0 restrict writable : memref<64x64xf32, 2 : i32>
+    %in1 = bufferization.to_tensor %arg1 restrict writable : memref<64x64xf32, 2 : i32>
+    %out = bufferization.to_tensor %arg2 restrict writable : memref<64x64xf32, 2 : i32>
+    %0 = linalg.generic {indexing_maps =
+                          [
+                           affine_map<(d0, d1) -> (d0, d1)>,
+                           affine_map<(d0, d1) -> (d0, d1)>,
+                           affine_map<(d0, d1) -> (d0, d1)>
+                          ],
+                         iterator_types = ["parallel", "parallel"]}
+                         ins(%in0, %in1 : !t2, !t2) outs(%out : !t2) {
+    ^bb0(%in: f32, %in_0: f32, %out_1: f32):
+      %1 = arith.addf %in, %in_0 : f32
+      linalg.yield %1 : f32
+    } -> !t2
+    return %0 : !t2
+  }
+
+  // A fill of a packed accumulator keeps the 2 inner-most dimensions, as 4x8
+  // f32 elements is the smallest whole number of 16 lane vectors.
+  // CHECK-LABEL: fill_accumulator
+  // CHECK-COUNT-4: scf.for
+  // CHECK-NOT: scf.for
+  // CHECK: linalg.fill
+  // CHECK-SAME: tensor<1x1x1x1x4x8xf32>
+  func.func @fill_accumulator(%arg0: memref<1x1x8x16x4x8xf32, 2 : i32>) -> tensor<1x1x8x16x4x8xf32> {
+    %cst = arith.constant 0.000000e+00 : f32
+    %acc = bufferization.to_tensor %arg0 restrict writable : memref<1x1x8x16x4x8xf32, 2 : i32>
+    %0 = linalg.fill ins(%cst : f32) outs(%acc : tensor<1x1x8x16x4x8xf32>) -> tensor<1x1x8x16x4x8xf32>
+    return %0 : tensor<1x1x8x16x4x8xf32>
+  }
+
+  // A copy whose inner-most dimensions can not be covered by whole vectors
+  // is not transformed.
+  // CHECK-LABEL: copy_unaligned
+  // CHECK-NOT: scf.for
+  // CHECK: linalg.copy
+  func.func @copy_unaligned(%arg0: memref<4x3x5xbf16, 2 : i32>, %arg1: memref<4x3x5xbf16, 2 : i32>) -> tensor<4x3x5xbf16> {
+    %src = bufferization.to_tensor %arg0 restrict writable : memref<4x3x5xbf16, 2 : i32>
+    %dst = bufferization.to_tensor %arg1 restrict writable : memref<4x3x5xbf16, 2 : i32>
+    %0 = linalg.copy ins(%src : tensor<4x3x5xbf16>) outs(%dst : tensor<4x3x5xbf16>) -> tensor<4x3x5xbf16>
+    return %0 : tensor<4x3x5xbf16>
+  }
 
+  // A copy into shared memory is lowered to a DMA, not vectorized, so it is
+  // not transformed.
+  // CHECK-LABEL: copy_to_shared_memory
+  // CHECK-NOT: scf.for
+  // CHECK: linalg.copy
+  // CHECK-SAME: tensor<8x64xf32>
+  func.func @copy_to_shared_memory(%arg0: tensor<8x64xf32>, %arg1: memref<8x64xf32, 1 : i32>) -> tensor<8x64xf32> {
+    %dst = bufferization.to_tensor %arg1 restrict writable : memref<8x64xf32, 1 : i32>
+    %0 = linalg.copy ins(%arg0 : tensor<8x64xf32>) outs(%dst : tensor<8x64xf32>) -> tensor<8x64xf32>
+    return %0 : tensor<8x64xf32>
+  }
+}
@@ -33,6 +33,101 @@ module {
 
 // -----
 
+// Verify that the cores of an accumulator chain are configured to send their
+// cascade output east and to receive their cascade input from the west.
+//
+// CHECK:       aie.device
+// CHECK-DAG:   %[[TILE_0_2:.+]] = aie.tile(0, 2)
+// CHECK-DAG:   %[[TILE_1_2:.+]] = aie.tile(1, 2)
+// CHECK-DAG:   %[[TILE_2_2:.+]] = aie.tile(2, 2)
+// CHECK-DAG:   aie.configure_cascade(%[[TILE_0_2]], North, East)
+// CHECK-DAG:   aie.configure_cascade(%[[TILE_1_2]], West, East)
+// CHECK-DAG:   aie.configure_cascade(%[[TILE_2_2]], West, South)
+// CHECK:       aie.core(%[[TILE_0_2]])
+// CHECK:         aie.put_cascade
+// CHECK:       aie.core(%[[TILE_1_2]])
+// CHECK:         aie.get_cascade
+// CHECK:         aie.put_cascade
+// CHECK:       aie.core(%[[TILE_2_2]])
+// CHECK:         aie.get_cascade
+module {
+  func.func @configure_cascade() {
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %c2 = arith.constant 2 : index
+    amdaie.workgroup {
+      %tile_0_2 = amdaie.tile(%c0, %c2)
+      %tile_1_2 = amdaie.tile(%c1, %c2)
+      %tile_2_2 = amdaie.tile(%c2, %c2)
+      %core_0_2 = amdaie.core(%tile_0_2) {
+        %cst = arith.constant dense<0> : vector<16xi32>
+        aie.put_cascade(%cst : vector<16xi32>)
+        amdaie.end
+      }
+      %core_1_2 = amdaie.core(%tile_1_2) {
+        %0 = aie.get_cascade() : vector<16xi32>
+        aie.put_cascade(%0 : vector<16xi32>)
+        amdaie.end
+      }
+      %core_2_2 = amdaie.core(%tile_2_2) {
+        %0 = aie.get_cascade() : vector<16xi32>
+        amdaie.end
+      }
+      amdaie.controlcode {
+        amdaie.end
+      }
+    }
+    return
+  }
+}
+
+// -----
+
+module {
+  func.func @cascade_without_receiver() {
+    %c0 = arith.constant 0 : index
+    %c2 = arith.constant 2 : index
+    amdaie.workgroup {
+      %tile_0_2 = amdaie.tile(%c0, %c2)
+      // expected-error @+2 {{no tile east of it to receive them}}
+      // expected-error @+1 {{could not convert to AIEDialect ops}}
+      %core_0_2 = amdaie.core(%tile_0_2) {
+        %cst = arith.constant dense<0> : vector<16xi32>
+        aie.put_cascade(%cst : vector<16xi32>)
+        amdaie.end
+      }
+      amdaie.controlcode {
+        amdaie.end
+      }
+    }
+    return
+  }
+}
+
+// -----
+
+module {
+  func.func @cascade_without_sender() {
+    %c0 = arith.constant 0 : index
+    %c2 = arith.constant 2 : index
+    amdaie.workgroup {
+      %tile_0_2 = amdaie.tile(%c0, %c2)
+      // expected-error @+2 {{no tile west of it to send them}}
+      // expected-error @+1 {{could not convert to AIEDialect ops}}
+      %core_0_2 = amdaie.core(%tile_0_2) {
+        %0 = aie.get_cascade() : vector<16xi32>
+        amdaie.end
+      }
+      amdaie.controlcode {
+        amdaie.end
+      }
+    }
+    return
+  }
+}
+
+// -----
+
 // CHECK:       func.func @hal_bindings
 // CHECK-SAME:  %{{.+}}: memref<32x1024xi32>
 // CHECK-SAME:  %{{.+}}: memref<1024x64xi32>
@@ -53,6 +148,50 @@ module {
 
 // -----
 
+// Verify that a contiguous slice of an L2 buffer accessed by a single DMA,
+// which isn't part of a transfer distributed over multiple shim tiles, keeps
+// its access pattern and the objectFifo carries the whole buffer.
+//
+// CHECK:       aie.device
+// CHECK-DAG:   %[[TILE_0_2:.+]] = aie.tile(0, 2)
+// CHECK-DAG:   %[[TILE_0_1:.+]] = aie.tile(0, 1)
+// CHECK-DAG:   %[[TILE_0_0:.+]] = aie.tile(0, 0)
+// CHECK:       aie.objectfifo @[[OBJ0:.+]](%[[TILE_0_1]], {%[[TILE_0_2]]}
+// CHECK-SAME:  !aie.objectfifo<memref<1024xi32, 1>>
+// CHECK-NEXT:  aie.objectfifo @[[OBJ1:.+]](%[[TILE_0_0]], {%[[TILE_0_1]] fromStream [<size = 512, stride = 1>]}
+// CHECK-SAME:  !aie.objectfifo<memref<1024xi32, 1>>
+// CHECK-NEXT:  aie.objectfifo.link [@[[OBJ1]]] -> [@[[OBJ0]]]
+// CHECK:       func.func @circular_dma_cpy_nd_slice_not_distributed
+module {
+  func.func @circular_dma_cpy_nd_slice_not_distributed() {
+    amdaie.workgroup {
+      %c0 = arith.constant 0 : index
+      %c1 = arith.constant 1 : index
+      %c2 = arith.constant 2 : index
+      %tile_0_0 = amdaie.tile(%c0, %c0)
+      %tile_0_1 = amdaie.tile(%c0, %c1)
+      %tile_0_2 = amdaie.tile(%c0, %c2)
+      %alloc_0 = memref.alloc() : memref<32x64xi32>
+      %alloc_1 = memref.alloc() : memref<32x32xi32, 1>
+      %alloc_2 = memref.alloc() : memref<32x32xi32, 2>
+      %obj0 = amdaie.logicalobjectfifo.from_memref %alloc_0, {%tile_0_0} : memref<32x64xi32> -> !amdaie.logicalobjectfifo<memref<32x64xi32>>
+      %obj1 = amdaie.logicalobjectfifo.from_memref %alloc_1, {%tile_0_1} : memref<32x32xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x32xi32, 1>>
+      %obj2 = amdaie.logicalobjectfifo.from_memref %alloc_2, {%tile_0_2} : memref<32x32xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x32xi32, 2>>
+      %dma0 = amdaie.circular_dma_cpy_nd(%obj2[] [] [], %obj1[] [] []) : (!amdaie.logicalobjectfifo<memref<32x32xi32, 2>>, !amdaie.logicalobjectfifo<memref<32x32xi32, 1>>)
+      %dma1 = amdaie.circular_dma_cpy_nd(%obj1[0] [512] [1], %obj0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x32xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x64xi32>>)
+      memref.dealloc %alloc_2 : memref<32x32xi32, 2>
+      memref.dealloc %alloc_1 : memref<32x32xi32, 1>
+      memref.dealloc %alloc_0 : memref<32x64xi32>
+      amdaie.controlcode {
+        amdaie.end
+      }
+    }
+    return
+  }
+}
+
+// -----
+
 // NOTE: Due to an AIE check that verifies whether aie.objectfifo is linked correctly,
 // this test checks two `amdaie.circular_dma_cpy_nd` operations, so they can be linked
 // correctly.
@@ -97,6 +236,56 @@ module {
 
 // -----
 
+// Verify that DMAs filling contiguous slices of an L2 buffer from shim tiles
+// in different columns result in objectFifos carrying just those slices,
+// joined by the link in the order of their offsets.
+//
+// CHECK:       aie.device
+// CHECK-DAG:   %[[TILE_0_2:.+]] = aie.tile(0, 2)
+// CHECK-DAG:   %[[TILE_0_1:.+]] = aie.tile(0, 1)
+// CHECK-DAG:   %[[TILE_0_0:.+]] = aie.tile(0, 0)
+// CHECK-DAG:   %[[TILE_1_0:.+]] = aie.tile(1, 0)
+// CHECK:       aie.objectfifo @[[OBJ0:.+]](%[[TILE_0_1]], {%[[TILE_0_2]]}
+// CHECK-SAME:  !aie.objectfifo<memref<1024xi32, 1>>
+// CHECK-NEXT:  aie.objectfifo @[[OBJ1:.+]](%[[TILE_1_0]], {%[[TILE_0_1]]}
+// CHECK-SAME:  !aie.objectfifo<memref<512xi32, 1>>
+// CHECK-NEXT:  aie.objectfifo @[[OBJ2:.+]](%[[TILE_0_0]], {%[[TILE_0_1]]}
+// CHECK-SAME:  !aie.objectfifo<memref<512xi32, 1>>
+// CHECK-NEXT:  aie.objectfifo.link [@[[OBJ2]], @[[OBJ1]]] -> [@[[OBJ0]]]
+// CHECK:       func.func @circular_dma_cpy_nd_join_slices
+module {
+  func.func @circular_dma_cpy_nd_join_slices() {
+    amdaie.workgroup {
+      %c0 = arith.constant 0 : index
+      %c1 = arith.constant 1 : index
+      %c2 = arith.constant 2 : index
+      %tile_0_0 = amdaie.tile(%c0, %c0)
+      %tile_1_0 = amdaie.tile(%c1, %c0)
+      %tile_0_1 = amdaie.tile(%c0, %c1)
+      %tile_0_2 = amdaie.tile(%c0, %c2)
+      %alloc_0 = memref.alloc() : memref<32x64xi32>
+      %alloc_1 = memref.alloc() : memref<32x32xi32, 1>
+      %alloc_2 = memref.alloc() : memref<32x32xi32, 2>
+      %obj0 = amdaie.logicalobjectfifo.from_memref %alloc_0, {%tile_0_0} : memref<32x64xi32> -> !amdaie.logicalobjectfifo<memref<32x64xi32>>
+      %obj1 = amdaie.logicalobjectfifo.from_memref %alloc_0, {%tile_1_0} : memref<32x64xi32> -> !amdaie.logicalobjectfifo<memref<32x64xi32>>
+      %obj2 = amdaie.logicalobjectfifo.from_memref %alloc_1, {%tile_0_1} : memref<32x32xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x32xi32, 1>>
+      %obj3 = amdaie.logicalobjectfifo.from_memref %alloc_2, {%tile_0_2} : memref<32x32xi32, 2> -> !amdaie.logicalobjectfifo<memref<32x32xi32, 2>>
+      %dma0 = amdaie.circular_dma_cpy_nd(%obj3[] [] [], %obj2[] [] []) : (!amdaie.logicalobjectfifo<memref<32x32xi32, 2>>, !amdaie.logicalobjectfifo<memref<32x32xi32, 1>>)
+      %dma1 = amdaie.circular_dma_cpy_nd(%obj2[512] [512] [1], %obj1[] [] []) : (!amdaie.logicalobjectfifo<memref<32x32xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x64xi32>>)
+      %dma2 = amdaie.circular_dma_cpy_nd(%obj2[0] [512] [1], %obj0[] [] []) : (!amdaie.logicalobjectfifo<memref<32x32xi32, 1>>, !amdaie.logicalobjectfifo<memref<32x64xi32>>)
+      memref.dealloc %alloc_2 : memref<32x32xi32, 2>
+      memref.dealloc %alloc_1 : memref<32x32xi32, 1>
+      memref.dealloc %alloc_0 : memref<32x64xi32>
+      amdaie.controlcode {
+        amdaie.end
+      }
+    }
+    return
+  }
+}
+
+// -----
+
 // NOTE: Due to an AIE check that verifies whether aie.objectfifo is linked correctly,
 // this test checks two `amdaie.circular_dma_cpy_nd` operations, so they can be linked
 // correctly.
@@ -451,3 +640,93 @@ module {
     return
   }
 }
+
+// -----
+
+// CHECK:       aie.device
+// CHECK-NOT:   hal.interface.constant.load
+// CHECK:       func.func @controlcode_runtime_sizes
+// CHECK-SAME:  %[[ARG0:.+]]: memref<?x64xi32>
+// CHECK-NOT:     arith.divui
+// CHECK:         aiex.npu.dma_memcpy_nd
+// CHECK-SAME:    %[[ARG0]]
+// CHECK-SAME:    [1, 1, 0, 0]
+// CHECK-SAME:    [1, 1, 1, 32]
+// CHECK-SAME:    [1, 1, 64]
+// CHECK-SAME:    amdaie.runtime_sizes = [{addend = -31 : i64, dim = 2 : i64, divisor = 32 : i64, multiplier = 1 : i64, ordinal = 0 : i64}]
+// CHECK-NEXT:    aiex.npu.dma_wait
+module {
+  func.func @controlcode_runtime_sizes() {
+    amdaie.workgroup {
+      %c0 = arith.constant 0 : index
+      %c1 = arith.constant 1 : index
+      %c2 = arith.constant 2 : index
+      %c32 = arith.constant 32 : index
+      %c64 = arith.constant 64 : index
+      %0 = hal.interface.constant.load[0] : i32
+      %1 = arith.index_cast %0 : i32 to index
+      %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) alignment(64) offset(%c0) : memref<?x64xi32>{%1}
+      memref.assume_alignment %2, 64 : memref<?x64xi32>
+      %tile_0_0 = amdaie.tile(%c0, %c0)
+      %tile_0_1 = amdaie.tile(%c0, %c1)
+      %tile_0_2 = amdaie.tile(%c0, %c2)
+      %alloc_1 = memref.alloc() : memref<32x32xi32, 1>
+      %alloc_2 = memref.alloc() : memref<4x8x4x8xi32, 2>
+      %obj0 = amdaie.logicalobjectfifo.from_memref %2, {%tile_0_0} : memref<?x64xi32> -> !amdaie.logicalobjectfifo<memref<?x64xi32>>
+      %obj1 = amdaie.logicalobjectfifo.from_memref %alloc_1, {%tile_0_1} : memref<32x32xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x32xi32, 1>>
+      %obj2 = amdaie.logicalobjectfifo.from_memref %alloc_2, {%tile_0_2} : memref<4x8x4x8xi32, 2> -> !amdaie.logicalobjectfifo<memref<4x8x4x8xi32, 2>>
+      %dma0 = amdaie.circular_dma_cpy_nd(%obj1[] [] [], %obj2[] [] []) : (!amdaie.logicalobjectfifo<memref<32x32xi32, 1>>, !amdaie.logicalobjectfifo<memref<4x8x4x8xi32, 2>>)
+      %dma1 = amdaie.circular_dma_cpy_nd(%obj0[] [] [], %obj1[] [] []) : (!amdaie.logicalobjectfifo<memref<?x64xi32>>, !amdaie.logicalobjectfifo<memref<32x32xi32, 1>>)
+      memref.dealloc %alloc_2 : memref<4x8x4x8xi32, 2>
+      memref.dealloc %alloc_1 : memref<32x32xi32, 1>
+      amdaie.controlcode {
+        %3 = arith.divui %1, %c32 : index
+        %npu_dma = amdaie.npu.dma_cpy_nd %dma1([%c0, %c0] [%3, %c32] [%c64, %c1], [] [] [])
+        amdaie.npu.dma_wait(%npu_dma, S2MM)
+        amdaie.end
+      }
+    }
+    return
+  }
+}
+
+// -----
+
+// Verify that a push constant used by an operation which couldn't be converted
+// results in an error instead of that operation being erased.
+module {
+  func.func @controlcode_unconverted_push_constant() {
+    amdaie.workgroup {
+      %c0 = arith.constant 0 : index
+      %c1 = arith.constant 1 : index
+      %c2 = arith.constant 2 : index
+      %c32 = arith.constant 32 : index
+      %c64 = arith.constant 64 : index
+      %0 = hal.interface.constant.load[0] : i32
+      %1 = arith.index_cast %0 : i32 to index
+      %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) alignment(64) offset(%c0) : memref<32x64xi32>
+      memref.assume_alignment %2, 64 : memref<32x64xi32>
+      %tile_0_0 = amdaie.tile(%c0, %c0)
+      %tile_0_1 = amdaie.tile(%c0, %c1)
+      %tile_0_2 = amdaie.tile(%c0, %c2)
+      %alloc_1 = memref.alloc() : memref<32x32xi32, 1>
+      %alloc_2 = memref.alloc() : memref<4x8x4x8xi32, 2>
+      %obj0 = amdaie.logicalobjectfifo.from_memref %2, {%tile_0_0} : memref<32x64xi32> -> !amdaie.logicalobjectfifo<memref<32x64xi32>>
+      %obj1 = amdaie.logicalobjectfifo.from_memref %alloc_1, {%tile_0_1} : memref<32x32xi32, 1> -> !amdaie.logicalobjectfifo<memref<32x32xi32, 1>>
+      %obj2 = amdaie.logicalobjectfifo.from_memref %alloc_2, {%tile_0_2} : memref<4x8x4x8xi32, 2> -> !amdaie.logicalobjectfifo<memref<4x8x4x8xi32, 2>>
+      %dma0 = amdaie.circular_dma_cpy_nd(%obj1[] [] [], %obj2[] [] []) : (!amdaie.logicalobjectfifo<memref<32x32xi32, 1>>, !amdaie.logicalobjectfifo<memref<4x8x4x8xi32, 2>>)
+      %dma1 = amdaie.circular_dma_cpy_nd(%obj0[] [] [], %obj1[] [] []) : (!amdaie.logicalobjectfifo<memref<32x64xi32>>, !amdaie.logicalobjectfifo<memref<32x32xi32, 1>>)
+      memref.dealloc %alloc_2 : memref<4x8x4x8xi32, 2>
+      memref.dealloc %alloc_1 : memref<32x32xi32, 1>
+      amdaie.controlcode {
+        // expected-error @+1 {{depends on a HAL binding or push constant in a way that can't be lowered to AIE}}
+        scf.for %arg0 = %c0 to %1 step %c1 {
+          %npu_dma = amdaie.npu.dma_cpy_nd %dma1([%c0, %c0] [%c32, %c32] [%c64, %c1], [] [] [])
+          amdaie.npu.dma_wait(%npu_dma, S2MM)
+        }
+        amdaie.end
+      }
+    }
+    return
+  }
+}
@@ -130,6 +130,148 @@ module {
 
 // -----
 
+#executable_target_amdaie_xclbin_fb = #hal.executable.target<"amd-aie", "amdaie-xclbin-fb", {target_arch = "chip-tbd", ukernels = "all"}>
+#map = affine_map<(d0, d1, d2, d3, d4, d5) -> (d2, d0, d3, d5)>
+#map1 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>
+#map2 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d0, d3, d4)>
+module {
+  func.func @generic_matmul_i8i8i32_pad_pack(%arg0: tensor<?x?x?x?xi8>, %arg1: tensor<?x?x?x?xi8>, %arg2: tensor<?x?x?x?xi32>) -> tensor<?x?x?x?xi32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %0 = linalg.generic {indexing_maps = [#map, #map1, #map2],
+                         iterator_types = ["parallel", "parallel", "reduction",
+                         "parallel", "parallel", "reduction"]
+                        } ins(%arg0, %arg1 : tensor<?x?x?x?xi8>, tensor<?x?x?x?xi8>)
+                          outs(%arg2 : tensor<?x?x?x?xi32>) {
+    ^bb0(%in: i8, %in_0: i8, %out: i32):
+      %1 = arith.extsi %in : i8 to i32
+      %2 = arith.extsi %in_0 : i8 to i32
+      %3 = arith.muli %1, %2 : i32
+      %4 = arith.addi %out, %3 : i32
+      linalg.yield %4 : i32
+    } -> tensor<?x?x?x?xi32>
+    return %0 : tensor<?x?x?x?xi32>
+  }
+}
+//      CHECK: func @generic_matmul_i8i8i32_pad_pack(
+//      CHECK:   iree_codegen.ukernel.generic "matmul_i8_i32"
+// CHECK-SAME:       fn_def_attrs {link_with = "/custom/path/to/ukernels/mm.o"}
+
+// -----
+
+// Tile shapes with a dedicated microkernel variant select that variant. Other
+// static tile shapes fall back to the generic microkernel from
+// `path-to-ukernels`, which is compiled for the tile shape in use.
+#executable_target_amdaie_xclbin_fb = #hal.executable.target<"amd-aie", "amdaie-xclbin-fb", {target_arch = "chip-tbd", ukernels = "all"}>
+#map = affine_map<(d0, d1, d2, d3, d4, d5) -> (d2, d0, d3, d5)>
+#map1 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>
+#map2 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d0, d3, d4)>
+module {
+  func.func @matmul_shape_specialized(%arg0: tensor<8x16x4x8xbf16>, %arg1: tensor<16x8x8x4xbf16>, %arg2: tensor<16x16x4x4xf32>) -> tensor<16x16x4x4xf32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %0 = linalg.generic {indexing_maps = [#map, #map1, #map2],
+                         iterator_types = ["parallel", "parallel", "reduction",
+                         "parallel", "parallel", "reduction"]
+                        } ins(%arg0, %arg1 : tensor<8x16x4x8xbf16>, tensor<16x8x8x4xbf16>)
+                          outs(%arg2 : tensor<16x16x4x4xf32>) {
+    ^bb0(%in: bf16, %in_0: bf16, %out: f32):
+      %1 = arith.extf %in : bf16 to f32
+      %2 = arith.extf %in_0 : bf16 to f32
+      %3 = arith.mulf %1, %2 : f32
+      %4 = arith.addf %out, %3 : f32
+      linalg.yield %4 : f32
+    } -> tensor<16x16x4x4xf32>
+    return %0 : tensor<16x16x4x4xf32>
+  }
+  func.func @matmul_shape_fallback(%arg0: tensor<2x6x4x8xbf16>, %arg1: tensor<6x2x8x4xbf16>, %arg2: tensor<6x6x4x4xf32>) -> tensor<6x6x4x4xf32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %0 = linalg.generic {indexing_maps = [#map, #map1, #map2],
+                         iterator_types = ["parallel", "parallel", "reduction",
+                         "parallel", "parallel", "reduction"]
+                        } ins(%arg0, %arg1 : tensor<2x6x4x8xbf16>, tensor<6x2x8x4xbf16>)
+                          outs(%arg2 : tensor<6x6x4x4xf32>) {
+    ^bb0(%in: bf16, %in_0: bf16, %out: f32):
+      %1 = arith.extf %in : bf16 to f32
+      %2 = arith.extf %in_0 : bf16 to f32
+      %3 = arith.mulf %1, %2 : f32
+      %4 = arith.addf %out, %3 : f32
+      linalg.yield %4 : f32
+    } -> tensor<6x6x4x4xf32>
+    return %0 : tensor<6x6x4x4xf32>
+  }
+}
+//      CHECK: func @matmul_shape_specialized(
+//      CHECK:   iree_codegen.ukernel.generic "matmul_bf16_f32_64x64x64"
+// CHECK-SAME:       fn_def_attrs {link_with = "/custom/path/to/ukernels/mm.o"}
+//      CHECK: func @matmul_shape_fallback(
+//      CHECK:   iree_codegen.ukernel.generic "matmul_bf16_f32"
+// CHECK-SAME:       fn_def_attrs {link_with = "/custom/path/to/ukernels/mm.o"}
+
+// -----
+
+// A transposed rhs is only supported by the shape-specialized variants, so
+// there is no microkernel for a transposed rhs with an unsupported tile shape.
+// The variants expect the N x K blocks of the rhs in row-major order, so there
+// is none for K x N blocks either.
+#executable_target_amdaie_xclbin_fb = #hal.executable.target<"amd-aie", "amdaie-xclbin-fb", {target_arch = "chip-tbd", ukernels = "all"}>
+#map = affine_map<(d0, d1, d2, d3, d4, d5) -> (d2, d0, d3, d5)>
+#map1 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d4, d5)>
+#map2 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d0, d3, d4)>
+#map3 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d2, d1, d4, d5)>
+module {
+  func.func @matmul_transpose_b_specialized(%arg0: tensor<4x8x4x8xbf16>, %arg1: tensor<8x4x4x8xbf16>, %arg2: tensor<8x8x4x4xf32>) -> tensor<8x8x4x4xf32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %0 = linalg.generic {indexing_maps = [#map, #map1, #map2],
+                         iterator_types = ["parallel", "parallel", "reduction",
+                         "parallel", "parallel", "reduction"]
+                        } ins(%arg0, %arg1 : tensor<4x8x4x8xbf16>, tensor<8x4x4x8xbf16>)
+                          outs(%arg2 : tensor<8x8x4x4xf32>) {
+    ^bb0(%in: bf16, %in_0: bf16, %out: f32):
+      %1 = arith.extf %in : bf16 to f32
+      %2 = arith.extf %in_0 : bf16 to f32
+      %3 = arith.mulf %1, %2 : f32
+      %4 = arith.addf %out, %3 : f32
+      linalg.yield %4 : f32
+    } -> tensor<8x8x4x4xf32>
+    return %0 : tensor<8x8x4x4xf32>
+  }
+  func.func @matmul_transpose_b_unsupported(%arg0: tensor<2x6x4x8xbf16>, %arg1: tensor<6x2x4x8xbf16>, %arg2: tensor<6x6x4x4xf32>) -> tensor<6x6x4x4xf32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %0 = linalg.generic {indexing_maps = [#map, #map1, #map2],
+                         iterator_types = ["parallel", "parallel", "reduction",
+                         "parallel", "parallel", "reduction"]
+                        } ins(%arg0, %arg1 : tensor<2x6x4x8xbf16>, tensor<6x2x4x8xbf16>)
+                          outs(%arg2 : tensor<6x6x4x4xf32>) {
+    ^bb0(%in: bf16, %in_0: bf16, %out: f32):
+      %1 = arith.extf %in : bf16 to f32
+      %2 = arith.extf %in_0 : bf16 to f32
+      %3 = arith.mulf %1, %2 : f32
+      %4 = arith.addf %out, %3 : f32
+      linalg.yield %4 : f32
+    } -> tensor<6x6x4x4xf32>
+    return %0 : tensor<6x6x4x4xf32>
+  }
+  func.func @matmul_transpose_b_column_major_blocks(%arg0: tensor<4x8x4x8xbf16>, %arg1: tensor<4x8x4x8xbf16>, %arg2: tensor<8x8x4x4xf32>) -> tensor<8x8x4x4xf32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %0 = linalg.generic {indexing_maps = [#map, #map3, #map2],
+                         iterator_types = ["parallel", "parallel", "reduction",
+                         "parallel", "parallel", "reduction"]
+                        } ins(%arg0, %arg1 : tensor<4x8x4x8xbf16>, tensor<4x8x4x8xbf16>)
+                          outs(%arg2 : tensor<8x8x4x4xf32>) {
+    ^bb0(%in: bf16, %in_0: bf16, %out: f32):
+      %1 = arith.extf %in : bf16 to f32
+      %2 = arith.extf %in_0 : bf16 to f32
+      %3 = arith.mulf %1, %2 : f32
+      %4 = arith.addf %out, %3 : f32
+      linalg.yield %4 : f32
+    } -> tensor<8x8x4x4xf32>
+    return %0 : tensor<8x8x4x4xf32>
+  }
+}
+//      CHECK: func @matmul_transpose_b_specialized(
+//      CHECK:   iree_codegen.ukernel.generic "matmul_bf16_f32_32x32x32_bT"
+//      CHECK: func @matmul_transpose_b_unsupported(
+//      CHECK:   linalg.generic
+//  CHECK-NOT:   iree_codegen.ukernel.generic
+//      CHECK: func @matmul_transpose_b_column_major_blocks(
+//      CHECK:   linalg.generic
+//  CHECK-NOT:   iree_codegen.ukernel.generic
+
+// -----
+
 func.func @zero_fill(%arg0 : tensor<?x?x?x?xbf16>) -> tensor<?x?x?x?xbf16> attributes {
   hal.executable.target = #hal.executable.target<"amd-aie", "amdaie-xclbin-fb", {target_arch = "chip-tbd", ukernels = "all"}>
 } {
@@ -161,6 +303,30 @@ func.func @non_zero_fill(%arg0 : tensor<?x?x?x?xbf16>) -> tensor<?x?x?x?xbf16> a
 
 // -----
 
+// Zero fills of a static size with a dedicated microkernel variant select that
+// variant. Like for matmuls, other sizes only fall back to the generic
+// microkernel from `path-to-ukernels`.
+#executable_target_amdaie_xclbin_fb = #hal.executable.target<"amd-aie", "amdaie-xclbin-fb", {target_arch = "chip-tbd", ukernels = "all"}>
+module {
+  func.func @zero_fill_size_specialized(%arg0 : tensor<1x1x8x8x4x4xf32>) -> tensor<1x1x8x8x4x4xf32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %cst = arith.constant 0.0 : f32
+    %fill = linalg.fill ins(%cst : f32) outs(%arg0 : tensor<1x1x8x8x4x4xf32>) -> tensor<1x1x8x8x4x4xf32>
+    return %fill : tensor<1x1x8x8x4x4xf32>
+  }
+  func.func @zero_fill_size_fallback(%arg0 : tensor<1x1x6x6x4x4xf32>) -> tensor<1x1x6x6x4x4xf32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %cst = arith.constant 0.0 : f32
+    %fill = linalg.fill ins(%cst : f32) outs(%arg0 : tensor<1x1x6x6x4x4xf32>) -> tensor<1x1x6x6x4x4xf32>
+    return %fill : tensor<1x1x6x6x4x4xf32>
+  }
+}
+//      CHECK: func @zero_fill_size_specialized(
+//      CHECK:   iree_codegen.ukernel.generic "zero_f32_1024"
+//      CHECK: func @zero_fill_size_fallback(
+//      CHECK:   iree_codegen.ukernel.generic "zero_f32"
+// CHECK-SAME:       fn_def_attrs {link_with = "/custom/path/to/ukernels/mm.o"}
+
+// -----
+
 func.func @zero_fill_with_matmul(%arg0 : tensor<?x?x?x?xbf16>, %arg1 : tensor<?x?x?x?xbf16>,
     %arg2 : tensor<?x?x?x?xbf16>) -> tensor<?x?x?x?xbf16> attributes {
   hal.executable.target = #hal.executable.target<"amd-aie", "amdaie-xclbin-fb", {target_arch = "chip-tbd", ukernels = "all"}>
@@ -0,0 +1,132 @@
+// RUN: iree-opt --split-input-file --pass-pipeline="builtin.module(func.func(iree-amdaie-lower-to-ukernels,cse,canonicalize))" --verify-diagnostics %s | FileCheck %s
+
+// Without `path-to-ukernels`, `link_with` is only the name of the object file,
+// which is resolved against the bundled microkernel library. The library has
+// a variant for every L1 tile shape chosen by the pack-peel heuristic for
+// power-of-two matmul sizes.
+#executable_target_amdaie_xclbin_fb = #hal.executable.target<"amd-aie", "amdaie-xclbin-fb", {target_arch = "chip-tbd", ukernels = "all"}>
+#map = affine_map<(d0, d1, d2, d3, d4, d5) -> (d2, d0, d3, d5)>
+#map1 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>
+#map2 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d0, d3, d4)>
+module {
+  func.func @matmul_i8_64x64x64(%arg0: tensor<8x16x4x8xi8>, %arg1: tensor<8x8x8x8xi8>, %arg2: tensor<8x16x4x8xi32>) -> tensor<8x16x4x8xi32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %0 = linalg.generic {indexing_maps = [#map, #map1, #map2],
+                         iterator_types = ["parallel", "parallel", "reduction",
+                         "parallel", "parallel", "reduction"]
+                        } ins(%arg0, %arg1 : tensor<8x16x4x8xi8>, tensor<8x8x8x8xi8>)
+                          outs(%arg2 : tensor<8x16x4x8xi32>) {
+    ^bb0(%in: i8, %in_0: i8, %out: i32):
+      %1 = arith.extsi %in : i8 to i32
+      %2 = arith.extsi %in_0 : i8 to i32
+      %3 = arith.muli %1, %2 : i32
+      %4 = arith.addi %out, %3 : i32
+      linalg.yield %4 : i32
+    } -> tensor<8x16x4x8xi32>
+    return %0 : tensor<8x16x4x8xi32>
+  }
+  func.func @matmul_bf16_16x16x16(%arg0: tensor<2x4x4x8xbf16>, %arg1: tensor<4x2x8x4xbf16>, %arg2: tensor<4x4x4x4xf32>) -> tensor<4x4x4x4xf32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %0 = linalg.generic {indexing_maps = [#map, #map1, #map2],
+                         iterator_types = ["parallel", "parallel", "reduction",
+                         "parallel", "parallel", "reduction"]
+                        } ins(%arg0, %arg1 : tensor<2x4x4x8xbf16>, tensor<4x2x8x4xbf16>)
+                          outs(%arg2 : tensor<4x4x4x4xf32>) {
+    ^bb0(%in: bf16, %in_0: bf16, %out: f32):
+      %1 = arith.extf %in : bf16 to f32
+      %2 = arith.extf %in_0 : bf16 to f32
+      %3 = arith.mulf %1, %2 : f32
+      %4 = arith.addf %out, %3 : f32
+      linalg.yield %4 : f32
+    } -> tensor<4x4x4x4xf32>
+    return %0 : tensor<4x4x4x4xf32>
+  }
+}
+//      CHECK: func @matmul_i8_64x64x64(
+//      CHECK:   iree_codegen.ukernel.generic "matmul_i8_i32_64x64x64"
+// CHECK-SAME:       fn_def_attrs {link_with = "mm.o"}
+//      CHECK: func @matmul_bf16_16x16x16(
+//      CHECK:   iree_codegen.ukernel.generic "matmul_bf16_f32_16x16x16"
+// CHECK-SAME:       fn_def_attrs {link_with = "mm.o"}
+
+// -----
+
+// The generic microkernels of the bundled library are only compiled for a
+// 64x64x64 tile, so a tile of unknown shape has no microkernel and is left to
+// code generation.
+func.func @matmul_dynamic_shape(%arg0 : tensor<?x?x?x?xbf16>, %arg1 : tensor<?x?x?x?xbf16>,
+    %arg2 : tensor<?x?x?x?xf32>) -> tensor<?x?x?x?xf32> attributes {
+  hal.executable.target = #hal.executable.target<"amd-aie", "amdaie-xclbin-fb", {target_arch = "chip-tbd", ukernels = "all"}>
+} {
+  // expected-remark @+1 {{has no matmul microkernel for its element types, tile shape and rhs layout in the bundled microkernel library, falling back to code generation}}
+  %0 = linalg.generic {indexing_maps = [affine_map<(d0, d1, d2, d3, d4, d5) -> (d2, d0, d3, d5)>,
+                                        affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>,
+                                        affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d0, d3, d4)>],
+                       iterator_types = ["parallel", "parallel", "reduction",
+                                         "parallel", "parallel", "reduction"]
+                      } ins(%arg0, %arg1 : tensor<?x?x?x?xbf16>, tensor<?x?x?x?xbf16>)
+                        outs(%arg2 : tensor<?x?x?x?xf32>)
+      {
+        ^bb0(%in: bf16, %in_0: bf16, %out: f32):
+          %1 = arith.extf %in : bf16 to f32
+          %2 = arith.extf %in_0 : bf16 to f32
+          %3 = arith.mulf %1, %2 : f32
+          %4 = arith.addf %out, %3 : f32
+          linalg.yield %4 : f32
+      } -> tensor<?x?x?x?xf32>
+  return %0 : tensor<?x?x?x?xf32>
+}
+//      CHECK: func @matmul_dynamic_shape(
+//      CHECK:   linalg.generic
+//  CHECK-NOT:   iree_codegen.ukernel.generic
+
+// -----
+
+// A tile shape which isn't chosen by the tiling heuristics, here 24x24x16, has
+// no microkernel either.
+#executable_target_amdaie_xclbin_fb = #hal.executable.target<"amd-aie", "amdaie-xclbin-fb", {target_arch = "chip-tbd", ukernels = "all"}>
+#map = affine_map<(d0, d1, d2, d3, d4, d5) -> (d2, d0, d3, d5)>
+#map1 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d2, d5, d4)>
+#map2 = affine_map<(d0, d1, d2, d3, d4, d5) -> (d1, d0, d3, d4)>
+module {
+  func.func @matmul_unsupported_shape(%arg0: tensor<2x6x4x8xbf16>, %arg1: tensor<6x2x8x4xbf16>, %arg2: tensor<6x6x4x4xf32>) -> tensor<6x6x4x4xf32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    // expected-remark @+1 {{has no matmul microkernel for its element types, tile shape and rhs layout in the bundled microkernel library, falling back to code generation}}
+    %0 = linalg.generic {indexing_maps = [#map, #map1, #map2],
+                         iterator_types = ["parallel", "parallel", "reduction",
+                         "parallel", "parallel", "reduction"]
+                        } ins(%arg0, %arg1 : tensor<2x6x4x8xbf16>, tensor<6x2x8x4xbf16>)
+                          outs(%arg2 : tensor<6x6x4x4xf32>) {
+    ^bb0(%in: bf16, %in_0: bf16, %out: f32):
+      %1 = arith.extf %in : bf16 to f32
+      %2 = arith.extf %in_0 : bf16 to f32
+      %3 = arith.mulf %1, %2 : f32
+      %4 = arith.addf %out, %3 : f32
+      linalg.yield %4 : f32
+    } -> tensor<6x6x4x4xf32>
+    return %0 : tensor<6x6x4x4xf32>
+  }
+}
+//      CHECK: func @matmul_unsupported_shape(
+//      CHECK:   linalg.generic
+//  CHECK-NOT:   iree_codegen.ukernel.generic
+
+// -----
+
+// Zero fills of a size without a microkernel are left to code generation.
+#executable_target_amdaie_xclbin_fb = #hal.executable.target<"amd-aie", "amdaie-xclbin-fb", {target_arch = "chip-tbd", ukernels = "all"}>
+module {
+  func.func @zero_fill_size_specialized(%arg0 : tensor<1x1x8x8x4x4xf32>) -> tensor<1x1x8x8x4x4xf32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %cst = arith.constant 0.0 : f32
+    %fill = linalg.fill ins(%cst : f32) outs(%arg0 : tensor<1x1x8x8x4x4xf32>) -> tensor<1x1x8x8x4x4xf32>
+    return %fill : tensor<1x1x8x8x4x4xf32>
+  }
+  func.func @zero_fill_size_unsupported(%arg0 : tensor<1x1x6x6x4x4xf32>) -> tensor<1x1x6x6x4x4xf32> attributes {hal.executable.target = #executable_target_amdaie_xclbin_fb} {
+    %cst = arith.constant 0.0 : f32
+    %fill = linalg.fill ins(%cst : f32) outs(%arg0 : tensor<1x1x6x6x4x4xf32>) -> tensor<1x1x6x6x4x4xf32>
+    return %fill : tensor<1x1x6x6x4x4xf32>
+  }
+}
+//      CHECK: func @zero_fill_size_specialized(
+//      CHECK:   iree_codegen.ukernel.generic "zero_f32_1024"
+// CHECK-SAME:       fn_def_attrs {link_with = "mm.o"}
+//      CHECK: func @zero_fill_size_unsupported(
+//      CHECK:   linalg.fill
+//  CHECK-NOT:   iree_codegen.ukernel.generic
@@ -0,0 +1,20 @@
+// RUN: iree-opt %s --pass-pipeline='builtin.module(iree-amdaie-lowering-strategy{use-pass-pipeline=pack-peel cascade-k-split=4})' --verify-diagnostics
+
+// The partial sums of a K split are only chained by the objectFifo lowering.
+// expected-error@below {{cascade-k-split > 1 requires the objectFifo lowering (use-objectfifo-lowering)}}
+builtin.module {
+  func.func @matmul_dispatch_0_matmul_64x64x4096_bf16xbf16xf32() {
+    %cst = arith.constant 0.000000e+00 : f32
+    %c0 = arith.constant 0 : index
+    %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) alignment(64) offset(%c0) flags(ReadOnly) : !flow.dispatch.tensor<readonly:tensor<64x4096xbf16>>
+    %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) alignment(64) offset(%c0) flags(ReadOnly) : !flow.dispatch.tensor<readonly:tensor<4096x64xbf16>>
+    %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) alignment(64) offset(%c0) : !flow.dispatch.tensor<writeonly:tensor<64x64xf32>>
+    %3 = flow.dispatch.tensor.load %0, offsets = [0, 0], sizes = [64, 4096], strides = [1, 1] : !flow.dispatch.tensor<readonly:tensor<64x4096xbf16>> -> tensor<64x4096xbf16>
+    %4 = flow.dispatch.tensor.load %1, offsets = [0, 0], sizes = [4096, 64], strides = [1, 1] : !flow.dispatch.tensor<readonly:tensor<4096x64xbf16>> -> tensor<4096x64xbf16>
+    %5 = tensor.empty() : tensor<64x64xf32>
+    %6 = linalg.fill ins(%cst : f32) outs(%5 : tensor<64x64xf32>) -> tensor<64x64xf32>
+    %7 = linalg.matmul ins(%3, %4 : tensor<64x4096xbf16>, tensor<4096x64xbf16>) outs(%6 : tensor<64x64xf32>) -> tensor<64x64xf32>
+    flow.dispatch.tensor.store %7, %2, offsets = [0, 0], sizes = [64, 64], strides = [1, 1] : tensor<64x64xf32> -> !flow.dispatch.tensor<writeonly:tensor<64x64xf32>>
+    return
+  }
+}
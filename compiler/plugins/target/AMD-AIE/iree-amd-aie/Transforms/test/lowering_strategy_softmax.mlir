@@ -0,0 +1,47 @@
+// RUN: iree-opt --split-input-file --pass-pipeline='builtin.module(func.func(iree-amdaie-decompose-softmax),iree-amdaie-lowering-strategy{use-pass-pipeline=pad-pack})' %s | FileCheck %s --check-prefix=CHECK-PAD-PACK
+// RUN: iree-opt --split-input-file --pass-pipeline='builtin.module(func.func(iree-amdaie-decompose-softmax),iree-amdaie-lowering-strategy{use-pass-pipeline=pack-peel})' %s | FileCheck %s --check-prefix=CHECK-PACK-PEEL
+
+// Softmax is decomposed into row reductions and elementwise ops, the rows are
+// distributed over the workgroups and cores independent of the matmul pipeline.
+// CHECK-PAD-PACK{LITERAL}: #config = #iree_codegen.lowering_config<tile_sizes = [[4, 0], [4, 0]]>
+// CHECK-PACK-PEEL{LITERAL}: #config = #iree_codegen.lowering_config<tile_sizes = [[4, 0], [4, 0]]>
+builtin.module {
+  func.func @softmax_dispatch_0_softmax_256x1024_bf16() {
+    %c0 = arith.constant 0 : index
+    %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) alignment(64) offset(%c0) flags(ReadOnly) : !flow.dispatch.tensor<readonly:tensor<256x1024xbf16>>
+    %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) alignment(64) offset(%c0) : !flow.dispatch.tensor<writeonly:tensor<256x1024xbf16>>
+    %2 = flow.dispatch.tensor.load %0, offsets = [0, 0], sizes = [256, 1024], strides = [1, 1] : !flow.dispatch.tensor<readonly:tensor<256x1024xbf16>> -> tensor<256x1024xbf16>
+    %3 = tensor.empty() : tensor<256x1024xbf16>
+    // CHECK-PAD-PACK-NOT:  linalg.softmax
+    // CHECK-PAD-PACK:      lowering_config = #config
+    // CHECK-PACK-PEEL-NOT: linalg.softmax
+    // CHECK-PACK-PEEL:     lowering_config = #config
+    %4 = linalg.softmax dimension(1) ins(%2 : tensor<256x1024xbf16>) outs(%3 : tensor<256x1024xbf16>) -> tensor<256x1024xbf16>
+    flow.dispatch.tensor.store %4, %1, offsets = [0, 0], sizes = [256, 1024], strides = [1, 1] : tensor<256x1024xbf16> -> !flow.dispatch.tensor<writeonly:tensor<256x1024xbf16>>
+    return
+  }
+}
+
+// -----
+
+// A rank-4 softmax has three row dimensions. Only the innermost two are tiled,
+// as there are only two dimensions to map the tiled loops to, the rows of the
+// outermost one are part of every block.
+// CHECK-PAD-PACK{LITERAL}: #config = #iree_codegen.lowering_config<tile_sizes = [[0, 1, 2, 0], [0, 1, 2, 0]]>
+// CHECK-PACK-PEEL{LITERAL}: #config = #iree_codegen.lowering_config<tile_sizes = [[0, 1, 2, 0], [0, 1, 2, 0]]>
+builtin.module {
+  func.func @softmax_dispatch_0_softmax_2x4x64x1024_bf16() {
+    %c0 = arith.constant 0 : index
+    %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) alignment(64) offset(%c0) flags(ReadOnly) : !flow.dispatch.tensor<readonly:tensor<2x4x64x1024xbf16>>
+    %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) alignment(64) offset(%c0) : !flow.dispatch.tensor<writeonly:tensor<2x4x64x1024xbf16>>
+    %2 = flow.dispatch.tensor.load %0, offsets = [0, 0, 0, 0], sizes = [2, 4, 64, 1024], strides = [1, 1, 1, 1] : !flow.dispatch.tensor<readonly:tensor<2x4x64x1024xbf16>> -> tensor<2x4x64x1024xbf16>
+    %3 = tensor.empty() : tensor<2x4x64x1024xbf16>
+    // CHECK-PAD-PACK-NOT:  linalg.softmax
+    // CHECK-PAD-PACK:      lowering_config = #config
+    // CHECK-PACK-PEEL-NOT: linalg.softmax
+    // CHECK-PACK-PEEL:     lowering_config = #config
+    %4 = linalg.softmax dimension(3) ins(%2 : tensor<2x4x64x1024xbf16>) outs(%3 : tensor<2x4x64x1024xbf16>) -> tensor<2x4x64x1024xbf16>
+    flow.dispatch.tensor.store %4, %1, offsets = [0, 0, 0, 0], sizes = [2, 4, 64, 1024], strides = [1, 1, 1, 1] : tensor<2x4x64x1024xbf16> -> !flow.dispatch.tensor<writeonly:tensor<2x4x64x1024xbf16>>
+    return
+  }
+}
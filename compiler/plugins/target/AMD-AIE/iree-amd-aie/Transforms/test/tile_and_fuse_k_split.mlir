@@ -0,0 +1,39 @@
+// RUN: iree-opt --pass-pipeline='builtin.module(func.func(iree-amdaie-tile-and-fuse{tiling-level=2 tile-elementwise=false}))' %s | FileCheck %s
+
+// Second level tiling of the pack-peel pipeline for a 64x64x4096 matmul with K
+// split across 4 cores (see the `cascade-k-split` case of
+// lowering_strategy.mlir). The packed op is tiled along M over thread y and
+// along the packed K blocks over thread x, so each core of a row gets 8 of the
+// 32 K blocks and the whole output tile. The fill isn't fused as a reduction
+// dimension is tiled.
+
+#config = #iree_codegen.lowering_config<tile_sizes = [[64, 64], [0, 0, 1], [1, 0, 0, 0, 0, 8]]>
+#map = affine_map<(d0, d1, d2, d3, d4, d5, d6, d7, d8) -> (d0, d2, d5, d3, d6, d8)>
+#map1 = affine_map<(d0, d1, d2, d3, d4, d5, d6, d7, d8) -> (d1, d2, d4, d5, d8, d7)>
+#map2 = affine_map<(d0, d1, d2, d3, d4, d5, d6, d7, d8) -> (d0, d1, d4, d3, d6, d7)>
+// CHECK-LABEL: @matmul_k_split
+//       CHECK:   linalg.fill
+//       CHECK:   scf.forall (%[[IV0:.+]], %[[IV1:.+]]) = (0, 0) to (2, 32) step (1, 8)
+//   CHECK-DAG:     tensor.extract_slice %{{.+}}[%[[IV0]], 0, %[[IV1]], 0, 0, 0] [1, 1, 8, 8, 4, 8] [1, 1, 1, 1, 1, 1]
+//   CHECK-DAG:     tensor.extract_slice %{{.+}}[0, 0, 0, %[[IV1]], 0, 0] [1, 1, 16, 8, 8, 4] [1, 1, 1, 1, 1, 1]
+//   CHECK-DAG:     tensor.extract_slice %{{.+}}[%[[IV0]], 0, 0, 0, 0, 0] [1, 1, 16, 8, 4, 4] [1, 1, 1, 1, 1, 1]
+//       CHECK:     linalg.generic
+//  CHECK-SAME:       ins(%{{.+}}, %{{.+}} : tensor<1x1x8x8x4x8xbf16>, tensor<1x1x16x8x8x4xbf16>)
+//  CHECK-SAME:       outs(%{{.+}} : tensor<1x1x16x8x4x4xf32>)
+//       CHECK:     scf.forall.in_parallel
+//       CHECK:       tensor.parallel_insert_slice %{{.+}} into %{{.+}}[%[[IV0]], 0, 0, 0, 0, 0] [1, 1, 16, 8, 4, 4] [1, 1, 1, 1, 1, 1]
+//       CHECK:   } {mapping = [#gpu.thread<y>, #gpu.thread<x>]}
+func.func @matmul_k_split(%arg0: tensor<2x1x32x8x4x8xbf16>, %arg1: tensor<1x1x16x32x8x4xbf16>) -> tensor<2x1x16x8x4x4xf32> {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = tensor.empty() : tensor<2x1x16x8x4x4xf32>
+  %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<2x1x16x8x4x4xf32>) -> tensor<2x1x16x8x4x4xf32>
+  %2 = linalg.generic {indexing_maps = [#map, #map1, #map2], iterator_types = ["parallel", "parallel", "reduction", "parallel", "parallel", "reduction", "parallel", "parallel", "reduction"]} ins(%arg0, %arg1 : tensor<2x1x32x8x4x8xbf16>, tensor<1x1x16x32x8x4xbf16>) outs(%1 : tensor<2x1x16x8x4x4xf32>) attrs = {lowering_config = #config} {
+  ^bb0(%in: bf16, %in_0: bf16, %out: f32):
+    %3 = arith.extf %in : bf16 to f32
+    %4 = arith.extf %in_0 : bf16 to f32
+    %5 = arith.mulf %3, %4 : f32
+    %6 = arith.addf %out, %5 : f32
+    linalg.yield %6 : f32
+  } -> tensor<2x1x16x8x4x4xf32>
+  return %2 : tensor<2x1x16x8x4x4xf32>
+}
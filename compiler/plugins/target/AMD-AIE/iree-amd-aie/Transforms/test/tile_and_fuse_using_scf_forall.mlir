@@ -100,3 +100,26 @@ func.func @matmul_bias_add(%arg0 : tensor<?x?xf32>, %arg1 : tensor<?x?xf32>, %ar
 //      TILE-MATMUL-ONLY:       linalg.matmul
 //      TILE-MATMUL-ONLY:   } {mapping = [#gpu.block<y>, #gpu.block<x>]}
 //      TILE-MATMUL-ONLY:   linalg.generic
+
+// -----
+
+// A row reduction with three row dimensions, of which the innermost two are
+// tiled and mapped to y and x.
+func.func @row_reduction_rank_4(%arg0: tensor<2x4x64x1024xf32>) -> tensor<2x4x64xf32> {
+  %cst = arith.constant 0xFF800000 : f32
+  %0 = tensor.empty() : tensor<2x4x64xf32>
+  %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<2x4x64xf32>) -> tensor<2x4x64xf32>
+  %2 = linalg.generic {indexing_maps = [affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>, affine_map<(d0, d1, d2, d3) -> (d0, d1, d2)>], iterator_types = ["parallel", "parallel", "parallel", "reduction"]} ins(%arg0 : tensor<2x4x64x1024xf32>) outs(%1 : tensor<2x4x64xf32>) attrs = {lowering_config = #iree_codegen.lowering_config<tile_sizes = [[0, 1, 2, 0], [0, 1, 2, 0]]>} {
+  ^bb0(%in: f32, %out: f32):
+    %3 = arith.maximumf %in, %out : f32
+    linalg.yield %3 : f32
+  } -> tensor<2x4x64xf32>
+  return %2 : tensor<2x4x64xf32>
+}
+//      TILE-LEVEL-0: @row_reduction_rank_4
+//      TILE-LEVEL-0:   scf.forall (%{{.+}}, %{{.+}}) = (0, 0) to (4, 64) step (1, 2)
+//      TILE-LEVEL-0:     linalg.fill
+// TILE-LEVEL-0-SAME:       tensor<2x1x2xf32>
+//      TILE-LEVEL-0:     linalg.generic
+// TILE-LEVEL-0-SAME:       ins(%{{.+}} : tensor<2x1x2x1024xf32>)
+//      TILE-LEVEL-0:   } {mapping = [#gpu.block<y>, #gpu.block<x>]}
@@ -45,9 +45,9 @@ func.func @matmul_m4_n4_k8_f32_f32(%arg0: tensor<4x8xf32>, %arg1: tensor<8x4xf32
   return %0 : tensor<4x4xf32>
 }
 
-// Test that the currently 'black listed' linalg operations are not vectorized:
-//  - linalg.copy
-//  - linalg.fill
+// Test that linalg.copy and linalg.fill operations are not vectorized if their
+// operands are not known to be in the local memory of a core, as these copies
+// are used to move data between memory spaces with DMAs:
 // CHECK-LABEL: func @fillAndCopy
 func.func @fillAndCopy() -> tensor<8xbf16> {
   // CHECK-NOT: vector
@@ -65,5 +65,67 @@ func.func @fillAndCopy() -> tensor<8xbf16> {
 }
 
 
+// Test that a fill and a copy in the local memory of a core (memory space 2)
+// are vectorized, also for 32-bit element types.
+// CHECK-LABEL: func @fillAndCopyLocal
+func.func @fillAndCopyLocal(%arg0: memref<1x1x4x4xf32, 2 : i32>) -> tensor<1x1x4x4xf32> {
+  // CHECK: vector.transfer_write{{.*}} vector<1x1x4x4xf32>, tensor<1x1x4x4xf32>
+  // CHECK: vector.transfer_read{{.*}} tensor<1x1x4x4xf32>, vector<1x1x4x4xf32>
+  // CHECK: vector.transfer_write{{.*}} vector<1x1x4x4xf32>, tensor<1x1x4x4xf32>
+  %cst = arith.constant 0.000000e+00 : f32
+  %alloc = memref.alloc() : memref<1x1x4x4xf32, 2 : i32>
+  %0 = bufferization.to_tensor %alloc restrict writable : memref<1x1x4x4xf32, 2 : i32>
+  %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<1x1x4x4xf32>) -> tensor<1x1x4x4xf32>
+  %2 = bufferization.to_tensor %arg0 restrict writable : memref<1x1x4x4xf32, 2 : i32>
+  %copy = linalg.copy ins(%1 : tensor<1x1x4x4xf32>) outs(%2 : tensor<1x1x4x4xf32>) -> tensor<1x1x4x4xf32>
+  // CHECK: return
+  return %copy : tensor<1x1x4x4xf32>
 }
 
+// Test that a fill of a buffer in shared memory (memory space 1) is not
+// vectorized.
+// CHECK-LABEL: func @fillShared
+func.func @fillShared() -> tensor<8x16xbf16> {
+  // CHECK-NOT: vector
+  %cst = arith.constant 0.000000e+00 : bf16
+  %alloc = memref.alloc() : memref<8x16xbf16, 1 : i32>
+  %0 = bufferization.to_tensor %alloc restrict writable : memref<8x16xbf16, 1 : i32>
+  %1 = linalg.fill ins(%cst : bf16) outs(%0 : tensor<8x16xbf16>) -> tensor<8x16xbf16>
+  // CHECK: return
+  return %1 : tensor<8x16xbf16>
+}
+
+// Test that an elementwise operation with f32 operands is vectorized.
+// CHECK-LABEL: func @elementwise_add_f32
+func.func @elementwise_add_f32(%arg0: tensor<1x16xf32>, %arg1: tensor<1x16xf32>, %arg2: tensor<1x16xf32>) -> tensor<1x16xf32> {
+  // CHECK-DAG: vector.transfer_read{{.*}} tensor<1x16xf32>, vector<1x16xf32>
+  // CHECK-DAG: vector.transfer_read{{.*}} tensor<1x16xf32>, vector<1x16xf32>
+  // CHECK: arith.addf{{.*}} vector<1x16xf32>
+  // CHECK: vector.transfer_write{{.*}} vector<1x16xf32>, tensor<1x16xf32>
+  %0 = linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0, d1)>], iterator_types = ["parallel", "parallel"]} ins(%arg0, %arg1 : tensor<1x16xf32>, tensor<1x16xf32>) outs(%arg2 : tensor<1x16xf32>) {
+  ^bb0(%in: f32, %in_0: f32, %out: f32):
+    %1 = arith.addf %in, %in_0 : f32
+    linalg.yield %1 : f32
+  } -> tensor<1x16xf32>
+  // CHECK: return
+  return %0 : tensor<1x16xf32>
+}
+
+// Test that a row reduction with f32 operands, e.g. the row sums of a softmax,
+// is vectorized to a vector.multi_reduction operation.
+// CHECK-LABEL: func @row_sum_f32
+func.func @row_sum_f32(%arg0: tensor<4x64xf32>, %arg1: tensor<4xf32>) -> tensor<4xf32> {
+  // CHECK-DAG: vector.transfer_read{{.*}} tensor<4x64xf32>, vector<4x64xf32>
+  // CHECK-DAG: vector.transfer_read{{.*}} tensor<4xf32>, vector<4xf32>
+  // CHECK: vector.multi_reduction <add>{{.*}} [1] : vector<4x64xf32> to vector<4xf32>
+  // CHECK: vector.transfer_write{{.*}} vector<4xf32>, tensor<4xf32>
+  %0 = linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>], iterator_types = ["parallel", "reduction"]} ins(%arg0 : tensor<4x64xf32>) outs(%arg1 : tensor<4xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    %1 = arith.addf %in, %out : f32
+    linalg.yield %1 : f32
+  } -> tensor<4xf32>
+  // CHECK: return
+  return %0 : tensor<4xf32>
+}
+
+}
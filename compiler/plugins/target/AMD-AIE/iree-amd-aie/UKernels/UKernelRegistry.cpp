@@ -0,0 +1,224 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree-amd-aie/UKernels/UKernelRegistry.h"
+
+#include <algorithm>
+#include <array>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "mlir/Support/FileUtilities.h"
+
+#ifdef IREE_AMD_AIE_HAS_BUNDLED_UKERNELS
+#include "iree-amd-aie/UKernels/bundled_ukernels.h"
+#endif
+
+#define DEBUG_TYPE "iree-amdaie-ukernel-registry"
+
+namespace mlir::iree_compiler::AMDAIE {
+
+std::string UKernelDescriptor::getFnName() const {
+  std::string fnName = (name + "_" + elemTypes).str();
+  if (!isGeneric) {
+    fnName += "_";
+    llvm::interleave(
+        tileShape, [&](int64_t size) { fnName += std::to_string(size); },
+        [&] { fnName += "x"; });
+  }
+  if (transposeB) fnName += "_bT";
+  return fnName;
+}
+
+/// The (M, N, K) tile shape the generic matmuls of UKernels/aie2/mm.cc are
+/// compiled for, i.e. the defaults of DIM_M, DIM_N and DIM_K.
+static constexpr std::array<int64_t, 3> kGenericMatmulTileShape = {64, 64, 64};
+
+namespace {
+/// A matmul with a vectorized implementation, see MATMUL_VECTORIZED_COMBOS in
+/// UKernels/aie2/mm.cc.
+struct VectorizedMatmul {
+  StringRef elemTypes;
+  /// Bitwidth of the lhs element type.
+  int64_t lhsBitWidth;
+  /// The (M, N, K) size of the AIE matmul instruction.
+  std::array<int64_t, 3> instructionSize;
+};
+}  // namespace
+
+static const VectorizedMatmul kVectorizedMatmuls[] = {
+    {"bf16_bf16", 16, {4, 4, 8}},
+    {"bf16_f32", 16, {4, 4, 8}},
+    {"i8_i32", 8, {4, 8, 8}}};
+
+/// Returns the (M, N, K) tile shapes with a shape-specialized variant of
+/// `matmul`. These are the L1 tile shapes that the pack-peel heuristic in
+/// KernelDispatch.cpp chooses for matmuls with power-of-two sizes: every
+/// dimension is a power of two of at most 16 * (64 / lhs bitwidth), the
+/// largest L1 tile size of the heuristic. M and N are at least twice the
+/// instruction size, as the kernels compute 2x2 instructions per iteration.
+/// See MATMUL_SHAPE_COMBOS in UKernels/aie2/mm.cc.
+static SmallVector<std::array<int64_t, 3>> getMatmulTileShapes(
+    const VectorizedMatmul &matmul) {
+  int64_t maxSize = 16 * (64 / matmul.lhsBitWidth);
+  auto [instM, instN, instK] = matmul.instructionSize;
+  SmallVector<std::array<int64_t, 3>> tileShapes;
+  for (int64_t m = 2 * instM; m <= maxSize; m *= 2) {
+    for (int64_t n = 2 * instN; n <= maxSize; n *= 2) {
+      for (int64_t k = instK; k <= maxSize; k *= 2)
+        tileShapes.push_back({m, n, k});
+    }
+  }
+  return tileShapes;
+}
+
+/// Returns the shape-specialized matmul variants for `matmul`.
+static SmallVector<UKernelDescriptor> getShapedMatmulDescriptors(
+    const VectorizedMatmul &matmul) {
+  SmallVector<UKernelDescriptor> descriptors;
+  for (const std::array<int64_t, 3> &tileShape : getMatmulTileShapes(matmul)) {
+    for (bool transposeB : {false, true}) {
+      descriptors.push_back({"matmul", matmul.elemTypes, "mm.o",
+                             {tileShape.begin(), tileShape.end()},
+                             /*isGeneric=*/false, transposeB});
+    }
+  }
+  return descriptors;
+}
+
+/// Returns the shape-specialized zero fills for `elemType`, one for the
+/// accumulator of every shape-specialized matmul, see ZERO_SIZE_COMBOS in
+/// UKernels/aie2/mm.cc.
+static SmallVector<UKernelDescriptor> getShapedZeroDescriptors(
+    StringRef elemType) {
+  SmallVector<int64_t> numElements;
+  for (const VectorizedMatmul &matmul : kVectorizedMatmuls) {
+    for (const auto &[m, n, k] : getMatmulTileShapes(matmul))
+      numElements.push_back(m * n);
+  }
+  llvm::sort(numElements);
+  numElements.erase(std::unique(numElements.begin(), numElements.end()),
+                    numElements.end());
+  SmallVector<UKernelDescriptor> descriptors;
+  for (int64_t size : numElements)
+    descriptors.push_back({"zero", elemType, "mm.o", {size}});
+  return descriptors;
+}
+
+ArrayRef<UKernelDescriptor> getUKernelDescriptors() {
+  static const SmallVector<UKernelDescriptor> descriptors = [] {
+    SmallVector<int64_t, 3> matmulShape(kGenericMatmulTileShape.begin(),
+                                        kGenericMatmulTileShape.end());
+    SmallVector<int64_t, 3> zeroShape = {kGenericMatmulTileShape[0] *
+                                         kGenericMatmulTileShape[1]};
+    SmallVector<UKernelDescriptor> result = {
+        // Generic matmuls, see UKernels/aie2/mm.cc.
+        {"matmul", "bf16_bf16", "mm.o", matmulShape, /*isGeneric=*/true},
+        {"matmul", "bf16_f32", "mm.o", matmulShape, /*isGeneric=*/true},
+        {"matmul", "i8_i32", "mm.o", matmulShape, /*isGeneric=*/true},
+        {"matmul", "i32_i32", "mm.o", matmulShape, /*isGeneric=*/true},
+        {"matmul", "f32_f32", "mm.o", matmulShape, /*isGeneric=*/true},
+        // Zero fills, see UKernels/aie2/mm.cc.
+        {"zero", "bf16", "mm.o", zeroShape, /*isGeneric=*/true},
+        {"zero", "f32", "mm.o", zeroShape, /*isGeneric=*/true},
+        {"zero", "i32", "mm.o", zeroShape, /*isGeneric=*/true},
+    };
+    // Shape-specialized matmuls, only for the types with a vectorized
+    // implementation, and the zero fills of their accumulators.
+    for (const VectorizedMatmul &matmul : kVectorizedMatmuls)
+      llvm::append_range(result, getShapedMatmulDescriptors(matmul));
+    for (StringRef elemType : {"bf16", "f32", "i32"})
+      llvm::append_range(result, getShapedZeroDescriptors(elemType));
+    return result;
+  }();
+  return descriptors;
+}
+
+FailureOr<UKernelDescriptor> lookupUKernel(StringRef name, StringRef elemTypes,
+                                           ArrayRef<int64_t> tileShape,
+                                           bool transposeB,
+                                           bool anyGenericTileShape) {
+  std::optional<UKernelDescriptor> generic;
+  for (const UKernelDescriptor &descriptor : getUKernelDescriptors()) {
+    if (descriptor.name != name || descriptor.elemTypes != elemTypes ||
+        descriptor.transposeB != transposeB) {
+      continue;
+    }
+    bool shapeMatches = llvm::equal(descriptor.tileShape, tileShape);
+    if (!descriptor.isGeneric && shapeMatches) return descriptor;
+    // Calling a microkernel on a tile of another shape than it is compiled for
+    // reads and writes out of bounds.
+    if (descriptor.isGeneric && (shapeMatches || anyGenericTileShape))
+      generic = descriptor;
+  }
+  if (generic) return *generic;
+  return failure();
+}
+
+std::optional<StringRef> getBundledUKernelObject(StringRef targetArch,
+                                                 StringRef objectFile) {
+#ifdef IREE_AMD_AIE_HAS_BUNDLED_UKERNELS
+  // The object files are embedded with their name prefixed by the lowercase
+  // target architecture, e.g. `aie2_mm.o`.
+  std::string tocName = (targetArch.lower() + "_" + objectFile).str();
+  const iree_file_toc_t *toc = iree_amd_aie_bundled_ukernels_create();
+  for (size_t i = 0; i < iree_amd_aie_bundled_ukernels_size(); ++i) {
+    if (tocName == toc[i].name) return StringRef(toc[i].data, toc[i].size);
+  }
+#endif
+  return std::nullopt;
+}
+
+LogicalResult materializeBundledUKernels(xilinx::AIE::DeviceOp deviceOp,
+                                         StringRef targetArch,
+                                         StringRef workDir) {
+  SmallString<128> ukernelDir(workDir);
+  llvm::sys::path::append(
+      ukernelDir, "ukernels_v" + std::to_string(kUKernelLibraryVersion));
+  WalkResult res = deviceOp.walk([&](xilinx::AIE::CoreOp coreOp) {
+    std::optional<StringRef> linkWith = coreOp.getLinkWith();
+    if (!linkWith || llvm::sys::fs::exists(*linkWith))
+      return WalkResult::advance();
+
+    StringRef objectFile = llvm::sys::path::filename(*linkWith);
+    std::optional<StringRef> contents =
+        getBundledUKernelObject(targetArch, objectFile);
+    if (!contents) {
+      coreOp.emitOpError() << "can't find microkernel object file '"
+                           << *linkWith
+                           << "' and no bundled microkernel with this name is "
+                              "available for target "
+                           << targetArch;
+      return WalkResult::interrupt();
+    }
+
+    SmallString<128> objectPath(ukernelDir);
+    llvm::sys::path::append(objectPath, objectFile);
+    if (!llvm::sys::fs::exists(objectPath)) {
+      if (std::error_code ec = llvm::sys::fs::create_directories(ukernelDir)) {
+        coreOp.emitOpError() << "failed to create directory " << ukernelDir
+                             << ": " << ec.message();
+        return WalkResult::interrupt();
+      }
+      std::string errorMessage;
+      auto output = openOutputFile(objectPath, &errorMessage);
+      if (!output) {
+        coreOp.emitOpError() << errorMessage;
+        return WalkResult::interrupt();
+      }
+      output->os() << *contents;
+      output->keep();
+    }
+    coreOp.setLinkWith(objectPath.str());
+    return WalkResult::advance();
+  });
+  return failure(res.wasInterrupted());
+}
+
+}  // namespace mlir::iree_compiler::AMDAIE
@@ -0,0 +1,88 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_AMD_AIE_UKERNELS_UKERNELREGISTRY_H_
+#define IREE_AMD_AIE_UKERNELS_UKERNELREGISTRY_H_
+
+#include <optional>
+#include <string>
+
+#include "aie/Dialect/AIE/IR/AIEDialect.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir/Support/LogicalResult.h"
+
+namespace mlir::iree_compiler::AMDAIE {
+
+/// Version of the microkernel library bundled with the compiler. This has to
+/// be bumped whenever the name, signature or semantics of a microkernel
+/// changes, so that object files of different versions are never mixed up.
+constexpr uint32_t kUKernelLibraryVersion = 2;
+
+/// Description of a microkernel provided by the microkernel library.
+struct UKernelDescriptor {
+  /// Unprefixed name of the microkernel as used in the `ukernels` field of the
+  /// executable target, e.g. `matmul`.
+  StringRef name;
+  /// Element types of the operands, e.g. `bf16_f32` for a matmul with bf16
+  /// inputs and an f32 output.
+  StringRef elemTypes;
+  /// Name of the object file containing the microkernel.
+  StringRef objectFile;
+  /// The tile shape the microkernel is compiled for: (M, N, K) for a matmul
+  /// and the number of elements for a zero fill.
+  SmallVector<int64_t, 3> tileShape;
+  /// Whether this is the generic variant, whose symbol name doesn't contain
+  /// the tile shape. The generic microkernels are compiled for DIM_M, DIM_N
+  /// and DIM_K of UKernels/aie2/mm.cc, which can be overridden when compiling
+  /// an object file for `--iree-amdaie-path-to-ukernels`.
+  bool isGeneric = false;
+  /// Whether the microkernel expects the rhs operand transposed.
+  bool transposeB = false;
+
+  /// Returns the symbol name of the microkernel: `<name>_<elemTypes>` for the
+  /// generic variant and `<name>_<elemTypes>_<tile shape>[_bT]` otherwise, with
+  /// the dimensions of the tile shape separated by `x`.
+  std::string getFnName() const;
+};
+
+/// Returns all microkernels in the microkernel library. To add a microkernel,
+/// add its source to UKernels/<arch>/ and an entry to this registry.
+ArrayRef<UKernelDescriptor> getUKernelDescriptors();
+
+/// Returns the microkernel with the given `name` and `elemTypes` compiled for
+/// `tileShape` and the rhs layout `transposeB`, or failure if the library
+/// doesn't provide one. An empty `tileShape` denotes a tile shape which isn't
+/// known statically. Variants specialized for the tile shape are preferred
+/// over the generic one. If `anyGenericTileShape` is set, the generic
+/// microkernels are assumed to be compiled for whatever tile shape is asked
+/// for, which is only the case for object files provided by the user.
+FailureOr<UKernelDescriptor> lookupUKernel(StringRef name, StringRef elemTypes,
+                                           ArrayRef<int64_t> tileShape,
+                                           bool transposeB = false,
+                                           bool anyGenericTileShape = false);
+
+/// Returns the contents of the object file `objectFile` that was compiled for
+/// `targetArch` (e.g. `AIE2`) and embedded into the compiler at build time.
+/// Returns std::nullopt if the compiler was built without bundled
+/// microkernels or if no such object file exists.
+std::optional<StringRef> getBundledUKernelObject(StringRef targetArch,
+                                                 StringRef objectFile);
+
+/// Makes the object files referenced by the `link_with` attributes of the
+/// cores in `deviceOp` available for linking. A `link_with` path which
+/// doesn't exist on disk is resolved against the bundled microkernel library:
+/// the object file is written to `workDir` and the attribute is updated to
+/// its absolute path. Paths which exist (e.g. from
+/// `--iree-amdaie-path-to-ukernels`) are left untouched.
+LogicalResult materializeBundledUKernels(xilinx::AIE::DeviceOp deviceOp,
+                                         StringRef targetArch,
+                                         StringRef workDir);
+
+}  // namespace mlir::iree_compiler::AMDAIE
+
+#endif  // IREE_AMD_AIE_UKERNELS_UKERNELREGISTRY_H_
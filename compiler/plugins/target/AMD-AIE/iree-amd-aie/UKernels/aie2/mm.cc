@@ -0,0 +1,343 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Matmul and zero-fill microkernels for AIE2, bundled with the compiler and
+// linked into the core ELFs through the `link_with` attribute set by
+// AMDAIELowerToUKernels.
+//
+// The kernels operate on a single L1 tile of size M x K (lhs), K x N (rhs) and
+// M x N (acc). The operands are in the blocked layout produced by the second
+// level of packing, where each block has the size of one AIE matmul
+// instruction (r x s for the lhs, s x t for the rhs and r x t for the acc).
+//
+// There are two flavours of every matmul:
+//  - `matmul_<types>` is compiled for DIM_M x DIM_N x DIM_K, which can be
+//    overridden to build an object file for `--iree-amdaie-path-to-ukernels`.
+//    The compiler only calls the bundled one on tiles of exactly this shape.
+//  - `matmul_<types>_<M>x<N>x<K>[_bT]` is specialized for one tile shape, so
+//    all trip counts are compile-time constants and the reduction loop is
+//    fully unrolled. The `_bT` variants expect the rhs blocks transposed, i.e.
+//    N x K in blocks of t x s.
+// Likewise, `zero_<type>` zeroes DIM_M x DIM_N elements and
+// `zero_<type>_<size>` zeroes `size` elements.
+//
+// All kernels follow the calling convention of `iree_codegen.ukernel.generic`
+// with `strided_outer_dims(0)`: every memref operand is passed as a base
+// pointer and an offset in elements.
+
+#include <stdint.h>
+
+#include <aie_api/aie.hpp>
+
+#ifndef DIM_M
+#define DIM_M 64
+#endif
+
+#ifndef DIM_K
+#define DIM_K 64
+#endif
+
+#ifndef DIM_N
+#define DIM_N 64
+#endif
+
+namespace {
+
+template <typename T_in, typename T_out, unsigned rowA, unsigned colA,
+          unsigned colB>
+void matmul_scalar(const T_in *__restrict pA, unsigned offsetA,
+                   const T_in *__restrict pB, unsigned offsetB,
+                   T_out *__restrict pC, unsigned offsetC) {
+  for (unsigned row = 0; row < rowA; row++) {
+    for (unsigned col = 0; col < colB; col++) {
+      T_out running_sum = pC[offsetC + row * colB + col];
+      for (unsigned i = 0; i < colA; i++) {
+        running_sum +=
+            pA[offsetA + row * colA + i] * pB[offsetB + i * colB + col];
+      }
+      pC[offsetC + row * colB + col] = running_sum;
+    }
+  }
+}
+
+// Computes a 2x2 block of AIE matmul instructions per iteration of the
+// innermost loop, such that every loaded lhs and rhs vector is used twice.
+// `rowA`, `colA` and `colB` are the number of blocks of size (r x s), (s x t)
+// and (r x t) along the corresponding dimension.
+template <typename T_in, typename T_out, unsigned rowA, unsigned colA,
+          unsigned colB, unsigned r, unsigned s, unsigned t>
+void matmul_vectorized(const T_in *__restrict pA, unsigned offsetA,
+                       const T_in *__restrict pB, unsigned offsetB,
+                       T_out *__restrict pC, unsigned offsetC) {
+  using MMUL = aie::mmul<r, s, t, T_in, T_in, accauto>;
+  static_assert(rowA % 2 == 0 && colB % 2 == 0,
+                "expected an even number of row and column blocks");
+
+  for (unsigned z = 0; z < rowA; z += 2) {
+    T_out *__restrict pC1 = pC + offsetC + (z * colB) * MMUL::size_C;
+    T_out *__restrict pC2 = pC + offsetC + ((z + 1) * colB) * MMUL::size_C;
+
+    for (unsigned j = 0; j < colB; j += 2) {
+      const T_in *__restrict pA1 = pA + offsetA + (z * colA) * MMUL::size_A;
+      const T_in *__restrict pA2 =
+          pA + offsetA + ((z + 1) * colA) * MMUL::size_A;
+      const T_in *__restrict pB1 = pB + offsetB + j * MMUL::size_B;
+      const T_in *__restrict pB2 = pB + offsetB + (j + 1) * MMUL::size_B;
+
+      aie::vector<T_in, MMUL::size_A> A0 = aie::load_v<MMUL::size_A>(pA1);
+      pA1 += MMUL::size_A;
+      aie::vector<T_in, MMUL::size_A> A1 = aie::load_v<MMUL::size_A>(pA2);
+      pA2 += MMUL::size_A;
+      aie::vector<T_in, MMUL::size_B> B0 = aie::load_v<MMUL::size_B>(pB1);
+      pB1 += MMUL::size_B * colB;
+      aie::vector<T_in, MMUL::size_B> B1 = aie::load_v<MMUL::size_B>(pB2);
+      pB2 += MMUL::size_B * colB;
+
+      aie::vector<T_out, MMUL::size_C> acc_C00 = aie::load_v<MMUL::size_C>(pC1);
+      aie::vector<T_out, MMUL::size_C> acc_C01 =
+          aie::load_v<MMUL::size_C>(pC1 + MMUL::size_C);
+      aie::vector<T_out, MMUL::size_C> acc_C10 = aie::load_v<MMUL::size_C>(pC2);
+      aie::vector<T_out, MMUL::size_C> acc_C11 =
+          aie::load_v<MMUL::size_C>(pC2 + MMUL::size_C);
+
+      MMUL C00(acc_C00);
+      MMUL C01(acc_C01);
+      MMUL C10(acc_C10);
+      MMUL C11(acc_C11);
+
+      C00.mac(A0, B0);
+      C01.mac(A0, B1);
+      C10.mac(A1, B0);
+      C11.mac(A1, B1);
+
+#pragma clang loop unroll(full)
+      for (unsigned i = 1; i < colA; ++i) {
+        A0 = aie::load_v<MMUL::size_A>(pA1);
+        pA1 += MMUL::size_A;
+        A1 = aie::load_v<MMUL::size_A>(pA2);
+        pA2 += MMUL::size_A;
+        B0 = aie::load_v<MMUL::size_B>(pB1);
+        pB1 += MMUL::size_B * colB;
+        B1 = aie::load_v<MMUL::size_B>(pB2);
+        pB2 += MMUL::size_B * colB;
+
+        C00.mac(A0, B0);
+        C01.mac(A0, B1);
+        C10.mac(A1, B0);
+        C11.mac(A1, B1);
+      }
+
+      aie::store_v(pC1, C00.template to_vector<T_out>());
+      pC1 += MMUL::size_C;
+      aie::store_v(pC1, C01.template to_vector<T_out>());
+      pC1 += MMUL::size_C;
+      aie::store_v(pC2, C10.template to_vector<T_out>());
+      pC2 += MMUL::size_C;
+      aie::store_v(pC2, C11.template to_vector<T_out>());
+      pC2 += MMUL::size_C;
+    }
+  }
+}
+
+// Same as `matmul_vectorized`, but with the rhs blocks stored transposed:
+// block (i, j) of the rhs is a t x s block at index (j * colA + i).
+template <typename T_in, typename T_out, unsigned rowA, unsigned colA,
+          unsigned colB, unsigned r, unsigned s, unsigned t>
+void matmul_vectorized_b_transposed(const T_in *__restrict pA,
+                                    unsigned offsetA,
+                                    const T_in *__restrict pB,
+                                    unsigned offsetB, T_out *__restrict pC,
+                                    unsigned offsetC) {
+  using MMUL = aie::mmul<r, s, t, T_in, T_in, accauto>;
+  static_assert(rowA % 2 == 0 && colB % 2 == 0,
+                "expected an even number of row and column blocks");
+
+  for (unsigned z = 0; z < rowA; z += 2) {
+    T_out *__restrict pC1 = pC + offsetC + (z * colB) * MMUL::size_C;
+    T_out *__restrict pC2 = pC + offsetC + ((z + 1) * colB) * MMUL::size_C;
+
+    for (unsigned j = 0; j < colB; j += 2) {
+      const T_in *__restrict pA1 = pA + offsetA + (z * colA) * MMUL::size_A;
+      const T_in *__restrict pA2 =
+          pA + offsetA + ((z + 1) * colA) * MMUL::size_A;
+      const T_in *__restrict pB1 = pB + offsetB + (j * colA) * MMUL::size_B;
+      const T_in *__restrict pB2 =
+          pB + offsetB + ((j + 1) * colA) * MMUL::size_B;
+
+      MMUL C00(aie::load_v<MMUL::size_C>(pC1));
+      MMUL C01(aie::load_v<MMUL::size_C>(pC1 + MMUL::size_C));
+      MMUL C10(aie::load_v<MMUL::size_C>(pC2));
+      MMUL C11(aie::load_v<MMUL::size_C>(pC2 + MMUL::size_C));
+
+#pragma clang loop unroll(full)
+      for (unsigned i = 0; i < colA; ++i) {
+        aie::vector<T_in, MMUL::size_A> A0 = aie::load_v<MMUL::size_A>(pA1);
+        pA1 += MMUL::size_A;
+        aie::vector<T_in, MMUL::size_A> A1 = aie::load_v<MMUL::size_A>(pA2);
+        pA2 += MMUL::size_A;
+        aie::vector<T_in, MMUL::size_B> B0 =
+            aie::transpose(aie::load_v<MMUL::size_B>(pB1), t, s);
+        pB1 += MMUL::size_B;
+        aie::vector<T_in, MMUL::size_B> B1 =
+            aie::transpose(aie::load_v<MMUL::size_B>(pB2), t, s);
+        pB2 += MMUL::size_B;
+
+        C00.mac(A0, B0);
+        C01.mac(A0, B1);
+        C10.mac(A1, B0);
+        C11.mac(A1, B1);
+      }
+
+      aie::store_v(pC1, C00.template to_vector<T_out>());
+      pC1 += MMUL::size_C;
+      aie::store_v(pC1, C01.template to_vector<T_out>());
+      pC1 += MMUL::size_C;
+      aie::store_v(pC2, C10.template to_vector<T_out>());
+      pC2 += MMUL::size_C;
+      aie::store_v(pC2, C11.template to_vector<T_out>());
+      pC2 += MMUL::size_C;
+    }
+  }
+}
+
+template <typename T, unsigned size>
+void zero_vectorized(T *__restrict pC, unsigned offsetC) {
+  // One full 512-bit vector register per store.
+  constexpr unsigned r = 512 / (sizeof(T) * 8);
+  static_assert(size % r == 0, "expected a whole number of vectors");
+  const aie::vector<T, r> zeros = aie::zeros<T, r>();
+  T *__restrict pC1 = pC + offsetC;
+  const T *__restrict pCEnd = pC1 + size;
+  for (; pC1 < pCEnd; pC1 += r) {
+    aie::store_v(pC1, zeros);
+  }
+}
+
+}  // namespace
+
+extern "C" {
+
+// The symbol names are `<ukernel name>_<element types>`, matching the
+// registry in UKernelRegistry.cpp.
+//
+// Every vectorized matmul also lists the M, N and K sizes of its
+// shape-specialized variants, which are instantiated for all combinations of
+// them. These are the L1 tile sizes the pack-peel heuristic in
+// KernelDispatch.cpp chooses for power-of-two matmul sizes: powers of two up
+// to 16 * (64 / lhs bitwidth), and at least 2 * r for M and 2 * t for N.
+// Keep in sync with `getMatmulTileShapes` in UKernelRegistry.cpp.
+#define MATMUL_VECTORIZED_COMBOS(X)                                      \
+  X(bfloat16, bf16, bfloat16, bf16, 4, 8, 4, MATMUL_M_8_TO_64,           \
+    MATMUL_N_8_TO_64, MATMUL_K_8_TO_64)                                  \
+  X(bfloat16, bf16, float, f32, 4, 8, 4, MATMUL_M_8_TO_64,               \
+    MATMUL_N_8_TO_64, MATMUL_K_8_TO_64)                                  \
+  X(int8, i8, int32, i32, 4, 8, 8, MATMUL_M_8_TO_128, MATMUL_N_16_TO_128, \
+    MATMUL_K_8_TO_128)
+
+// The lists of sizes, with separate macros for M, N and K, as a macro can't
+// be expanded within its own expansion.
+#define MATMUL_M_8_TO_64(X, ...) \
+  X(__VA_ARGS__, 8) X(__VA_ARGS__, 16) X(__VA_ARGS__, 32) X(__VA_ARGS__, 64)
+#define MATMUL_M_8_TO_128(X, ...) \
+  MATMUL_M_8_TO_64(X, __VA_ARGS__) X(__VA_ARGS__, 128)
+#define MATMUL_N_8_TO_64(X, ...) \
+  X(__VA_ARGS__, 8) X(__VA_ARGS__, 16) X(__VA_ARGS__, 32) X(__VA_ARGS__, 64)
+#define MATMUL_N_16_TO_128(X, ...) \
+  X(__VA_ARGS__, 16) X(__VA_ARGS__, 32) X(__VA_ARGS__, 64) X(__VA_ARGS__, 128)
+#define MATMUL_K_8_TO_64(X, ...) \
+  X(__VA_ARGS__, 8) X(__VA_ARGS__, 16) X(__VA_ARGS__, 32) X(__VA_ARGS__, 64)
+#define MATMUL_K_8_TO_128(X, ...) \
+  MATMUL_K_8_TO_64(X, __VA_ARGS__) X(__VA_ARGS__, 128)
+
+#define MATMUL_SCALAR_COMBOS(X) \
+  X(int32, i32, int32, i32)     \
+  X(float, f32, float, f32)
+
+#define ZERO_COMBOS(X) \
+  X(bfloat16, bf16)    \
+  X(float, f32)        \
+  X(int32, i32)
+
+// Sizes with a dedicated zero fill, the accumulator sizes M x N of all
+// shape-specialized matmuls. Keep in sync with UKernelRegistry.cpp.
+#define ZERO_SIZE_COMBOS(X, ...) \
+  X(__VA_ARGS__, 64)             \
+  X(__VA_ARGS__, 128)            \
+  X(__VA_ARGS__, 256)            \
+  X(__VA_ARGS__, 512)            \
+  X(__VA_ARGS__, 1024)           \
+  X(__VA_ARGS__, 2048)           \
+  X(__VA_ARGS__, 4096)           \
+  X(__VA_ARGS__, 8192)           \
+  X(__VA_ARGS__, 16384)
+
+#define MATMUL_VECTORIZED_C_FUNC(ctype_in, mlir_type_in, ctype_out,         \
+                                 mlir_type_out, r, s, t, ...)               \
+  void matmul_##mlir_type_in##_##mlir_type_out(                             \
+      ctype_in *a_in, unsigned offsetA, ctype_in *b_in, unsigned offsetB,   \
+      ctype_out *c_out, unsigned offsetC) {                                 \
+    matmul_vectorized<ctype_in, ctype_out, DIM_M / r, DIM_K / s, DIM_N / t, \
+                      r, s, t>(a_in, offsetA, b_in, offsetB, c_out,         \
+                               offsetC);                                    \
+  }
+
+#define MATMUL_SHAPED_C_FUNC(ctype_in, mlir_type_in, ctype_out, mlir_type_out, \
+                             r, s, t, M, N, K)                                \
+  void matmul_##mlir_type_in##_##mlir_type_out##_##M##x##N##x##K(             \
+      ctype_in *a_in, unsigned offsetA, ctype_in *b_in, unsigned offsetB,     \
+      ctype_out *c_out, unsigned offsetC) {                                   \
+    matmul_vectorized<ctype_in, ctype_out, M / r, K / s, N / t, r, s, t>(     \
+        a_in, offsetA, b_in, offsetB, c_out, offsetC);                        \
+  }                                                                           \
+  void matmul_##mlir_type_in##_##mlir_type_out##_##M##x##N##x##K##_bT(        \
+      ctype_in *a_in, unsigned offsetA, ctype_in *b_in, unsigned offsetB,     \
+      ctype_out *c_out, unsigned offsetC) {                                   \
+    matmul_vectorized_b_transposed<ctype_in, ctype_out, M / r, K / s, N / t,  \
+                                   r, s, t>(a_in, offsetA, b_in, offsetB,     \
+                                            c_out, offsetC);                  \
+  }
+
+#define MATMUL_SHAPED_N_C_FUNC(FOR_K, ...) \
+  FOR_K(MATMUL_SHAPED_C_FUNC, __VA_ARGS__)
+
+#define MATMUL_SHAPED_M_C_FUNC(FOR_N, FOR_K, ...) \
+  FOR_N(MATMUL_SHAPED_N_C_FUNC, FOR_K, __VA_ARGS__)
+
+#define MATMUL_SHAPED_COMBOS_C_FUNC(ctype_in, mlir_type_in, ctype_out,      \
+                                    mlir_type_out, r, s, t, FOR_M, FOR_N,   \
+                                    FOR_K)                                  \
+  FOR_M(MATMUL_SHAPED_M_C_FUNC, FOR_N, FOR_K, ctype_in, mlir_type_in,       \
+        ctype_out, mlir_type_out, r, s, t)
+
+#define MATMUL_SCALAR_C_FUNC(ctype_in, mlir_type_in, ctype_out,           \
+                             mlir_type_out)                               \
+  void matmul_##mlir_type_in##_##mlir_type_out(                           \
+      ctype_in *a_in, unsigned offsetA, ctype_in *b_in, unsigned offsetB, \
+      ctype_out *c_out, unsigned offsetC) {                               \
+    matmul_scalar<ctype_in, ctype_out, DIM_M, DIM_K, DIM_N>(              \
+        a_in, offsetA, b_in, offsetB, c_out, offsetC);                    \
+  }
+
+#define ZERO_C_FUNC(ctype_out, mlir_type_out)                     \
+  void zero_##mlir_type_out(ctype_out *c_out, unsigned offsetC) { \
+    zero_vectorized<ctype_out, DIM_M * DIM_N>(c_out, offsetC);    \
+  }
+
+#define ZERO_SIZED_C_FUNC(ctype_out, mlir_type_out, size)                   \
+  void zero_##mlir_type_out##_##size(ctype_out *c_out, unsigned offsetC) { \
+    zero_vectorized<ctype_out, size>(c_out, offsetC);                      \
+  }
+
+#define ZERO_SIZED_COMBOS_C_FUNC(...) \
+  ZERO_SIZE_COMBOS(ZERO_SIZED_C_FUNC, __VA_ARGS__)
+
+MATMUL_VECTORIZED_COMBOS(MATMUL_VECTORIZED_C_FUNC)
+MATMUL_VECTORIZED_COMBOS(MATMUL_SHAPED_COMBOS_C_FUNC)
+MATMUL_SCALAR_COMBOS(MATMUL_SCALAR_C_FUNC)
+ZERO_COMBOS(ZERO_C_FUNC)
+ZERO_COMBOS(ZERO_SIZED_COMBOS_C_FUNC)
+
+}  // extern "C"
@@ -0,0 +1,366 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Bulk conversion between float and bfloat16 for the AIE delegate.
+//
+// float -> bfloat16 rounds to nearest, ties to even, and keeps NaNs quiet
+// (a plain 16-bit truncation can turn a NaN with only low mantissa bits set
+// into an infinity).  bfloat16 -> float is exact.
+//
+// The bulk functions pick the widest vector ISA available on the running CPU
+// (AVX-512, AVX2 or NEON) and split large tensors over several threads.  All
+// vector paths produce exactly the same bits as the scalar path.
+
+#ifndef IREE_AMD_AIE_EXPERIMENTAL_DELEGATE_BF16_CONVERSION_H_
+#define IREE_AMD_AIE_EXPERIMENTAL_DELEGATE_BF16_CONVERSION_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define BF16_CONVERSION_X86 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define BF16_CONVERSION_NEON 1
+#endif
+
+// With GCC and Clang the x86 vector paths are compiled for their ISA with
+// target attributes and selected at run time, so that the delegate does not
+// need to be built with -mavx2/-mavx512f.  Other compilers only get the paths
+// enabled by the compiler flags.
+#if defined(BF16_CONVERSION_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BF16_CONVERSION_RUNTIME_DISPATCH 1
+#define BF16_TARGET_AVX2 __attribute__((target("avx2")))
+#define BF16_TARGET_AVX512 __attribute__((target("avx512f")))
+#define BF16_HAS_AVX2 1
+#define BF16_HAS_AVX512 1
+#else
+#define BF16_TARGET_AVX2
+#define BF16_TARGET_AVX512
+#if defined(__AVX2__)
+#define BF16_HAS_AVX2 1
+#endif
+#if defined(__AVX512F__)
+#define BF16_HAS_AVX512 1
+#endif
+#endif
+
+// Fake bfloat16 type (assuming no C++ 23)
+using bfloat16_t = std::uint16_t;
+
+//=============================================================================
+// Scalar conversions
+
+inline bfloat16_t floatToBf16(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  // NaN: truncate and force the quiet bit so the result stays a NaN
+  if ((bits & 0x7fffffffu) > 0x7f800000u)
+    return bfloat16_t((bits >> 16) | 0x0040u);
+  // Round to nearest, ties to even
+  uint32_t lsb = (bits >> 16) & 1u;
+  return bfloat16_t((bits + 0x7fffu + lsb) >> 16);
+}
+
+inline float bf16ToFloat(bfloat16_t value) {
+  uint32_t bits = uint32_t(value) << 16;
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+// Previous conversion of the delegate (truncation), kept as the baseline of
+// the conversion benchmark.
+inline bfloat16_t floatToBf16Truncate(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bfloat16_t(bits >> 16);
+}
+
+inline void convertFloatToBf16Scalar(bfloat16_t *dest, const float *src,
+                                     std::size_t numElements) {
+  for (std::size_t i = 0; i < numElements; ++i)
+    dest[i] = floatToBf16(src[i]);
+}
+
+inline void convertBf16ToFloatScalar(float *dest, const bfloat16_t *src,
+                                     std::size_t numElements) {
+  for (std::size_t i = 0; i < numElements; ++i)
+    dest[i] = bf16ToFloat(src[i]);
+}
+
+//=============================================================================
+// Vector conversions
+//
+// Each function converts the largest multiple of its vector width and leaves
+// the tail to the scalar path.
+
+#ifdef BF16_HAS_AVX512
+BF16_TARGET_AVX512 inline void convertFloatToBf16Avx512(
+    bfloat16_t *dest, const float *src, std::size_t numElements) {
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i bias = _mm512_set1_epi32(0x7fff);
+  const __m512i quietBit = _mm512_set1_epi32(0x0040);
+  std::size_t i = 0;
+  for (; i + 16 <= numElements; i += 16) {
+    __m512 v = _mm512_loadu_ps(src + i);
+    __m512i bits = _mm512_castps_si512(v);
+    __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(bits, 16), one);
+    __m512i rounded = _mm512_srli_epi32(
+        _mm512_add_epi32(bits, _mm512_add_epi32(bias, lsb)), 16);
+    __m512i nan = _mm512_or_si512(_mm512_srli_epi32(bits, 16), quietBit);
+    __mmask16 isNan = _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q);
+    __m512i result = _mm512_mask_blend_epi32(isNan, rounded, nan);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + i),
+                        _mm512_cvtepi32_epi16(result));
+  }
+  convertFloatToBf16Scalar(dest + i, src + i, numElements - i);
+}
+
+BF16_TARGET_AVX512 inline void convertBf16ToFloatAvx512(
+    float *dest, const bfloat16_t *src, std::size_t numElements) {
+  std::size_t i = 0;
+  for (; i + 16 <= numElements; i += 16) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    __m512i bits = _mm512_slli_epi32(_mm512_cvtepu16_epi32(v), 16);
+    _mm512_storeu_ps(dest + i, _mm512_castsi512_ps(bits));
+  }
+  convertBf16ToFloatScalar(dest + i, src + i, numElements - i);
+}
+#endif
+
+#ifdef BF16_HAS_AVX2
+// Rounds 8 floats and returns the bfloat16 bits in the low half of each lane.
+BF16_TARGET_AVX2 inline __m256i roundFloatToBf16Avx2(__m256 v) {
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i bias = _mm256_set1_epi32(0x7fff);
+  const __m256i quietBit = _mm256_set1_epi32(0x0040);
+  __m256i bits = _mm256_castps_si256(v);
+  __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+  __m256i rounded = _mm256_srli_epi32(
+      _mm256_add_epi32(bits, _mm256_add_epi32(bias, lsb)), 16);
+  __m256i nan = _mm256_or_si256(_mm256_srli_epi32(bits, 16), quietBit);
+  __m256i isNan = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+  return _mm256_blendv_epi8(rounded, nan, isNan);
+}
+
+BF16_TARGET_AVX2 inline void convertFloatToBf16Avx2(bfloat16_t *dest,
+                                                    const float *src,
+                                                    std::size_t numElements) {
+  std::size_t i = 0;
+  for (; i + 16 <= numElements; i += 16) {
+    __m256i lo = roundFloatToBf16Avx2(_mm256_loadu_ps(src + i));
+    __m256i hi = roundFloatToBf16Avx2(_mm256_loadu_ps(src + i + 8));
+    // packus works per 128-bit lane: restore the element order afterwards
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi),
+                                              0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + i), packed);
+  }
+  convertFloatToBf16Scalar(dest + i, src + i, numElements - i);
+}
+
+BF16_TARGET_AVX2 inline void convertBf16ToFloatAvx2(float *dest,
+                                                    const bfloat16_t *src,
+                                                    std::size_t numElements) {
+  std::size_t i = 0;
+  for (; i + 8 <= numElements; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m256i bits = _mm256_slli_epi32(_mm256_cvtepu16_epi32(v), 16);
+    _mm256_storeu_ps(dest + i, _mm256_castsi256_ps(bits));
+  }
+  convertBf16ToFloatScalar(dest + i, src + i, numElements - i);
+}
+#endif
+
+#ifdef BF16_CONVERSION_NEON
+// Rounds 4 floats and returns the bfloat16 bits in the low half of each lane.
+inline uint32x4_t roundFloatToBf16Neon(float32x4_t v) {
+  uint32x4_t bits = vreinterpretq_u32_f32(v);
+  uint32x4_t lsb = vandq_u32(vshrq_n_u32(bits, 16), vdupq_n_u32(1));
+  uint32x4_t rounded = vshrq_n_u32(
+      vaddq_u32(bits, vaddq_u32(vdupq_n_u32(0x7fff), lsb)), 16);
+  uint32x4_t nan = vorrq_u32(vshrq_n_u32(bits, 16), vdupq_n_u32(0x0040));
+  uint32x4_t isNotNan = vceqq_f32(v, v);
+  return vbslq_u32(isNotNan, rounded, nan);
+}
+
+inline void convertFloatToBf16Neon(bfloat16_t *dest, const float *src,
+                                   std::size_t numElements) {
+  std::size_t i = 0;
+  for (; i + 8 <= numElements; i += 8) {
+    uint16x4_t lo = vmovn_u32(roundFloatToBf16Neon(vld1q_f32(src + i)));
+    uint16x4_t hi = vmovn_u32(roundFloatToBf16Neon(vld1q_f32(src + i + 4)));
+    vst1q_u16(dest + i, vcombine_u16(lo, hi));
+  }
+  convertFloatToBf16Scalar(dest + i, src + i, numElements - i);
+}
+
+inline void convertBf16ToFloatNeon(float *dest, const bfloat16_t *src,
+                                   std::size_t numElements) {
+  std::size_t i = 0;
+  for (; i + 8 <= numElements; i += 8) {
+    uint16x8_t v = vld1q_u16(src + i);
+    vst1q_f32(dest + i,
+              vreinterpretq_f32_u32(vshll_n_u16(vget_low_u16(v), 16)));
+    vst1q_f32(dest + i + 4,
+              vreinterpretq_f32_u32(vshll_n_u16(vget_high_u16(v), 16)));
+  }
+  convertBf16ToFloatScalar(dest + i, src + i, numElements - i);
+}
+#endif
+
+//=============================================================================
+// ISA selection
+
+enum class Bf16ConversionIsa { Scalar, Avx2, Avx512, Neon };
+
+inline const char *getBf16ConversionIsaName(Bf16ConversionIsa isa) {
+  switch (isa) {
+    case Bf16ConversionIsa::Avx2:
+      return "avx2";
+    case Bf16ConversionIsa::Avx512:
+      return "avx512";
+    case Bf16ConversionIsa::Neon:
+      return "neon";
+    default:
+      return "scalar";
+  }
+}
+
+// Widest vector ISA usable on the running CPU
+inline Bf16ConversionIsa getBestBf16ConversionIsa() {
+  static const Bf16ConversionIsa isa = [] {
+#if defined(BF16_CONVERSION_RUNTIME_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return Bf16ConversionIsa::Avx512;
+    if (__builtin_cpu_supports("avx2")) return Bf16ConversionIsa::Avx2;
+    return Bf16ConversionIsa::Scalar;
+#elif defined(BF16_HAS_AVX512)
+    return Bf16ConversionIsa::Avx512;
+#elif defined(BF16_HAS_AVX2)
+    return Bf16ConversionIsa::Avx2;
+#elif defined(BF16_CONVERSION_NEON)
+    return Bf16ConversionIsa::Neon;
+#else
+    return Bf16ConversionIsa::Scalar;
+#endif
+  }();
+  return isa;
+}
+
+// Single-threaded conversions using `isa`, which must be supported by the CPU
+inline void convertFloatToBf16(bfloat16_t *dest, const float *src,
+                               std::size_t numElements,
+                               Bf16ConversionIsa isa) {
+  switch (isa) {
+#ifdef BF16_HAS_AVX512
+    case Bf16ConversionIsa::Avx512:
+      return convertFloatToBf16Avx512(dest, src, numElements);
+#endif
+#ifdef BF16_HAS_AVX2
+    case Bf16ConversionIsa::Avx2:
+      return convertFloatToBf16Avx2(dest, src, numElements);
+#endif
+#ifdef BF16_CONVERSION_NEON
+    case Bf16ConversionIsa::Neon:
+      return convertFloatToBf16Neon(dest, src, numElements);
+#endif
+    default:
+      return convertFloatToBf16Scalar(dest, src, numElements);
+  }
+}
+
+inline void convertBf16ToFloat(float *dest, const bfloat16_t *src,
+                               std::size_t numElements,
+                               Bf16ConversionIsa isa) {
+  switch (isa) {
+#ifdef BF16_HAS_AVX512
+    case Bf16ConversionIsa::Avx512:
+      return convertBf16ToFloatAvx512(dest, src, numElements);
+#endif
+#ifdef BF16_HAS_AVX2
+    case Bf16ConversionIsa::Avx2:
+      return convertBf16ToFloatAvx2(dest, src, numElements);
+#endif
+#ifdef BF16_CONVERSION_NEON
+    case Bf16ConversionIsa::Neon:
+      return convertBf16ToFloatNeon(dest, src, numElements);
+#endif
+    default:
+      return convertBf16ToFloatScalar(dest, src, numElements);
+  }
+}
+
+//=============================================================================
+// Multithreading
+
+// Tensors smaller than this many elements per thread are not worth the cost
+// of starting a thread (1 MiB of float data).
+constexpr std::size_t kBf16ConversionMinElementsPerThread = 1 << 18;
+
+// The conversion is memory bound: more threads than this only add contention.
+constexpr unsigned kBf16ConversionMaxThreads = 8;
+
+inline unsigned getBf16ConversionNumThreads(std::size_t numElements) {
+  std::size_t numThreads = numElements / kBf16ConversionMinElementsPerThread;
+  if (numThreads <= 1) return 1;
+  // hardware_concurrency() can hit the file system: query it once
+  static const unsigned maxThreads = std::max(
+      1u, std::min(std::thread::hardware_concurrency(),
+                   kBf16ConversionMaxThreads));
+  return unsigned(std::min<std::size_t>(numThreads, maxThreads));
+}
+
+// Calls `fn(begin, end)` on disjoint ranges covering [0, numElements), using
+// up to `numThreads` threads including the calling one.
+template <typename Fn>
+void parallelForRanges(std::size_t numElements, unsigned numThreads, Fn fn) {
+  if (numThreads <= 1) {
+    fn(std::size_t(0), numElements);
+    return;
+  }
+  // Keep chunk boundaries on a cache line of the narrower (bf16) side
+  constexpr std::size_t kAlignElements = 32;
+  std::size_t chunk = (numElements + numThreads - 1) / numThreads;
+  chunk = (chunk + kAlignElements - 1) / kAlignElements * kAlignElements;
+  std::vector<std::thread> workers;
+  workers.reserve(numThreads - 1);
+  for (std::size_t begin = chunk; begin < numElements; begin += chunk)
+    workers.emplace_back(fn, begin, std::min(begin + chunk, numElements));
+  fn(std::size_t(0), std::min(chunk, numElements));
+  for (std::thread &worker : workers) worker.join();
+}
+
+//=============================================================================
+// Entry points used by the delegate: best ISA, multithreaded when large
+
+inline void copyFloatToBf16(bfloat16_t *dest, const float *src,
+                            std::size_t numElements) {
+  Bf16ConversionIsa isa = getBestBf16ConversionIsa();
+  parallelForRanges(numElements, getBf16ConversionNumThreads(numElements),
+                    [=](std::size_t begin, std::size_t end) {
+                      convertFloatToBf16(dest + begin, src + begin,
+                                         end - begin, isa);
+                    });
+}
+
+inline void copyBf16ToFloat(float *dest, const bfloat16_t *src,
+                            std::size_t numElements) {
+  Bf16ConversionIsa isa = getBestBf16ConversionIsa();
+  parallelForRanges(numElements, getBf16ConversionNumThreads(numElements),
+                    [=](std::size_t begin, std::size_t end) {
+                      convertBf16ToFloat(dest + begin, src + begin,
+                                         end - begin, isa);
+                    });
+}
+
+#endif  // IREE_AMD_AIE_EXPERIMENTAL_DELEGATE_BF16_CONVERSION_H_
@@ -0,0 +1,175 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Microbenchmark of the float <-> bfloat16 conversions used by the AIE
+// delegate when copying between HAL and XRT buffers.
+//
+// Usage: bf16_conversion_benchmark [numElements] [numIterations]
+//
+// The default size is the LHS of the 8192x9728x2432 kernel.  Before timing,
+// every vector path is checked to produce the same bits as the scalar
+// round-to-nearest-even path, including NaNs, infinities and denormals.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bf16_conversion.h"
+
+namespace {
+
+std::vector<float> makeInput(std::size_t numElements) {
+  std::vector<float> values(numElements);
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-4.0f, 4.0f);
+  for (float &v : values) v = dist(gen);
+  // Sprinkle special values, including a NaN that truncation turns into inf
+  const float specials[] = {0.0f,
+                            -0.0f,
+                            std::numeric_limits<float>::infinity(),
+                            -std::numeric_limits<float>::infinity(),
+                            std::numeric_limits<float>::quiet_NaN(),
+                            std::numeric_limits<float>::denorm_min(),
+                            std::numeric_limits<float>::max(),
+                            std::numeric_limits<float>::lowest()};
+  uint32_t lowNanBits = 0x7f800001u;
+  float lowNan;
+  std::memcpy(&lowNan, &lowNanBits, sizeof(lowNan));
+  for (std::size_t i = 0; i < numElements; i += 97)
+    values[i] = specials[(i / 97) % (sizeof(specials) / sizeof(float))];
+  if (numElements > 1) values[1] = lowNan;
+  return values;
+}
+
+// Checks all float bit patterns whose low 16 bits exercise the rounding
+// boundary, plus the random input.
+bool checkIsa(Bf16ConversionIsa isa, const std::vector<float> &input) {
+  std::vector<float> src;
+  for (uint32_t hi = 0; hi < 0x10000u; hi += 0x101u)
+    for (uint32_t lo : {0x0000u, 0x7fffu, 0x8000u, 0x8001u, 0xffffu}) {
+      uint32_t bits = (hi << 16) | lo;
+      float f;
+      std::memcpy(&f, &bits, sizeof(f));
+      src.push_back(f);
+    }
+  src.insert(src.end(), input.begin(),
+             input.begin() + std::min<std::size_t>(input.size(), 1 << 16));
+  std::vector<bfloat16_t> expected(src.size()), actual(src.size());
+  convertFloatToBf16Scalar(expected.data(), src.data(), src.size());
+  convertFloatToBf16(actual.data(), src.data(), src.size(), isa);
+  if (expected != actual) {
+    std::cerr << "MISMATCH: float -> bf16 with "
+              << getBf16ConversionIsaName(isa) << std::endl;
+    return false;
+  }
+  std::vector<float> expectedF(src.size()), actualF(src.size());
+  convertBf16ToFloatScalar(expectedF.data(), expected.data(), src.size());
+  convertBf16ToFloat(actualF.data(), expected.data(), src.size(), isa);
+  if (std::memcmp(expectedF.data(), actualF.data(),
+                  src.size() * sizeof(float)) != 0) {
+    std::cerr << "MISMATCH: bf16 -> float with "
+              << getBf16ConversionIsaName(isa) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Returns the best time in milliseconds over `numIterations` runs
+double timeIt(int numIterations, const std::function<void()> &fn) {
+  double best = std::numeric_limits<double>::max();
+  for (int i = 0; i < numIterations; ++i) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    fn();
+    auto endTime = std::chrono::high_resolution_clock::now();
+    best = std::min(
+        best, std::chrono::duration<double, std::milli>(endTime - startTime)
+                  .count());
+  }
+  return best;
+}
+
+void report(const std::string &name, double ms, double baselineMs,
+            std::size_t numBytes) {
+  std::cout << "  " << std::left << std::setw(28) << name << std::right
+            << std::fixed << std::setprecision(3) << std::setw(10) << ms
+            << " ms " << std::setprecision(2) << std::setw(8)
+            << numBytes / ms / 1.0e6 << " GB/s " << std::setw(7)
+            << baselineMs / ms << "x" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::size_t numElements =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8192ull * 2432ull;
+  int numIterations = argc > 2 ? std::atoi(argv[2]) : 10;
+
+  std::vector<float> input = makeInput(numElements);
+  std::vector<bfloat16_t> bf16(numElements);
+  std::vector<float> output(numElements);
+
+  Bf16ConversionIsa bestIsa = getBestBf16ConversionIsa();
+  std::vector<Bf16ConversionIsa> isas = {Bf16ConversionIsa::Scalar};
+  if (bestIsa == Bf16ConversionIsa::Avx512)
+    isas.push_back(Bf16ConversionIsa::Avx2);
+  if (bestIsa != Bf16ConversionIsa::Scalar) isas.push_back(bestIsa);
+
+  for (Bf16ConversionIsa isa : isas)
+    if (!checkIsa(isa, input)) return 1;
+
+  unsigned numThreads = getBf16ConversionNumThreads(numElements);
+  std::cout << "Elements: " << numElements << ", iterations: "
+            << numIterations << ", best ISA: "
+            << getBf16ConversionIsaName(bestIsa)
+            << ", threads: " << numThreads << std::endl;
+
+  std::size_t numBytes = numElements * (sizeof(float) + sizeof(bfloat16_t));
+
+  std::cout << "float -> bf16" << std::endl;
+  double baselineMs = timeIt(numIterations, [&] {
+    for (std::size_t i = 0; i < numElements; ++i)
+      bf16[i] = floatToBf16Truncate(input[i]);
+  });
+  report("scalar truncate (old)", baselineMs, baselineMs, numBytes);
+  for (Bf16ConversionIsa isa : isas) {
+    double ms = timeIt(numIterations, [&] {
+      convertFloatToBf16(bf16.data(), input.data(), numElements, isa);
+    });
+    report(std::string(getBf16ConversionIsaName(isa)) + " rne", ms,
+           baselineMs, numBytes);
+  }
+  double ms = timeIt(numIterations, [&] {
+    copyFloatToBf16(bf16.data(), input.data(), numElements);
+  });
+  report("copyFloatToBf16 (threaded)", ms, baselineMs, numBytes);
+
+  std::cout << "bf16 -> float" << std::endl;
+  baselineMs = timeIt(numIterations, [&] {
+    convertBf16ToFloatScalar(output.data(), bf16.data(), numElements);
+  });
+  report("scalar", baselineMs, baselineMs, numBytes);
+  for (Bf16ConversionIsa isa : isas) {
+    if (isa == Bf16ConversionIsa::Scalar) continue;
+    double ms = timeIt(numIterations, [&] {
+      convertBf16ToFloat(output.data(), bf16.data(), numElements, isa);
+    });
+    report(getBf16ConversionIsaName(isa), ms, baselineMs, numBytes);
+  }
+  ms = timeIt(numIterations, [&] {
+    copyBf16ToFloat(output.data(), bf16.data(), numElements);
+  });
+  report("copyBf16ToFloat (threaded)", ms, baselineMs, numBytes);
+  return 0;
+}
@@ -0,0 +1,381 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// CPU matmul for the AIE delegate's CPU fallback: `result = lhs * rhs` with
+// row-major bfloat16 or float operands.
+//
+// The matmul is cache-blocked and packed.  The output is split into work items
+// of GemmRowsPerItem rows by GemmNC columns, spread over multiple threads.
+// Each work item walks the K dimension in blocks of GemmKC: it converts the
+// GemmKC x GemmNC block of the RHS into panels of GemmNR columns, and then
+// every GemmMC x GemmKC block of the LHS into panels of GemmMR rows, so both
+// stay cache resident while they're used and only the part of the RHS in use
+// is ever converted.  A GemmMR x GemmNR micro-kernel accumulates each output
+// tile with its accumulators in registers, using AVX-512 or AVX2+FMA when
+// available.
+//
+// With `bf16Accumulate`, every product and every partial sum is rounded to
+// bfloat16, as an emulation of a bfloat16 accumulator.  This path keeps the
+// blocking and threading but uses the generic micro-kernel.
+
+#ifndef IREE_AMD_AIE_EXPERIMENTAL_DELEGATE_CPU_GEMM_H_
+#define IREE_AMD_AIE_EXPERIMENTAL_DELEGATE_CPU_GEMM_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "bf16_conversion.h"
+
+#if defined(BF16_CONVERSION_RUNTIME_DISPATCH)
+#define GEMM_TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+#define GEMM_HAS_AVX2_FMA 1
+#else
+#define GEMM_TARGET_AVX2_FMA
+#if defined(__AVX2__) && defined(__FMA__)
+#define GEMM_HAS_AVX2_FMA 1
+#endif
+#endif
+
+// Micro-kernel tile: rows of the LHS panels and columns of the RHS panels
+constexpr int64_t GemmMR = 6;
+constexpr int64_t GemmNR = 16;
+
+// Rows of the LHS packed at once.  A multiple of GemmMR.
+constexpr int64_t GemmMC = 16 * GemmMR;
+
+// RHS panels per work item
+constexpr int64_t GemmPanelsPerChunk = 16;
+
+// Columns of the RHS packed at once
+constexpr int64_t GemmNC = GemmPanelsPerChunk * GemmNR;
+
+// Rows of the output per work item.  A multiple of GemmMC, so that every
+// packed RHS block is used by several LHS blocks before being replaced.
+constexpr int64_t GemmRowsPerItem = 4 * GemmMC;
+
+// Depth of the packed LHS and RHS blocks, so that a GemmKC x GemmNR RHS panel
+// stays in L1 and the GemmMC x GemmKC LHS block in L2.
+constexpr int64_t GemmKC = 256;
+
+template <typename T>
+inline float gemmToFloat(T value) {
+  if constexpr (std::is_same_v<T, float>)
+    return value;
+  else
+    return bf16ToFloat(value);
+}
+
+template <typename T>
+inline T gemmFromFloat(float value) {
+  if constexpr (std::is_same_v<T, float>)
+    return value;
+  else
+    return floatToBf16(value);
+}
+
+inline float roundToBf16(float value) {
+  return bf16ToFloat(floatToBf16(value));
+}
+
+//=============================================================================
+// Micro-kernels
+//
+// Each computes c[GemmMR][GemmNR] += sum over k of a[k][i] * b[k][j], where
+// `a` is an LHS panel (GemmMR values per k) and `b` an RHS panel (GemmNR
+// values per k).
+
+template <bool Bf16Accumulate>
+inline void gemmMicroKernelGeneric(const float *a, const float *b, int64_t K,
+                                   float *c) {
+  float acc[GemmMR][GemmNR];
+  for (int64_t i = 0; i < GemmMR; ++i)
+    for (int64_t j = 0; j < GemmNR; ++j) acc[i][j] = c[i * GemmNR + j];
+  for (int64_t k = 0; k < K; ++k) {
+    const float *bk = b + k * GemmNR;
+    for (int64_t i = 0; i < GemmMR; ++i) {
+      float ai = a[k * GemmMR + i];
+      for (int64_t j = 0; j < GemmNR; ++j) {
+        if constexpr (Bf16Accumulate)
+          acc[i][j] = roundToBf16(acc[i][j] + roundToBf16(ai * bk[j]));
+        else
+          acc[i][j] += ai * bk[j];
+      }
+    }
+  }
+  for (int64_t i = 0; i < GemmMR; ++i)
+    for (int64_t j = 0; j < GemmNR; ++j) c[i * GemmNR + j] = acc[i][j];
+}
+
+#ifdef BF16_HAS_AVX512
+BF16_TARGET_AVX512 inline void gemmMicroKernelAvx512(const float *a,
+                                                     const float *b, int64_t K,
+                                                     float *c) {
+  static_assert(GemmMR == 6 && GemmNR == 16, "micro-kernel tile mismatch");
+  __m512 c0 = _mm512_loadu_ps(c + 0 * GemmNR);
+  __m512 c1 = _mm512_loadu_ps(c + 1 * GemmNR);
+  __m512 c2 = _mm512_loadu_ps(c + 2 * GemmNR);
+  __m512 c3 = _mm512_loadu_ps(c + 3 * GemmNR);
+  __m512 c4 = _mm512_loadu_ps(c + 4 * GemmNR);
+  __m512 c5 = _mm512_loadu_ps(c + 5 * GemmNR);
+  for (int64_t k = 0; k < K; ++k, a += GemmMR, b += GemmNR) {
+    __m512 bv = _mm512_loadu_ps(b);
+    c0 = _mm512_fmadd_ps(_mm512_set1_ps(a[0]), bv, c0);
+    c1 = _mm512_fmadd_ps(_mm512_set1_ps(a[1]), bv, c1);
+    c2 = _mm512_fmadd_ps(_mm512_set1_ps(a[2]), bv, c2);
+    c3 = _mm512_fmadd_ps(_mm512_set1_ps(a[3]), bv, c3);
+    c4 = _mm512_fmadd_ps(_mm512_set1_ps(a[4]), bv, c4);
+    c5 = _mm512_fmadd_ps(_mm512_set1_ps(a[5]), bv, c5);
+  }
+  _mm512_storeu_ps(c + 0 * GemmNR, c0);
+  _mm512_storeu_ps(c + 1 * GemmNR, c1);
+  _mm512_storeu_ps(c + 2 * GemmNR, c2);
+  _mm512_storeu_ps(c + 3 * GemmNR, c3);
+  _mm512_storeu_ps(c + 4 * GemmNR, c4);
+  _mm512_storeu_ps(c + 5 * GemmNR, c5);
+}
+#endif
+
+#ifdef GEMM_HAS_AVX2_FMA
+GEMM_TARGET_AVX2_FMA inline void gemmMicroKernelAvx2(const float *a,
+                                                     const float *b, int64_t K,
+                                                     float *c) {
+  static_assert(GemmMR == 6 && GemmNR == 16, "micro-kernel tile mismatch");
+  // Spelled out so that the 12 accumulators stay in registers
+  __m256 c00 = _mm256_loadu_ps(c + 0 * GemmNR);
+  __m256 c01 = _mm256_loadu_ps(c + 0 * GemmNR + 8);
+  __m256 c10 = _mm256_loadu_ps(c + 1 * GemmNR);
+  __m256 c11 = _mm256_loadu_ps(c + 1 * GemmNR + 8);
+  __m256 c20 = _mm256_loadu_ps(c + 2 * GemmNR);
+  __m256 c21 = _mm256_loadu_ps(c + 2 * GemmNR + 8);
+  __m256 c30 = _mm256_loadu_ps(c + 3 * GemmNR);
+  __m256 c31 = _mm256_loadu_ps(c + 3 * GemmNR + 8);
+  __m256 c40 = _mm256_loadu_ps(c + 4 * GemmNR);
+  __m256 c41 = _mm256_loadu_ps(c + 4 * GemmNR + 8);
+  __m256 c50 = _mm256_loadu_ps(c + 5 * GemmNR);
+  __m256 c51 = _mm256_loadu_ps(c + 5 * GemmNR + 8);
+  for (int64_t k = 0; k < K; ++k, a += GemmMR, b += GemmNR) {
+    __m256 b0 = _mm256_loadu_ps(b);
+    __m256 b1 = _mm256_loadu_ps(b + 8);
+    __m256 ai = _mm256_broadcast_ss(a + 0);
+    c00 = _mm256_fmadd_ps(ai, b0, c00);
+    c01 = _mm256_fmadd_ps(ai, b1, c01);
+    ai = _mm256_broadcast_ss(a + 1);
+    c10 = _mm256_fmadd_ps(ai, b0, c10);
+    c11 = _mm256_fmadd_ps(ai, b1, c11);
+    ai = _mm256_broadcast_ss(a + 2);
+    c20 = _mm256_fmadd_ps(ai, b0, c20);
+    c21 = _mm256_fmadd_ps(ai, b1, c21);
+    ai = _mm256_broadcast_ss(a + 3);
+    c30 = _mm256_fmadd_ps(ai, b0, c30);
+    c31 = _mm256_fmadd_ps(ai, b1, c31);
+    ai = _mm256_broadcast_ss(a + 4);
+    c40 = _mm256_fmadd_ps(ai, b0, c40);
+    c41 = _mm256_fmadd_ps(ai, b1, c41);
+    ai = _mm256_broadcast_ss(a + 5);
+    c50 = _mm256_fmadd_ps(ai, b0, c50);
+    c51 = _mm256_fmadd_ps(ai, b1, c51);
+  }
+  _mm256_storeu_ps(c + 0 * GemmNR, c00);
+  _mm256_storeu_ps(c + 0 * GemmNR + 8, c01);
+  _mm256_storeu_ps(c + 1 * GemmNR, c10);
+  _mm256_storeu_ps(c + 1 * GemmNR + 8, c11);
+  _mm256_storeu_ps(c + 2 * GemmNR, c20);
+  _mm256_storeu_ps(c + 2 * GemmNR + 8, c21);
+  _mm256_storeu_ps(c + 3 * GemmNR, c30);
+  _mm256_storeu_ps(c + 3 * GemmNR + 8, c31);
+  _mm256_storeu_ps(c + 4 * GemmNR, c40);
+  _mm256_storeu_ps(c + 4 * GemmNR + 8, c41);
+  _mm256_storeu_ps(c + 5 * GemmNR, c50);
+  _mm256_storeu_ps(c + 5 * GemmNR + 8, c51);
+}
+#endif
+
+//=============================================================================
+// ISA selection
+
+enum class GemmIsa { Generic, Avx2Fma, Avx512 };
+
+inline const char *getGemmIsaName(GemmIsa isa) {
+  switch (isa) {
+    case GemmIsa::Avx2Fma:
+      return "avx2+fma";
+    case GemmIsa::Avx512:
+      return "avx512";
+    default:
+      return "generic";
+  }
+}
+
+// Widest micro-kernel usable on the running CPU
+inline GemmIsa getBestGemmIsa() {
+  static const GemmIsa isa = [] {
+#if defined(BF16_CONVERSION_RUNTIME_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return GemmIsa::Avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+      return GemmIsa::Avx2Fma;
+    return GemmIsa::Generic;
+#elif defined(BF16_HAS_AVX512)
+    return GemmIsa::Avx512;
+#elif defined(GEMM_HAS_AVX2_FMA)
+    return GemmIsa::Avx2Fma;
+#else
+    return GemmIsa::Generic;
+#endif
+  }();
+  return isa;
+}
+
+inline void gemmMicroKernel(GemmIsa isa, bool bf16Accumulate, const float *a,
+                            const float *b, int64_t K, float *c) {
+  if (bf16Accumulate)
+    return gemmMicroKernelGeneric<true>(a, b, K, c);
+  switch (isa) {
+#ifdef BF16_HAS_AVX512
+    case GemmIsa::Avx512:
+      return gemmMicroKernelAvx512(a, b, K, c);
+#endif
+#ifdef GEMM_HAS_AVX2_FMA
+    case GemmIsa::Avx2Fma:
+      return gemmMicroKernelAvx2(a, b, K, c);
+#endif
+    default:
+      return gemmMicroKernelGeneric<false>(a, b, K, c);
+  }
+}
+
+//=============================================================================
+// Packing
+
+// Packs rows [k0, k0 + kc) and columns [col0, col0 + GemmNR) of the K x N
+// `rhs` into `packed` (kc x GemmNR floats), padding the columns past N with
+// zeros.
+template <typename RhsT>
+void gemmPackRhsPanel(const RhsT *rhs, int64_t N, int64_t k0, int64_t kc,
+                      int64_t col0, float *packed) {
+  Bf16ConversionIsa isa = getBestBf16ConversionIsa();
+  int64_t numCols = std::min(GemmNR, N - col0);
+  for (int64_t k = 0; k < kc; ++k) {
+    const RhsT *src = rhs + (k0 + k) * N + col0;
+    float *dst = packed + k * GemmNR;
+    if constexpr (std::is_same_v<RhsT, float>)
+      std::copy(src, src + numCols, dst);
+    else
+      convertBf16ToFloat(dst, src, std::size_t(numCols), isa);
+    for (int64_t j = numCols; j < GemmNR; ++j) dst[j] = 0.0f;
+  }
+}
+
+// Packs rows [row0, row0 + numRows) and columns [k0, k0 + kc) of the M x K
+// `lhs` into panels of GemmMR rows (kc x GemmMR floats each), padding the last
+// panel with zero rows.
+template <typename LhsT>
+void gemmPackLhsBlock(const LhsT *lhs, int64_t K, int64_t row0,
+                      int64_t numRows, int64_t k0, int64_t kc, float *packed) {
+  for (int64_t p = 0; p * GemmMR < numRows; ++p) {
+    float *panel = packed + p * kc * GemmMR;
+    for (int64_t i = 0; i < GemmMR; ++i) {
+      int64_t row = p * GemmMR + i;
+      if (row < numRows) {
+        const LhsT *src = lhs + (row0 + row) * K + k0;
+        for (int64_t k = 0; k < kc; ++k)
+          panel[k * GemmMR + i] = gemmToFloat(src[k]);
+      } else {
+        for (int64_t k = 0; k < kc; ++k) panel[k * GemmMR + i] = 0.0f;
+      }
+    }
+  }
+}
+
+//=============================================================================
+// Driver
+
+// Computes the M x N `result` = `lhs` (M x K) * `rhs` (K x N), all row-major.
+// `numThreads` = 0 uses all hardware threads.
+template <typename LhsT, typename RhsT, typename ResultT>
+void cpuGemm(const LhsT *lhs, const RhsT *rhs, ResultT *result, int64_t M,
+             int64_t N, int64_t K, bool bf16Accumulate,
+             GemmIsa isa = getBestGemmIsa(), unsigned numThreads = 0) {
+  if (M <= 0 || N <= 0)
+    return;
+  int64_t numPanels = (N + GemmNR - 1) / GemmNR;
+  int64_t numRowGroups = (M + GemmRowsPerItem - 1) / GemmRowsPerItem;
+  int64_t numChunks = (N + GemmNC - 1) / GemmNC;
+  int64_t numItems = numRowGroups * numChunks;
+  if (numThreads == 0) {
+    // hardware_concurrency() can hit the file system: query it once
+    static const unsigned hwThreads =
+        std::max(1u, std::thread::hardware_concurrency());
+    numThreads = hwThreads;
+  }
+  numThreads = unsigned(std::min<int64_t>(numThreads, numItems));
+
+  std::atomic<int64_t> nextItem{0};
+  auto worker = [&] {
+    std::vector<float> packedLhs(std::size_t(GemmMC) * GemmKC);
+    std::vector<float> packedRhs(std::size_t(GemmKC) * GemmNC);
+    // Accumulators of the work item, in micro-kernel tiles: a column of
+    // GemmRowsPerItem / GemmMR tiles for every RHS panel
+    std::vector<float> acc(std::size_t(GemmRowsPerItem) * GemmNC);
+    for (int64_t item = nextItem++; item < numItems; item = nextItem++) {
+      int64_t group = item / numChunks;
+      int64_t chunk = item % numChunks;
+      int64_t groupRow0 = group * GemmRowsPerItem;
+      int64_t numGroupRows = std::min(GemmRowsPerItem, M - groupRow0);
+      int64_t numRowPanels = (numGroupRows + GemmMR - 1) / GemmMR;
+      int64_t panel0 = chunk * GemmPanelsPerChunk;
+      int64_t numChunkPanels =
+          std::min(numPanels, panel0 + GemmPanelsPerChunk) - panel0;
+      auto getTile = [&](int64_t p, int64_t r) {
+        return acc.data() + (p * numRowPanels + r) * GemmMR * GemmNR;
+      };
+      std::fill(acc.begin(), acc.end(), 0.0f);
+      for (int64_t k0 = 0; k0 < K; k0 += GemmKC) {
+        int64_t kc = std::min(GemmKC, K - k0);
+        for (int64_t p = 0; p < numChunkPanels; ++p)
+          gemmPackRhsPanel(rhs, N, k0, kc, (panel0 + p) * GemmNR,
+                           packedRhs.data() + p * kc * GemmNR);
+        for (int64_t i0 = 0; i0 < numGroupRows; i0 += GemmMC) {
+          int64_t numRows = std::min(GemmMC, numGroupRows - i0);
+          gemmPackLhsBlock(lhs, K, groupRow0 + i0, numRows, k0, kc,
+                           packedLhs.data());
+          for (int64_t p = 0; p < numChunkPanels; ++p) {
+            const float *b = packedRhs.data() + p * kc * GemmNR;
+            for (int64_t r = 0; r * GemmMR < numRows; ++r)
+              gemmMicroKernel(isa, bf16Accumulate,
+                              packedLhs.data() + r * kc * GemmMR, b, kc,
+                              getTile(p, i0 / GemmMR + r));
+          }
+        }
+      }
+      for (int64_t p = 0; p < numChunkPanels; ++p) {
+        int64_t col0 = (panel0 + p) * GemmNR;
+        int64_t numCols = std::min(GemmNR, N - col0);
+        for (int64_t r = 0; r < numRowPanels; ++r) {
+          const float *tile = getTile(p, r);
+          int64_t tileRows = std::min(GemmMR, numGroupRows - r * GemmMR);
+          for (int64_t i = 0; i < tileRows; ++i) {
+            ResultT *dst = result + (groupRow0 + r * GemmMR + i) * N + col0;
+            for (int64_t j = 0; j < numCols; ++j)
+              dst[j] = gemmFromFloat<ResultT>(tile[i * GemmNR + j]);
+          }
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < numThreads; ++t) threads.emplace_back(worker);
+  worker();
+  for (std::thread &thread : threads) thread.join();
+}
+
+#endif  // IREE_AMD_AIE_EXPERIMENTAL_DELEGATE_CPU_GEMM_H_
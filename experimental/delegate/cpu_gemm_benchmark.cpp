@@ -0,0 +1,133 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Microbenchmark and correctness check of the AIE delegate's CPU fallback
+// matmul (cpu_gemm.h) against a naive triple loop, with bf16 operands and an
+// f32 result like the delegate kernels.
+//
+// Usage: cpu_gemm_benchmark [M K N] [numIterations]
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cpu_gemm.h"
+
+namespace {
+
+// The delegate's original scalar implementation
+void naiveGemm(const bfloat16_t *lhs, const bfloat16_t *rhs, float *result,
+               int64_t M, int64_t N, int64_t K, bool bf16Accumulate) {
+  for (int64_t i = 0; i < M; ++i)
+    for (int64_t j = 0; j < N; ++j) {
+      float acc = 0.0f;
+      for (int64_t k = 0; k < K; ++k) {
+        float product = bf16ToFloat(lhs[i * K + k]) * bf16ToFloat(rhs[k * N + j]);
+        acc = bf16Accumulate ? roundToBf16(acc + roundToBf16(product))
+                             : acc + product;
+      }
+      result[i * N + j] = acc;
+    }
+}
+
+double timeIt(int numIterations, const std::function<void()> &fn) {
+  double best = std::numeric_limits<double>::max();
+  for (int i = 0; i < numIterations; ++i) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    fn();
+    auto endTime = std::chrono::high_resolution_clock::now();
+    best = std::min(
+        best, std::chrono::duration<double, std::milli>(endTime - startTime)
+                  .count());
+  }
+  return best;
+}
+
+// Largest difference relative to the magnitude of the reference
+double maxRelativeError(const std::vector<float> &expected,
+                        const std::vector<float> &actual) {
+  double maxError = 0.0;
+  for (std::size_t i = 0; i < expected.size(); ++i)
+    maxError = std::max(maxError, std::abs(double(expected[i]) - actual[i]) /
+                                      std::max(1.0, std::abs(double(expected[i]))));
+  return maxError;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int64_t M = argc > 3 ? std::atoll(argv[1]) : 512;
+  int64_t K = argc > 3 ? std::atoll(argv[2]) : 512;
+  int64_t N = argc > 3 ? std::atoll(argv[3]) : 512;
+  int numIterations = argc > 4 ? std::atoi(argv[4]) : 3;
+
+  std::vector<bfloat16_t> lhs(M * K), rhs(K * N);
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  for (bfloat16_t &v : lhs) v = floatToBf16(dist(gen));
+  for (bfloat16_t &v : rhs) v = floatToBf16(dist(gen));
+  std::vector<float> expected(M * N), actual(M * N);
+
+  GemmIsa bestIsa = getBestGemmIsa();
+  std::vector<GemmIsa> isas = {GemmIsa::Generic};
+  if (bestIsa == GemmIsa::Avx512) isas.push_back(GemmIsa::Avx2Fma);
+  if (bestIsa != GemmIsa::Generic) isas.push_back(bestIsa);
+
+  std::cout << "Matmul " << M << "x" << K << "x" << N << " (MxKxN), "
+            << "iterations: " << numIterations
+            << ", threads: " << std::thread::hardware_concurrency()
+            << std::endl;
+  double gflop = 2.0 * M * N * K / 1.0e9;
+  auto report = [&](const std::string &name, double ms, double baselineMs,
+                    double error) {
+    std::cout << "  " << std::left << std::setw(28) << name << std::right
+              << std::fixed << std::setprecision(3) << std::setw(10) << ms
+              << " ms " << std::setprecision(2) << std::setw(8)
+              << gflop / ms * 1.0e3 << " GFLOP/s " << std::setw(8)
+              << baselineMs / ms << "x  max rel err " << std::scientific
+              << std::setprecision(2) << error << std::endl;
+  };
+
+  bool ok = true;
+  for (bool bf16Accumulate : {false, true}) {
+    std::cout << (bf16Accumulate ? "bf16 accumulator" : "f32 accumulator")
+              << std::endl;
+    double baselineMs = timeIt(1, [&] {
+      naiveGemm(lhs.data(), rhs.data(), expected.data(), M, N, K,
+                bf16Accumulate);
+    });
+    report("naive", baselineMs, baselineMs, 0.0);
+    for (GemmIsa isa : isas) {
+      if (bf16Accumulate && isa != GemmIsa::Generic) continue;
+      for (unsigned numThreads : {1u, 0u}) {
+        double ms = timeIt(numIterations, [&] {
+          cpuGemm(lhs.data(), rhs.data(), actual.data(), M, N, K,
+                  bf16Accumulate, isa, numThreads);
+        });
+        double error = maxRelativeError(expected, actual);
+        // The bf16 accumulation order is the same as the naive loop, so it
+        // must match exactly.  The f32 one differs only by FMA rounding.
+        if (bf16Accumulate ? error != 0.0 : error > 1.0e-4) ok = false;
+        report(std::string(getGemmIsaName(isa)) +
+                   (numThreads == 1 ? ", 1 thread" : ", all threads"),
+               ms, baselineMs, error);
+      }
+    }
+  }
+  if (!ok) {
+    std::cerr << "MISMATCH between cpuGemm and the naive matmul" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,71 @@
+// RUN: python3 %p/generate_offload_pdl.py --manifest %p/kernels/manifest.txt --model %s -o %t.pdl.mlir | FileCheck %s --check-prefix=SUMMARY
+// RUN: FileCheck %s --check-prefix=PDL --input-file=%t.pdl.mlir
+// RUN: iree-opt --pass-pipeline="builtin.module(iree-preprocessing-apply-pdl-patterns{patterns-file=%t.pdl.mlir}, cse)" %s | FileCheck %s
+
+// Checks the PDL spec generated from the kernel manifest for this model: only
+// the large bf16 matmul is worth offloading, the small one is left on the CPU
+// by the estimates and the f32 one by its dtypes.
+
+// SUMMARY: 1 matmul shape(s) offloaded to
+// SUMMARY-NEXT: left on CPU: matmul 8x768x768: estimated {{.+}} ms on NPU, {{.+}} ms on CPU
+// SUMMARY-NEXT: left on CPU: matmul 64x64x64 with dtypes f32, f32, f32
+
+// PDL: GENERATED by generate_offload_pdl.py
+// PDL: // matmul 8192x9728x2432 (kernel 8192x9728x2432): estimated
+// PDL: pdl.pattern @mlp_matmul_8192x9728x2432 : benefit(1) {
+// PDL-NEXT: %lhs_type = pdl.type : tensor<8192x2432xbf16>
+// PDL-NEXT: %rhs_type = pdl.type : tensor<2432x9728xbf16>
+// PDL-NEXT: %matmul_type = pdl.type : tensor<8192x9728xf32>
+// PDL: %fn_name = pdl.attribute = "mlp_external"
+// PDL-NOT: pdl.pattern
+
+#x86_64_target = #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {
+  data_layout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128",
+  native_vector_size = 32 : index,
+  target_triple = "x86_64-none-elf"
+}>
+
+#cpu_target = #hal.device.target<"llvm-cpu", [
+  #x86_64_target
+]>
+
+module @example attributes {hal.device.targets = [#cpu_target]} {
+// CHECK-LABEL: module @example
+// CHECK: stream.executable private @mlp_external_bf16_bf16_f32_i32_i32_i32_executable {
+// CHECK: func.func private @mlp_external(memref<bf16>, index, memref<bf16>, index, memref<f32>, index, i32, i32, i32)
+
+  func.func @large(%lhs: tensor<8192x2432xbf16>,
+                   %rhs: tensor<2432x9728xbf16>) -> (tensor<8192x9728xf32>) {
+    %cst = arith.constant 0.000000e+00 : f32
+    %0 = tensor.empty() : tensor<8192x9728xf32>
+    %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<8192x9728xf32>) -> tensor<8192x9728xf32>
+    %2 = linalg.matmul ins(%lhs, %rhs : tensor<8192x2432xbf16>, tensor<2432x9728xbf16>) outs(%1 : tensor<8192x9728xf32>) -> tensor<8192x9728xf32>
+    return %2 : tensor<8192x9728xf32>
+  }
+// CHECK: func.func @large
+// CHECK: flow.dispatch @mlp_external_bf16_bf16_f32_i32_i32_i32_executable::@mlp_external_entry_point({{.+}}) : (tensor<8192x2432xbf16>, tensor<2432x9728xbf16>, i32, i32, i32) -> tensor<8192x9728xf32>
+
+  func.func @small(%lhs: tensor<8x768xbf16>,
+                   %rhs: tensor<768x768xbf16>) -> (tensor<8x768xf32>) {
+    %cst = arith.constant 0.000000e+00 : f32
+    %0 = tensor.empty() : tensor<8x768xf32>
+    %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<8x768xf32>) -> tensor<8x768xf32>
+    %2 = linalg.matmul ins(%lhs, %rhs : tensor<8x768xbf16>, tensor<768x768xbf16>) outs(%1 : tensor<8x768xf32>) -> tensor<8x768xf32>
+    return %2 : tensor<8x768xf32>
+  }
+// CHECK: func.func @small
+// CHECK-NOT: flow.dispatch
+// CHECK: linalg.matmul
+
+  func.func @f32(%lhs: tensor<64x64xf32>,
+                 %rhs: tensor<64x64xf32>) -> (tensor<64x64xf32>) {
+    %cst = arith.constant 0.000000e+00 : f32
+    %0 = tensor.empty() : tensor<64x64xf32>
+    %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<64x64xf32>) -> tensor<64x64xf32>
+    %2 = linalg.matmul ins(%lhs, %rhs : tensor<64x64xf32>, tensor<64x64xf32>) outs(%1 : tensor<64x64xf32>) -> tensor<64x64xf32>
+    return %2 : tensor<64x64xf32>
+  }
+// CHECK: func.func @f32
+// CHECK-NOT: flow.dispatch
+// CHECK: linalg.matmul
+}  // module
@@ -0,0 +1,349 @@
+# Copyright 2024 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+# Generates a PDL spec that offloads matmuls to the AIE delegate, from the
+# delegate's kernel manifest.
+#
+# Example:
+# ```
+# python generate_offload_pdl.py --manifest kernels/manifest.txt \
+#     --model large-matmul.mlir -o large-matmul.auto.pdl.mlir
+# iree-compile large-matmul.mlir \
+#     --iree-preprocessing-pdl-spec-filename=large-matmul.auto.pdl.mlir ...
+# ```
+#
+# Each `linalg.matmul` and `linalg.batch_matmul` (with a batch of 1) of the
+# model with static shapes and the delegate's model dtypes is considered.  The
+# delegate runs a matmul on the kernel of its shape, or tiles it with padding
+# onto the kernel that needs the least padded work, so every shape is
+# supported.  A matmul is offloaded only if a rough estimate of its NPU time,
+# including the host staging, beats the estimate of its CPU time.  The rest
+# are left to llvm-cpu.  The estimates are tunable with the `--npu-*` and
+# `--cpu-*` options.
+#
+# Without `--model`, patterns are generated for the exact shapes of the
+# manifest's kernels.
+#
+# PDL patterns match fixed types, so there is one pattern per offloaded
+# (op, shape).  All the patterns call the same external function, whose
+# dtypes must match `ModelLhsDType`, `ModelRhsDType` and `ModelReturnDType` in
+# mlp_aie_bf16_plugin.cpp (see `--lhs-type` etc.).
+
+import argparse
+import math
+import re
+import sys
+
+DTYPE_SIZES = {"bf16": 2, "f32": 4}
+
+C_TYPES = {"bf16": "bfloat16_t", "f32": "float"}
+
+
+class KernelSpec:
+    def __init__(self, m, k, n, lhs_type, rhs_type, result_type):
+        self.m = m
+        self.k = k
+        self.n = n
+        self.lhs_type = lhs_type
+        self.rhs_type = rhs_type
+        self.result_type = result_type
+
+    def num_tiles(self, m, k, n):
+        return (
+            math.ceil(m / self.m) * math.ceil(k / self.k) * math.ceil(n / self.n)
+        )
+
+    def shape_str(self):
+        return f"{self.m}x{self.n}x{self.k}"
+
+
+class Matmul:
+    def __init__(self, op, batch, m, k, n, lhs_type, rhs_type, result_type):
+        self.op = op  # "matmul" or "batch_matmul"
+        self.batch = batch  # None for matmul
+        self.m = m
+        self.k = k
+        self.n = n
+        self.lhs_type = lhs_type
+        self.rhs_type = rhs_type
+        self.result_type = result_type
+
+    def key(self):
+        return (self.op, self.batch, self.m, self.k, self.n, self.lhs_type,
+                self.rhs_type, self.result_type)
+
+    def shape_str(self):
+        return f"{self.m}x{self.n}x{self.k}"
+
+    def tensor_type(self, rows, cols, dtype):
+        batch = "" if self.batch is None else f"{self.batch}x"
+        return f"tensor<{batch}{rows}x{cols}x{dtype}>"
+
+
+def read_manifest(path):
+    """Reads the kernels of a manifest (see `KernelRegistry` in
+    mlp_aie_bf16_plugin.cpp)."""
+    specs = []
+    with open(path) as f:
+        for line_num, line in enumerate(f, 1):
+            fields = line.split()
+            if not fields or fields[0].startswith("#"):
+                continue
+            if len(fields) < 9 or any(t not in DTYPE_SIZES for t in fields[3:6]):
+                sys.exit(f"Malformed kernel manifest entry at {path}:{line_num}")
+            m, k, n = (int(x) for x in fields[:3])
+            specs.append(KernelSpec(m, k, n, *fields[3:6]))
+    if not specs:
+        sys.exit(f"No kernels in kernel manifest {path}")
+    return specs
+
+
+MATMUL_RE = re.compile(
+    r"linalg\.(matmul|batch_matmul)\s+ins\([^:]*:\s*tensor<([^>]*)>\s*,\s*"
+    r"tensor<([^>]*)>\s*\)\s*outs\([^:]*:\s*tensor<([^>]*)>\s*\)"
+)
+
+
+def parse_tensor_type(type_str):
+    """Returns the dims and dtype of `AxBx...xdtype`, or None if dynamic."""
+    parts = type_str.replace(" ", "").split("x")
+    if any(not p.isdigit() for p in parts[:-1]):
+        return None
+    return [int(p) for p in parts[:-1]], parts[-1]
+
+
+def find_matmuls(model_path):
+    """Returns the distinct static matmuls of a model, with the reason for
+    each one that is skipped."""
+    with open(model_path) as f:
+        text = f.read()
+    matmuls = {}
+    skipped = []
+    for match in MATMUL_RE.finditer(text):
+        op = match.group(1)
+        types = [parse_tensor_type(match.group(i)) for i in (2, 3, 4)]
+        if any(t is None for t in types):
+            skipped.append(f"{match.group(0).split()[0]} with dynamic shapes")
+            continue
+        (lhs_dims, lhs_type), (rhs_dims, rhs_type), (_, result_type) = types
+        batch = None
+        if op == "batch_matmul":
+            batch = lhs_dims[0]
+            if batch != 1:
+                skipped.append(f"batch_matmul with a batch of {batch}")
+                continue
+            lhs_dims, rhs_dims = lhs_dims[1:], rhs_dims[1:]
+        matmul = Matmul(op, batch, lhs_dims[0], lhs_dims[1], rhs_dims[1],
+                        lhs_type, rhs_type, result_type)
+        matmuls.setdefault(matmul.key(), matmul)
+    return list(matmuls.values()), skipped
+
+
+def find_kernel(specs, m, k, n):
+    """Mirrors `KernelRegistry::find` and `findTilingKernel`."""
+    for spec in specs:
+        if (spec.m, spec.k, spec.n) == (m, k, n):
+            return spec
+    return min(
+        specs,
+        key=lambda s: (s.num_tiles(m, k, n) * s.m * s.k * s.n,
+                       s.num_tiles(m, k, n)),
+    )
+
+
+def estimate_npu_seconds(args, spec, matmul):
+    runs = spec.num_tiles(matmul.m, matmul.k, matmul.n)
+    kernel_macs = spec.m * spec.k * spec.n
+    staged_bytes = runs * (
+        spec.m * spec.k * DTYPE_SIZES[spec.lhs_type]
+        + spec.k * spec.n * DTYPE_SIZES[spec.rhs_type]
+    ) + matmul.m * matmul.n * DTYPE_SIZES[spec.result_type]
+    return (
+        runs * (args.npu_run_overhead_us * 1e-6 + kernel_macs / (args.npu_gmacs * 1e9))
+        + staged_bytes / (args.npu_staging_gbps * 1e9)
+        + args.npu_call_overhead_us * 1e-6
+    )
+
+
+def estimate_cpu_seconds(args, matmul):
+    return matmul.m * matmul.k * matmul.n / (args.cpu_gmacs * 1e9)
+
+
+def emit_header(out, args):
+    lhs, rhs, res = (C_TYPES[t] for t in (args.lhs_type, args.rhs_type,
+                                          args.result_type))
+    out.write(f"""\
+// PDL pattern spec to offload matmuls to the AIE delegate
+//
+// GENERATED by generate_offload_pdl.py from {args.manifest}; do not edit.
+//
+// Every pattern rewrites one matmul shape to a call to
+//
+// ```
+// void mlp_external(void *params, void *context, void *reserved)
+// ```
+//
+// which is implemented by the AIE delegate plugin, with `params` being
+//
+// ```
+// using bfloat16_t = unsigned short;
+//
+// struct mlp_params_t {{
+//   const {lhs} *restrict lhs;
+//   size_t lhs_offset;
+//   const {rhs} *restrict rhs;
+//   size_t rhs_offset;
+//   {res} *restrict result;
+//   size_t result_offset;
+//   int32_t M;
+//   int32_t N;
+//   int32_t K;
+// }};
+// ```
+//
+// See large-matmul.pdl.mlir for a commented example of such a pattern.
+""")
+
+
+def emit_pattern(out, matmul, spec, npu_s, cpu_s):
+    lhs_type = matmul.tensor_type(matmul.m, matmul.k, matmul.lhs_type)
+    rhs_type = matmul.tensor_type(matmul.k, matmul.n, matmul.rhs_type)
+    result_type = matmul.tensor_type(matmul.m, matmul.n, matmul.result_type)
+    kernel = (
+        f"kernel {spec.shape_str()}"
+        if (spec.m, spec.k, spec.n) == (matmul.m, matmul.k, matmul.n)
+        else f"tiled onto kernel {spec.shape_str()}"
+    )
+    out.write(f"""
+// {matmul.op} {matmul.shape_str()} ({kernel}): estimated {npu_s * 1e3:.3f} ms
+// on NPU, {cpu_s * 1e3:.3f} ms on CPU
+pdl.pattern @mlp_{matmul.op}_{matmul.shape_str()} : benefit(1) {{
+  %lhs_type = pdl.type : {lhs_type}
+  %rhs_type = pdl.type : {rhs_type}
+  %matmul_type = pdl.type : {result_type}
+  %fixed_M = pdl.attribute = {matmul.m} : i32
+  %fixed_N = pdl.attribute = {matmul.n} : i32
+  %fixed_K = pdl.attribute = {matmul.k} : i32
+
+  %zero_attr = pdl.attribute = 0.0 : {matmul.result_type}
+  %zero_type = pdl.type : {matmul.result_type}
+  %zero_op = pdl.operation "arith.constant" {{"value" = %zero_attr}} -> (%zero_type : !pdl.type)
+  %zero = pdl.result 0 of %zero_op
+
+  %empty = pdl.operand
+  %fill_op = pdl.operation "linalg.fill" (%zero, %empty : !pdl.value, !pdl.value) -> (%matmul_type : !pdl.type)
+  %fill = pdl.result 0 of %fill_op
+
+  %lhs = pdl.operand : %lhs_type
+  %rhs = pdl.operand : %rhs_type
+  %matmul = pdl.operation "linalg.{matmul.op}" (%lhs, %rhs, %fill : !pdl.value, !pdl.value, !pdl.value) -> (%matmul_type : !pdl.type)
+
+  pdl.rewrite %matmul {{
+    %i32_type = pdl.type : i32
+    %m_op = pdl.operation "arith.constant" {{"value" = %fixed_M}} -> (%i32_type : !pdl.type)
+    %m = pdl.result 0 of %m_op
+    %n_op = pdl.operation "arith.constant" {{"value" = %fixed_N}} -> (%i32_type : !pdl.type)
+    %n = pdl.result 0 of %n_op
+    %k_op = pdl.operation "arith.constant" {{"value" = %fixed_K}} -> (%i32_type : !pdl.type)
+    %k = pdl.result 0 of %k_op
+
+    %replaced_values_dims = pdl.range : !pdl.range<value>
+    %input_values = pdl.range %lhs, %rhs : !pdl.value, !pdl.value
+    %replaced_value = pdl.result 0 of %matmul
+    %replaced_values = pdl.range %replaced_value : !pdl.value
+    %other_operands = pdl.range %m, %n, %k : !pdl.value, !pdl.value, !pdl.value
+
+    %fn_name = pdl.attribute = "mlp_external"
+    pdl.apply_native_rewrite "rewriteAsFlowDispatch"(
+        %matmul, %fn_name, %input_values, %replaced_values, %replaced_values_dims, %other_operands
+        : !pdl.operation, !pdl.attribute, !pdl.range<value>, !pdl.range<value>, !pdl.range<value>, !pdl.range<value>)
+  }}
+}}
+""")
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(
+        description="Generator of a PDL spec offloading matmuls to the AIE "
+        "delegate"
+    )
+    parser.add_argument("--manifest", required=True,
+                        help="kernel manifest of the delegate")
+    parser.add_argument("--model",
+                        help="model whose matmuls to consider; without it, "
+                        "the manifest's kernel shapes are used")
+    parser.add_argument("-o", "--output", required=True,
+                        help="PDL spec to write")
+    for operand, default in (("lhs", "bf16"), ("rhs", "bf16"),
+                             ("result", "f32")):
+        parser.add_argument(f"--{operand}-type", default=default,
+                            choices=sorted(DTYPE_SIZES),
+                            help=f"model dtype of the {operand}, as set in "
+                            "the delegate (default: %(default)s)")
+    parser.add_argument("--batch-matmul", action="store_true",
+                        help="without --model, match batch_matmul instead of "
+                        "matmul")
+    parser.add_argument("--force", action="store_true",
+                        help="offload every supported matmul, ignoring the "
+                        "estimates")
+    parser.add_argument("--npu-gmacs", type=float, default=500.0,
+                        help="sustained NPU throughput in GMAC/s "
+                        "(default: %(default)s)")
+    parser.add_argument("--npu-run-overhead-us", type=float, default=100.0,
+                        help="cost of each kernel run in us "
+                        "(default: %(default)s)")
+    parser.add_argument("--npu-call-overhead-us", type=float, default=200.0,
+                        help="fixed cost of each delegate call in us "
+                        "(default: %(default)s)")
+    parser.add_argument("--npu-staging-gbps", type=float, default=10.0,
+                        help="host staging bandwidth in GB/s "
+                        "(default: %(default)s)")
+    parser.add_argument("--cpu-gmacs", type=float, default=100.0,
+                        help="CPU matmul throughput in GMAC/s "
+                        "(default: %(default)s)")
+    return parser.parse_args()
+
+
+def main(args):
+    specs = read_manifest(args.manifest)
+    if args.model:
+        matmuls, skipped = find_matmuls(args.model)
+    else:
+        op = "batch_matmul" if args.batch_matmul else "matmul"
+        matmuls = [
+            Matmul(op, 1 if args.batch_matmul else None, s.m, s.k, s.n,
+                   args.lhs_type, args.rhs_type, args.result_type)
+            for s in specs
+        ]
+        skipped = []
+
+    with open(args.output, "w") as out:
+        emit_header(out, args)
+        num_offloaded = 0
+        for matmul in matmuls:
+            dtypes = (matmul.lhs_type, matmul.rhs_type, matmul.result_type)
+            if dtypes != (args.lhs_type, args.rhs_type, args.result_type):
+                skipped.append(f"{matmul.op} {matmul.shape_str()} with dtypes "
+                               f"{', '.join(dtypes)}")
+                continue
+            spec = find_kernel(specs, matmul.m, matmul.k, matmul.n)
+            npu_s = estimate_npu_seconds(args, spec, matmul)
+            cpu_s = estimate_cpu_seconds(args, matmul)
+            if npu_s >= cpu_s and not args.force:
+                skipped.append(f"{matmul.op} {matmul.shape_str()}: estimated "
+                               f"{npu_s * 1e3:.3f} ms on NPU, "
+                               f"{cpu_s * 1e3:.3f} ms on CPU")
+                continue
+            emit_pattern(out, matmul, spec, npu_s, cpu_s)
+            num_offloaded += 1
+
+    print(f"{num_offloaded} matmul shape(s) offloaded to {args.output}")
+    for reason in skipped:
+        print(f"  left on CPU: {reason}")
+
+
+if __name__ == "__main__":
+    main(parse_arguments())
@@ -1,4 +1,5 @@
 // RUN: iree-opt --pass-pipeline="builtin.module(iree-preprocessing-apply-pdl-patterns{patterns-file=%p/linalg.pdl.mlir}, cse)" %s | FileCheck %s
+// RUN: iree-compile --iree-preprocessing-transform-spec-filename=%p/mlp_spec_async.mlir --compile-to=flow %s | FileCheck %s --check-prefix=ASYNC
 
 // CHECK-LABEL:   stream.executable private @mlp_external_f32_f32_f32_i32_i32_i32_executable
 //       CHECK:   stream.executable.export public @mlp_external_entry_point
@@ -97,3 +98,20 @@ module @example attributes {hal.device.targets = [#cpu_target]} {
     return %neg : tensor<?x?xf32>
   }
 }  // module
+
+// Check that the spec of the async demo queues the matmul in one dispatch and
+// waits for it in a second one, tied to the result, which the rest of the
+// model consumes
+// ASYNC-LABEL: module @example
+// ASYNC: stream.executable private @executable {
+// ASYNC: builtin.module {
+// ASYNC: func.func private @mlp_external_async(memref<f32>, index, memref<f32>, index, memref<f32>, index, i32, i32, i32)
+// ASYNC: func.func @mlp({{.+}}) {
+// ASYNC: call @mlp_external_async({{.+}}) : (memref<f32>, index, memref<f32>, index, memref<f32>, index, i32, i32, i32) -> ()
+// ASYNC: func.func private @mlp_external_wait(memref<f32>, index, memref<f32>, index, memref<f32>, index)
+// ASYNC: func.func @mlp_wait({{.+}}) {
+// ASYNC: call @mlp_external_wait({{.+}}) : (memref<f32>, index, memref<f32>, index, memref<f32>, index) -> ()
+// ASYNC: util.func public @mlp_invocation({{.+}}) -> {{.+}} {
+// ASYNC: %[[RESULT:.+]] = flow.dispatch @executable::@mlp({{.+}}) : (tensor<?x?xf32>{{.+}}, tensor<?x?xf32>{{.+}}, i32, i32, i32) -> tensor<?x?xf32>
+// ASYNC: %[[WAITED:.+]] = flow.dispatch @executable::@mlp_wait({{.+}}%[[RESULT]], {{.+}} -> %[[RESULT]]{
+// ASYNC: flow.dispatch @{{.+}}(%[[WAITED]]
@@ -14,17 +14,31 @@
 #include <stdio.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <exception>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
@@ -32,33 +46,24 @@
 #include "xrt/xrt_device.h"
 #include "xrt/xrt_kernel.h"
 
+#include "bf16_conversion.h"
+#include "cpu_gemm.h"
+
 // The only header required from IREE:
 #include "iree/hal/local/executable_plugin.h"
 
-// Delegate kernels
-#define REF_MATMUL_DELEGATE_KERNEL 1
-#define OPT_DELEGATE_KERNEL 2
-#define LARGE_MATMUL_DELEGATE_KERNEL 3
-#define MATMUL_16K_DELEGATE_KERNEL 4
-
 //#############################################################################
 //
 // Macros for configuring AIE delegate behavior
 //
 
-// Uncomment the kernel to use
-// #define DELEGATE_KERNEL_TO_USE REF_MATMUL_DELEGATE_KERNEL
-// #define DELEGATE_KERNEL_TO_USE OPT_DELEGATE_KERNEL
-// #define DELEGATE_KERNEL_TO_USE LARGE_MATMUL_DELEGATE_KERNEL
-#define DELEGATE_KERNEL_TO_USE MATMUL_16K_DELEGATE_KERNEL
-
 // Turn this on to use XRT buffers which are separate from HAL buffers.
 // There is a performance cost to copying between HAL and XRT buffer, but it
 // also isolates XRT code from HAL (for troubleshooting, for example).
 #define USE_INDIRECT_XRT_BUFFERS 1
 
-// Turn this on to replace the AIE implementation with a simple reference
-// implementation on CPU.
+// Turn this on to replace the AIE implementation with a CPU implementation
+// (see cpu_gemm.h).
 // #define USE_CPU_IMPLEMENTATION 1
 
 // Turn this on to use bfloat16 accumulation in the CPU implementation instead
@@ -68,6 +73,11 @@
 // Turn this on to print debug messages throughout the delegate run
 // #define ENABLE_TRACE_DELEGATE 1
 
+// Turn this on to accumulate the time spent in each phase of the delegate run
+// (see `PerfCounters`).  Nothing is printed unless requested with the
+// environment variables below.
+#define ENABLE_PERF_COUNTERS 1
+
 // Turn this on to dump matmul operand and result tensor values
 // #define DEBUG_VALUES 1
 
@@ -78,6 +88,32 @@
 // being done
 // #define ENABLE_PERFORMANCE_WARNING 1
 
+// Turn this on to convert between float and bfloat16 one element at a time
+// on the calling thread, instead of with SIMD instructions on multiple threads
+// (for troubleshooting, for example).
+// #define USE_SCALAR_DTYPE_CONVERSION 1
+
+// Turn this on to do all host-side staging (buffer copies and dtype
+// conversions) on the calling thread, instead of overlapping part of it with
+// the calling thread's work on a worker thread (for troubleshooting, for
+// example).
+// #define USE_SEQUENTIAL_STAGING 1
+
+// Turn this on to keep constant operands (the RHS weights) resident in XRT
+// buffers across calls, instead of copying and converting them on every call
+#define USE_WEIGHT_CACHE 1
+
+// Turn this on to identify cached weights by HAL buffer address alone,
+// skipping the content check.  This is only safe if the RHS of every
+// delegated matmul is a model constant.
+// #define WEIGHT_CACHE_TRUST_POINTERS 1
+
+// Turn this on to check cached weights against a fingerprint of evenly spaced
+// samples of their content, instead of a hash of their full content.  Saves
+// reading the whole RHS on every call, but misses a HAL buffer being reused
+// for data that only differs outside of the samples.
+// #define WEIGHT_CACHE_SAMPLED_HASH 1
+
 //#############################################################################
 
 #if DEBUG_VALUE_CONVERSIONS
@@ -98,133 +134,60 @@
 #define TRACE_DELEGATE1(str_, arg1_)
 #endif
 
-  // Fake bfloat16 type (assuming no C++ 23)
-  using bfloat16_t = std::uint16_t;
-
-  //#############################################################################
-  //
-  // Configuration of the kernel that the AIE delegate uses
-  //
-
-#if DELEGATE_KERNEL_TO_USE == MATMUL_16K_DELEGATE_KERNEL
-// Kernel file names (without extension) relative to installation root
-const std::string kernelFileName =
-    "matmul/matmul-bf16-f32-16384x16384X512-phx-v1";  // From AIE codegen
-
-// Kernel name inside the xclbin file
-const std::string KernelName =
-    "matmul_16384x16384_512xbf16__dispatch_0_matmul_1";
-
-// Fixed shape of the matmul kernel
-#define MLP_M 16384
-#define MLP_K 512
-#define MLP_N 16384
-
-// Types of the matmul LHS, RHS, and result, as defined by the kernel
-using A_DATATYPE = bfloat16_t;
-using B_DATATYPE = bfloat16_t;
-using C_DATATYPE = float;
+//#############################################################################
+//
+// Configuration of the model that the AIE delegate serves
+//
+// The kernels themselves are chosen at run time from the kernel manifest (see
+// `KernelRegistry` below).  The model dtypes, however, are fixed by the
+// signature of the external function that the PDL or Transform script
+// creates, so they must match the demo being run.
 
 // Types of the matmul LHS, RHS, and result, as seen by the model
 using ModelLhsDType = bfloat16_t;
 using ModelRhsDType = bfloat16_t;
 using ModelReturnDType = float;
 
-// Set to 1 if the kernel requires a pre-initialized buffer to be loaded
-// into the kernel before the kernel runs
-#define KERNEL_REQUIRES_RESULT_PRELOAD 0
-
-//-----------------------------------------------------------------------------
-
-#elif DELEGATE_KERNEL_TO_USE == LARGE_MATMUL_DELEGATE_KERNEL
-// Kernel file names (without extension) relative to installation root
-const std::string kernelFileName = 
-    "matmul/matmul-bf16-f32-8192x9728x2432-v1";  // From AIE codegen
-
-// Kernel name inside the xclbin file
-const std::string KernelName = "matmul_8192x9728_2432xbf16__dispatch_0_matmul_81";
-
-// Fixed shape of the matmul kernel
-#define MLP_M 8192
-#define MLP_K 2432
-#define MLP_N 9728
-
-// Types of the matmul LHS, RHS, and result, as defined by the kernel
-using A_DATATYPE = bfloat16_t;
-using B_DATATYPE = bfloat16_t;
-using C_DATATYPE = float; // bfloat16_t;
-
-// Types of the matmul LHS, RHS, and result, as seen by the model
-using ModelLhsDType = float; // bfloat16_t;
-using ModelRhsDType = float; // bfloat16_t;
-using ModelReturnDType = float;
-
-// Set to 1 if the kernel requires a pre-initialized buffer to be loaded
-// into the kernel before the kernel runs
-#define KERNEL_REQUIRES_RESULT_PRELOAD 0
-
-
-//-----------------------------------------------------------------------------
-
-#elif DELEGATE_KERNEL_TO_USE == OPT_DELEGATE_KERNEL
-// Kernel file names (without extension) relative to installation root
-const std::string kernelFileName = 
-    "matmul/matmul-bf16-f32-8x768x768-v1";  // Erwei's 4x4 vector matmul
-
-// Kernel name inside the xclbin file
-const std::string KernelName = "matmul_8x768_768xbf16__dispatch_0_matmul_8x768x7";
-
-// Fixed shape of the matmul kernel
-#define MLP_M 8
-#define MLP_K 768
-#define MLP_N 768
+// Name of the environment variable that overrides the path of the kernel
+// manifest.  By default, the manifest is `kernels/manifest.txt` under the
+// directory of this plugin's .so.
+const char *const ManifestEnvVar = "AIE_DELEGATE_MANIFEST";
 
-// Types of the matmul LHS, RHS, and result, as defined by the kernel
-using A_DATATYPE = bfloat16_t;
-using B_DATATYPE = bfloat16_t;
-using C_DATATYPE = float; // bfloat16_t;
+// Name of the environment variable that overrides the budget of the weight
+// cache, in MiB
+const char *const WeightCacheEnvVar = "AIE_DELEGATE_WEIGHT_CACHE_MB";
+const std::size_t DefaultWeightCacheMiB = 1024;
 
-// Types of the matmul LHS, RHS, and result, as seen by the model
-using ModelLhsDType = bfloat16_t;
-using ModelRhsDType = bfloat16_t;
-using ModelReturnDType = bfloat16_t;
+// Name of the environment variable that, if set to a nonzero value, prints a
+// summary of the performance counters at unload
+const char *const PerfSummaryEnvVar = "AIE_DELEGATE_PERF_SUMMARY";
 
-// Set to 1 if the kernel requires a pre-initialized buffer to be loaded
-// into the kernel before the kernel runs
-#define KERNEL_REQUIRES_RESULT_PRELOAD 0
+// Name of the environment variable with the path of a JSON trace of the
+// performance counters, written at unload
+const char *const PerfTraceEnvVar = "AIE_DELEGATE_PERF_TRACE";
 
-//-----------------------------------------------------------------------------
-
-#elif DELEGATE_KERNEL_TO_USE == REF_MATMUL_DELEGATE_KERNEL
-// Kernel file names (without extension) relative to installation root
-const std::string kernelFileName = "matmul/matmul-bf16-256x256x256-v1";
-
-// Kernel name inside the xclbin file
-const std::string KernelName = "MLIR_AIE";
-
-// Fixed shape of the matmul kernel
-#define MLP_M 256
-#define MLP_K 256
-#define MLP_N 256
-
-// Types of the matmul LHS, RHS, and result, as defined by the kernel
-using A_DATATYPE = bfloat16_t;
-using B_DATATYPE = bfloat16_t;
-using C_DATATYPE = float;
-
-// Types of the matmul LHS, RHS, and result, as seen by the model
-using ModelLhsDType = float;
-using ModelRhsDType = float;
-using ModelReturnDType = float;
-
-// Set to 1 if the kernel requires a pre-initialized buffer to be loaded
-// into the kernel before the kernel runs
-#define KERNEL_REQUIRES_RESULT_PRELOAD 0
+// Name of the environment variable that, if set to a nonzero value, prints the
+// kernels found at setup, each kernel as it is loaded, and the weight cache
+// statistics at unload.  Always on with ENABLE_TRACE_DELEGATE.
+const char *const VerboseEnvVar = "AIE_DELEGATE_VERBOSE";
 
+bool isDelegateVerbose() {
+#ifdef ENABLE_TRACE_DELEGATE
+  return true;
 #else
-#error "[AIE Delegate]: Unknown kernel.  \
-Set DELEGATE_KERNEL_TO_USE to a supported kernel."
+  static const bool verbose = [] {
+    const char *verboseEnv = std::getenv(VerboseEnvVar);
+    return verboseEnv && std::strtol(verboseEnv, nullptr, 10) != 0;
+  }();
+  return verbose;
 #endif
+}
+
+#define LOG_DELEGATE(args_)                                  \
+  do {                                                       \
+    if (isDelegateVerbose())                                 \
+      std::cout << "[AIE Delegate]: " << args_ << std::endl; \
+  } while (0)
 
 //#############################################################################
 //
@@ -291,6 +254,200 @@ std::string getLibraryPath() {
 std::string getLibraryPath() { return std::string(); }
 #endif
 
+//=============================================================================
+// Performance counters
+//
+// The time spent in each phase of the delegated matmuls is accumulated in
+// counters, which can be printed as a summary at unload, and optionally also
+// recorded as events of a JSON trace in the Chrome trace event format (viewable
+// with chrome://tracing or Perfetto).  Phases running concurrently on the
+// staging worker and the calling thread are both counted in full, so the
+// phase totals can add up to more than the `matmul` total.
+
+enum class PerfPhase {
+  Setup,           // reading the manifest and opening the device
+  LoadKernel,      // loading a kernel's xclbin and instructions
+  Matmul,          // a whole delegated matmul
+  Bind,            // mapping HAL buffers to XRT buffers
+  HashWeights,     // hashing the RHS for the weight cache
+  CopyIn,          // copying (and converting) inputs into XRT buffers
+  SyncToDevice,    // syncing input XRT buffers to the device
+  Kernel,          // from the start of a kernel run to the end of its wait
+  SyncFromDevice,  // syncing the result XRT buffer from the device
+  CopyOut,         // copying (and converting) the result out of XRT buffers
+  NumPhases
+};
+
+const char *getPerfPhaseName(PerfPhase phase) {
+  static const char *const names[] = {
+      "setup",        "load kernel", "matmul",         "bind",
+      "hash weights", "copy in",     "sync to device", "kernel",
+      "sync from device", "copy out"};
+  static_assert(std::size(names) == std::size_t(PerfPhase::NumPhases),
+                "missing PerfPhase name");
+  return names[std::size_t(phase)];
+}
+
+// Process-wide accumulator of per-phase times.  Used as a singleton via
+// `getInstance()`.  Recording is lock-free, except for trace events.
+class PerfCounters {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static PerfCounters &getInstance() {
+    static PerfCounters instance;
+    return instance;
+  }
+
+  // Starts recording trace events for `writeTrace`, on top of the counters
+  void enableTrace() {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    traceStart = Clock::now();
+    tracing = true;
+  }
+
+  bool isTracing() const { return tracing; }
+
+  void record(PerfPhase phase, Clock::time_point start, Clock::time_point end,
+              const std::string &detail = std::string()) {
+#ifdef ENABLE_PERF_COUNTERS
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      end - start).count();
+    Counter &counter = counters[std::size_t(phase)];
+    counter.count.fetch_add(1, std::memory_order_relaxed);
+    counter.totalNs.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t maxNs = counter.maxNs.load(std::memory_order_relaxed);
+    while (ns > maxNs && !counter.maxNs.compare_exchange_weak(
+                             maxNs, ns, std::memory_order_relaxed))
+      ;
+    if (tracing) {
+      std::lock_guard<std::mutex> lock(traceMutex);
+      events.push_back({phase, getThreadIndex(), start, end, detail});
+    }
+#endif
+  }
+
+  // Prints count, total, average, and maximum time of each phase seen so far
+  std::ostream &dumpSummary(std::ostream &os) const {
+    os << "[AIE Delegate]: Performance counters:" << std::endl;
+    os << "    " << std::left << std::setw(18) << "phase" << std::right
+       << std::setw(10) << "count" << std::setw(14) << "total ms"
+       << std::setw(12) << "avg ms" << std::setw(12) << "max ms" << std::endl;
+    for (std::size_t i = 0; i < std::size_t(PerfPhase::NumPhases); ++i) {
+      const Counter &counter = counters[i];
+      uint64_t count = counter.count.load(std::memory_order_relaxed);
+      if (count == 0)
+        continue;
+      double totalMs = counter.totalNs.load(std::memory_order_relaxed) / 1e6;
+      double maxMs = counter.maxNs.load(std::memory_order_relaxed) / 1e6;
+      os << "    " << std::left << std::setw(18)
+         << getPerfPhaseName(PerfPhase(i)) << std::right << std::setw(10)
+         << count << std::fixed << std::setprecision(3) << std::setw(14)
+         << totalMs << std::setw(12) << totalMs / count << std::setw(12)
+         << maxMs << std::defaultfloat << std::endl;
+    }
+    return os;
+  }
+
+  // Writes the trace events recorded since `enableTrace` to `path`
+  void writeTrace(const std::string &path) {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    std::ofstream file(path);
+    if (!file) {
+      std::ostringstream oss;
+      oss << "[AIE Delegate] FATAL ERROR: Can't write performance trace "
+          << path << std::endl;
+      throw DelegateException(oss.str());
+    }
+    auto toUs = [&](Clock::time_point t) {
+      return std::chrono::duration<double, std::micro>(t - traceStart).count();
+    };
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    const char *separator = "\n";
+    for (const Event &event : events) {
+      file << separator << "{\"name\": \"" << getPerfPhaseName(event.phase)
+           << "\", \"cat\": \"aie_delegate\", \"ph\": \"X\", \"pid\": 0"
+           << ", \"tid\": " << event.threadIndex << std::fixed
+           << std::setprecision(3) << ", \"ts\": " << toUs(event.start)
+           << ", \"dur\": " << toUs(event.end) - toUs(event.start);
+      if (!event.detail.empty())
+        file << ", \"args\": {\"detail\": \"" << event.detail << "\"}";
+      file << "}";
+      separator = ",\n";
+    }
+    file << "\n]}" << std::endl;
+  }
+
+  // Clears the counters and trace events, and stops tracing
+  void reset() {
+    for (Counter &counter : counters) {
+      counter.count = 0;
+      counter.totalNs = 0;
+      counter.maxNs = 0;
+    }
+    std::lock_guard<std::mutex> lock(traceMutex);
+    events.clear();
+    tracing = false;
+  }
+
+private:
+  struct Counter {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> maxNs{0};
+  };
+
+  struct Event {
+    PerfPhase phase;
+    int threadIndex;
+    Clock::time_point start, end;
+    std::string detail;
+  };
+
+  // Small, stable thread numbers for the trace
+  static int getThreadIndex() {
+    static std::atomic<int> numThreads{0};
+    thread_local int index = numThreads++;
+    return index;
+  }
+
+  Counter counters[std::size_t(PerfPhase::NumPhases)];
+  std::atomic<bool> tracing{false};
+  std::mutex traceMutex;  // guards the members below
+  Clock::time_point traceStart;
+  std::vector<Event> events;
+};
+
+// Records the time from its construction to its destruction (or to `stop`)
+// under a phase of the performance counters
+class PerfTimer {
+public:
+  explicit PerfTimer(PerfPhase phase, std::string detail = std::string())
+  : phase(phase), detail(std::move(detail)) {
+#ifdef ENABLE_PERF_COUNTERS
+    start = PerfCounters::Clock::now();
+#endif
+  }
+
+  ~PerfTimer() { stop(); }
+
+  void stop() {
+#ifdef ENABLE_PERF_COUNTERS
+    if (stopped)
+      return;
+    stopped = true;
+    PerfCounters::getInstance().record(phase, start,
+                                       PerfCounters::Clock::now(), detail);
+#endif
+  }
+
+private:
+  PerfPhase phase;
+  std::string detail;
+  PerfCounters::Clock::time_point start;
+  bool stopped = false;
+};
+
 //=============================================================================
 // Dtype casting and copying
 
@@ -325,8 +482,7 @@ struct Converter<float, bfloat16_t> {
     if (DebugValueConversions)
       std::cout << "float to bf16 value conversion" << std::endl;
 #endif
-    bfloat16_t bf = (bfloat16_t) (((*reinterpret_cast<uint32_t*>(&value))) >> 16);
-    return bf;
+    return floatToBf16(value);
   }
 };
 
@@ -338,9 +494,7 @@ struct Converter<bfloat16_t, float> {
     if (DebugValueConversions)
       std::cout << "bf16 to float value conversion" << std::endl;
 #endif
-    uint32_t tmp = uint32_t(value) << 16;
-    float f = *reinterpret_cast<float*>(&tmp);
-    return f;
+    return bf16ToFloat(value);
   }
 };
 
@@ -378,6 +532,32 @@ struct TensorCopier<T, T> {
   }
 };
 
+#ifndef USE_SCALAR_DTYPE_CONVERSION
+// float to bfloat16: vectorized, and split over multiple threads for large
+// tensors.  See bf16_conversion.h.
+template<>
+struct TensorCopier<float, bfloat16_t> {
+  static void copy(bfloat16_t *destBuf, const float *srcBuf, std::size_t numElements) {
+#ifdef DEBUG_VALUE_CONVERSIONS
+    std::cout << "TensorCopier: Using vectorized float to bf16 copy" << std::endl;
+#endif
+    copyFloatToBf16(destBuf, srcBuf, numElements);
+  }
+};
+
+// bfloat16 to float: vectorized, and split over multiple threads for large
+// tensors.  See bf16_conversion.h.
+template<>
+struct TensorCopier<bfloat16_t, float> {
+  static void copy(float *destBuf, const bfloat16_t *srcBuf, std::size_t numElements) {
+#ifdef DEBUG_VALUE_CONVERSIONS
+    std::cout << "TensorCopier: Using vectorized bf16 to float copy" << std::endl;
+#endif
+    copyBf16ToFloat(destBuf, srcBuf, numElements);
+  }
+};
+#endif
+
 // Info about a tensor passed between model and plugin.
 //
 // The layout of this struct must match the calling convention for the plugin.
@@ -421,21 +601,294 @@ struct TensorData {
   }
 };
 
+//=============================================================================
+// Kernel registry
+//
+// The kernels available to the delegate are listed in a manifest file.  Each
+// line that is not empty or a comment (starting with '#') describes one kernel:
+//
+//   M K N lhsType rhsType resultType requiresResultPreload fileName kernelName
+//
+// - `M`, `K`, `N`: fixed shape of the matmul kernel
+// - `lhsType`, `rhsType`, `resultType`: `bf16` or `f32`, as defined by the
+//   kernel
+// - `requiresResultPreload`: 1 if the kernel requires a pre-initialized buffer
+//   to be loaded into the kernel before the kernel runs, 0 otherwise
+// - `fileName`: the kernel's .xclbin and .insts.txt files without extension,
+//   relative to the directory of the manifest
+// - `kernelName`: name (or prefix of the name) of the kernel inside the xclbin
+//
+// Two optional columns follow for kernels that read their inputs in a blocked
+// layout (see `OperandLayout`):
+//
+//   ... kernelName lhsLayout rhsLayout
+//
+// - `lhsLayout`, `rhsLayout`: `row` for row-major (the default), or
+//   `<rows>x<cols>` for blocks of that shape, which must divide the operand
+//   shape of the kernel
+
+// Dtypes of the kernel operands
+enum class KernelDType { BF16, F32 };
+
+std::size_t getDTypeSize(KernelDType dtype) {
+  return dtype == KernelDType::BF16 ? sizeof(bfloat16_t) : sizeof(float);
+}
+
+const char *getDTypeName(KernelDType dtype) {
+  return dtype == KernelDType::BF16 ? "bf16" : "f32";
+}
+
+// Kernel dtype that holds the same values as the model dtype `T`
+template <typename T>
+constexpr KernelDType getKernelDTypeFor() {
+  static_assert(std::is_same_v<T, bfloat16_t> || std::is_same_v<T, float>,
+                "Unsupported model dtype");
+  return std::is_same_v<T, float> ? KernelDType::F32 : KernelDType::BF16;
+}
+
+// Layout of a kernel input in its XRT buffer.  Row-major by default.  A
+// blocked layout splits the matrix into `blockRows` x `blockCols` blocks,
+// stored one after the other in row-major order of blocks, each block
+// row-major and contiguous.  A kernel reading whole blocks then streams
+// contiguous memory instead of gathering strided rows with its DMA, and the
+// host produces the layout at no extra cost while it converts the operand's
+// dtype.
+struct OperandLayout {
+  int32_t blockRows = 0;  // 0 for row-major
+  int32_t blockCols = 0;
+
+  bool isRowMajor() const { return blockRows == 0; }
+
+  std::string str() const {
+    if (isRowMajor())
+      return "row";
+    return std::to_string(blockRows) + "x" + std::to_string(blockCols);
+  }
+};
+
+// Description of one kernel of the manifest
+struct KernelSpec {
+  int32_t M = 0;
+  int32_t K = 0;
+  int32_t N = 0;
+  KernelDType lhsDType = KernelDType::BF16;
+  KernelDType rhsDType = KernelDType::BF16;
+  KernelDType resultDType = KernelDType::F32;
+  bool requiresResultPreload = false;
+  std::string filePath;  // path of the kernel files, without extension
+  std::string kernelName;
+  OperandLayout lhsLayout;
+  OperandLayout rhsLayout;
+
+  std::size_t getLhsVolume() const { return std::size_t(M) * K; }
+  std::size_t getRhsVolume() const { return std::size_t(K) * N; }
+  std::size_t getResultVolume() const { return std::size_t(M) * N; }
+
+  // Number of kernel runs needed to tile a matmul of the given shape
+  int64_t getNumTiles(int32_t matM, int32_t matK, int32_t matN) const {
+    auto ceilDiv = [](int64_t a, int64_t b) { return (a + b - 1) / b; };
+    return ceilDiv(matM, M) * ceilDiv(matK, K) * ceilDiv(matN, N);
+  }
+
+  std::string getShapeStr() const {
+    std::ostringstream oss;
+    oss << M << 'x' << N << 'x' << K;
+    return oss.str();
+  }
+
+  std::ostream &dump(std::ostream &os) const {
+    return os << getShapeStr() << " (" << getDTypeName(lhsDType) << ", "
+              << getDTypeName(rhsDType) << " -> "
+              << getDTypeName(resultDType)
+              << (requiresResultPreload ? ", result preload" : "")
+              << (lhsLayout.isRowMajor() ? "" : ", lhs " + lhsLayout.str())
+              << (rhsLayout.isRowMajor() ? "" : ", rhs " + rhsLayout.str())
+              << "): " << filePath << " [" << kernelName << "]";
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const KernelSpec &spec) {
+    return spec.dump(os);
+  }
+};
+
+// Set of kernels available to the delegate, read from the kernel manifest
+class KernelRegistry {
+public:
+  void load(const std::string &manifestPath) {
+    TRACE_DELEGATE1("KernelRegistry::load ", manifestPath);
+    std::ifstream manifestFile(manifestPath);
+    if (!manifestFile) {
+      std::ostringstream oss;
+      oss << "[AIE Delegate] FATAL ERROR: Can't open kernel manifest "
+          << manifestPath << std::endl;
+      throw DelegateException(oss.str());
+    }
+    std::string manifestDir;
+    std::size_t slashPos = manifestPath.find_last_of("/\\");
+    if (slashPos != std::string::npos)
+      manifestDir = manifestPath.substr(0, slashPos + 1);
+
+    specs.clear();
+    std::string line;
+    for (int lineNum = 1; std::getline(manifestFile, line); ++lineNum) {
+      std::istringstream iss(line);
+      std::string first;
+      if (!(iss >> first) || first[0] == '#') continue;
+
+      KernelSpec spec;
+      std::string lhsType, rhsType, resultType, fileName;
+      int preload = 0;
+      iss.str(line);
+      iss.clear();
+      if (!(iss >> spec.M >> spec.K >> spec.N >> lhsType >> rhsType
+                >> resultType >> preload >> fileName >> spec.kernelName) ||
+          spec.M <= 0 || spec.K <= 0 || spec.N <= 0) {
+        std::ostringstream oss;
+        oss << "[AIE Delegate] FATAL ERROR: Malformed kernel manifest entry at "
+            << manifestPath << ":" << lineNum << std::endl;
+        throw DelegateException(oss.str());
+      }
+      spec.lhsDType = parseDType(lhsType, manifestPath, lineNum);
+      spec.rhsDType = parseDType(rhsType, manifestPath, lineNum);
+      spec.resultDType = parseDType(resultType, manifestPath, lineNum);
+      spec.requiresResultPreload = preload != 0;
+      spec.filePath = manifestDir + fileName;
+      std::string layout;
+      if (iss >> layout)
+        spec.lhsLayout =
+            parseLayout(layout, spec.M, spec.K, manifestPath, lineNum);
+      if (iss >> layout)
+        spec.rhsLayout =
+            parseLayout(layout, spec.K, spec.N, manifestPath, lineNum);
+      if (find(spec.M, spec.K, spec.N)) {
+        std::ostringstream oss;
+        oss << "[AIE Delegate] FATAL ERROR: Duplicate kernel shape "
+            << spec.getShapeStr() << " at " << manifestPath << ":" << lineNum
+            << std::endl;
+        throw DelegateException(oss.str());
+      }
+      specs.push_back(spec);
+    }
+    TRACE_DELEGATE("KernelRegistry::load done");
+  }
+
+  // Returns the kernel for the given matmul shape, or nullptr if none
+  const KernelSpec *find(int32_t M, int32_t K, int32_t N) const {
+    for (const KernelSpec &spec : specs)
+      if (spec.M == M && spec.K == K && spec.N == N) return &spec;
+    return nullptr;
+  }
+
+  // Returns the kernel to tile a matmul of the given shape onto (see
+  // `tiled_aie_matmul`): the one computing the fewest padded multiply-adds,
+  // then the one needing the fewest runs.
+  const KernelSpec *findTilingKernel(int32_t M, int32_t K, int32_t N) const {
+    const KernelSpec *best = nullptr;
+    double bestMacs = 0.0;
+    int64_t bestRuns = 0;
+    for (const KernelSpec &spec : specs) {
+      int64_t runs = spec.getNumTiles(M, K, N);
+      double macs = double(runs) * spec.M * spec.K * spec.N;
+      if (!best || macs < bestMacs || (macs == bestMacs && runs < bestRuns)) {
+        best = &spec;
+        bestMacs = macs;
+        bestRuns = runs;
+      }
+    }
+    return best;
+  }
+
+  const std::vector<KernelSpec> &getSpecs() const { return specs; }
+
+private:
+  static KernelDType parseDType(const std::string &str,
+                                const std::string &manifestPath, int lineNum) {
+    if (str == "bf16") return KernelDType::BF16;
+    if (str == "f32") return KernelDType::F32;
+    std::ostringstream oss;
+    oss << "[AIE Delegate] FATAL ERROR: Unsupported dtype " << str << " at "
+        << manifestPath << ":" << lineNum << " (expected bf16 or f32)"
+        << std::endl;
+    throw DelegateException(oss.str());
+  }
+
+  // Parses the layout of a `rows` x `cols` operand
+  static OperandLayout parseLayout(const std::string &str, int32_t rows,
+                                   int32_t cols,
+                                   const std::string &manifestPath,
+                                   int lineNum) {
+    OperandLayout layout;
+    if (str == "row")
+      return layout;
+    char x = 0;
+    std::istringstream iss(str);
+    if (iss >> layout.blockRows >> x >> layout.blockCols && x == 'x' &&
+        iss.peek() == EOF && layout.blockRows > 0 && layout.blockCols > 0 &&
+        rows % layout.blockRows == 0 && cols % layout.blockCols == 0)
+      return layout;
+    std::ostringstream oss;
+    oss << "[AIE Delegate] FATAL ERROR: Invalid operand layout " << str
+        << " at " << manifestPath << ":" << lineNum
+        << " (expected row or <rows>x<cols> dividing " << rows << "x" << cols
+        << ")" << std::endl;
+    throw DelegateException(oss.str());
+  }
+
+  // A vector rather than a map: the registry has a handful of entries, and
+  // pointers to them are handed out.
+  std::vector<KernelSpec> specs;
+};
+
 //=============================================================================
 // Classes for managing the connection between HAL and XRT
 
-// Functionality common to all variants of tensor binder
-template <typename ModelDType, typename KernelDType, typename ModelDataPtr>
-class TensorBinderCommon {
+// Copy a model tensor into an XRT buffer of dtype `kernelDType`
+template <typename ModelDType>
+void copyModelToKernel(void *kernelBuf, KernelDType kernelDType,
+                       const ModelDType *modelBuf, std::size_t numElements) {
+  if (kernelDType == KernelDType::BF16)
+    TensorCopier<ModelDType, bfloat16_t>::copy(
+        static_cast<bfloat16_t *>(kernelBuf), modelBuf, numElements);
+  else
+    TensorCopier<ModelDType, float>::copy(static_cast<float *>(kernelBuf),
+                                          modelBuf, numElements);
+}
+
+// Copy an XRT buffer of dtype `kernelDType` into a model tensor
+template <typename ModelDType>
+void copyKernelToModel(ModelDType *modelBuf, const void *kernelBuf,
+                       KernelDType kernelDType, std::size_t numElements) {
+  if (kernelDType == KernelDType::BF16)
+    TensorCopier<bfloat16_t, ModelDType>::copy(
+        modelBuf, static_cast<const bfloat16_t *>(kernelBuf), numElements);
+  else
+    TensorCopier<float, ModelDType>::copy(
+        modelBuf, static_cast<const float *>(kernelBuf), numElements);
+}
+
+// Class for binding a HAL buffer to an XRT buffer (BO).
+//
+// In the general case, the HAL buffer is separate from the XRT buffer, so that
+// memory copies are done between the HAL buffer and XRT buffer.  If
+// USE_INDIRECT_XRT_BUFFERS is off and the model and kernel dtypes match, the
+// HAL buffer is instead bound directly to the XRT buffer, so that they share
+// the same memory.
+template <typename ModelDType, typename ModelDataPtr>
+class TensorBinderBase {
 protected:
   xrt::device device;
   int memoryBank = 0;
+  KernelDType kernelDType;
   std::size_t xrtBufferNumBytes;  // fixed size of XRT buffer
   xrt::bo bo;
+  std::size_t numModelElements = 0;  // number of elements in model tensor
+  ModelDataPtr modelTensorData = ModelDataPtr(); // pointer to HAL buffer
+  bool isInitialized = false;
 
   // Make sure that the XRT buffer is large enough to handle the model tensor
-  void checkBufferSizes(ModelDataPtr modelTensorData, std::size_t numModelElements) {
-    std::size_t modelBufferNumBytes = numModelElements * sizeof(KernelDType);
+  void checkBufferSizes(std::size_t numModelElements) {
+    std::size_t modelBufferNumBytes =
+        numModelElements * getDTypeSize(kernelDType);
     if (modelBufferNumBytes > xrtBufferNumBytes) {
       std::ostringstream oss;
       oss << "INTERNAL ERROR: XRT buffer too small!  XRT buffer size: "
@@ -446,33 +899,31 @@ protected:
   }
 
 public:
-  TensorBinderCommon(xrt::device device, int memoryBank, std::size_t xrtBufferNumBytes)
-  : device(device), memoryBank(memoryBank), xrtBufferNumBytes(xrtBufferNumBytes)
+  // Whether the HAL buffer is shared with the XRT buffer
+  bool isDirect() const {
+#ifdef USE_INDIRECT_XRT_BUFFERS
+    return false;
+#else
+    return getKernelDTypeFor<ModelDType>() == kernelDType;
+#endif
+  }
+
+  TensorBinderBase(xrt::device device, int memoryBank, KernelDType kernelDType,
+                   std::size_t xrtBufferNumBytes)
+  : device(device), memoryBank(memoryBank), kernelDType(kernelDType),
+    xrtBufferNumBytes(xrtBufferNumBytes)
   {}
 
-  virtual ~TensorBinderCommon() {}
+  virtual ~TensorBinderBase() {}
   xrt::bo getBo() { return bo; }
-};
-
-
-// Class for binding a HAL buffer to an XRT buffer (BO).
-//
-// In the general case, the HAL buffer is separate from the XRT buffer, so that
-// memory copies are done between the HAL buffer and XRT buffer
-template <typename ModelDType, typename KernelDType, typename ModelDataPtr>
-class TensorBinderBase : public TensorBinderCommon<ModelDType, KernelDType, ModelDataPtr> {
-protected:
-  std::size_t numModelElements;  // number of elements in model tensor
-  ModelDataPtr modelTensorData = ModelDataPtr(); // pointer to HAL buffer
-  bool isInitialized = false;
-
-public:
-  using CommonClass = TensorBinderCommon<ModelDType, KernelDType, ModelDataPtr>;
-  using CommonClass::CommonClass;
 
   void bind(ModelDataPtr modelTensorData, std::size_t numModelElements) {
-    CommonClass::checkBufferSizes(modelTensorData, numModelElements);
-    if (!isInitialized || numModelElements != this->numModelElements) {
+    checkBufferSizes(numModelElements);
+    if (isDirect()) {
+      // Construct BO every time, as HAL buffer can be different with every call
+      this->bo = xrt::bo(this->device, (void *) modelTensorData,
+          this->xrtBufferNumBytes, this->memoryBank);
+    } else if (!isInitialized || numModelElements != this->numModelElements) {
       this->bo = xrt::bo(this->device, this->xrtBufferNumBytes,
           XRT_BO_FLAGS_HOST_ONLY, this->memoryBank);
       isInitialized = true;
@@ -482,90 +933,54 @@ public:
   }
 
   void copyModelToXrt() {
-    KernelDType *xrtBuf = this->bo.template map<KernelDType *>();
+    if (!isDirect()) {
 #ifdef ENABLE_PERFORMANCE_WARNING
-    std::cout << "[AIE Delegate]: PERFORMANCE WARNING: using extra buffer copy!" << std::endl;
+      std::cout << "[AIE Delegate]: PERFORMANCE WARNING: using extra buffer copy!" << std::endl;
 #endif
-    TensorCopier<ModelDType, KernelDType>::copy(xrtBuf, modelTensorData,
-        numModelElements);
-    this->bo.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-  }
-
-};
-
-
-#ifndef USE_INDIRECT_XRT_BUFFERS
-// Special case for binding a HAL buffer directly to an XRT buffer (BO),
-// so that they share the same memory.
-//
-// This class can be used only if the Model (HAL) and kernel (XRT) data types
-// match.
-template <typename DType, typename ModelDataPtr>
-class TensorBinderBase<DType, DType, ModelDataPtr> : public TensorBinderCommon<DType, DType, ModelDataPtr> {
-public:
-  using CommonClass = TensorBinderCommon<DType, DType, ModelDataPtr>;
-  using CommonClass::CommonClass;
-
-  void bind(ModelDataPtr modelTensorData, std::size_t numModelElements) {
-    CommonClass::checkBufferSizes(modelTensorData, numModelElements);
-
-    // std::cout << "Using direct buffers" << std::endl;
-
-    // Construct BO every time, as HAL buffer can be different with every call
-    this->bo = xrt::bo(this->device, (void *) modelTensorData,
-        this->xrtBufferNumBytes, this->memoryBank);
-  }
-
-  void copyModelToXrt() {
+      PerfTimer timer(PerfPhase::CopyIn);
+      copyModelToKernel(this->bo.template map<void *>(), kernelDType,
+          (const ModelDType *) modelTensorData, numModelElements);
+    }
+    PerfTimer timer(PerfPhase::SyncToDevice);
     this->bo.sync(XCL_BO_SYNC_BO_TO_DEVICE);
   }
 };
-#endif
 
 
 // TensorBinder whose HAL buffer CANNOT be written to
-template <typename ModelDType, typename KernelDType>
-class ConstTensorBinder : public TensorBinderBase<ModelDType, KernelDType, const ModelDType *> {
+template <typename ModelDType>
+class ConstTensorBinder : public TensorBinderBase<ModelDType, const ModelDType *> {
 public:
-  using BaseClass = TensorBinderBase<ModelDType, KernelDType, const ModelDType *>;
+  using BaseClass = TensorBinderBase<ModelDType, const ModelDType *>;
   using BaseClass::BaseClass;
 };
 
 
-// TensorBinder whose HAL buffer CAN be written to, default case
-template <typename ModelDType, typename KernelDType>
-class MutableTensorBinder : public TensorBinderBase<ModelDType, KernelDType, ModelDType *> {
+// TensorBinder whose HAL buffer CAN be written to
+template <typename ModelDType>
+class MutableTensorBinder : public TensorBinderBase<ModelDType, ModelDType *> {
 public:
-  using BaseClass = TensorBinderBase<ModelDType, KernelDType, ModelDType *>;
+  using BaseClass = TensorBinderBase<ModelDType, ModelDType *>;
   using BaseClass::BaseClass;
 
   void copyXrtToModel() {
-    this->bo.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
-    KernelDType *xrtBuf = this->bo.template map<KernelDType *>();
+    {
+      PerfTimer timer(PerfPhase::SyncFromDevice);
+      this->bo.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+    }
+    if (this->isDirect())
+      return;
 #ifdef ENABLE_PERFORMANCE_WARNING
     std::cout << "[AIE Delegate]: PERFORMANCE WARNING: using extra buffer copy!" << std::endl;
 #endif
-    TensorCopier<KernelDType, ModelDType>::copy(this->modelTensorData, xrtBuf,
+    PerfTimer timer(PerfPhase::CopyOut);
+    copyKernelToModel(this->modelTensorData,
+        this->bo.template map<void *>(), this->kernelDType,
         this->numModelElements);
   }
 };
 
 
-#ifndef USE_INDIRECT_XRT_BUFFERS
-// TensorBinder whose HAL buffer CAN be written to, conversion not required
-template <typename DType>
-class MutableTensorBinder<DType, DType> : public TensorBinderBase<DType, DType, DType *> {
-public:
-  using BaseClass = TensorBinderBase<DType, DType, DType *>;
-  using BaseClass::BaseClass;
-
-  void copyXrtToModel() {
-    this->bo.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
-  }
-};
-#endif
-
-
 // Set of all arguments passed from model to plugin
 //
 // The layout of this struct must match the calling convention for the plugin.
@@ -616,22 +1031,322 @@ std::vector<uint32_t> loadInstrSequence(std::string instr_path) {
   return instrV;
 }
 
+// Single background thread for host-side staging work (buffer copies and
+// dtype conversions), so that the calling thread can stage other buffers or
+// drive the NPU in the meantime.  Tasks run in submission order.  Also used to
+// run the matmuls of `mlp_external_async`.
+class StagingWorker {
+public:
+  StagingWorker() : thread([this] { loop(); }) {}
+
+  ~StagingWorker() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    condition.notify_one();
+    thread.join();
+  }
+
+  // Queues `fn`.  The returned future becomes ready when `fn` has run, and
+  // rethrows its exception, if any.  The caller must wait for the future
+  // before releasing anything `fn` uses.
+  std::future<void> submit(std::function<void()> fn) {
+    std::packaged_task<void()> task(std::move(fn));
+    std::future<void> future = task.get_future();
+#ifdef USE_SEQUENTIAL_STAGING
+    task();
+#else
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+#endif
+    return future;
+  }
+
+private:
+  void loop() {
+    while (true) {
+      std::packaged_task<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty())
+          return;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<std::packaged_task<void()>> tasks;
+  bool stopping = false;
+  std::thread thread;  // last, so that it starts after the members above
+};
+
+// Fast non-cryptographic hash of a buffer.  Used to detect the HAL buffer of
+// a cached operand being reused for other data.
+uint64_t hashBuffer(const void *data, std::size_t numBytes) {
+  constexpr uint64_t kMul = 0x9e3779b97f4a7c15ull;
+  auto mix = [](uint64_t h, uint64_t v) {
+    h ^= v * 0xff51afd7ed558ccdull;
+    return ((h << 31) | (h >> 33)) * kMul;
+  };
+  const char *p = static_cast<const char *>(data);
+  // Four independent lanes, so that the multiplies pipeline
+  uint64_t h[4] = {kMul, kMul + 1, kMul + 2, kMul + 3};
+  std::size_t i = 0;
+  for (; i + 32 <= numBytes; i += 32) {
+    for (int lane = 0; lane < 4; ++lane) {
+      uint64_t v;
+      std::memcpy(&v, p + i + 8 * lane, sizeof(v));
+      h[lane] = mix(h[lane], v);
+    }
+  }
+  for (; i < numBytes; ++i)
+    h[0] = mix(h[0], uint64_t(uint8_t(p[i])));
+  return mix(mix(mix(mix(numBytes, h[0]), h[1]), h[2]), h[3]);
+}
+
+// Fingerprint of a buffer from its address, its size and `numSamples` evenly
+// spaced chunks of `sampleBytes` bytes, including the first and the last one.
+// Reads a bounded amount of memory, regardless of the size of the buffer.
+uint64_t fingerprintBuffer(const void *data, std::size_t numBytes,
+                           std::size_t numSamples = 64,
+                           std::size_t sampleBytes = 64) {
+  if (numBytes <= numSamples * sampleBytes)
+    return hashBuffer(data, numBytes) ^ reinterpret_cast<uintptr_t>(data);
+  const char *p = static_cast<const char *>(data);
+  std::size_t lastOffset = numBytes - sampleBytes;
+  uint64_t h = reinterpret_cast<uintptr_t>(data);
+  for (std::size_t i = 0; i < numSamples; ++i) {
+    std::size_t offset = lastOffset * i / (numSamples - 1);
+    h = hashBuffer(p + offset, sampleBytes) ^ (h * 0x9e3779b97f4a7c15ull);
+  }
+  return h ^ numBytes;
+}
+
+// Cache of constant operands (model weights) kept resident in XRT buffers, in
+// kernel dtype and layout, across calls.
+//
+// An operand is identified by the address and shape of its HAL buffer, as
+// constants keep their buffers for the lifetime of the model.  Since a HAL
+// buffer can also be reused for other data, a content hash is checked on every
+// lookup, unless WEIGHT_CACHE_TRUST_POINTERS is on.  The XRT buffer of a stale
+// entry is refilled in place, so that an operand which is not a constant costs
+// a copy per call, as it would without the cache, but no new allocation.  The
+// least recently used entries are evicted to keep the total size under a
+// budget.
+class WeightCache {
+public:
+  // Identity of one cached operand tile
+  struct Key {
+    const KernelSpec *spec;  // kernel whose layout the tile is in
+    const void *data;        // HAL buffer of the whole operand
+    int32_t rows, cols;      // shape of the whole operand
+    int32_t row0, col0;      // offset of the tile in the operand
+
+    bool operator<(const Key &other) const {
+      return std::tie(spec, data, rows, cols, row0, col0) <
+             std::tie(other.spec, other.data, other.rows, other.cols,
+                      other.row0, other.col0);
+    }
+  };
+
+  std::size_t getMaxBytes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxBytes;
+  }
+
+  void setMaxBytes(std::size_t maxBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->maxBytes = maxBytes;
+    evict(0);
+  }
+
+  // Returns the XRT buffer holding the tile `key`, whose operand content has
+  // hash `hash`.  On a miss, allocates a `numBytes` buffer in `memoryBank`
+  // and fills it with `fill`, which receives the mapped buffer.  Returns an
+  // empty optional if the tile does not fit in the cache.
+  std::optional<xrt::bo> lookup(const Key &key, uint64_t hash,
+                                std::size_t numBytes, xrt::device &device,
+                                int memoryBank,
+                                const std::function<void(void *)> &fill) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end()) {
+      Entry &entry = *it->second;
+      lru.splice(lru.begin(), lru, it->second);
+      if (entry.hash == hash) {
+        ++numHits;
+        return entry.bo;
+      }
+      // Same HAL buffer, different content: the entry is stale.  The key
+      // fixes the kernel and the tile, hence the size of the buffer, and the
+      // runs of a kernel are serialized, so the buffer is no longer in use.
+      TRACE_DELEGATE("WeightCache: stale entry");
+      ++numMisses;
+      ++numRefills;
+      entry.hash = hash;
+      fillAndSync(entry.bo, fill);
+      return entry.bo;
+    }
+    ++numMisses;
+    if (numBytes > maxBytes)
+      return std::nullopt;
+    evict(numBytes);
+    xrt::bo bo(device, numBytes, XRT_BO_FLAGS_HOST_ONLY, memoryBank);
+    fillAndSync(bo, fill);
+    lru.push_front(Entry{key, hash, numBytes, bo});
+    index.emplace(key, lru.begin());
+    totalBytes += numBytes;
+    return bo;
+  }
+
+  std::ostream &dumpStats(std::ostream &os) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return os << "weight cache: " << index.size() << " entries, "
+              << totalBytes << " bytes, " << numHits << " hits, " << numMisses
+              << " misses (" << numRefills << " stale)";
+  }
+
+private:
+  struct Entry {
+    Key key;
+    uint64_t hash;
+    std::size_t numBytes;
+    xrt::bo bo;
+  };
+
+  static void fillAndSync(xrt::bo &bo,
+                          const std::function<void(void *)> &fill) {
+    PerfTimer copyTimer(PerfPhase::CopyIn);
+    fill(bo.map<void *>());
+    copyTimer.stop();
+    PerfTimer syncTimer(PerfPhase::SyncToDevice);
+    bo.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+  }
+
+  // Evicts least recently used entries until `numBytes` more bytes fit.
+  // Buffers still used by a run stay alive through the run's own handles.
+  void evict(std::size_t numBytes) {
+    while (!lru.empty() && totalBytes + numBytes > maxBytes) {
+      totalBytes -= lru.back().numBytes;
+      index.erase(lru.back().key);
+      lru.pop_back();
+    }
+  }
+
+  std::mutex mutex;
+  std::list<Entry> lru;  // most recently used first
+  std::map<Key, std::list<Entry>::iterator> index;
+  std::size_t totalBytes = 0;
+  std::size_t maxBytes = 0;
+  uint64_t numHits = 0;
+  uint64_t numMisses = 0;
+  uint64_t numRefills = 0;
+};
+
+// Content hash of a weight operand, checked by the weight cache.  By default,
+// this hashes the full content, so that a HAL buffer reused for other data is
+// never mistaken for the cached operand.
+uint64_t getWeightHash(const void *data, std::size_t numBytes) {
+#if defined(WEIGHT_CACHE_TRUST_POINTERS)
+  return 0;
+#elif defined(WEIGHT_CACHE_SAMPLED_HASH)
+  PerfTimer timer(PerfPhase::HashWeights);
+  return fingerprintBuffer(data, numBytes);
+#else
+  PerfTimer timer(PerfPhase::HashWeights);
+  return hashBuffer(data, numBytes);
+#endif
+}
+
+// An xclbin registered with the device, with its hardware context.  Kernels
+// from the same xclbin share these.
+struct LoadedXclbin {
+  xrt::xclbin xclbin;
+  xrt::hw_context context;
+};
+
+// A kernel of the registry loaded on the NPU, with its instruction sequence
+// and the XRT buffers of its operands
+struct LoadedKernel {
+  using LhsBinder = ConstTensorBinder<ModelLhsDType>;
+  using RhsBinder = ConstTensorBinder<ModelRhsDType>;
+  using ResultBinder = MutableTensorBinder<ModelReturnDType>;
+
+  const KernelSpec *spec = nullptr;
+  xrt::kernel kernel;
+  xrt::bo boInstr;
+  int instrSize = 0;
+  std::unique_ptr<LhsBinder> lhsBinder;
+  std::unique_ptr<RhsBinder> rhsBinder;
+  std::unique_ptr<ResultBinder> resultBinder;
+
+  // XRT buffers for running tiles of larger or ragged matmuls on this kernel
+  // (see `tiled_aie_matmul`).  There are two of each, so that the host can
+  // fill or drain one while the NPU uses the other.
+  struct TileBuffers {
+    xrt::bo lhs;
+    xrt::bo rhs;
+    xrt::bo result;
+  };
+  std::vector<TileBuffers> tileBuffers;
+
+  // Serializes the runs of this kernel, which share the binders and tile
+  // buffers
+  std::mutex mutex;
+
+  // Allocates the tile buffers on first use
+  void allocateTileBuffers(xrt::device &device) {
+    if (!tileBuffers.empty())
+      return;
+    TRACE_DELEGATE("allocateTileBuffers");
+    for (int i = 0; i < 2; ++i) {
+      TileBuffers buffers;
+      buffers.lhs = xrt::bo(device,
+          spec->getLhsVolume() * getDTypeSize(spec->lhsDType),
+          XRT_BO_FLAGS_HOST_ONLY, kernel.group_id(2));
+      buffers.rhs = xrt::bo(device,
+          spec->getRhsVolume() * getDTypeSize(spec->rhsDType),
+          XRT_BO_FLAGS_HOST_ONLY, kernel.group_id(3));
+      buffers.result = xrt::bo(device,
+          spec->getResultVolume() * getDTypeSize(spec->resultDType),
+          XRT_BO_FLAGS_HOST_ONLY, kernel.group_id(4));
+      tileBuffers.push_back(buffers);
+    }
+  }
+};
+
 // Holder of AIE hardware resources of which there should be only one of each.
 // This class is used as a singleton via `getInstance()`.
 struct XrtState {
-    using LhsBinder = ConstTensorBinder<ModelLhsDType, A_DATATYPE>;
-    using RhsBinder = ConstTensorBinder<ModelRhsDType, B_DATATYPE>;
-    using ResultBinder = MutableTensorBinder<ModelReturnDType, C_DATATYPE>;
-
     xrt::device device;
-    xrt::kernel kernel;
-    xrt::bo boInstr;
-    std::unique_ptr<LhsBinder> lhsBinder;
-    std::unique_ptr<RhsBinder> rhsBinder;
-    std::unique_ptr<ResultBinder> resultBinder;
+    KernelRegistry registry;
+
+    // Guards the caches below
+    std::mutex mutex;
+
+    // Xclbins loaded so far, by path
+    std::map<std::string, std::unique_ptr<LoadedXclbin>> xclbins;
+
+    // Kernels loaded so far, by (M, K, N) shape
+    std::map<std::tuple<int32_t, int32_t, int32_t>,
+             std::unique_ptr<LoadedKernel>> kernels;
+
+    // Overlaps host-side staging with other host work and NPU runs
+    StagingWorker stagingWorker;
+
+    // Constant operands resident on the device
+    WeightCache weightCache;
 
     static XrtState *getInstance(bool shouldDelete = false) {
-        // TODO: handle multiple simultaneous dispatches, multiple kernels
         static XrtState *instance = nullptr;
         if (shouldDelete) {
             delete instance;
@@ -642,213 +1357,650 @@ struct XrtState {
             instance = new XrtState();
         return instance;
     }
-};
-
-constexpr int M = MLP_M;
-constexpr int K = MLP_K;
-constexpr int N = MLP_N;
 
-constexpr int aVolume = M * K;
-constexpr int bVolume = K * N;
-constexpr int cVolume = M * N;
+    // Returns the loaded kernel for `spec`, loading it on first use
+    LoadedKernel *getKernel(const KernelSpec &spec);
 
-constexpr int aSize = (aVolume * sizeof(A_DATATYPE));
-constexpr int bSize = (bVolume * sizeof(B_DATATYPE));
-constexpr int cSize = (cVolume * sizeof(C_DATATYPE));
+private:
+    LoadedXclbin *getXclbin(const std::string &xclbinPath);
+};
 
-bool aie_setup = false;
-int instrSize = 0;
 int aie_matmuls_done = 0;
 int matmuls_done = 0;
 
 void setupNPUAccelerator() {
   TRACE_DELEGATE("setupNPUAccelerator");
-  auto startTime = std::chrono::high_resolution_clock::now();
+  PerfTimer timer(PerfPhase::Setup);
   std::string libPath = getLibraryPath();
-  std::cout << "[AIE Delegate]: Using delegate installation at: " << libPath
-            << std::endl;
-  std::string instrFilePath =
-      libPath + "/kernels/" + kernelFileName + ".insts.txt";
-  std::vector<uint32_t> instrV = loadInstrSequence(instrFilePath);
-  instrSize = instrV.size();
-  if (instrSize == 0) {
+  LOG_DELEGATE("Using delegate installation at: " << libPath);
+  const char *manifestEnv = std::getenv(ManifestEnvVar);
+  std::string manifestPath = manifestEnv && *manifestEnv
+                                 ? std::string(manifestEnv)
+                                 : libPath + "/kernels/manifest.txt";
+
+  // Read the set of available kernels.  The kernels are loaded on the NPU
+  // the first time a matmul of their shape is seen.
+  auto xrtState = XrtState::getInstance();
+  xrtState->registry.load(manifestPath);
+  if (xrtState->registry.getSpecs().empty()) {
     std::ostringstream oss;
-    oss << "[AIE Delegate]: Couldn't load instructions from file "
-        << instrFilePath << std::endl;
+    oss << "[AIE Delegate] FATAL ERROR: No kernels in kernel manifest "
+        << manifestPath << std::endl;
     throw DelegateException(oss.str());
   }
-  std::cout << "[AIE Delegate]: Sequence instr count: " << instrV.size()
-            << "\n";
+  LOG_DELEGATE("Kernels in " << manifestPath << ":");
+  for (const KernelSpec &spec : xrtState->registry.getSpecs())
+    LOG_DELEGATE("    " << spec);
+
+  const char *weightCacheEnv = std::getenv(WeightCacheEnvVar);
+  std::size_t weightCacheMiB = weightCacheEnv && *weightCacheEnv
+                                   ? std::strtoull(weightCacheEnv, nullptr, 10)
+                                   : DefaultWeightCacheMiB;
+  xrtState->weightCache.setMaxBytes(weightCacheMiB << 20);
 
-  // Start the XRT test code
   // Get a device handle
-  auto xrtState = XrtState::getInstance();
   unsigned int deviceIndex = 0;
   TRACE_DELEGATE("setupNPUAccelerator get device");
   xrtState->device = xrt::device(deviceIndex);
 
-  // Load the xclbin
-  std::string xclbinPath = libPath + "/kernels/" + kernelFileName + ".xclbin";
-  TRACE_DELEGATE("setupNPUAccelerator get xclbin");
-  auto xclbin = xrt::xclbin(xclbinPath);
+  LOG_DELEGATE("NPU setup done.");
+  TRACE_DELEGATE("setupNPUAccelerator done");
+}
+
+LoadedXclbin *XrtState::getXclbin(const std::string &xclbinPath) {
+  auto it = xclbins.find(xclbinPath);
+  if (it != xclbins.end())
+    return it->second.get();
+
+  auto loaded = std::make_unique<LoadedXclbin>();
+  TRACE_DELEGATE1("getXclbin load ", xclbinPath);
+  loaded->xclbin = xrt::xclbin(xclbinPath);
+
+  // Register the xclbin
+  TRACE_DELEGATE("getXclbin register xclbin");
+  device.register_xclbin(loaded->xclbin);
+
+  // Get a hardware context
+  TRACE_DELEGATE("getXclbin create context");
+  loaded->context = xrt::hw_context(device, loaded->xclbin.get_uuid());
+
+  LoadedXclbin *result = loaded.get();
+  xclbins.emplace(xclbinPath, std::move(loaded));
+  return result;
+}
+
+LoadedKernel *XrtState::getKernel(const KernelSpec &spec) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto key = std::make_tuple(spec.M, spec.K, spec.N);
+  auto it = kernels.find(key);
+  if (it != kernels.end())
+    return it->second.get();
+
+  TRACE_DELEGATE1("getKernel load ", spec.getShapeStr());
+  PerfTimer timer(PerfPhase::LoadKernel, spec.getShapeStr());
+  std::string instrFilePath = spec.filePath + ".insts.txt";
+  std::vector<uint32_t> instrV = loadInstrSequence(instrFilePath);
+  if (instrV.empty()) {
+    std::ostringstream oss;
+    oss << "[AIE Delegate]: Couldn't load instructions from file "
+        << instrFilePath << std::endl;
+    throw DelegateException(oss.str());
+  }
+  LOG_DELEGATE("Sequence instr count: " << instrV.size());
+
+  // Load the xclbin, or reuse it if another kernel already did
+  std::string xclbinPath = spec.filePath + ".xclbin";
+  LoadedXclbin *loadedXclbin = getXclbin(xclbinPath);
 
   // Search in the xclbin for the kernel by its name
-  TRACE_DELEGATE("setupNPUAccelerator get kernels");
-  auto xkernels = xclbin.get_kernels();
+  TRACE_DELEGATE("getKernel get kernels");
+  auto xkernels = loadedXclbin->xclbin.get_kernels();
   std::vector<std::string> kernelNames;
   auto foundIter = std::find_if(xkernels.begin(), xkernels.end(),
                                 [&](xrt::xclbin::kernel &k) {
                                   auto name = k.get_name();
                                   kernelNames.push_back(name);
-                                  return name.rfind(KernelName, 0) == 0;
+                                  return name.rfind(spec.kernelName, 0) == 0;
                                 });
 
   // If the kernel name we're looking for doesn't exist, error out with a
   // list of all the kernel names in the xclbin
   if (foundIter == xkernels.end()) {
     std::ostringstream oss;
-    oss << "[AIE Delegate] FATAL ERROR: No such kernel " << KernelName << " in "
-        << xclbinPath << ".  Possible kernel names are:" << std::endl;
+    oss << "[AIE Delegate] FATAL ERROR: No such kernel " << spec.kernelName
+        << " in " << xclbinPath << ".  Possible kernel names are:"
+        << std::endl;
     for (const std::string &kernelName : kernelNames)
       oss << "    " << kernelName << std::endl;
     throw DelegateException(oss.str());
   }
 
-  // Kernel name found in the xclbin: get the kernel
-  auto xkernel = *foundIter;
-  auto kernelName = xkernel.get_name();
-
-  // Register the xclbin
-  TRACE_DELEGATE("setupNPUAccelerator register xclbin");
-  xrtState->device.register_xclbin(xclbin);
-
-  // Get a hardware context
-  TRACE_DELEGATE("setupNPUAccelerator create context");
-  xrt::hw_context context(xrtState->device, xclbin.get_uuid());
-
-  // Get a kernel handle
-  TRACE_DELEGATE("setupNPUAccelerator create kernel");
-  xrtState->kernel = xrt::kernel(context, kernelName);
-
-  TRACE_DELEGATE("setupNPUAccelerator create BOs");
-  xrtState->boInstr =
-      xrt::bo(xrtState->device, instrV.size() * sizeof(int),
-              XCL_BO_FLAGS_CACHEABLE, xrtState->kernel.group_id(0));
-
-  xrtState->lhsBinder = std::make_unique<XrtState::LhsBinder>(
-      xrtState->device, xrtState->kernel.group_id(2), aSize);
-  xrtState->rhsBinder = std::make_unique<XrtState::RhsBinder>(
-      xrtState->device, xrtState->kernel.group_id(3), bSize);
-  xrtState->resultBinder = std::make_unique<XrtState::ResultBinder>(
-      xrtState->device, xrtState->kernel.group_id(4), cSize);
+  // Kernel name found in the xclbin: get a kernel handle
+  auto loaded = std::make_unique<LoadedKernel>();
+  loaded->spec = &spec;
+  TRACE_DELEGATE("getKernel create kernel");
+  loaded->kernel = xrt::kernel(loadedXclbin->context, foundIter->get_name());
+
+  TRACE_DELEGATE("getKernel create BOs");
+  loaded->instrSize = instrV.size();
+  loaded->boInstr =
+      xrt::bo(device, instrV.size() * sizeof(int),
+              XCL_BO_FLAGS_CACHEABLE, loaded->kernel.group_id(0));
+
+  loaded->lhsBinder = std::make_unique<LoadedKernel::LhsBinder>(
+      device, loaded->kernel.group_id(2), spec.lhsDType,
+      spec.getLhsVolume() * getDTypeSize(spec.lhsDType));
+  loaded->rhsBinder = std::make_unique<LoadedKernel::RhsBinder>(
+      device, loaded->kernel.group_id(3), spec.rhsDType,
+      spec.getRhsVolume() * getDTypeSize(spec.rhsDType));
+  loaded->resultBinder = std::make_unique<LoadedKernel::ResultBinder>(
+      device, loaded->kernel.group_id(4), spec.resultDType,
+      spec.getResultVolume() * getDTypeSize(spec.resultDType));
 
   // copy instruction stream to NPU
-  void *bufInstr = xrtState->boInstr.map<void *>();
+  void *bufInstr = loaded->boInstr.map<void *>();
   std::memcpy(bufInstr, instrV.data(), instrV.size() * sizeof(int));
-  TRACE_DELEGATE("setupNPUAccelerator sync instruction BO");
-  xrtState->boInstr.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+  TRACE_DELEGATE("getKernel sync instruction BO");
+  loaded->boInstr.sync(XCL_BO_SYNC_BO_TO_DEVICE);
 
-  std::cout << "[AIE Delegate]: NPU setup done." << std::endl;
+  timer.stop();
+  LOG_DELEGATE("Loaded kernel " << spec.getShapeStr());
 
-  aie_setup = true;
-  auto endTime = std::chrono::high_resolution_clock::now();
-  auto duration =
-      std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime)
-          .count();
-  std::cout << "[AIE Delegate]: NPU setup time: " << duration << " ms"
-            << std::endl;
-  TRACE_DELEGATE("setupNPUAccelerator done");
+  LoadedKernel *result = loaded.get();
+  kernels.emplace(key, std::move(loaded));
+  TRACE_DELEGATE("getKernel done");
+  return result;
 }
 
-void aie_matmul(Params *params) {
-  TRACE_DELEGATE("aie_matmul");
-  std::cout << "[AIE Delegate]: Computing AIE matmul of "
-            << params->getShapeStr() << std::endl;
-  auto startTime = std::chrono::high_resolution_clock::now();
-  int cnt = 0;
-  auto xrtState = XrtState::getInstance();
+void aie_matmul(Params *params, LoadedKernel *loadedKernel,
+                XrtState *xrtState) {
+  TRACE_DELEGATE1("aie_matmul ", params->getShapeStr());
+  std::lock_guard<std::mutex> lock(loadedKernel->mutex);
+  const KernelSpec &spec = *loadedKernel->spec;
 
 #ifdef DEBUG_VALUES
   std::cout << "LHS Tensor" << std::endl;
-  params->lhs.dumpVals(std::cout, aVolume);
+  params->lhs.dumpVals(std::cout, spec.getLhsVolume());
   std::cout << "RHS Tensor" << std::endl;
-  params->rhs.dumpVals(std::cout, bVolume);
+  params->rhs.dumpVals(std::cout, spec.getRhsVolume());
 #endif
 
   // Set up binders to map HAL buffers to XRT buffers
   TRACE_DELEGATE("aie_matmul binder setup");
-  xrtState->lhsBinder->bind(params->lhs.get(), aVolume);
-  xrtState->rhsBinder->bind(params->rhs.get(), bVolume);
-  xrtState->resultBinder->bind(params->result.get(), cVolume);
-
-  // Copy inputs to kernel input BOs and sync the BOs
+  PerfTimer bindTimer(PerfPhase::Bind);
+  loadedKernel->lhsBinder->bind(params->lhs.get(), spec.getLhsVolume());
+  loadedKernel->rhsBinder->bind(params->rhs.get(), spec.getRhsVolume());
+  loadedKernel->resultBinder->bind(params->result.get(),
+                                   spec.getResultVolume());
+  bindTimer.stop();
+
+  // Copy inputs to kernel input BOs and sync the BOs.  The RHS is staged on
+  // the worker thread while this thread stages the LHS.  As the RHS is
+  // usually a model constant (the weights), it is taken from the weight cache
+  // when possible.
   TRACE_DELEGATE("aie_matmul copy inputs");
-  xrtState->lhsBinder->copyModelToXrt();
-  xrtState->rhsBinder->copyModelToXrt();
-
-  // copy output to XRT BO and sync it, if the kernel requires it
-#if KERNEL_REQUIRES_RESULT_PRELOAD
-  xrtState->resultBinder->copyModelToXrt();
+  std::optional<xrt::bo> cachedRhs;
+  std::future<void> rhsStaged = xrtState->stagingWorker.submit([&] {
+#ifdef USE_WEIGHT_CACHE
+    if (!loadedKernel->rhsBinder->isDirect()) {
+      const ModelRhsDType *rhs = params->rhs.get();
+      std::size_t volume = spec.getRhsVolume();
+      cachedRhs = xrtState->weightCache.lookup(
+          {&spec, rhs, spec.K, spec.N, 0, 0},
+          getWeightHash(rhs, volume * sizeof(ModelRhsDType)),
+          volume * getDTypeSize(spec.rhsDType), xrtState->device,
+          loadedKernel->kernel.group_id(3), [&](void *buf) {
+            copyModelToKernel(buf, spec.rhsDType, rhs, volume);
+          });
+    }
 #endif
+    if (!cachedRhs)
+      loadedKernel->rhsBinder->copyModelToXrt();
+  });
+  try {
+    loadedKernel->lhsBinder->copyModelToXrt();
+
+    // copy output to XRT BO and sync it, if the kernel requires it
+    if (spec.requiresResultPreload)
+      loadedKernel->resultBinder->copyModelToXrt();
+  } catch (...) {
+    rhsStaged.wait();
+    throw;
+  }
+  rhsStaged.get();
 
   // execute the kernel on NPU
   TRACE_DELEGATE("aie_matmul run kernel");
-  auto run = xrtState->kernel(
-      xrtState->boInstr, instrSize, xrtState->lhsBinder->getBo(),
-      xrtState->rhsBinder->getBo(), xrtState->resultBinder->getBo());
+  PerfTimer kernelTimer(PerfPhase::Kernel);
+  auto run = loadedKernel->kernel(
+      loadedKernel->boInstr, loadedKernel->instrSize,
+      loadedKernel->lhsBinder->getBo(),
+      cachedRhs ? *cachedRhs : loadedKernel->rhsBinder->getBo(),
+      loadedKernel->resultBinder->getBo());
   TRACE_DELEGATE("aie_matmul wait");
   run.wait();
+  kernelTimer.stop();
 
   // sync output to host and copy the data from the BO
   TRACE_DELEGATE("aie_matmul copy output");
-  xrtState->resultBinder->copyXrtToModel();
-
-  auto endTime = std::chrono::high_resolution_clock::now();
-  auto duration =
-      std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime)
-          .count();
-  std::cout << "[AIE Delegate]: Kernel execution time: " << duration << " ms"
-            << std::endl;
+  loadedKernel->resultBinder->copyXrtToModel();
 
 #ifdef DEBUG_VALUES
   std::cout << "Result Tensor" << std::endl;
-  params->result.dumpVals(std::cout, cVolume);
+  params->result.dumpVals(std::cout, spec.getResultVolume());
 #endif
   TRACE_DELEGATE("aie_matmul done");
 }
 
+//=============================================================================
+// Host-side tiling
+//
+// A matmul without a kernel of its exact shape is decomposed into tiles of
+// the shape of a registered kernel.  So is a matmul whose kernel reads blocked
+// inputs, as a single tile.  The edge tiles are padded with zeros.
+// The partial results over the K dimension are accumulated on the NPU if the
+// kernel supports a preloaded result, and on the host otherwise.
+
+// Copies rows [row0, row0 + numRows) and columns [col0, col0 + numCols) of a
+// row-major model matrix with `srcStride` columns into a dense `tileRows` x
+// `tileCols` kernel tile in `layout`, padding the rest of the tile with zeros.
+//
+// The tile is written sequentially, block by block, which suits the
+// write-combined memory of XRT buffers.  A row-major tile is a single block.
+template <typename ModelDType>
+void packTile(void *tileBuf, KernelDType kernelDType, OperandLayout layout,
+              int32_t tileRows, int32_t tileCols, const ModelDType *src,
+              int32_t srcStride, int32_t row0, int32_t col0, int32_t numRows,
+              int32_t numCols) {
+  std::size_t elemSize = getDTypeSize(kernelDType);
+  int32_t blockRows = layout.isRowMajor() ? tileRows : layout.blockRows;
+  int32_t blockCols = layout.isRowMajor() ? tileCols : layout.blockCols;
+  char *dst = static_cast<char *>(tileBuf);
+  for (int32_t bi = 0; bi < tileRows; bi += blockRows) {
+    for (int32_t bj = 0; bj < tileCols; bj += blockCols) {
+      for (int32_t i = bi; i < bi + blockRows; ++i) {
+        int32_t validCols =
+            i < numRows ? std::clamp(numCols - bj, 0, blockCols) : 0;
+        if (validCols > 0)
+          copyModelToKernel(dst, kernelDType,
+                            src + std::size_t(row0 + i) * srcStride + col0 +
+                                bj,
+                            validCols);
+        std::memset(dst + validCols * elemSize, 0,
+                    (blockCols - validCols) * elemSize);
+        dst += std::size_t(blockCols) * elemSize;
+      }
+    }
+  }
+}
+
+// Copies the top-left `numRows` x `numCols` of a dense kernel tile with
+// `tileCols` columns to rows [row0, ...) and columns [col0, ...) of a
+// row-major model matrix with `dstStride` columns.
+template <typename ModelDType>
+void unpackTile(ModelDType *dst, int32_t dstStride, int32_t row0, int32_t col0,
+                const void *tileBuf, KernelDType kernelDType, int32_t tileCols,
+                int32_t numRows, int32_t numCols) {
+  std::size_t elemSize = getDTypeSize(kernelDType);
+  const char *src = static_cast<const char *>(tileBuf);
+  for (int32_t i = 0; i < numRows; ++i)
+    copyKernelToModel(dst + std::size_t(row0 + i) * dstStride + col0,
+                      src + std::size_t(i) * tileCols * elemSize, kernelDType,
+                      numCols);
+}
+
+// Adds (or assigns, if `assign`) the top-left `numRows` x `numCols` of a
+// dense kernel tile with `tileCols` columns to a dense float accumulator with
+// `numCols` columns.
+void accumulateTile(float *acc, const void *tileBuf, KernelDType kernelDType,
+                    int32_t tileCols, int32_t numRows, int32_t numCols,
+                    bool assign) {
+  for (int32_t i = 0; i < numRows; ++i) {
+    float *accRow = acc + std::size_t(i) * numCols;
+    std::size_t srcOffset = std::size_t(i) * tileCols;
+    if (kernelDType == KernelDType::F32) {
+      const float *srcRow = static_cast<const float *>(tileBuf) + srcOffset;
+      for (int32_t j = 0; j < numCols; ++j)
+        accRow[j] = assign ? srcRow[j] : accRow[j] + srcRow[j];
+    } else {
+      const bfloat16_t *srcRow =
+          static_cast<const bfloat16_t *>(tileBuf) + srcOffset;
+      for (int32_t j = 0; j < numCols; ++j)
+        accRow[j] = assign ? bf16ToFloat(srcRow[j])
+                           : accRow[j] + bf16ToFloat(srcRow[j]);
+    }
+  }
+}
+
+// Runs a matmul of any shape as a sequence of runs of `loadedKernel`.
+//
+// The runs are pipelined over two sets of tile buffers: while the NPU runs
+// tile r, this thread packs the inputs of tile r + 1, and the staging worker
+// drains the result of tile r - 1.
+void tiled_aie_matmul(Params *params, LoadedKernel *loadedKernel,
+                      XrtState *xrtState) {
+  TRACE_DELEGATE("tiled_aie_matmul");
+  std::lock_guard<std::mutex> lock(loadedKernel->mutex);
+  const KernelSpec &spec = *loadedKernel->spec;
+  const int32_t M = params->M, K = params->K, N = params->N;
+  const int32_t numTilesM = (M + spec.M - 1) / spec.M;
+  const int32_t numTilesK = (K + spec.K - 1) / spec.K;
+  const int32_t numTilesN = (N + spec.N - 1) / spec.N;
+  const int64_t numRuns = int64_t(numTilesM) * numTilesN * numTilesK;
+  TRACE_DELEGATE1("tiled_aie_matmul ",
+                  params->getShapeStr() + " as " + std::to_string(numRuns) +
+                      " tiles of kernel " + spec.getShapeStr());
+
+#ifdef DEBUG_VALUES
+  std::cout << "LHS Tensor" << std::endl;
+  params->lhs.dumpVals(std::cout, std::size_t(M) * K);
+  std::cout << "RHS Tensor" << std::endl;
+  params->rhs.dumpVals(std::cout, std::size_t(K) * N);
+#endif
+
+  PerfTimer bindTimer(PerfPhase::Bind);
+  loadedKernel->allocateTileBuffers(xrtState->device);
+  bindTimer.stop();
+  auto &tileBuffers = loadedKernel->tileBuffers;
+
+  // Run `r` computes the partial product of output tile `r / numTilesK`
+  // over the K tile `r % numTilesK`.
+  struct Tile {
+    int32_t row0, col0, k0;     // offsets in the model matrices
+    int32_t numRows, numCols;   // valid part of the output tile
+    int32_t numK;               // valid part of the reduction
+    int32_t kIndex;
+    int64_t outputIndex;
+  };
+  auto getTile = [&](int64_t r) {
+    Tile tile;
+    tile.outputIndex = r / numTilesK;
+    tile.kIndex = int32_t(r % numTilesK);
+    tile.row0 = int32_t(tile.outputIndex / numTilesN) * spec.M;
+    tile.col0 = int32_t(tile.outputIndex % numTilesN) * spec.N;
+    tile.k0 = tile.kIndex * spec.K;
+    tile.numRows = std::min(spec.M, M - tile.row0);
+    tile.numCols = std::min(spec.N, N - tile.col0);
+    tile.numK = std::min(spec.K, K - tile.k0);
+    return tile;
+  };
+
+  // With a preloaded result, the K tiles of an output tile accumulate in the
+  // same result buffer, so result buffers alternate per output tile.
+  // Otherwise, they alternate per run.
+  auto getResultBuffer = [&](const Tile &tile, int64_t r) -> xrt::bo & {
+    int64_t index = spec.requiresResultPreload ? tile.outputIndex : r;
+    return tileBuffers[index % 2].result;
+  };
+
+  // Host accumulator over K, needed only without result preload
+  std::vector<float> acc;
+  if (!spec.requiresResultPreload && numTilesK > 1)
+    acc.resize(std::size_t(spec.M) * spec.N);
+
+  // RHS buffers of the runs in flight: either tile buffers or buffers of the
+  // weight cache.  The weight cache is used only if all the RHS tiles fit in
+  // it, as tiles evicting each other would cost more than packing them.
+  xrt::bo rhsBos[2];
+  std::size_t rhsTileBytes = spec.getRhsVolume() * getDTypeSize(spec.rhsDType);
+  bool useWeightCache = false;
+  uint64_t rhsHash = 0;
+#ifdef USE_WEIGHT_CACHE
+  useWeightCache = double(numTilesK) * numTilesN * rhsTileBytes <=
+                   double(xrtState->weightCache.getMaxBytes());
+  if (useWeightCache)
+    rhsHash = getWeightHash(params->rhs.get(),
+                            std::size_t(K) * N * sizeof(ModelRhsDType));
+#endif
+
+  // Result drain running on the staging worker, if any
+  std::future<void> drained;
+  auto waitForDrain = [&] {
+    if (drained.valid())
+      drained.get();
+  };
+
+  auto packInputs = [&](int64_t r) {
+    Tile tile = getTile(r);
+    LoadedKernel::TileBuffers &buffers = tileBuffers[r % 2];
+    {
+      PerfTimer timer(PerfPhase::CopyIn);
+      packTile(buffers.lhs.map<void *>(), spec.lhsDType, spec.lhsLayout,
+               spec.M, spec.K, params->lhs.get(), K, tile.row0, tile.k0,
+               tile.numRows, tile.numK);
+    }
+    {
+      PerfTimer timer(PerfPhase::SyncToDevice);
+      buffers.lhs.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    }
+    auto packRhs = [&](void *buf) {
+      packTile(buf, spec.rhsDType, spec.rhsLayout, spec.K, spec.N,
+               params->rhs.get(), N, tile.k0, tile.col0, tile.numK,
+               tile.numCols);
+    };
+    std::optional<xrt::bo> cachedRhs;
+    if (useWeightCache)
+      cachedRhs = xrtState->weightCache.lookup(
+          {&spec, params->rhs.get(), K, N, tile.k0, tile.col0}, rhsHash,
+          rhsTileBytes, xrtState->device, loadedKernel->kernel.group_id(3),
+          packRhs);
+    if (cachedRhs) {
+      rhsBos[r % 2] = *cachedRhs;
+    } else {
+      {
+        PerfTimer timer(PerfPhase::CopyIn);
+        packRhs(buffers.rhs.map<void *>());
+      }
+      PerfTimer timer(PerfPhase::SyncToDevice);
+      buffers.rhs.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+      rhsBos[r % 2] = buffers.rhs;
+    }
+    if (spec.requiresResultPreload && tile.kIndex == 0) {
+      // The buffer was last used by the output tile before the previous one,
+      // whose drain may still be running
+      waitForDrain();
+      xrt::bo &result = getResultBuffer(tile, r);
+      {
+        PerfTimer timer(PerfPhase::CopyIn);
+        std::memset(result.map<void *>(), 0,
+                    spec.getResultVolume() * getDTypeSize(spec.resultDType));
+      }
+      PerfTimer timer(PerfPhase::SyncToDevice);
+      result.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    }
+  };
+
+  // Start of the run in flight, for the `kernel` performance counter
+  PerfCounters::Clock::time_point runStart;
+
+  auto startRun = [&](int64_t r) {
+    LoadedKernel::TileBuffers &buffers = tileBuffers[r % 2];
+    runStart = PerfCounters::Clock::now();
+    return loadedKernel->kernel(loadedKernel->boInstr, loadedKernel->instrSize,
+                                buffers.lhs, rhsBos[r % 2],
+                                getResultBuffer(getTile(r), r));
+  };
+
+  auto drainResult = [&](int64_t r) {
+    Tile tile = getTile(r);
+    bool isLastK = tile.kIndex == numTilesK - 1;
+    if (spec.requiresResultPreload && !isLastK)
+      return;
+    xrt::bo &result = getResultBuffer(tile, r);
+    {
+      PerfTimer timer(PerfPhase::SyncFromDevice);
+      result.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+    }
+    PerfTimer timer(PerfPhase::CopyOut);
+    const void *resultBuf = result.map<void *>();
+    if (acc.empty()) {
+      unpackTile(params->result.get(), N, tile.row0, tile.col0, resultBuf,
+                 spec.resultDType, spec.N, tile.numRows, tile.numCols);
+      return;
+    }
+    accumulateTile(acc.data(), resultBuf, spec.resultDType, spec.N,
+                   tile.numRows, tile.numCols, tile.kIndex == 0);
+    if (isLastK)
+      for (int32_t i = 0; i < tile.numRows; ++i)
+        TensorCopier<float, ModelReturnDType>::copy(
+            params->result.get() + std::size_t(tile.row0 + i) * N +
+                tile.col0,
+            acc.data() + std::size_t(i) * tile.numCols, tile.numCols);
+  };
+
+  try {
+    packInputs(0);
+    auto run = startRun(0);
+    for (int64_t r = 0; r < numRuns; ++r) {
+      if (r + 1 < numRuns)
+        packInputs(r + 1);
+      TRACE_DELEGATE1("tiled_aie_matmul wait run ", r);
+      run.wait();
+      PerfCounters::getInstance().record(PerfPhase::Kernel, runStart,
+                                         PerfCounters::Clock::now());
+      // Run r + 1 may write the result buffer drained for run r - 1
+      waitForDrain();
+      if (r + 1 < numRuns)
+        run = startRun(r + 1);
+      drained = xrtState->stagingWorker.submit([&, r] { drainResult(r); });
+    }
+    waitForDrain();
+  } catch (...) {
+    if (drained.valid())
+      drained.wait();
+    throw;
+  }
+
+#ifdef DEBUG_VALUES
+  std::cout << "Result Tensor" << std::endl;
+  params->result.dumpVals(std::cout, std::size_t(M) * N);
+#endif
+  TRACE_DELEGATE("tiled_aie_matmul done");
+}
+
 //#############################################################################
 //
-// Reference scalar CPU implementation, adapted from Mahesh's CPU delegate
-// in iree/samples/custom_dispatch/cpu/mlp_plugin
+// CPU implementation, originally adapted from Mahesh's CPU delegate in
+// iree/samples/custom_dispatch/cpu/mlp_plugin.  The matmul itself is the
+// blocked, packed and multithreaded one in cpu_gemm.h.
 //
 
-// Type for accumulating the multiplications over the k dimension
-using CpuAccDType = 
+static void cpu_matmul(Params *params) {
 #ifdef USE_BF16_CPU_ACCUMULATOR
-  bfloat16_t;
+  // Rounds every product and partial sum to bfloat16
+  constexpr bool bf16Accumulate = true;
 #else
-  float;
+  constexpr bool bf16Accumulate = false;
 #endif
+  GemmIsa isa = bf16Accumulate ? GemmIsa::Generic : getBestGemmIsa();
+  TRACE_DELEGATE1("cpu_matmul ", std::string(getGemmIsaName(isa)) + " " +
+                                     params->getShapeStr());
+  cpuGemm(params->lhs.get(), params->rhs.get(), params->result.get(),
+          params->M, params->N, params->K, bf16Accumulate, isa);
+}
 
-static void cpu_matmul(Params *params) {
-  std::cout << "[AIE Delegate]: Computing CPU scalar matmul of " << params->getShapeStr() << std::endl;
-  for (int32_t i = 0; i < params->M; i++) {
-    for (int32_t j = 0; j < params->N; j++) {
-      CpuAccDType curr_result = Converter<float, CpuAccDType>::convert(0.0);
-      for (int32_t k = 0; k < params->K; k++) {
-        float a = Converter<ModelLhsDType, float>::convert(params->lhs.getElement(i, k, K));
-        float b = Converter<ModelRhsDType, float>::convert(params->rhs.getElement(k, j, N));
-        curr_result = Converter<float, CpuAccDType>::convert(
-          Converter<CpuAccDType, float>::convert(curr_result)
-          + Converter<float, CpuAccDType>::convert(a * b)
-        );
+//#############################################################################
+//
+// Matmul entry points, synchronous and asynchronous
+//
+
+// Computes the matmul of `params` on the NPU, or on the CPU with
+// USE_CPU_IMPLEMENTATION
+static void delegate_matmul(Params *params) {
+  PerfTimer timer(PerfPhase::Matmul, params->getShapeStr());
+
+#ifdef USE_CPU_IMPLEMENTATION
+  cpu_matmul(params);  // enable this if CPU fallback desired
+#else
+  // Use the kernel of the input shapes if there is one, otherwise tile the
+  // matmul onto the best-fitting kernel.  Kernels with blocked inputs always
+  // go through the tiling path, which stages the inputs in their layout.
+  auto xrtState = XrtState::getInstance();
+  if (params->M <= 0 || params->K <= 0 || params->N <= 0) {
+    std::ostringstream oss;
+    oss << "[AIE Delegate] FATAL ERROR: Invalid matmul shape: M=" << params->M
+        << ", N=" << params->N << ", K=" << params->K << std::endl;
+    throw DelegateException(oss.str());
+  }
+  const KernelSpec *spec =
+      xrtState->registry.find(params->M, params->K, params->N);
+  if (spec && spec->lhsLayout.isRowMajor() && spec->rhsLayout.isRowMajor()) {
+    aie_matmul(params, xrtState->getKernel(*spec), xrtState);
+  } else if (spec) {
+    tiled_aie_matmul(params, xrtState->getKernel(*spec), xrtState);
+  } else {
+    spec = xrtState->registry.findTilingKernel(params->M, params->K,
+                                               params->N);
+    tiled_aie_matmul(params, xrtState->getKernel(*spec), xrtState);
+  }
+#endif
+}
+
+// Matmuls queued by `mlp_external_async`, run one after the other on a worker
+// thread, and their completion, for `mlp_external_wait`.  Used as a singleton
+// via `getInstance()`.
+//
+// The operand buffers of a queued matmul must stay valid, and must not be
+// written or read by anything else, until a wait on its result returns.
+class AsyncMatmulQueue {
+public:
+  static AsyncMatmulQueue &getInstance() {
+    static AsyncMatmulQueue instance;
+    return instance;
+  }
+
+  void submit(const Params &params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back({params.lhs.get(), params.rhs.get(), params.result.get(),
+                       worker.submit([params]() mutable {
+                         delegate_matmul(&params);
+                       })});
+  }
+
+  // Waits for the queued matmuls that read `lhs` or `rhs`, or write `result`,
+  // so that none of these buffers is in use anymore when this returns.  Null
+  // buffers are ignored, and all queued matmuls are waited for if all three
+  // are null.  Rethrows the first of their exceptions, if any.
+  void wait(const void *lhs, const void *rhs, const void *result) {
+    bool waitAll = !lhs && !rhs && !result;
+    std::vector<std::future<void>> futures;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto it = pending.begin(); it != pending.end();) {
+        if (waitAll || (lhs && it->lhs == lhs) || (rhs && it->rhs == rhs) ||
+            (result && it->result == result)) {
+          futures.push_back(std::move(it->done));
+          it = pending.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    std::exception_ptr error;
+    for (std::future<void> &future : futures) {
+      try {
+        future.get();
+      } catch (...) {
+        if (!error)
+          error = std::current_exception();
       }
-      // curr_result = curr_result < 0.0 ? 0.0 : curr_result;  ref matmul doesn't seem to have this
-      params->result.setElement(i, j, N, Converter<CpuAccDType, ModelReturnDType>::convert(curr_result));
     }
+    if (error)
+      std::rethrow_exception(error);
   }
-}
+
+private:
+  struct PendingMatmul {
+    const void *lhs;
+    const void *rhs;
+    const void *result;
+    std::future<void> done;
+  };
+
+  std::mutex mutex;
+  std::list<PendingMatmul> pending;
+  StagingWorker worker;  // last, so that it stops before the members above
+};
 
 //#############################################################################
 //
@@ -893,26 +2045,47 @@ static int mlp_external(void* params_ptr, void* context, void* reserved) {
   // fprintf(plugin->file, "[AIE Delegate]: M = %d, N = %d, K = %d\n", params->M,
   //         params->N, params->K);
   TRACE_DELEGATE("mlp_external");
+  delegate_matmul(params);
+  TRACE_DELEGATE("mlp_external done");
+  return 0;
+}
 
-#ifdef USE_CPU_IMPLEMENTATION
-  cpu_matmul(params);  // enable this if CPU fallback desired
-#else
-  // If the input shapes do not match the AIE kernel, deliberately fail to
-  // make sure AIE version is getting used
-  if (params->M != MLP_M || params->K != MLP_K || params->N != MLP_N) {
-    std::ostringstream oss;
-    oss << "[AIE Delegate] FATAL ERROR: Shape mismatch between model and kernel."
-        << std::endl;
-    oss << "    Model shape: M=" << params->M << ", N=" << params->N << ", K="
-        << params->K << std::endl;
-    oss << "    Kernel shape: M=" << MLP_M << ", N=" << MLP_N << ", K="
-        << MLP_K << std::endl;
-    throw DelegateException(oss.str());
-  }
+// Asynchronous variant of `mlp_external`: queues the matmul and returns
+// without waiting for it, so that the caller can go on with other work while
+// the NPU computes.  Takes the same params as `mlp_external`.  A call to
+// `mlp_external_wait` on the result must come before anything reads the
+// result, or reads or writes the operands.  Matmuls run in the order that
+// they are queued.
+static int mlp_external_async(void* params_ptr, void* context,
+                              void* reserved) {
+  auto params = reinterpret_cast<Params *>(params_ptr);
+  TRACE_DELEGATE1("mlp_external_async ", params->getShapeStr());
+  AsyncMatmulQueue::getInstance().submit(*params);
+  return 0;
+}
 
-  aie_matmul(params);
-#endif
-  TRACE_DELEGATE("mlp_external done");
+// Set of all arguments passed from model to `mlp_external_wait`
+//
+// The layout of this struct must match the calling convention for the plugin.
+struct WaitParams {
+  const TensorData<ModelLhsDType> lhs;
+  const TensorData<ModelRhsDType> rhs;
+  const TensorData<ModelReturnDType> result;
+};
+
+// `mlp_external_wait(lhs, rhs, result)`: waits for the matmuls queued by
+// `mlp_external_async` that read `lhs` or `rhs`, or write `result`, or for all
+// queued matmuls if all three pointers are null.  The operands are passed so
+// that the dispatch calling this keeps their buffers alive until the matmuls
+// reading them are done.
+static int mlp_external_wait(void* params_ptr, void* context, void* reserved) {
+  auto params = reinterpret_cast<WaitParams *>(params_ptr);
+  TRACE_DELEGATE("mlp_external_wait");
+  AsyncMatmulQueue::getInstance().wait(
+      params->lhs.data ? params->lhs.get() : nullptr,
+      params->rhs.data ? params->rhs.get() : nullptr,
+      params->result.data ? params->result.get() : nullptr);
+  TRACE_DELEGATE("mlp_external_wait done");
   return 0;
 }
 
@@ -942,8 +2115,12 @@ static iree_hal_executable_plugin_status_t mlp_plugin_load(
   // stateful/side-effecting things.
   plugin->file = stdout;
 
+  const char *perfTraceEnv = std::getenv(PerfTraceEnvVar);
+  if (perfTraceEnv && *perfTraceEnv)
+    PerfCounters::getInstance().enableTrace();
+
 #ifndef USE_CPU_IMPLEMENTATION
-  // Initialize XRT with the one-and-only xclbin and instruction file
+  // Initialize XRT and read the kernel manifest
   setupNPUAccelerator();
 #endif
 
@@ -964,7 +2141,35 @@ static void mlp_plugin_unload(void* self) {
   fflush(plugin->file);
   plugin->file = NULL;
 
+  // Finish the matmuls still queued, which use the state released below
+  try {
+    AsyncMatmulQueue::getInstance().wait(nullptr, nullptr, nullptr);
+  } catch (const std::exception &e) {
+    std::cerr << e.what();
+  }
+
+  // Report the performance counters of this load, if requested
+  PerfCounters &perfCounters = PerfCounters::getInstance();
+  const char *perfSummaryEnv = std::getenv(PerfSummaryEnvVar);
+  if (perfSummaryEnv && std::strtol(perfSummaryEnv, nullptr, 10) != 0)
+    perfCounters.dumpSummary(std::cout);
+  const char *perfTraceEnv = std::getenv(PerfTraceEnvVar);
+  if (perfTraceEnv && *perfTraceEnv && perfCounters.isTracing()) {
+    try {
+      perfCounters.writeTrace(perfTraceEnv);
+    } catch (const DelegateException &e) {
+      std::cerr << e.what();
+    }
+  }
+  perfCounters.reset();
+
 #ifndef USE_CPU_IMPLEMENTATION
+#ifdef USE_WEIGHT_CACHE
+  if (isDelegateVerbose()) {
+    XrtState::getInstance()->weightCache.dumpStats(
+        std::cout << "[AIE Delegate]: ") << std::endl;
+  }
+#endif
   XrtState::getInstance(true); // delete singleton data
 #endif
 
@@ -992,6 +2197,14 @@ static iree_hal_executable_plugin_status_t mlp_plugin_resolve(
       params->out_fn_ptrs[i] = reinterpret_cast<void *>(mlp_external);
       params->out_fn_contexts[i] =
           plugin;  // passing plugin to each import call
+    } else if (iree_hal_executable_plugin_strcmp(symbol_name,
+                                                 "mlp_external_async") == 0) {
+      params->out_fn_ptrs[i] = reinterpret_cast<void *>(mlp_external_async);
+      params->out_fn_contexts[i] = plugin;
+    } else if (iree_hal_executable_plugin_strcmp(symbol_name,
+                                                 "mlp_external_wait") == 0) {
+      params->out_fn_ptrs[i] = reinterpret_cast<void *>(mlp_external_wait);
+      params->out_fn_contexts[i] = plugin;
     } else {
       if (is_optional) {
         *out_resolution |=
@@ -29,6 +29,12 @@ typedef struct iree_hal_xrt_device_params_t {
   // Larger sizes will lower overhead and ensure the heap isn't hit for
   // transient allocations while also increasing memory consumption.
   iree_host_size_t arena_block_size;
+
+  // Whether to reorder the dispatches between two barriers of a command buffer
+  // so that the dispatches running in the same hardware context are adjacent.
+  // This minimizes the number of hardware context switches, which are among
+  // the most expensive operations of the NPU.
+  bool group_dispatches_by_context;
 } iree_hal_xrt_device_params_t;
 
 // Initializes |out_params| to default values.
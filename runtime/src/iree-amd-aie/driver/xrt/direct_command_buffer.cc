@@ -9,8 +9,23 @@
 #include "iree-amd-aie/driver/xrt/native_executable.h"
 #include "iree-amd-aie/driver/xrt/pipeline_layout.h"
 #include "iree-amd-aie/driver/xrt/xrt_buffer.h"
+#include "iree-amd-aie/driver/xrt/xrt_device.h"
 #include "iree/hal/utils/resource_set.h"
 
+// A dispatch recorded since the last barrier, which is executed when the
+// command buffer is flushed.
+typedef struct iree_hal_xrt_pending_dispatch_t {
+  struct iree_hal_xrt_pending_dispatch_t* next;
+  iree_hal_xrt_kernel_params_t kernel_params;
+  // The run with all its arguments set, except for the instruction buffer
+  // which is only patched right before starting the run.
+  xrt::run* run;
+  // Push constants at the time the dispatch was recorded.
+  uint32_t push_constants[IREE_HAL_XRT_MAX_PUSH_CONSTANT_COUNT];
+  // Whether the dispatch has been given its place in the execution order.
+  bool scheduled;
+} iree_hal_xrt_pending_dispatch_t;
+
 typedef struct iree_hal_xrt_direct_command_buffer_t {
   iree_hal_command_buffer_t base;
   iree_allocator_t host_allocator;
@@ -22,6 +37,11 @@ typedef struct iree_hal_xrt_direct_command_buffer_t {
   // Staging arena used for host->device transfers.
   iree_arena_allocator_t arena;
 
+  // State of the device queue the command buffer executes on.
+  iree_hal_xrt_queue_state_t* queue_state;
+  // See iree_hal_xrt_device_params_t::group_dispatches_by_context.
+  bool group_dispatches_by_context;
+
   struct {
     xrt::bo* bindings[IREE_HAL_XRT_MAX_DESCRIPTOR_SET_BINDING_COUNT];
     // Offset and length are used to get the sub buffer at kernel launch.
@@ -29,6 +49,16 @@ typedef struct iree_hal_xrt_direct_command_buffer_t {
     iree_device_size_t lengths[IREE_HAL_XRT_MAX_DESCRIPTOR_SET_BINDING_COUNT];
 
   } descriptor_sets[IREE_HAL_XRT_MAX_DESCRIPTOR_SET_COUNT];
+
+  // Push constants, used to patch the instruction buffer at dispatch time.
+  uint32_t push_constants[IREE_HAL_XRT_MAX_PUSH_CONSTANT_COUNT];
+
+  // Dispatches recorded since the last barrier, in recording order. These are
+  // independent of each other, so they may be reordered to group those running
+  // in the same hardware context.
+  iree_hal_xrt_pending_dispatch_t* pending_head;
+  iree_hal_xrt_pending_dispatch_t* pending_tail;
+  iree_host_size_t pending_count;
 } iree_hal_xrt_direct_command_buffer_t;
 
 namespace {
@@ -70,6 +100,9 @@ iree_status_t iree_hal_xrt_direct_command_buffer_create(
       &command_buffer->base);
   command_buffer->host_allocator = host_allocator;
   iree_arena_initialize(block_pool, &command_buffer->arena);
+  command_buffer->queue_state = iree_hal_xrt_device_queue_state(device);
+  command_buffer->group_dispatches_by_context =
+      iree_hal_xrt_device_params(device)->group_dispatches_by_context;
   iree_status_t status =
       iree_hal_resource_set_allocate(block_pool, &command_buffer->resource_set);
   if (iree_status_is_ok(status)) {
@@ -80,12 +113,30 @@ iree_status_t iree_hal_xrt_direct_command_buffer_create(
 
   return status;
 }
+
+// Drops the pending dispatches without executing them.
+static void iree_hal_xrt_direct_command_buffer_discard_pending(
+    iree_hal_xrt_direct_command_buffer_t* command_buffer) {
+  for (iree_hal_xrt_pending_dispatch_t* dispatch = command_buffer->pending_head;
+       dispatch; dispatch = dispatch->next) {
+    try {
+      delete dispatch->run;
+    } catch (...) {
+      (void)iree_status_from_code(IREE_STATUS_DATA_LOSS);
+    }
+  }
+  command_buffer->pending_head = NULL;
+  command_buffer->pending_tail = NULL;
+  command_buffer->pending_count = 0;
+}
+
 static void iree_hal_xrt_direct_command_buffer_destroy(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_xrt_direct_command_buffer_t* command_buffer =
       iree_hal_xrt_direct_command_buffer_cast(base_command_buffer);
   iree_allocator_t host_allocator = command_buffer->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_xrt_direct_command_buffer_discard_pending(command_buffer);
   iree_hal_resource_set_free(command_buffer->resource_set);
   iree_arena_deinitialize(&command_buffer->arena);
   iree_allocator_free(host_allocator, command_buffer);
@@ -99,6 +150,126 @@ bool iree_hal_xrt_direct_command_buffer_isa(
                               &iree_hal_xrt_direct_command_buffer_vtable);
 }
 
+// Patches the fields of the instruction buffer, which depend on push constants,
+// see `iree_hal_xrt_instr_patch_t`. The fields are overwritten entirely right
+// before every run, which is safe as runs are executed one after another.
+static iree_status_t iree_hal_xrt_direct_command_buffer_patch_instr(
+    const uint32_t* push_constants,
+    const iree_hal_xrt_kernel_params_t* kernel_params) {
+  if (kernel_params->instr_patch_count == 0) return iree_ok_status();
+  uint32_t* instr_buffer = kernel_params->instr->map<uint32_t*>();
+  for (iree_host_size_t i = 0; i < kernel_params->instr_patch_count; ++i) {
+    const iree_hal_xrt_instr_patch_t* patch = &kernel_params->instr_patches[i];
+    if (patch->constant_ordinal >= IREE_HAL_XRT_MAX_PUSH_CONSTANT_COUNT) {
+      return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "instruction patch refers to push constant %u",
+                              patch->constant_ordinal);
+    }
+    int64_t constant = push_constants[patch->constant_ordinal];
+    int64_t numerator = constant * patch->multiplier + patch->addend;
+    int64_t quotient = numerator / patch->divisor;
+    if (quotient * patch->divisor < numerator) ++quotient;
+    int64_t value = quotient * patch->scale + patch->bias;
+    uint64_t max_value = (1ull << patch->bit_width) - 1;
+    if (value < 0 || (uint64_t)value > max_value) {
+      return iree_make_status(
+          IREE_STATUS_OUT_OF_RANGE,
+          "value %" PRId64 " derived from push constant %u doesn't fit in the "
+          "%u bit instruction field",
+          value, patch->constant_ordinal, patch->bit_width);
+    }
+    uint32_t mask = (uint32_t)(max_value << patch->bit_offset);
+    uint32_t* word = &instr_buffer[patch->word_index];
+    *word = (*word & ~mask) | (((uint32_t)value << patch->bit_offset) & mask);
+  }
+  kernel_params->instr->sync(XCL_BO_SYNC_BO_TO_DEVICE);
+  return iree_ok_status();
+}
+
+// Executes the pending dispatches. As there is no barrier between them, the
+// ones running in the same hardware context are grouped together, starting with
+// the context which is already active on the queue, to minimize the number of
+// context switches. Within a context the recording order is kept. The queue
+// state is locked for the whole flush, so that the dispatches of command
+// buffers executing concurrently don't interleave with these.
+static iree_status_t iree_hal_xrt_direct_command_buffer_flush(
+    iree_hal_xrt_direct_command_buffer_t* command_buffer) {
+  if (!command_buffer->pending_head) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_xrt_queue_state_t* queue_state = command_buffer->queue_state;
+
+  iree_hal_xrt_pending_dispatch_t** order = NULL;
+  iree_status_t status = iree_arena_allocate(
+      &command_buffer->arena, command_buffer->pending_count * sizeof(*order),
+      (void**)&order);
+  if (!iree_status_is_ok(status)) {
+    iree_hal_xrt_direct_command_buffer_discard_pending(command_buffer);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+  iree_slim_mutex_lock(&queue_state->mutex);
+  iree_host_size_t order_count = 0;
+  int64_t recorded_switch_count = 0;
+  const xrt::hw_context* context = queue_state->active_context;
+  for (iree_hal_xrt_pending_dispatch_t* dispatch = command_buffer->pending_head;
+       dispatch; dispatch = dispatch->next) {
+    if (dispatch->kernel_params.context != context) ++recorded_switch_count;
+    context = dispatch->kernel_params.context;
+    if (!command_buffer->group_dispatches_by_context) {
+      order[order_count++] = dispatch;
+    }
+  }
+  context = queue_state->active_context;
+  while (order_count < command_buffer->pending_count) {
+    // Take all the dispatches in the current context and then move on to the
+    // context of the first dispatch left.
+    const xrt::hw_context* next_context = NULL;
+    for (iree_hal_xrt_pending_dispatch_t* dispatch =
+             command_buffer->pending_head;
+         dispatch; dispatch = dispatch->next) {
+      if (dispatch->scheduled) continue;
+      if (dispatch->kernel_params.context == context) {
+        dispatch->scheduled = true;
+        order[order_count++] = dispatch;
+      } else if (!next_context) {
+        next_context = dispatch->kernel_params.context;
+      }
+    }
+    context = next_context;
+  }
+
+  int64_t switch_count = 0;
+  for (iree_host_size_t i = 0; i < order_count; ++i) {
+    iree_hal_xrt_pending_dispatch_t* dispatch = order[i];
+    // The queue state must be unlocked below, so don't let XRT errors escape.
+    try {
+      status = iree_hal_xrt_direct_command_buffer_patch_instr(
+          dispatch->push_constants, &dispatch->kernel_params);
+      if (!iree_status_is_ok(status)) break;
+      if (dispatch->kernel_params.context != queue_state->active_context) {
+        ++switch_count;
+        queue_state->active_context = dispatch->kernel_params.context;
+      }
+      dispatch->run->start();
+      dispatch->run->wait();
+    } catch (std::exception& e) {
+      status = iree_make_status(IREE_STATUS_INTERNAL, "XRT run error: %s",
+                                e.what());
+      break;
+    }
+  }
+  queue_state->context_switch_count += switch_count;
+  if (iree_status_is_ok(status)) {
+    queue_state->context_switches_avoided_count +=
+        recorded_switch_count - switch_count;
+  }
+  iree_slim_mutex_unlock(&queue_state->mutex);
+
+  iree_hal_xrt_direct_command_buffer_discard_pending(command_buffer);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static iree_status_t iree_hal_xrt_direct_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
   // Nothing to do.
@@ -110,6 +281,8 @@ static iree_status_t iree_hal_xrt_direct_command_buffer_end(
   iree_hal_xrt_direct_command_buffer_t* command_buffer =
       iree_hal_xrt_direct_command_buffer_cast(base_command_buffer);
   IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_xrt_direct_command_buffer_flush(command_buffer));
   iree_arena_reset(&command_buffer->arena);
   iree_hal_resource_set_free(command_buffer->resource_set);
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -152,9 +325,10 @@ static iree_status_t iree_hal_xrt_direct_command_buffer_execution_barrier(
                             "non-zero barrier flag not yet supported");
   }
 
-  // Nothing to do in current synchronous mode.
-
-  return iree_ok_status();
+  // Dispatches recorded after the barrier may depend on the ones before it.
+  iree_hal_xrt_direct_command_buffer_t* command_buffer =
+      iree_hal_xrt_direct_command_buffer_cast(base_command_buffer);
+  return iree_hal_xrt_direct_command_buffer_flush(command_buffer);
 }
 
 static iree_status_t iree_hal_xrt_direct_command_buffer_signal_event(
@@ -200,7 +374,13 @@ static iree_status_t iree_hal_xrt_direct_command_buffer_update_buffer(
     iree_hal_command_buffer_t* base_command_buffer, const void* source_buffer,
     iree_host_size_t source_offset, iree_hal_buffer_t* target_buffer,
     iree_device_size_t target_offset, iree_device_size_t length) {
+  iree_hal_xrt_direct_command_buffer_t* command_buffer =
+      iree_hal_xrt_direct_command_buffer_cast(base_command_buffer);
   IREE_TRACE_ZONE_BEGIN(z0);
+  // Transfers are executed right away, so execute the dispatches recorded
+  // before them first.
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_xrt_direct_command_buffer_flush(command_buffer));
   const uint8_t* src = (const uint8_t*)source_buffer + source_offset;
 
   // No need to Allocate scratch space (in an arena) as the memcpy
@@ -221,7 +401,11 @@ static iree_status_t iree_hal_xrt_direct_command_buffer_copy_buffer(
     iree_hal_buffer_t* source_buffer, iree_device_size_t source_offset,
     iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
     iree_device_size_t length) {
+  iree_hal_xrt_direct_command_buffer_t* command_buffer =
+      iree_hal_xrt_direct_command_buffer_cast(base_command_buffer);
   IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_xrt_direct_command_buffer_flush(command_buffer));
 
   xrt::bo* target_device_buffer = iree_hal_xrt_buffer_handle(
       iree_hal_buffer_allocated_buffer(target_buffer));
@@ -254,8 +438,21 @@ static iree_status_t iree_hal_xrt_direct_command_buffer_push_constants(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_pipeline_layout_t* pipeline_layout, iree_host_size_t offset,
     const void* values, iree_host_size_t values_length) {
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                          "push constants not yet supported");
+  iree_hal_xrt_direct_command_buffer_t* command_buffer =
+      iree_hal_xrt_direct_command_buffer_cast(base_command_buffer);
+  iree_host_size_t constant_base_index = offset / sizeof(uint32_t);
+  if (offset % sizeof(uint32_t) != 0 || values_length % sizeof(uint32_t) != 0 ||
+      constant_base_index + values_length / sizeof(uint32_t) >
+          IREE_HAL_XRT_MAX_PUSH_CONSTANT_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "push constants out of range; offset %" PRIhsz
+                            " and length %" PRIhsz " vs. maximal %d constants",
+                            offset, values_length,
+                            IREE_HAL_XRT_MAX_PUSH_CONSTANT_COUNT);
+  }
+  memcpy(&command_buffer->push_constants[constant_base_index], values,
+         values_length);
+  return iree_ok_status();
 }
 
 static iree_status_t iree_hal_xrt_direct_command_buffer_push_descriptor_set(
@@ -324,7 +521,24 @@ static iree_status_t iree_hal_xrt_direct_command_buffer_dispatch(
   xrt::bo instr = *kernel_params.instr;
   uint32_t num_instr = kernel_params.num_instr;
 
-  xrt::run run = xrt::run(kernel);
+  iree_hal_xrt_pending_dispatch_t* dispatch = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_arena_allocate(&command_buffer->arena, sizeof(*dispatch),
+                              (void**)&dispatch));
+  dispatch->next = NULL;
+  dispatch->kernel_params = kernel_params;
+  dispatch->run = new xrt::run(kernel);
+  dispatch->scheduled = false;
+  memcpy(dispatch->push_constants, command_buffer->push_constants,
+         sizeof(dispatch->push_constants));
+  if (command_buffer->pending_tail) {
+    command_buffer->pending_tail->next = dispatch;
+  } else {
+    command_buffer->pending_head = dispatch;
+  }
+  command_buffer->pending_tail = dispatch;
+  ++command_buffer->pending_count;
+  xrt::run& run = *dispatch->run;
 
   // set opcode for transaction binary execution
   unsigned int opcode = 3;
@@ -362,8 +576,8 @@ static iree_status_t iree_hal_xrt_direct_command_buffer_dispatch(
       run.set_arg(arg_index + base_index + j, arg_buffer);
     }
   }
-  run.start();
-  run.wait();
+  // The run is started when the command buffer is flushed at the next barrier
+  // or at its end.
 
   IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
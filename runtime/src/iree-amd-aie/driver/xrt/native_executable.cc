@@ -8,6 +8,10 @@
 
 #include <stddef.h>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "iree-amd-aie/schemas/xrt_executable_def_reader.h"
 #include "iree-amd-aie/schemas/xrt_executable_def_verifier.h"
 #include "iree/base/api.h"
@@ -20,6 +24,14 @@ typedef struct iree_hal_xrt_native_executable_t {
 
   iree_allocator_t host_allocator;
 
+  // State of the device queue, which may still refer to one of the hardware
+  // contexts below.
+  iree_hal_xrt_queue_state_t* queue_state;
+
+  // Hardware contexts of the xclbins, which are shared by their entry points.
+  iree_host_size_t context_count;
+  xrt::hw_context** contexts;
+
   iree_host_size_t entry_point_count;
   iree_hal_xrt_kernel_params_t entry_points[];
 } iree_hal_xrt_native_executable_t;
@@ -85,6 +97,26 @@ static iree_status_t iree_amd_aie_hal_xrt_native_executable_flatbuffer_verify(
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "no xclbin present");
   }
 
+  // Several entry points may share an xclbin, but each must refer to one.
+  flatbuffers_uint32_vec_t xclbin_indices =
+      iree_amd_aie_hal_xrt_ExecutableDef_xclbin_indices_get(executable_def);
+  if (flatbuffers_uint32_vec_len(xclbin_indices) != entry_point_count) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "number of entry points (%zu) and number of xclbin "
+                            "indices (%zu) mismatched",
+                            entry_point_count,
+                            flatbuffers_uint32_vec_len(xclbin_indices));
+  }
+  for (size_t i = 0; i < entry_point_count; ++i) {
+    uint32_t xclbin_index = flatbuffers_uint32_vec_at(xclbin_indices, i);
+    if (xclbin_index >= number_xclbin) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "entry point %zu refers to xclbin %u but only "
+                              "%zu are present",
+                              i, xclbin_index, number_xclbin);
+    }
+  }
+
   iree_amd_aie_hal_xrt_AsmInstDef_vec_t asm_instr =
       iree_amd_aie_hal_xrt_ExecutableDef_asm_instrs_get(executable_def);
   size_t number_asm_instr = iree_amd_aie_hal_xrt_AsmInstDef_vec_len(asm_instr);
@@ -95,11 +127,45 @@ static iree_status_t iree_amd_aie_hal_xrt_native_executable_flatbuffer_verify(
                             entry_point_count, number_asm_instr);
   }
 
+  for (size_t i = 0; i < number_asm_instr; ++i) {
+    iree_amd_aie_hal_xrt_AsmInstDef_table_t asminst_def =
+        iree_amd_aie_hal_xrt_AsmInstDef_vec_at(asm_instr, i);
+    size_t num_instr = flatbuffers_uint32_vec_len(
+        iree_amd_aie_hal_xrt_AsmInstDef_asm_inst_get(asminst_def));
+    iree_amd_aie_hal_xrt_AsmInstPatchDef_vec_t patches =
+        iree_amd_aie_hal_xrt_AsmInstDef_patches_get(asminst_def);
+    size_t patch_count = iree_amd_aie_hal_xrt_AsmInstPatchDef_vec_len(patches);
+    for (size_t j = 0; j < patch_count; ++j) {
+      iree_amd_aie_hal_xrt_AsmInstPatchDef_struct_t patch =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_vec_at(patches, j);
+      uint32_t word_index =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_word_index_get(patch);
+      uint32_t bit_offset =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_bit_offset_get(patch);
+      uint32_t bit_width =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_bit_width_get(patch);
+      if (word_index >= num_instr || bit_width == 0 || bit_offset >= 32 ||
+          bit_width > 32 - bit_offset) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "asm instructions %zu patch %zu is out of "
+                                "bounds",
+                                i, j);
+      }
+      if (iree_amd_aie_hal_xrt_AsmInstPatchDef_divisor_get(patch) <= 0) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "asm instructions %zu patch %zu has a "
+                                "non-positive divisor",
+                                i, j);
+      }
+    }
+  }
+
   return iree_ok_status();
 }
 
 iree_status_t iree_hal_xrt_native_executable_create(
-    xrt::device device, const iree_hal_executable_params_t* executable_params,
+    xrt::device device, iree_hal_xrt_queue_state_t* queue_state,
+    const iree_hal_executable_params_t* executable_params,
     iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(executable_params);
   IREE_ASSERT_ARGUMENT(out_executable);
@@ -133,6 +199,18 @@ iree_status_t iree_hal_xrt_native_executable_create(
 
   iree_host_size_t entry_point_count =
       flatbuffers_string_vec_len(entry_points_vec);
+  // Copies of the instruction patches are stored right after the entry points,
+  // as the flatbuffer may be released while the executable is still live.
+  iree_host_size_t total_instr_patch_count = 0;
+  for (iree_host_size_t entry_ordinal = 0; entry_ordinal < entry_point_count;
+       entry_ordinal++) {
+    uint32_t asm_instr_index =
+        flatbuffers_uint32_vec_at(asm_instr_indices_vec, entry_ordinal);
+    iree_amd_aie_hal_xrt_AsmInstDef_table_t asminst_def =
+        iree_amd_aie_hal_xrt_AsmInstDef_vec_at(asm_instrs_vec, asm_instr_index);
+    total_instr_patch_count += iree_amd_aie_hal_xrt_AsmInstPatchDef_vec_len(
+        iree_amd_aie_hal_xrt_AsmInstDef_patches_get(asminst_def));
+  }
   // Calculate the total number of characters across all entry point names. This
   // is only required when tracing so that we can store copies of the names as
   // the flatbuffer storing the strings may be released while the executable is
@@ -147,45 +225,73 @@ iree_status_t iree_hal_xrt_native_executable_create(
     }
   });
 
+  iree_host_size_t xclbin_count =
+      iree_amd_aie_hal_xrt_XclbinDef_vec_len(xclbins_vec);
   iree_host_size_t total_size =
       sizeof(*executable) +
       entry_point_count * sizeof(executable->entry_points[0]) +
+      xclbin_count * sizeof(xrt::hw_context*) +
+      total_instr_patch_count * sizeof(iree_hal_xrt_instr_patch_t) +
       total_entry_point_name_chars;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0,
       iree_allocator_malloc(host_allocator, total_size, (void**)&executable));
-  IREE_TRACE(
-      char* string_table_buffer =
-          (char*)((char*)executable + sizeof(*executable) +
-                  entry_point_count * sizeof(executable->entry_points[0])));
+  xrt::hw_context** context_buffer =
+      (xrt::hw_context**)((char*)executable + sizeof(*executable) +
+                          entry_point_count *
+                              sizeof(executable->entry_points[0]));
+  iree_hal_xrt_instr_patch_t* instr_patch_buffer =
+      (iree_hal_xrt_instr_patch_t*)(context_buffer + xclbin_count);
+  IREE_TRACE(char* string_table_buffer =
+                 (char*)(instr_patch_buffer + total_instr_patch_count));
 
   iree_hal_resource_initialize(&iree_hal_xrt_native_executable_vtable,
                                &executable->resource);
   executable->host_allocator = host_allocator;
+  executable->queue_state = queue_state;
   executable->entry_point_count = entry_point_count;
+  executable->context_count = xclbin_count;
+  executable->contexts = context_buffer;
+  // Entry points with the same array configuration share an xclbin, which is
+  // registered and given a hardware context only once. Such an xclbin only
+  // contains the kernel of the first entry point that was compiled into it.
+  std::vector<std::string> xclbin_kernel_names(xclbin_count);
   for (iree_host_size_t entry_ordinal = 0; entry_ordinal < entry_point_count;
        entry_ordinal++) {
     const char* entry_name =
         flatbuffers_string_vec_at(entry_points_vec, entry_ordinal);
     uint32_t xclbin_index =
         flatbuffers_uint32_vec_at(xclbin_indices_vec, entry_ordinal);
-    iree_amd_aie_hal_xrt_XclbinDef_table_t xclbin_def =
-        iree_amd_aie_hal_xrt_XclbinDef_vec_at(xclbins_vec, xclbin_index);
-    flatbuffers_string_t xclbin_fb =
-        iree_amd_aie_hal_xrt_XclbinDef_xclbin_get(xclbin_def);
-
-    // XRT API needs this vector and cant actually read a void*.
-    std::vector<char> xclbinVector(
-        xclbin_fb, xclbin_fb + flatbuffers_string_len(xclbin_fb));
-    xrt::xclbin xclbin;
-    try {
-      xclbin = xrt::xclbin(xclbinVector);
-    } catch (std::runtime_error& e) {
-      return iree_make_status(IREE_STATUS_INTERNAL, "XCLBIN load error: %s",
-                              e.what());
+    if (!executable->contexts[xclbin_index]) {
+      iree_amd_aie_hal_xrt_XclbinDef_table_t xclbin_def =
+          iree_amd_aie_hal_xrt_XclbinDef_vec_at(xclbins_vec, xclbin_index);
+      flatbuffers_string_t xclbin_fb =
+          iree_amd_aie_hal_xrt_XclbinDef_xclbin_get(xclbin_def);
+
+      // XRT API needs this vector and cant actually read a void*.
+      std::vector<char> xclbinVector(
+          xclbin_fb, xclbin_fb + flatbuffers_string_len(xclbin_fb));
+      xrt::xclbin xclbin;
+      try {
+        xclbin = xrt::xclbin(xclbinVector);
+        device.register_xclbin(xclbin);
+        executable->contexts[xclbin_index] =
+            new xrt::hw_context(device, xclbin.get_uuid());
+        std::vector<xrt::xclbin::kernel> xclbin_kernels = xclbin.get_kernels();
+        if (!xclbin_kernels.empty()) {
+          xclbin_kernel_names[xclbin_index] = xclbin_kernels.front().get_name();
+        }
+      } catch (std::runtime_error& e) {
+        iree_hal_executable_destroy((iree_hal_executable_t*)executable);
+        IREE_TRACE_ZONE_END(z0);
+        return iree_make_status(IREE_STATUS_INTERNAL, "XCLBIN load error: %s",
+                                e.what());
+      }
     }
-    device.register_xclbin(xclbin);
-    xrt::hw_context context(device, xclbin.get_uuid());
+    xrt::hw_context& context = *executable->contexts[xclbin_index];
+    std::string kernel_name = xclbin_kernel_names[xclbin_index].empty()
+                                  ? std::string(entry_name)
+                                  : xclbin_kernel_names[xclbin_index];
     uint32_t asm_instr_index =
         flatbuffers_uint32_vec_at(asm_instr_indices_vec, entry_ordinal);
     iree_amd_aie_hal_xrt_AsmInstDef_table_t asminst_def =
@@ -196,7 +302,7 @@ iree_status_t iree_hal_xrt_native_executable_create(
     std::unique_ptr<xrt::kernel> kernel;
     std::unique_ptr<xrt::bo> instr;
     try {
-      kernel = std::make_unique<xrt::kernel>(context, entry_name);
+      kernel = std::make_unique<xrt::kernel>(context, kernel_name);
       // XCL_BO_FLAGS_CACHEABLE is used to indicate that this is an instruction
       // buffer that resides in instr_memory. This buffer is always passed as
       // the second argument to the kernel and we can use the
@@ -220,8 +326,36 @@ iree_status_t iree_hal_xrt_native_executable_create(
     iree_hal_xrt_kernel_params_t* params =
         &executable->entry_points[entry_ordinal];
     params->kernel = kernel.release();
+    params->context = &context;
     params->instr = instr.release();
     params->num_instr = num_instr;
+    iree_amd_aie_hal_xrt_AsmInstPatchDef_vec_t patches_vec =
+        iree_amd_aie_hal_xrt_AsmInstDef_patches_get(asminst_def);
+    params->instr_patches = instr_patch_buffer;
+    params->instr_patch_count =
+        iree_amd_aie_hal_xrt_AsmInstPatchDef_vec_len(patches_vec);
+    for (iree_host_size_t j = 0; j < params->instr_patch_count; j++) {
+      iree_amd_aie_hal_xrt_AsmInstPatchDef_struct_t patch_def =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_vec_at(patches_vec, j);
+      iree_hal_xrt_instr_patch_t* patch = &instr_patch_buffer[j];
+      patch->word_index =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_word_index_get(patch_def);
+      patch->bit_offset =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_bit_offset_get(patch_def);
+      patch->bit_width =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_bit_width_get(patch_def);
+      patch->constant_ordinal =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_constant_ordinal_get(patch_def);
+      patch->multiplier =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_multiplier_get(patch_def);
+      patch->addend =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_addend_get(patch_def);
+      patch->divisor =
+          iree_amd_aie_hal_xrt_AsmInstPatchDef_divisor_get(patch_def);
+      patch->scale = iree_amd_aie_hal_xrt_AsmInstPatchDef_scale_get(patch_def);
+      patch->bias = iree_amd_aie_hal_xrt_AsmInstPatchDef_bias_get(patch_def);
+    }
+    instr_patch_buffer += params->instr_patch_count;
     params->layout = executable_params->pipeline_layouts[entry_ordinal];
     iree_hal_pipeline_layout_retain(params->layout);
 
@@ -274,6 +408,17 @@ static void iree_hal_xrt_native_executable_destroy(
     }
     iree_hal_pipeline_layout_release(executable->entry_points[i].layout);
   }
+  // The kernels hold on to their contexts, so release these last.
+  for (iree_host_size_t i = 0; i < executable->context_count; ++i) {
+    if (!executable->contexts[i]) continue;
+    iree_hal_xrt_queue_state_forget_context(executable->queue_state,
+                                            executable->contexts[i]);
+    try {
+      delete executable->contexts[i];
+    } catch (...) {
+      (void)iree_status_from_code(IREE_STATUS_DATA_LOSS);
+    }
+  }
   iree_allocator_free(host_allocator, executable);
 
   IREE_TRACE_ZONE_END(z0);
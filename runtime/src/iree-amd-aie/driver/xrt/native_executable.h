@@ -11,6 +11,7 @@
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
+#include "iree-amd-aie/driver/xrt/xrt_device.h"
 #include "iree/hal/api.h"
 #include "xrt/xrt_device.h"
 #include "xrt/xrt_kernel.h"
@@ -19,24 +20,51 @@
 extern "C" {
 #endif  // __cplusplus
 
+// A field of the instruction buffer, which is patched before every dispatch
+// with `ceil_div(constant * multiplier + addend, divisor) * scale + bias`,
+// where `constant` is the push constant at |constant_ordinal|.
+typedef struct iree_hal_xrt_instr_patch_t {
+  // Index of the instruction word containing the field.
+  uint32_t word_index;
+  // Bit offset and width of the field within the instruction word.
+  uint32_t bit_offset;
+  uint32_t bit_width;
+  uint32_t constant_ordinal;
+  int32_t multiplier;
+  int32_t addend;
+  int32_t divisor;
+  int32_t scale;
+  int32_t bias;
+} iree_hal_xrt_instr_patch_t;
+
 // Object and launch parameters for a compute kernel.
 typedef struct iree_hal_xrt_kernel_params_t {
   // The kernel code object.
   xrt::kernel* kernel;
+  // The hardware context of the kernel's xclbin, shared by all the entry points
+  // of the executable with the same xclbin.
+  xrt::hw_context* context;
   // Instruction buffer argument to the kernel.
   xrt::bo* instr;
   // Number of assembly instructions argument to the kernel
   uint32_t num_instr;  // number of instructions
+  // Fields of the instruction buffer depending on push constants.
+  iree_hal_xrt_instr_patch_t* instr_patches;
+  iree_host_size_t instr_patch_count;
   iree_hal_pipeline_layout_t* layout;
   IREE_TRACE(iree_string_view_t kernel_name;)
   IREE_TRACE(iree_string_view_t source_filename;)
   IREE_TRACE(uint32_t source_line;)
 } iree_hal_xrt_kernel_params_t;
 
+// The hardware contexts of the executable are cleared from |queue_state| when
+// it is destroyed.
+//
 // |out_executable| must be released by the caller (see
 // iree_hal_executable_release).
 iree_status_t iree_hal_xrt_native_executable_create(
-    xrt::device device, const iree_hal_executable_params_t* executable_params,
+    xrt::device device, iree_hal_xrt_queue_state_t* queue_state,
+    const iree_hal_executable_params_t* executable_params,
     iree_allocator_t host_allocator, iree_hal_executable_t** out_executable);
 
 // Returns the kernel launch parameters for the given |entry_point|.
@@ -19,6 +19,7 @@ typedef struct iree_hal_xrt_nop_executable_cache_t {
   iree_hal_resource_t resource;
 
   xrt::device device;
+  iree_hal_xrt_queue_state_t* queue_state;
 
   iree_allocator_t host_allocator;
 } iree_hal_xrt_nop_executable_cache_t;
@@ -36,7 +37,8 @@ iree_hal_xrt_nop_executable_cache_cast(
 }
 
 iree_status_t iree_hal_xrt_nop_executable_cache_create(
-    xrt::device device, iree_string_view_t identifier,
+    xrt::device device, iree_hal_xrt_queue_state_t* queue_state,
+    iree_string_view_t identifier,
     iree_allocator_t host_allocator,
     iree_hal_executable_cache_t** out_executable_cache) {
   IREE_ASSERT_ARGUMENT(out_executable_cache);
@@ -51,6 +53,7 @@ iree_status_t iree_hal_xrt_nop_executable_cache_create(
                                &executable_cache->resource);
   executable_cache->host_allocator = host_allocator;
   executable_cache->device = device;
+  executable_cache->queue_state = queue_state;
 
   *out_executable_cache = (iree_hal_executable_cache_t*)executable_cache;
   IREE_TRACE_ZONE_END(z0);
@@ -83,8 +86,8 @@ static iree_status_t iree_hal_xrt_nop_executable_cache_prepare_executable(
   iree_hal_xrt_nop_executable_cache_t* executable_cache =
       iree_hal_xrt_nop_executable_cache_cast(base_executable_cache);
   return iree_hal_xrt_native_executable_create(
-      executable_cache->device, executable_params,
-      executable_cache->host_allocator, out_executable);
+      executable_cache->device, executable_cache->queue_state,
+      executable_params, executable_cache->host_allocator, out_executable);
 }
 
 namespace {
@@ -7,6 +7,7 @@
 #ifndef IREE_AMD_AIE_DRIVER_XRT_NOP_EXECUTABLE_CACHE_H_
 #define IREE_AMD_AIE_DRIVER_XRT_NOP_EXECUTABLE_CACHE_H_
 
+#include "iree-amd-aie/driver/xrt/xrt_device.h"
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "xrt/xrt_device.h"
@@ -19,10 +20,15 @@ extern "C" {
 // This is useful to isolate pipeline caching behavior and verify compilation
 // behavior.
 //
+// The executables prepared by the cache clear their hardware contexts from
+// |queue_state| when they are destroyed, so the device owning |queue_state|
+// must outlive them.
+//
 // |out_executable_cache| must be released by the caller (see
 // iree_hal_executable_cache_release).
 iree_status_t iree_hal_xrt_nop_executable_cache_create(
-    xrt::device device, iree_string_view_t identifier,
+    xrt::device device, iree_hal_xrt_queue_state_t* queue_state,
+    iree_string_view_t identifier,
     iree_allocator_t host_allocator,
     iree_hal_executable_cache_t** out_executable_cache);
 
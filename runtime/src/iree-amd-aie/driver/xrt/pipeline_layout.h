@@ -24,6 +24,11 @@ extern "C" {
 // with it.
 #define IREE_HAL_XRT_MAX_DESCRIPTOR_SET_COUNT 4
 
+// The max number of push constants allowed in the XRT HAL implementation. Push
+// constants aren't passed to the kernel, but are used to patch the LX6 asm
+// instruction stream with sizes that are only known at dispatch time.
+#define IREE_HAL_XRT_MAX_PUSH_CONSTANT_COUNT 64
+
 // Note that IREE HAL uses a descriptor binding model for expressing resources
 // to the kernels--each descriptor specifies the resource information, together
 // with a (set, binding) number indicating which "slots" it's bound to.
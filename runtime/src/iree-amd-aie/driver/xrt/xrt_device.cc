@@ -34,6 +34,8 @@ typedef struct iree_hal_xrt_device_t {
   iree_hal_allocator_t* device_allocator;
 
   xrt::device device;
+
+  iree_hal_xrt_queue_state_t queue_state;
 } iree_hal_xrt_device_t;
 
 namespace {
@@ -56,6 +58,7 @@ void iree_hal_xrt_device_params_initialize(
     iree_hal_xrt_device_params_t* out_params) {
   memset(out_params, 0, sizeof(*out_params));
   out_params->arena_block_size = 32 * 1024;
+  out_params->group_dispatches_by_context = true;
 }
 
 const iree_hal_xrt_device_params_t* iree_hal_xrt_device_params(
@@ -65,6 +68,21 @@ const iree_hal_xrt_device_params_t* iree_hal_xrt_device_params(
   return &device->params;
 }
 
+iree_hal_xrt_queue_state_t* iree_hal_xrt_device_queue_state(
+    iree_hal_device_t* base_device) {
+  iree_hal_xrt_device_t* device = iree_hal_xrt_device_cast(base_device);
+  return &device->queue_state;
+}
+
+void iree_hal_xrt_queue_state_forget_context(
+    iree_hal_xrt_queue_state_t* queue_state, const xrt::hw_context* context) {
+  iree_slim_mutex_lock(&queue_state->mutex);
+  if (queue_state->active_context == context) {
+    queue_state->active_context = NULL;
+  }
+  iree_slim_mutex_unlock(&queue_state->mutex);
+}
+
 static iree_status_t iree_hal_xrt_device_create_internal(
     iree_string_view_t identifier, xrt::device xrt_device,
     const iree_hal_xrt_device_params_t* params, iree_allocator_t host_allocator,
@@ -90,6 +108,7 @@ static iree_status_t iree_hal_xrt_device_create_internal(
     device->host_allocator = host_allocator;
     device->device = xrt_device;
     device->params = *params;
+    iree_slim_mutex_initialize(&device->queue_state.mutex);
 
     *out_device = (iree_hal_device_t*)device;
   } else {
@@ -119,6 +138,7 @@ static void iree_hal_xrt_device_destroy(iree_hal_device_t* base_device) {
 
   iree_hal_allocator_release(device->device_allocator);
   iree_arena_block_pool_deinitialize(&device->block_pool);
+  iree_slim_mutex_deinitialize(&device->queue_state.mutex);
   iree_allocator_free(host_allocator, device);
 
   IREE_TRACE_ZONE_END(z0);
@@ -171,6 +191,23 @@ static iree_status_t iree_hal_xrt_device_query_i64(
         iree_string_view_equal(key, IREE_SV("amdaie-xclbin-fb")) ? 1 : 0;
     return iree_ok_status();
   }
+
+  if (iree_string_view_equal(category, IREE_SV("hal.xrt.queue"))) {
+    iree_hal_xrt_device_t* device = iree_hal_xrt_device_cast(base_device);
+    iree_hal_xrt_queue_state_t* queue_state = &device->queue_state;
+    if (iree_string_view_equal(key, IREE_SV("context_switches"))) {
+      iree_slim_mutex_lock(&queue_state->mutex);
+      *out_value = queue_state->context_switch_count;
+      iree_slim_mutex_unlock(&queue_state->mutex);
+      return iree_ok_status();
+    }
+    if (iree_string_view_equal(key, IREE_SV("context_switches_avoided"))) {
+      iree_slim_mutex_lock(&queue_state->mutex);
+      *out_value = queue_state->context_switches_avoided_count;
+      iree_slim_mutex_unlock(&queue_state->mutex);
+      return iree_ok_status();
+    }
+  }
   return iree_make_status(IREE_STATUS_UNIMPLEMENTED, "unsupported query");
 }
 
@@ -222,7 +259,8 @@ static iree_status_t iree_hal_xrt_device_create_executable_cache(
     iree_loop_t loop, iree_hal_executable_cache_t** out_executable_cache) {
   iree_hal_xrt_device_t* device = iree_hal_xrt_device_cast(base_device);
   return iree_hal_xrt_nop_executable_cache_create(
-      device->device, identifier, device->host_allocator, out_executable_cache);
+      device->device, &device->queue_state, identifier, device->host_allocator,
+      out_executable_cache);
 }
 
 static iree_status_t iree_hal_xrt_device_import_file(
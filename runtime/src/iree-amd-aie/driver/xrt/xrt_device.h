@@ -9,8 +9,10 @@
 
 #include "iree-amd-aie/driver/xrt/api.h"
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/hal/api.h"
 #include "xrt/xrt_device.h"
+#include "xrt/xrt_hw_context.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,6 +31,33 @@ iree_status_t iree_hal_xrt_device_create(
 const iree_hal_xrt_device_params_t* iree_hal_xrt_device_params(
     const iree_hal_device_t* device);
 
+// State of the device queue, which is carried over between the command buffers
+// executed on it.
+typedef struct iree_hal_xrt_queue_state_t {
+  // Guards the fields below, which are shared by all the command buffers
+  // executing on the device and read by device queries.
+  iree_slim_mutex_t mutex;
+  // Hardware context of the last dispatch or NULL if nothing was dispatched or
+  // the executable owning that context was destroyed since. Only compared
+  // against, never dereferenced.
+  const xrt::hw_context* active_context;
+  // Number of dispatches which ran in another hardware context than the
+  // previous one.
+  int64_t context_switch_count;
+  // Number of context switches avoided by reordering independent dispatches.
+  int64_t context_switches_avoided_count;
+} iree_hal_xrt_queue_state_t;
+
+// Returns the state of the (only) queue of the device.
+iree_hal_xrt_queue_state_t* iree_hal_xrt_device_queue_state(
+    iree_hal_device_t* device);
+
+// Clears the active context of |queue_state| if it is |context|, which is about
+// to be destroyed, so that a context allocated later at the same address isn't
+// taken for the active one.
+void iree_hal_xrt_queue_state_forget_context(
+    iree_hal_xrt_queue_state_t* queue_state, const xrt::hw_context* context);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -0,0 +1,41 @@
+// RUN: iree-compile --iree-hal-target-backends=amd-aie --compile-to=executable-sources %s | iree-opt --pass-pipeline="builtin.module(hal.executable(hal.executable.variant(iree-hal-translate-target-executable-variants{target=amd-aie})))" --iree-amdaie-use-pipeline=pack-peel --split-input-file | FileCheck %s
+
+// The softmax is decomposed into row reductions and elementwise ops, which are
+// distributed over the cores by the reduction pipeline. The cores reduce the
+// rows with vector ops.
+func.func @softmax_bf16(%input: tensor<256x1024xbf16>) -> tensor<256x1024xbf16>
+{
+  %0 = tensor.empty() : tensor<256x1024xbf16>
+  %res = linalg.softmax dimension(1) ins(%input : tensor<256x1024xbf16>)
+                                     outs(%0 : tensor<256x1024xbf16>) -> tensor<256x1024xbf16>
+  return %res : tensor<256x1024xbf16>
+}
+
+// CHECK-LABEL: hal.executable.export public @softmax_bf16_dispatch_0_softmax_256x1024_bf16
+//       CHECK:    aie.device(npu1_4col)
+//       CHECK:    aie.core
+//       CHECK:      vector.{{(multi_)?}}reduction
+//       CHECK:    aie.shim_dma_allocation
+//       CHECK:    aie.shim_dma_allocation
+//       CHECK:    func.func @softmax_bf16_dispatch_0_softmax_256x1024_bf16(
+//       CHECK:      aiex.npu.dma_memcpy_nd
+//       CHECK:      aiex.npu.dma_memcpy_nd
+//       CHECK:      aiex.npu.sync
+
+// -----
+
+func.func @softmax_f32(%input: tensor<64x256xf32>) -> tensor<64x256xf32>
+{
+  %0 = tensor.empty() : tensor<64x256xf32>
+  %res = linalg.softmax dimension(1) ins(%input : tensor<64x256xf32>)
+                                     outs(%0 : tensor<64x256xf32>) -> tensor<64x256xf32>
+  return %res : tensor<64x256xf32>
+}
+
+// CHECK-LABEL: hal.executable.export public @softmax_f32_dispatch_0_softmax_64x256_f32
+//       CHECK:    aie.device(npu1_4col)
+//       CHECK:    aie.core
+//       CHECK:      vector.{{(multi_)?}}reduction
+//       CHECK:    func.func @softmax_f32_dispatch_0_softmax_64x256_f32(
+//       CHECK:      aiex.npu.dma_memcpy_nd
+//       CHECK:      aiex.npu.sync